@@ -15,9 +15,221 @@
  */
 
 #include "CameraManager.h"
+#include <json/json_utils.h>
+#include <spa/param/format-utils.h>
+#include <spa/param/video/format-utils.h>
+#include <spa/pod/iter.h>
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
 
+namespace {
+
+// Version 2 expands size ranges instead of listing their bounds as sizes.
+constexpr int kCapabilityCacheVersion = 2;
+constexpr int kRegistrySyncTimeoutSec = 2;
+
+/**
+ * Properties tried in order to derive a stable per-device key. node.name is
+ * generated from the udev path by the v4l2/libcamera monitors, so it is
+ * stable across reboots even when no serial is exposed.
+ */
+constexpr const char* kSerialKeys[] = {"device.serial", "api.v4l2.cap.bus_info",
+                                       "node.name", "object.path"};
+
+std::string GetCapabilityCachePath() {
+  std::filesystem::path base;
+  if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    base = xdg;
+  } else if (const char* home = std::getenv("HOME"); home && *home) {
+    base = std::filesystem::path(home) / ".cache";
+  } else {
+    return {};
+  }
+  return base / "camera_pipewire" / "capabilities.json";
+}
+
+std::string VideoFormatToString(const uint32_t media_subtype,
+                                const uint32_t video_format) {
+  if (media_subtype == SPA_MEDIA_SUBTYPE_mjpg) {
+    return "MJPEG";
+  }
+  if (media_subtype == SPA_MEDIA_SUBTYPE_h264) {
+    return "H264";
+  }
+  switch (video_format) {
+    case SPA_VIDEO_FORMAT_YUY2:
+      return "YUY2";
+    case SPA_VIDEO_FORMAT_NV12:
+      return "NV12";
+    case SPA_VIDEO_FORMAT_I420:
+      return "I420";
+    case SPA_VIDEO_FORMAT_RGB:
+      return "RGB";
+    case SPA_VIDEO_FORMAT_RGBA:
+      return "RGBA";
+    case SPA_VIDEO_FORMAT_BGRA:
+      return "BGRA";
+    default:
+      return "raw:" + std::to_string(video_format);
+  }
+}
+
+/**
+ * Values of a property as stored in the pod: the value itself for no choice,
+ * the alternatives for an enum (without the leading default, which is
+ * repeated among them), and default, min, max[, step] for a range or step.
+ */
+template <typename T>
+struct PodValues {
+  uint32_t choice = SPA_CHOICE_None;
+  std::vector<T> values;
+};
+
+template <typename T>
+PodValues<T> GetPodValues(const spa_pod* param,
+                          const uint32_t key,
+                          const uint32_t pod_type) {
+  PodValues<T> result;
+  const spa_pod_prop* prop = spa_pod_find_prop(param, nullptr, key);
+  if (!prop) {
+    return result;
+  }
+  uint32_t n_vals = 0;
+  uint32_t choice = SPA_CHOICE_None;
+  const spa_pod* val = spa_pod_get_values(&prop->value, &n_vals, &choice);
+  if (!val || val->type != pod_type || n_vals == 0) {
+    return result;
+  }
+  const auto* body = static_cast<const T*>(SPA_POD_BODY_CONST(val));
+  const uint32_t expected = choice == SPA_CHOICE_Range  ? 3
+                            : choice == SPA_CHOICE_Step ? 4
+                                                        : 1;
+  if (n_vals < expected) {
+    // Malformed choice; only the default is usable.
+    choice = SPA_CHOICE_None;
+  }
+  result.choice = choice;
+  switch (choice) {
+    case SPA_CHOICE_Enum:
+      result.values.assign(body + (n_vals > 1 ? 1 : 0), body + n_vals);
+      break;
+    case SPA_CHOICE_Range:
+    case SPA_CHOICE_Step:
+      result.values.assign(body, body + expected);
+      break;
+    default:
+      // Flags choices are not used by video formats.
+      result.choice = SPA_CHOICE_None;
+      result.values.push_back(body[0]);
+      break;
+  }
+  return result;
+}
+
+/**
+ * Sizes tried against a continuous size range, since cameras that advertise
+ * one (mostly libcamera nodes) accept any size within it.
+ */
+constexpr spa_rectangle kCommonSizes[] = {
+    {160, 120},  {320, 240},   {352, 288},   {640, 360},   {640, 480},
+    {800, 600},  {1024, 768},  {1280, 720},  {1280, 960},  {1600, 1200},
+    {1920, 1080}, {2560, 1440}, {3840, 2160},
+};
+
+/**
+ * Expands a size property into discrete sizes. A range or step yields its
+ * default plus every common size within the bounds that lies on the step.
+ */
+std::vector<spa_rectangle> ExpandSizes(const PodValues<spa_rectangle>& sizes) {
+  if (sizes.choice != SPA_CHOICE_Range && sizes.choice != SPA_CHOICE_Step) {
+    return sizes.values;
+  }
+  const auto& min = sizes.values[1];
+  const auto& max = sizes.values[2];
+  const spa_rectangle step = sizes.choice == SPA_CHOICE_Step
+                                 ? sizes.values[3]
+                                 : spa_rectangle{1, 1};
+  auto fits = [&](const spa_rectangle& size) {
+    return size.width >= min.width && size.width <= max.width &&
+           size.height >= min.height && size.height <= max.height &&
+           (step.width == 0 || (size.width - min.width) % step.width == 0) &&
+           (step.height == 0 || (size.height - min.height) % step.height == 0);
+  };
+
+  std::vector<spa_rectangle> expanded{sizes.values[0]};
+  for (const auto& size : kCommonSizes) {
+    if (fits(size) && (size.width != sizes.values[0].width ||
+                       size.height != sizes.values[0].height)) {
+      expanded.push_back(size);
+    }
+  }
+  return expanded;
+}
+
+/**
+ * Returns the highest frame rate a rate property allows: the largest
+ * alternative of an enum, or the upper bound of a range or step.
+ */
+spa_fraction GetBestRate(const PodValues<spa_fraction>& rates) {
+  if (rates.choice == SPA_CHOICE_Range || rates.choice == SPA_CHOICE_Step) {
+    return rates.values[2];
+  }
+  spa_fraction best_rate{0, 1};
+  for (const auto& rate : rates.values) {
+    if (rate.denom != 0 && static_cast<uint64_t>(rate.num) * best_rate.denom >
+                               static_cast<uint64_t>(best_rate.num) *
+                                   rate.denom) {
+      best_rate = rate;
+    }
+  }
+  return best_rate;
+}
+
+void ParseEnumFormat(const spa_pod* param, std::vector<CameraFormat>& out) {
+  uint32_t media_type = 0;
+  uint32_t media_subtype = 0;
+  if (spa_format_parse(param, &media_type, &media_subtype) < 0 ||
+      media_type != SPA_MEDIA_TYPE_video) {
+    return;
+  }
+
+  auto video_formats =
+      GetPodValues<uint32_t>(param, SPA_FORMAT_VIDEO_format, SPA_TYPE_Id)
+          .values;
+  const auto sizes = ExpandSizes(GetPodValues<spa_rectangle>(
+      param, SPA_FORMAT_VIDEO_size, SPA_TYPE_Rectangle));
+  const auto best_rate = GetBestRate(GetPodValues<spa_fraction>(
+      param, SPA_FORMAT_VIDEO_framerate, SPA_TYPE_Fraction));
+
+  if (video_formats.empty()) {
+    video_formats.push_back(SPA_VIDEO_FORMAT_UNKNOWN);
+  }
+  for (const auto video_format : video_formats) {
+    const auto name = VideoFormatToString(media_subtype, video_format);
+    for (const auto& size : sizes) {
+      const auto it =
+          std::find_if(out.begin(), out.end(), [&](const CameraFormat& f) {
+            return f.format == name && f.width == size.width &&
+                   f.height == size.height;
+          });
+      if (it == out.end()) {
+        out.push_back({name, size.width, size.height, best_rate.num,
+                       best_rate.denom});
+      } else if (static_cast<uint64_t>(best_rate.num) * it->framerate_den >
+                 static_cast<uint64_t>(it->framerate_num) * best_rate.denom) {
+        // The same size listed again with faster rates.
+        it->framerate_num = best_rate.num;
+        it->framerate_den = best_rate.denom;
+      }
+    }
+  }
+}
+
+}  // namespace
+
 // Static instance
 CameraManager& CameraManager::instance() {
   static CameraManager s_instance;
@@ -33,16 +245,29 @@ CameraManager::~CameraManager() {
   }
 }
 
-const std::map<uint32_t, std::string>& CameraManager::getAvailableCameras()
-    const {
-  return camera_nodes_;
+std::map<uint32_t, std::string> CameraManager::getAvailableCameras() const {
+  std::lock_guard<std::mutex> lock(cameras_mutex_);
+  std::map<uint32_t, std::string> cameras;
+  for (const auto& [id, info] : camera_nodes_) {
+    cameras.emplace(id, info.name);
+  }
+  return cameras;
+}
+
+std::optional<CameraInfo> CameraManager::getCameraInfo(
+    const uint32_t id) const {
+  std::lock_guard<std::mutex> lock(cameras_mutex_);
+  if (const auto it = camera_nodes_.find(id); it != camera_nodes_.end()) {
+    return it->second;
+  }
+  return std::nullopt;
 }
 
 // Callback function for detecting cameras
 void CameraManager::on_global(void* data,
                               const uint32_t id,
                               uint32_t /*permissions*/,
-                              const char* /*type*/,
+                              const char* type,
                               uint32_t /*version*/,
                               const struct spa_dict* props) {
   if (!data) {
@@ -50,7 +275,7 @@ void CameraManager::on_global(void* data,
     return;
   }
 
-  if (!props)
+  if (!props || !type || std::string(type) != PW_TYPE_INTERFACE_Node)
     return;
 
   if (const char* media_class = spa_dict_lookup(props, "media.class");
@@ -60,22 +285,253 @@ void CameraManager::on_global(void* data,
   const char* node_name = spa_dict_lookup(props, "node.description");
   const std::string name = node_name ? node_name : "Unknown";
 
+  std::string serial;
+  for (const auto* key : kSerialKeys) {
+    if (const char* value = spa_dict_lookup(props, key); value && *value) {
+      serial = value;
+      break;
+    }
+  }
+  if (serial.empty()) {
+    serial = name;
+  }
+
   auto* self = static_cast<CameraManager*>(data);
-  self->camera_nodes_[id] = name;
-  spdlog::debug("[+] camera added: {} (camera_id: {})", name, id);
+  bool cached;
+  {
+    std::lock_guard<std::mutex> lock(self->cameras_mutex_);
+    auto& info = self->camera_nodes_[id];
+    info.id = id;
+    info.name = name;
+    info.serial = serial;
+    const auto it = self->capability_cache_.find(serial);
+    cached = it != self->capability_cache_.end();
+    if (cached) {
+      info.formats = it->second;
+    }
+  }
+  spdlog::debug("[+] camera added: {} (camera_id: {}, serial: {}, cached: {})",
+                name, id, serial, cached);
+
+  if (!cached) {
+    self->startProbe(id);
+  }
 }
+
 void CameraManager::on_global_remove(void* data, const uint32_t id) {
   if (!data) {
     spdlog::error("[error] on_global_remove received null data");
     return;
   }
   auto* self = static_cast<CameraManager*>(data);
+  if (const auto probe = self->probes_.find(id); probe != self->probes_.end()) {
+    self->destroyProbe(*probe->second);
+    self->probes_.erase(probe);
+  }
+  std::lock_guard<std::mutex> lock(self->cameras_mutex_);
   if (auto it = self->camera_nodes_.find(id); it != self->camera_nodes_.end()) {
-    spdlog::debug("[-] camera removed: {} (camera_id: {})", it->second, id);
+    spdlog::debug("[-] camera removed: {} (camera_id: {})", it->second.name,
+                  id);
     self->camera_nodes_.erase(it);
   }
 }
 
+void CameraManager::on_core_done(void* data, const uint32_t id, const int seq) {
+  auto* self = static_cast<CameraManager*>(data);
+  if (!self || id != PW_ID_CORE) {
+    return;
+  }
+
+  if (seq == self->registry_sync_seq_) {
+    self->registry_synced_ = true;
+    pw_thread_loop_signal(self->pw_thread_loop_, false);
+    return;
+  }
+
+  // The sync issued after enum_params completes once all param events for
+  // that node have been delivered.
+  for (const auto& [node_id, probe] : self->probes_) {
+    if (probe->sync_seq == seq) {
+      self->finishProbe(node_id);
+      return;
+    }
+  }
+}
+
+void CameraManager::on_node_param(void* data,
+                                  int /*seq*/,
+                                  const uint32_t id,
+                                  uint32_t /*index*/,
+                                  uint32_t /*next*/,
+                                  const struct spa_pod* param) {
+  auto* probe = static_cast<NodeProbe*>(data);
+  if (!probe || !param || id != SPA_PARAM_EnumFormat) {
+    return;
+  }
+  ParseEnumFormat(param, probe->formats);
+}
+
+void CameraManager::startProbe(const uint32_t id) {
+  auto* proxy = static_cast<pw_proxy*>(
+      pw_registry_bind(pw_registry_, id, PW_TYPE_INTERFACE_Node,
+                       PW_VERSION_NODE, 0));
+  if (!proxy) {
+    spdlog::error("[CameraManager] failed to bind camera node {}", id);
+    return;
+  }
+
+  auto probe = std::make_unique<NodeProbe>();
+  probe->self = this;
+  probe->id = id;
+  probe->proxy = proxy;
+
+  static const pw_node_events node_events = {
+      .version = PW_VERSION_NODE_EVENTS,
+      .param = on_node_param,
+  };
+  pw_node_add_listener(reinterpret_cast<pw_node*>(proxy), &probe->listener,
+                       &node_events, probe.get());
+  pw_node_enum_params(reinterpret_cast<pw_node*>(proxy), 0,
+                      SPA_PARAM_EnumFormat, 0, UINT32_MAX, nullptr);
+  probe->sync_seq = pw_core_sync(pw_core_, PW_ID_CORE, 0);
+
+  probes_[id] = std::move(probe);
+}
+
+void CameraManager::finishProbe(const uint32_t id) {
+  const auto it = probes_.find(id);
+  if (it == probes_.end()) {
+    return;
+  }
+  auto probe = std::move(it->second);
+  probes_.erase(it);
+  destroyProbe(*probe);
+
+  {
+    std::lock_guard<std::mutex> lock(cameras_mutex_);
+    const auto node = camera_nodes_.find(id);
+    if (node == camera_nodes_.end()) {
+      return;
+    }
+    node->second.formats = probe->formats;
+    capability_cache_[node->second.serial] = std::move(probe->formats);
+    spdlog::debug("[CameraManager] probed camera {}: {} formats", id,
+                  node->second.formats.size());
+    cache_dirty_ = true;
+  }
+  cache_writer_cv_.notify_one();
+}
+
+void CameraManager::destroyProbe(NodeProbe& probe) {
+  if (probe.proxy) {
+    spa_hook_remove(&probe.listener);
+    pw_proxy_destroy(probe.proxy);
+    probe.proxy = nullptr;
+  }
+}
+
+void CameraManager::loadCapabilityCache() {
+  capability_cache_path_ = GetCapabilityCachePath();
+  if (capability_cache_path_.empty() ||
+      !std::filesystem::exists(capability_cache_path_)) {
+    return;
+  }
+
+  const auto doc =
+      plugin_common::JsonUtils::GetJsonDocumentFromFile(capability_cache_path_);
+  if (!doc.IsObject() || !doc.HasMember("version") ||
+      !doc["version"].IsInt() ||
+      doc["version"].GetInt() != kCapabilityCacheVersion ||
+      !doc.HasMember("devices") || !doc["devices"].IsObject()) {
+    spdlog::warn("[CameraManager] ignoring stale capability cache: {}",
+                 capability_cache_path_);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(cameras_mutex_);
+  capability_cache_.clear();
+  for (const auto& device : doc["devices"].GetObject()) {
+    if (!device.value.IsArray()) {
+      continue;
+    }
+    auto& formats = capability_cache_[device.name.GetString()];
+    for (const auto& entry : device.value.GetArray()) {
+      if (!entry.IsObject() || !entry.HasMember("format") ||
+          !entry["format"].IsString() || !entry.HasMember("width") ||
+          !entry["width"].IsUint() || !entry.HasMember("height") ||
+          !entry["height"].IsUint()) {
+        continue;
+      }
+      CameraFormat format;
+      format.format = entry["format"].GetString();
+      format.width = entry["width"].GetUint();
+      format.height = entry["height"].GetUint();
+      if (entry.HasMember("framerate_num") &&
+          entry["framerate_num"].IsUint() &&
+          entry.HasMember("framerate_den") && entry["framerate_den"].IsUint()) {
+        format.framerate_num = entry["framerate_num"].GetUint();
+        format.framerate_den = entry["framerate_den"].GetUint();
+      }
+      formats.push_back(std::move(format));
+    }
+  }
+  spdlog::debug("[CameraManager] loaded capabilities for {} devices",
+                capability_cache_.size());
+}
+
+void CameraManager::runCacheWriter() {
+  std::unique_lock<std::mutex> lock(cameras_mutex_);
+  while (true) {
+    cache_writer_cv_.wait(
+        lock, [this] { return cache_dirty_ || cache_writer_stop_; });
+    if (!cache_dirty_) {
+      return;
+    }
+    cache_dirty_ = false;
+    const auto cache = capability_cache_;
+    lock.unlock();
+    saveCapabilityCache(cache);
+    lock.lock();
+  }
+}
+
+void CameraManager::saveCapabilityCache(
+    const std::map<std::string, std::vector<CameraFormat>>& cache) const {
+  if (capability_cache_path_.empty()) {
+    return;
+  }
+
+  rapidjson::Document doc;
+  doc.SetObject();
+  auto& allocator = doc.GetAllocator();
+  doc.AddMember("version", kCapabilityCacheVersion, allocator);
+
+  rapidjson::Value devices(rapidjson::kObjectType);
+  for (const auto& [serial, formats] : cache) {
+    rapidjson::Value list(rapidjson::kArrayType);
+    for (const auto& format : formats) {
+      rapidjson::Value entry(rapidjson::kObjectType);
+      entry.AddMember("format",
+                      rapidjson::Value(format.format.c_str(), allocator).Move(),
+                      allocator);
+      entry.AddMember("width", format.width, allocator);
+      entry.AddMember("height", format.height, allocator);
+      entry.AddMember("framerate_num", format.framerate_num, allocator);
+      entry.AddMember("framerate_den", format.framerate_den, allocator);
+      list.PushBack(entry, allocator);
+    }
+    devices.AddMember(rapidjson::Value(serial.c_str(), allocator).Move(), list,
+                      allocator);
+  }
+  doc.AddMember("devices", devices, allocator);
+
+  if (!plugin_common::JsonUtils::WriteJsonDocumentToFile(
+          capability_cache_path_, doc)) {
+    spdlog::error("[CameraManager] failed to write capability cache: {}",
+                  capability_cache_path_);
+  }
+}
+
 bool CameraManager::initialize() {
   std::lock_guard<std::mutex> lock(mutex_);
 
@@ -87,6 +543,9 @@ bool CameraManager::initialize() {
   // 1) Initialize PipeWire library (safe to call once)
   pw_init(nullptr, nullptr);
 
+  // Capabilities probed in a previous run, keyed by device serial
+  loadCapabilityCache();
+
   // 2) Create main loop, context, and core
   pw_thread_loop_ = pw_thread_loop_new("camera-loop", nullptr);
   if (!pw_thread_loop_) {
@@ -120,15 +579,35 @@ bool CameraManager::initialize() {
         pw_core_ = pw_context_connect(pw_context_, nullptr, 0);
         if (!pw_core_) {
           spdlog::error("[CameraManager] could not connect to PipeWire core.");
+        } else {
+          pw_registry_ =
+              pw_core_get_registry(pw_core_, PW_VERSION_REGISTRY, 0);
+          static pw_registry_events registry_events = {
+              .version = PW_VERSION_REGISTRY_EVENTS,
+              .global = on_global,
+              .global_remove = on_global_remove,
+          };
+          pw_registry_add_listener(pw_registry_, &registry_listener_,
+                                   &registry_events, this);
+
+          static pw_core_events core_events = {
+              .version = PW_VERSION_CORE_EVENTS,
+              .done = on_core_done,
+          };
+          pw_core_add_listener(pw_core_, &core_listener_, &core_events, this);
+
+          // Round-trip once so the initial set of globals has been delivered
+          // before the first getAvailableCameras() call.
+          registry_synced_ = false;
+          registry_sync_seq_ = pw_core_sync(pw_core_, PW_ID_CORE, 0);
+          while (!registry_synced_) {
+            if (pw_thread_loop_timed_wait(pw_thread_loop_,
+                                          kRegistrySyncTimeoutSec) != 0) {
+              spdlog::warn("[CameraManager] timed out waiting for registry");
+              break;
+            }
+          }
         }
-        pw_registry_ = pw_core_get_registry(pw_core_, PW_VERSION_REGISTRY, 0);
-        static pw_registry_events registry_events = {
-            .version = PW_VERSION_REGISTRY_EVENTS,
-            .global = on_global,
-            .global_remove = on_global_remove,
-        };
-        pw_registry_add_listener(pw_registry_, new spa_hook{}, &registry_events,
-                                 this);
       }
     }
   }
@@ -144,6 +623,14 @@ bool CameraManager::initialize() {
     return false;
   }
 
+  // Probes finished during the registry round-trip leave the cache dirty,
+  // so the writer saves them as soon as it starts.
+  {
+    std::lock_guard<std::mutex> cameras_lock(cameras_mutex_);
+    cache_writer_stop_ = false;
+  }
+  cache_writer_ = std::thread(&CameraManager::runCacheWriter, this);
+
   initialized_ = true;
   return true;
 }
@@ -161,7 +648,17 @@ void CameraManager::shutdown() {
   // 2) Lock while destroying
   pw_thread_loop_lock(pw_thread_loop_);
   {
+    for (auto& [id, probe] : probes_) {
+      destroyProbe(*probe);
+    }
+    probes_.clear();
+    if (pw_registry_) {
+      spa_hook_remove(&registry_listener_);
+      pw_proxy_destroy(reinterpret_cast<pw_proxy*>(pw_registry_));
+      pw_registry_ = nullptr;
+    }
     if (pw_core_) {
+      spa_hook_remove(&core_listener_);
       pw_core_disconnect(pw_core_);
       pw_core_ = nullptr;
     }
@@ -178,5 +675,17 @@ void CameraManager::shutdown() {
 
   // 4) De-init PipeWire
   pw_deinit();
+
+  // 5) Flush capabilities probed since the last write
+  {
+    std::lock_guard<std::mutex> cameras_lock(cameras_mutex_);
+    cache_writer_stop_ = true;
+  }
+  cache_writer_cv_.notify_one();
+  cache_writer_.join();
+  {
+    std::lock_guard<std::mutex> cameras_lock(cameras_mutex_);
+    camera_nodes_.clear();
+  }
   initialized_ = false;
 }
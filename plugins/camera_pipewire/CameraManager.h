@@ -21,9 +21,41 @@
 
 #include <pipewire/core.h>
 #include <pipewire/pipewire.h>
+#include <condition_variable>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
 #include <thread>
+#include <vector>
+
+/**
+ * @brief A single format/size combination advertised by a camera node via
+ * SPA_PARAM_EnumFormat. The frame rate is the highest one offered for the
+ * size.
+ */
+struct CameraFormat {
+  std::string format;  // "MJPEG", "YUY2", "NV12", ...
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t framerate_num = 0;
+  uint32_t framerate_den = 1;
+};
+
+/**
+ * @brief Registry entry for a camera node.
+ *
+ * `serial` is a stable device key (survives re-plugging and reboots) used to
+ * look up the persisted capability list. `formats` is empty until the node
+ * has been probed or its capabilities were found in the on-disk cache.
+ */
+struct CameraInfo {
+  uint32_t id = 0;
+  std::string name;
+  std::string serial;
+  std::vector<CameraFormat> formats;
+};
 
 /**
  * @brief A singleton manager that initializes and owns the shared
@@ -66,7 +98,17 @@ class CameraManager {
    */
   pw_core* core() const { return pw_core_; }
 
-  const std::map<uint32_t, std::string>& getAvailableCameras() const;
+  /**
+   * @brief Returns a snapshot of the camera nodes currently present in the
+   * registry (node id -> description). Safe to call from any thread.
+   */
+  std::map<uint32_t, std::string> getAvailableCameras() const;
+
+  /**
+   * @brief Returns the registry entry, including cached capabilities, for
+   * the given node id.
+   */
+  std::optional<CameraInfo> getCameraInfo(uint32_t id) const;
 
   CameraManager();
   ~CameraManager();
@@ -85,13 +127,69 @@ class CameraManager {
 
   static void on_global_remove(void* data, uint32_t id);
 
+  static void on_core_done(void* data, uint32_t id, int seq);
+
+  static void on_node_param(void* data,
+                            int seq,
+                            uint32_t id,
+                            uint32_t index,
+                            uint32_t next,
+                            const struct spa_pod* param);
+
+  /**
+   * @brief In-flight EnumFormat query against a single camera node. Owned by
+   * the loop thread; created on node add when the device serial is not in
+   * the capability cache.
+   */
+  struct NodeProbe {
+    CameraManager* self = nullptr;
+    uint32_t id = 0;
+    int sync_seq = -1;
+    pw_proxy* proxy = nullptr;
+    spa_hook listener{};
+    std::vector<CameraFormat> formats;
+  };
+
+  void startProbe(uint32_t id);
+  void finishProbe(uint32_t id);
+  void destroyProbe(NodeProbe& probe);
+
+  void loadCapabilityCache();
+  void saveCapabilityCache(
+      const std::map<std::string, std::vector<CameraFormat>>& cache) const;
+
+  // Body of cache_writer_; saves the capability cache whenever a probe
+  // changes it, until shutdown() asks it to stop.
+  void runCacheWriter();
+
   bool initialized_ = false;
   pw_thread_loop* pw_thread_loop_ = nullptr;
   pw_context* pw_context_ = nullptr;
   pw_core* pw_core_ = nullptr;
   pw_registry* pw_registry_ = nullptr;
+  spa_hook registry_listener_{};
+  spa_hook core_listener_{};
+  int registry_sync_seq_ = -1;
+  bool registry_synced_ = false;
   mutable std::mutex mutex_;
-  std::map<uint32_t, std::string> camera_nodes_;
+
+  // Guards camera_nodes_, capability_cache_ and the cache writer state,
+  // which are written from the PipeWire loop thread and read from the
+  // platform thread.
+  mutable std::mutex cameras_mutex_;
+  std::map<uint32_t, CameraInfo> camera_nodes_;
+  std::map<std::string, std::vector<CameraFormat>> capability_cache_;
+  std::string capability_cache_path_;
+
+  // Writes the capability cache to disk so the loop thread never blocks on
+  // file I/O.
+  std::thread cache_writer_;
+  std::condition_variable cache_writer_cv_;
+  bool cache_dirty_ = false;
+  bool cache_writer_stop_ = false;
+
+  // Loop thread only.
+  std::map<uint32_t, std::unique_ptr<NodeProbe>> probes_;
 };
 
 #endif  // CAMERAMANAGER_H
@@ -128,16 +128,37 @@ static int decode_yuy2(const uint8_t* input,
 
   return 0;
 }
+
+std::string CameraStream::OutputFormat() {
+  const char* env = std::getenv("CAMERA_OUTPUT_FORMAT");
+  if (env == nullptr || *env == '\0') {
+    return "YUV2";
+  }
+  const std::string format_env = env;
+  if (format_env == "MJPEG" || format_env == "YUV2") {
+    return format_env;
+  }
+  spdlog::error(
+      "CAMERA_OUTPUT_FORMAT is set to an unsupported value ('{}'). "
+      "Supported values: MJPEG, YUV2. Defaulting to YUV2.",
+      format_env);
+  return "YUV2";
+}
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
 CameraStream::CameraStream(flutter::PluginRegistrarDesktop* plugin_registrar,
                            std::string camera_id,
                            int width,
-                           int height)
+                           int height,
+                           uint32_t framerate_num,
+                           uint32_t framerate_den)
     : registrar_(plugin_registrar),
       width_(width),
       height_(height),
+      framerate_num_(framerate_num),
+      framerate_den_(framerate_den),
       camera_id_(std::move(camera_id)) {
   // Allocate RGB buffer for frames
   decoded_buffer_.reset(new uint8_t[width_ * height_ * 3]);
@@ -279,28 +300,11 @@ bool CameraStream::Start(const std::string& camera_id) {
         {}});
     spa_rectangle rect = {static_cast<uint32_t>(width_),
                           static_cast<uint32_t>(height_)};
-    spa_fraction fps = {30, 1};
+    spa_fraction fps = {framerate_num_, framerate_den_};
 
     const spa_pod* params[1];
 
-    std::string format_env;
-    if (const char* env = std::getenv("CAMERA_OUTPUT_FORMAT")) {
-      format_env = env;
-    } else {
-      format_env = "";
-    }
-
-    if (format_env == "MJPEG") {
-      camera_output_format = "MJPEG";
-    } else if (format_env == "YUV2") {
-      camera_output_format = "YUV2";
-    } else {
-      spdlog::error(
-          "CAMERA_OUTPUT_FORMAT is set to an unsupported value ('{}'). "
-          "Supported values: MJPEG, YUV2. Defaulting to YUV2.",
-          format_env);
-      camera_output_format = "YUV2";
-    }
+    camera_output_format = OutputFormat();
 
     spdlog::debug("[CameraStream] camera_output_format is set to {}",
                   camera_output_format);
@@ -40,11 +40,15 @@ class CameraStream {
    * @param camera_id The id of the camera
    * @param width      Desired width of the MJPEG frames.
    * @param height     Desired height of the MJPEG frames.
+   * @param framerate_num Numerator of the frame rate to negotiate.
+   * @param framerate_den Denominator of the frame rate to negotiate.
    */
   CameraStream(flutter::PluginRegistrarDesktop* plugin_registrar,
                std::string camera_id,
                int width,
-               int height);
+               int height,
+               uint32_t framerate_num = 30,
+               uint32_t framerate_den = 1);
 
   /**
    * Destructor. Automatically stops the camera stream if running.
@@ -75,6 +79,12 @@ class CameraStream {
   [[nodiscard]] int camera_width() const { return width_; }
   [[nodiscard]] int camera_height() const { return height_; }
   static std::optional<std::string> GetFilePathForPicture();
+
+  /**
+   * The format streams negotiate, from CAMERA_OUTPUT_FORMAT: "MJPEG" or
+   * "YUV2" (packed YUY2, the default).
+   */
+  static std::string OutputFormat();
   [[nodiscard]] std::string takePicture() const;
 
  private:
@@ -100,6 +110,8 @@ class CameraStream {
   // Dimensions
   int width_ = 640;
   int height_ = 480;
+  uint32_t framerate_num_ = 30;
+  uint32_t framerate_den_ = 1;
 
   // Private methods
   void HandleProcess();
@@ -17,9 +17,12 @@
 #include "camera_plugin.h"
 #include <flutter/plugin_registrar_homescreen.h>
 #include <jpeglib.h>
+#include <cstdlib>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include "CameraManager.h"
 #include "plugins/common/common.h"
@@ -28,36 +31,99 @@ extern "C" {
 #include <pipewire/pipewire.h>
 }
 
-struct CameraInfo {
-  uint32_t id;
-  std::string name;
-};
+using namespace plugin_common;
 
-// Global vector to store camera info
-std::vector<CameraInfo> cameras;
-
-// Callback function for detecting cameras
-void on_global(void* /*data*/,
-               uint32_t id,
-               uint32_t /*permissions*/,
-               const char* /*type*/,
-               uint32_t /*version*/,
-               const struct spa_dict* props) {
-  if (!props)
-    return;
+namespace camera_plugin {
+
+namespace {
 
-  const char* media_class = spa_dict_lookup(props, "media.class");
-  const char* name = spa_dict_lookup(props, "node.description");
+constexpr int kDefaultWidth = 640;
+constexpr int kDefaultHeight = 480;
 
-  if (media_class && std::string(media_class) == "Video/Source") {
-    spdlog::debug("found camera: {} (id: {})", name, id);
-    cameras.push_back({id, name ? name : "Unknown"});
+/**
+ * Maps a resolution preset to the frame height it asks for, following the
+ * camera platform interface: 240p, 480p, 720p, 1080p and 2160p. max has no
+ * limit.
+ */
+uint32_t PresetHeight(const PlatformResolutionPreset preset) {
+  switch (preset) {
+    case PlatformResolutionPreset::low:
+      return 240;
+    case PlatformResolutionPreset::medium:
+      return 480;
+    case PlatformResolutionPreset::high:
+      return 720;
+    case PlatformResolutionPreset::veryHigh:
+      return 1080;
+    case PlatformResolutionPreset::ultraHigh:
+      return 2160;
+    case PlatformResolutionPreset::max:
+    default:
+      return UINT32_MAX;
   }
 }
 
-using namespace plugin_common;
+/**
+ * Size and frame rate a CameraStream is created with.
+ */
+struct CaptureMode {
+  int width = kDefaultWidth;
+  int height = kDefaultHeight;
+  uint32_t framerate_num = 30;
+  uint32_t framerate_den = 1;
+};
 
-namespace camera_plugin {
+/**
+ * Picks the capture mode for |preset| among the modes the camera advertised
+ * in the format CameraStream negotiates: the largest size not taller than the
+ * preset, else the smallest size, at the fastest rate the camera lists for
+ * it. Falls back to 640x480 at 30 fps when the camera has not been probed or
+ * lists nothing in that format.
+ */
+CaptureMode SelectCaptureMode(const std::optional<CameraInfo>& info,
+                              const PlatformResolutionPreset preset) {
+  // CameraStream calls packed YUY2 "YUV2"; capabilities use the SPA name.
+  const std::string output_format = CameraStream::OutputFormat();
+  const std::string wanted = output_format == "MJPEG" ? "MJPEG" : "YUY2";
+  const uint32_t limit = PresetHeight(preset);
+  const CameraFormat* best = nullptr;
+  const CameraFormat* smallest = nullptr;
+  if (info) {
+    for (const auto& format : info->formats) {
+      if (format.format != wanted) {
+        continue;
+      }
+      const uint64_t area =
+          static_cast<uint64_t>(format.width) * format.height;
+      if (!smallest ||
+          area < static_cast<uint64_t>(smallest->width) * smallest->height) {
+        smallest = &format;
+      }
+      if (format.height <= limit &&
+          (!best ||
+           area > static_cast<uint64_t>(best->width) * best->height)) {
+        best = &format;
+      }
+    }
+  }
+  if (!best) {
+    best = smallest;
+  }
+  CaptureMode mode;
+  if (!best) {
+    return mode;
+  }
+  mode.width = static_cast<int>(best->width);
+  mode.height = static_cast<int>(best->height);
+  // A zero rate means the camera did not list one; keep the default.
+  if (best->framerate_num != 0 && best->framerate_den != 0) {
+    mode.framerate_num = best->framerate_num;
+    mode.framerate_den = best->framerate_den;
+  }
+  return mode;
+}
+
+}  // namespace
 
 void CameraPlugin::RegisterWithRegistrar(
     flutter::PluginRegistrarDesktop* registrar) {
@@ -84,8 +150,10 @@ ErrorOr<flutter::EncodableList> CameraPlugin::GetAvailableCameras() {
   auto& mgr = CameraManager::instance();
   auto cameras = mgr.getAvailableCameras();
   for (const auto& [id, name] : cameras) {
-    spdlog::debug("[camera_plugin] detected camera:  {} (camera_id: {})", name,
-                  id);
+    const auto info = mgr.getCameraInfo(id);
+    spdlog::debug(
+        "[camera_plugin] detected camera:  {} (camera_id: {}, formats: {})",
+        name, id, info ? info->formats.size() : 0);
     list.emplace_back(std::to_string(id));
   }
   return ErrorOr<flutter::EncodableList>(std::move(list));
@@ -93,12 +161,19 @@ ErrorOr<flutter::EncodableList> CameraPlugin::GetAvailableCameras() {
 
 void CameraPlugin::Create(
     const std::string& camera_id,
-    const PlatformMediaSettings& /*settings*/,
+    const PlatformMediaSettings& settings,
     const std::function<void(ErrorOr<int64_t> reply)> result) {
   spdlog::debug("[camera_plugin] create camera_id: {}", camera_id);
   if (CameraId_CameraStream.find(camera_id) == CameraId_CameraStream.end()) {
-    auto new_camera =
-        std::make_shared<CameraStream>(registrar_, camera_id, 640, 480);
+    const auto info = CameraManager::instance().getCameraInfo(
+        static_cast<uint32_t>(std::strtoul(camera_id.c_str(), nullptr, 10)));
+    const auto mode = SelectCaptureMode(info, settings.resolution_preset());
+    spdlog::debug("[camera_plugin] camera_id {} capture mode: {}x{} @ {}/{}",
+                  camera_id, mode.width, mode.height, mode.framerate_num,
+                  mode.framerate_den);
+    auto new_camera = std::make_shared<CameraStream>(
+        registrar_, camera_id, mode.width, mode.height, mode.framerate_num,
+        mode.framerate_den);
     CameraId_CameraStream.insert({camera_id, new_camera});
     TextureId_CameraStream.insert({new_camera->texture_id(), new_camera});
   }
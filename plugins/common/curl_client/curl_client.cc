@@ -19,8 +19,8 @@
 
 #include <algorithm>
 #include <cstdint>
-#include <memory>
-#include <sstream>
+#include <filesystem>
+#include <fstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -29,77 +29,23 @@
 #include <curl/easy.h>
 
 #include "../logging.h"
+#include "http_cache.h"
 
 namespace plugin_common_curl {
 
+namespace {
+
+// Buffers are not reserved past this size, whatever Content-Length claims.
+constexpr curl_off_t kMaxReserve = 256 * 1024 * 1024;
+
+}  // namespace
+
 CurlClient::CurlClient() : mCode(CURLE_OK) {
   curl_global_init(CURL_GLOBAL_DEFAULT);
-  mErrorBuffer = std::make_unique<char[]>(CURL_ERROR_SIZE);
-  mErrorBuffer[0] = '\0';
 }
 
 CurlClient::~CurlClient() {
-  if (mConn) {
-    curl_easy_cleanup(mConn);
-  }
-
-  if (mHeadersList) {
-    curl_slist_free_all(mHeadersList);
-  }
-
   curl_global_cleanup();
-  mErrorBuffer.reset();
-}
-
-int CurlClient::StringWriter(const char* data,
-                             const size_t size,
-                             const size_t num_mem_block,
-                             std::string* writerData) {
-  if (data && writerData) {
-    writerData->append(data, size * num_mem_block);
-  }
-  return static_cast<int>(size * num_mem_block);
-}
-
-int CurlClient::VectorWriter(char* data,
-                             const size_t size,
-                             const size_t num_mem_block,
-                             std::vector<uint8_t>* writerData) {
-  if (data && writerData) {
-    auto* u_data = reinterpret_cast<uint8_t*>(data);
-    writerData->insert(writerData->end(), u_data,
-                       u_data + size * num_mem_block);
-  }
-  return static_cast<int>(size * num_mem_block);
-}
-
-size_t CurlClient::HeaderWriter(char* data,
-                                size_t size,
-                                size_t num_mem_block,
-                                std::string* writerData) {
-  if (data && writerData) {
-    writerData->append(data, size * num_mem_block);
-  }
-  return size * num_mem_block;
-}
-
-void CurlClient::ResetState() {
-  mStringBuffer.clear();
-  mVectorBuffer.clear();
-  mHeaderBuffer.clear();
-  mPostFields.clear();
-  mResponseInfo = ResponseInfo{};
-  mCode = CURLE_OK;
-
-  if (mConn) {
-    curl_easy_cleanup(mConn);
-    mConn = nullptr;
-  }
-
-  if (mHeadersList) {
-    curl_slist_free_all(mHeadersList);
-    mHeadersList = nullptr;
-  }
 }
 
 void CurlClient::SetBearerToken(const std::string& token) {
@@ -110,6 +56,10 @@ void CurlClient::SetBearerToken(const std::string& token) {
   }
 }
 
+void CurlClient::SetProgressCallback(ProgressCallback callback) {
+  mProgress = std::move(callback);
+}
+
 void CurlClient::SetTimeout(long timeout_seconds) {
   mTimeout = timeout_seconds;
 }
@@ -122,174 +72,66 @@ void CurlClient::SetMaxRedirects(long max_redirects) {
   mMaxRedirects = max_redirects;
 }
 
-bool CurlClient::SetupCommonOptions(bool verbose) {
-  if (!mConn) {
-    return false;
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_ERRORBUFFER, mErrorBuffer.get());
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set error buffer [{}]",
-                  static_cast<int>(mCode));
-    return false;
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_VERBOSE, verbose ? 1L : 0L);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set verbose mode [{}]",
-                  mErrorBuffer.get());
-    return false;
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_TIMEOUT, mTimeout);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set timeout [{}]",
-                  mErrorBuffer.get());
-    return false;
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_CONNECTTIMEOUT, mConnectionTimeout);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set connection timeout [{}]",
-                  mErrorBuffer.get());
-    return false;
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_FOLLOWLOCATION, 1L);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set follow location [{}]",
-                  mErrorBuffer.get());
-    return false;
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_MAXREDIRS, mMaxRedirects);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set max redirects [{}]",
-                  mErrorBuffer.get());
-    return false;
-  }
+bool CurlClient::Prepare(const std::string& method,
+                         const std::string& url,
+                         const std::vector<std::string>& headers,
+                         const bool follow_location) {
+  mVectorBuffer.clear();
+  mResponseInfo = ResponseInfo{};
+  mCode = CURLE_OK;
+  mInitialized = false;
 
-  mCode = curl_easy_setopt(mConn, CURLOPT_HEADERFUNCTION, HeaderWriter);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set header callback [{}]",
-                  mErrorBuffer.get());
+  // Validate URL
+  if (url.empty()) {
+    spdlog::error("[CurlClient] URL cannot be empty");
     return false;
   }
+  spdlog::trace("[CurlClient] URL: {}", url);
 
-  mCode = curl_easy_setopt(mConn, CURLOPT_HEADERDATA, &mHeaderBuffer);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set header data [{}]",
-                  mErrorBuffer.get());
-    return false;
-  }
+  mRequest = HttpRequest{};
+  mRequest.url = url;
+  mRequest.method = method;
+  mRequest.follow_location = follow_location;
+  mRequest.timeout = mTimeout;
+  mRequest.connection_timeout = mConnectionTimeout;
+  mRequest.max_redirects = mMaxRedirects;
+  mRequest.on_progress = mProgress;
 
-  mCode = curl_easy_setopt(mConn, CURLOPT_SSL_VERIFYPEER, 1L);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set SSL verify peer [{}]",
-                  mErrorBuffer.get());
-    return false;
+  if (!mAuthHeader.empty()) {
+    mRequest.headers.push_back(mAuthHeader);
   }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_SSL_VERIFYHOST, 2L);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set SSL verify host [{}]",
-                  mErrorBuffer.get());
-    return false;
+  for (const auto& header : headers) {
+    spdlog::trace("[CurlClient] Header: {}", header);
+    mRequest.headers.push_back(header);
   }
-
+  mInitialized = true;
   return true;
 }
 
-void CurlClient::ExtractResponseInfo() {
-  if (!mConn)
-    return;
-
-  curl_easy_getinfo(mConn, CURLINFO_RESPONSE_CODE, &mResponseInfo.http_code);
-  curl_easy_getinfo(mConn, CURLINFO_TOTAL_TIME, &mResponseInfo.total_time);
-
-#if LIBCURL_VERSION_NUM >= 0x073700  // 7.55.0
-  curl_easy_getinfo(mConn, CURLINFO_SIZE_DOWNLOAD_T,
-                    &mResponseInfo.download_size);
-  curl_easy_getinfo(mConn, CURLINFO_SIZE_UPLOAD_T, &mResponseInfo.upload_size);
-#else
-  curl_easy_getinfo(mConn, CURLINFO_SIZE_DOWNLOAD,
-                    &mResponseInfo.download_size);
-  curl_easy_getinfo(mConn, CURLINFO_SIZE_UPLOAD, &mResponseInfo.upload_size);
-#endif
-
-  curl_easy_getinfo(mConn, CURLINFO_REDIRECT_COUNT,
-                    &mResponseInfo.redirect_count);
-
-  char* effective_url = nullptr;
-  curl_easy_getinfo(mConn, CURLINFO_EFFECTIVE_URL, &effective_url);
-  if (effective_url) {
-    mResponseInfo.effective_url = effective_url;
-  }
-
-  char* content_type = nullptr;
-  curl_easy_getinfo(mConn, CURLINFO_CONTENT_TYPE, &content_type);
-  if (content_type) {
-    mResponseInfo.content_type = content_type;
-  }
-
-  ParseHeaders();
-}
-
-void CurlClient::ParseHeaders() {
-  mResponseInfo.headers.clear();
-
-  if (mHeaderBuffer.empty())
-    return;
-
-  std::istringstream stream(mHeaderBuffer);
-  std::string line;
-
-  while (std::getline(stream, line)) {
-    if (!line.empty() && line.back() == '\r') {
-      line.pop_back();
-    }
-
-    if (line.empty() || line.find("HTTP/") == 0) {
-      continue;
-    }
-
-    size_t colon_pos = line.find(':');
-    if (colon_pos != std::string::npos) {
-      std::string key = line.substr(0, colon_pos);
-      std::string value = line.substr(colon_pos + 1);
-
-      key.erase(0, key.find_first_not_of(" \t"));
-      key.erase(key.find_last_not_of(" \t") + 1);
-      value.erase(0, value.find_first_not_of(" \t"));
-      value.erase(value.find_last_not_of(" \t") + 1);
-
-      if (!key.empty()) {
-        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
-        mResponseInfo.headers[key] = value;
-      }
-    }
-  }
-}
-
-bool CurlClient::PerformRequest(bool /* verbose */) {
-  if (!mConn)
-    return false;
-
-  mCode = curl_easy_perform(mConn);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to perform request: {} [{}]",
-                  curl_easy_strerror(mCode), mErrorBuffer.get());
-    return false;
-  }
-
-  // Extract response information
-  ExtractResponseInfo();
-
-  spdlog::debug("[CurlClient] Request completed - HTTP {}, {} bytes in {:.2f}s",
-                mResponseInfo.http_code, mResponseInfo.download_size,
-                mResponseInfo.total_time);
-
-  return true;
+HttpResponse CurlClient::PerformRequest(const bool verbose,
+                                        DataCallback on_data,
+                                        BodyStartCallback on_body_start) {
+  auto request = mRequest;
+  request.verbose = mRequest.verbose || verbose;
+  request.on_data = std::move(on_data);
+  request.on_body_start = std::move(on_body_start);
+  auto& client = CurlMultiClient::GetShared();
+  auto response =
+      mCache ? mCache->Fetch(std::move(request),
+                             [&client](HttpRequest network_request) {
+                               return client.Perform(
+                                   std::move(network_request));
+                             })
+             : client.Perform(std::move(request));
+  mCode = response.code;
+  mResponseInfo = std::move(response.info);
+  if (mCode == CURLE_OK) {
+    spdlog::debug(
+        "[CurlClient] Request completed - HTTP {}, {} bytes in {:.2f}s",
+        mResponseInfo.http_code, mResponseInfo.download_size,
+        mResponseInfo.total_time);
+  }
+  return response;
 }
 
 bool CurlClient::Init(
@@ -298,86 +140,33 @@ bool CurlClient::Init(
     const std::vector<std::pair<std::string, std::string>>& url_form,
     const bool follow_location,
     const bool verbose) {
-  // Validate URL
-  if (url.empty()) {
-    spdlog::error("[CurlClient] URL cannot be empty");
-    return false;
-  }
-
-  ResetState();
-
-  mConn = curl_easy_init();
-  if (mConn == nullptr) {
-    spdlog::error("[CurlClient] Failed to create CURL connection");
-    return false;
-  }
-
-  mUrl = url;
-  spdlog::trace("[CurlClient] URL: {}", mUrl);
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_URL, mUrl.c_str());
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set URL [{}]", mErrorBuffer.get());
-    return false;
-  }
-
-  if (!SetupCommonOptions(false)) {
+  if (!Prepare(url_form.empty() ? "GET" : "POST", url, headers,
+               follow_location)) {
     return false;
   }
+  mRequest.verbose = verbose;
 
   if (!url_form.empty()) {
+    std::string post_fields;
     for (const auto& [key, value] : url_form) {
-      if (!mPostFields.empty()) {
-        mPostFields += "&";
+      if (!post_fields.empty()) {
+        post_fields += "&";
       }
-      char* encoded_key =
-          curl_easy_escape(mConn, key.c_str(), static_cast<int>(key.length()));
-      char* encoded_value = curl_easy_escape(mConn, value.c_str(),
-                                             static_cast<int>(value.length()));
+      char* encoded_key = curl_easy_escape(nullptr, key.c_str(),
+                                           static_cast<int>(key.length()));
+      char* encoded_value = curl_easy_escape(
+          nullptr, value.c_str(), static_cast<int>(value.length()));
       if (encoded_key && encoded_value) {
-        mPostFields += encoded_key;
-        mPostFields += "=";
-        mPostFields += encoded_value;
+        post_fields += encoded_key;
+        post_fields += "=";
+        post_fields += encoded_value;
       }
       curl_free(encoded_key);
       curl_free(encoded_value);
     }
-    spdlog::trace("[CurlClient] PostFields: {}", mPostFields);
-    curl_easy_setopt(mConn, CURLOPT_POSTFIELDSIZE, mPostFields.length());
-    // libcurl does not copy
-    curl_easy_setopt(mConn, CURLOPT_POSTFIELDS, mPostFields.c_str());
+    spdlog::trace("[CurlClient] PostFields: {}", post_fields);
+    mRequest.body = std::move(post_fields);
   }
-
-  if (!mAuthHeader.empty()) {
-    mHeadersList = curl_slist_append(mHeadersList, mAuthHeader.c_str());
-  }
-  for (const auto& header : headers) {
-    spdlog::trace("[CurlClient] Header: {}", header);
-    mHeadersList = curl_slist_append(mHeadersList, header.c_str());
-  }
-  if (mHeadersList) {
-    mCode = curl_easy_setopt(mConn, CURLOPT_HTTPHEADER, mHeadersList);
-    if (mCode != CURLE_OK) {
-      spdlog::error("[CurlClient] Failed to set headers option [{}]",
-                    mErrorBuffer.get());
-      return false;
-    }
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_FOLLOWLOCATION,
-                           follow_location ? 1L : 0L);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set redirect option [{}]",
-                  mErrorBuffer.get());
-    return false;
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_VERBOSE, verbose ? 1L : 0L);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set verbose", mErrorBuffer.get());
-    return false;
-  }
-
   return true;
 }
 
@@ -395,6 +184,8 @@ std::string CurlClient::Post(
     const std::vector<std::pair<std::string, std::string>>& form_data,
     const std::vector<std::string>& additional_headers) {
   if (Init(url, additional_headers, form_data)) {
+    // An empty form is still posted.
+    mRequest.method = "POST";
     return RetrieveContentAsString();
   }
   return "";
@@ -404,189 +195,150 @@ std::string CurlClient::Put(
     const std::string& url,
     const std::string& data,
     const std::vector<std::string>& additional_headers) {
-  if (url.empty()) {
-    spdlog::error("[CurlClient] URL cannot be empty");
-    return "";
-  }
-
-  ResetState();
-
-  mConn = curl_easy_init();
-  if (!mConn) {
-    spdlog::error("[CurlClient] Failed to create CURL connection");
+  if (!Prepare("PUT", url, additional_headers, true)) {
     return "";
   }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_URL, url.c_str());
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set URL [{}]", mErrorBuffer.get());
-    return "";
-  }
-
-  if (!SetupCommonOptions(false)) {
-    return "";
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_CUSTOMREQUEST, "PUT");
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set PUT method [{}]",
-                  mErrorBuffer.get());
-    return "";
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_POSTFIELDS, data.c_str());
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set PUT data [{}]",
-                  mErrorBuffer.get());
-    return "";
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_POSTFIELDSIZE, data.length());
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set PUT data size [{}]",
-                  mErrorBuffer.get());
-    return "";
-  }
-
-  if (!mAuthHeader.empty()) {
-    mHeadersList = curl_slist_append(mHeadersList, mAuthHeader.c_str());
-  }
-  for (const auto& header : additional_headers) {
-    mHeadersList = curl_slist_append(mHeadersList, header.c_str());
-  }
-  if (mHeadersList) {
-    mCode = curl_easy_setopt(mConn, CURLOPT_HTTPHEADER, mHeadersList);
-    if (mCode != CURLE_OK) {
-      spdlog::error("[CurlClient] Failed to set headers [{}]",
-                    mErrorBuffer.get());
-      return "";
-    }
-  }
-
+  mRequest.body = data;
   return RetrieveContentAsString();
 }
 
 std::string CurlClient::Delete(
     const std::string& url,
     const std::vector<std::string>& additional_headers) {
-  if (url.empty()) {
-    spdlog::error("[CurlClient] URL cannot be empty");
-    return "";
-  }
-
-  ResetState();
-
-  mConn = curl_easy_init();
-  if (!mConn) {
-    spdlog::error("[CurlClient] Failed to create CURL connection");
+  if (!Prepare("DELETE", url, additional_headers, true)) {
     return "";
   }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_URL, url.c_str());
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set URL [{}]", mErrorBuffer.get());
-    return "";
-  }
-
-  if (!SetupCommonOptions(false)) {
-    return "";
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_CUSTOMREQUEST, "DELETE");
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set DELETE method [{}]",
-                  mErrorBuffer.get());
-    return "";
-  }
-
-  if (!mAuthHeader.empty()) {
-    mHeadersList = curl_slist_append(mHeadersList, mAuthHeader.c_str());
-  }
-  for (const auto& header : additional_headers) {
-    mHeadersList = curl_slist_append(mHeadersList, header.c_str());
-  }
-  if (mHeadersList) {
-    mCode = curl_easy_setopt(mConn, CURLOPT_HTTPHEADER, mHeadersList);
-    if (mCode != CURLE_OK) {
-      spdlog::error("[CurlClient] Failed to set headers [{}]",
-                    mErrorBuffer.get());
-      return "";
-    }
-  }
-
   return RetrieveContentAsString();
 }
 
 std::string CurlClient::RetrieveContentAsString(const bool verbose) {
-  if (mConn == nullptr) {
+  if (!mInitialized) {
     spdlog::error("[CurlClient] No connection available");
     return "";
   }
 
-  mCode = curl_easy_setopt(mConn, CURLOPT_VERBOSE, verbose ? 1L : 0L);
+  auto response = PerformRequest(verbose);
   if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set 'CURLOPT_VERBOSE' [{}]",
-                  mErrorBuffer.get());
     return "";
   }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_WRITEFUNCTION, StringWriter);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set writer [{}]", mErrorBuffer.get());
-    return "";
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_WRITEDATA, &mStringBuffer);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set write data [{}]",
-                  mErrorBuffer.get());
-    return "";
-  }
-
-  if (!PerformRequest(verbose)) {
-    return "";
-  }
-  return mStringBuffer;
+  return std::move(response.body);
 }
 
 const std::vector<uint8_t>& CurlClient::RetrieveContentAsVector(
     const bool verbose) {
-  if (mConn == nullptr) {
+  mVectorBuffer.clear();
+  if (!mInitialized) {
     spdlog::error("[CurlClient] No connection available");
-    mVectorBuffer.clear();
-    return mVectorBuffer;
-  }
-
-  mCode = curl_easy_setopt(mConn, CURLOPT_VERBOSE, verbose ? 1L : 0L);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set 'CURLOPT_VERBOSE' [{}]",
-                  mErrorBuffer.get());
-    mVectorBuffer.clear();
     return mVectorBuffer;
   }
 
-  mCode = curl_easy_setopt(mConn, CURLOPT_WRITEFUNCTION, VectorWriter);
+  // Written in place, so the body is never held twice.
+  PerformRequest(
+      verbose,
+      [this](const char* data, const size_t size) {
+        mVectorBuffer.insert(mVectorBuffer.end(), data, data + size);
+        return true;
+      },
+      [this](long /* http_code */, const curl_off_t content_length) {
+        if (content_length > 0) {
+          mVectorBuffer.reserve(
+              static_cast<size_t>(std::min(content_length, kMaxReserve)));
+        }
+        return true;
+      });
   if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set writer [{}]", mErrorBuffer.get());
     mVectorBuffer.clear();
-    return mVectorBuffer;
   }
+  return mVectorBuffer;
+}
 
-  mCode = curl_easy_setopt(mConn, CURLOPT_WRITEDATA, &mVectorBuffer);
-  if (mCode != CURLE_OK) {
-    spdlog::error("[CurlClient] Failed to set write data [{}]",
-                  mErrorBuffer.get());
-    mVectorBuffer.clear();
-    return mVectorBuffer;
+bool CurlClient::RetrieveContentStreaming(const DataCallback& on_data,
+                                          const bool verbose) {
+  if (!mInitialized) {
+    spdlog::error("[CurlClient] No connection available");
+    return false;
   }
 
-  mVectorBuffer.clear();
+  PerformRequest(verbose, on_data);
+  return IsSuccess();
+}
 
-  if (!PerformRequest(verbose)) {
-    mVectorBuffer.clear();
-    return mVectorBuffer;
+bool CurlClient::DownloadToFile(
+    const std::string& url,
+    const std::string& path,
+    const bool resume,
+    const std::vector<std::string>& additional_headers) {
+  if (path.empty()) {
+    spdlog::error("[CurlClient] Download path cannot be empty");
+    return false;
+  }
+  if (!Prepare("GET", url, additional_headers, true)) {
+    return false;
   }
 
-  return mVectorBuffer;
+  const std::string part_path = path + ".part";
+  std::error_code error;
+  std::uintmax_t offset = 0;
+  if (resume) {
+    offset = std::filesystem::file_size(part_path, error);
+    if (error) {
+      offset = 0;
+    }
+  }
+  if (offset > 0) {
+    mRequest.range = std::to_string(offset) + "-";
+  }
+
+  std::ofstream file;
+  PerformRequest(
+      false,
+      [&file](const char* data, const size_t size) {
+        if (!file.is_open()) {
+          // Error pages are not written.
+          return true;
+        }
+        file.write(data, static_cast<std::streamsize>(size));
+        return file.good();
+      },
+      [&file, &part_path, offset](const long http_code,
+                                  curl_off_t /* content_length */) {
+        if (http_code < 200 || http_code >= 300) {
+          return true;
+        }
+        // Anything but 206 Partial Content is the whole resource.
+        const auto mode =
+            http_code == 206 && offset > 0 ? std::ios::app : std::ios::trunc;
+        file.open(part_path, std::ios::binary | std::ios::out | mode);
+        if (!file.is_open()) {
+          spdlog::error("[CurlClient] Failed to open {}", part_path);
+        }
+        return file.is_open();
+      });
+
+  if (GetHttpCode() == 416 && offset > 0) {
+    // The partial file is not a prefix of the resource any more.
+    spdlog::debug("[CurlClient] Restarting download of {}", url);
+    return DownloadToFile(url, path, false, additional_headers);
+  }
+  if (!IsSuccess()) {
+    // A partial file is kept for a later resume.
+    return false;
+  }
+  if (!file.is_open()) {
+    // The body was empty.
+    file.open(part_path, std::ios::binary | std::ios::out | std::ios::trunc);
+  }
+  file.close();
+  if (file.fail()) {
+    spdlog::error("[CurlClient] Failed to write {}", part_path);
+    return false;
+  }
+  std::filesystem::rename(part_path, path, error);
+  if (error) {
+    spdlog::error("[CurlClient] Failed to move {} to {}: {}", part_path, path,
+                  error.message());
+    return false;
+  }
+  return true;
 }
-}  // namespace plugin_common_curl
\ No newline at end of file
+}  // namespace plugin_common_curl
@@ -28,24 +28,21 @@
 
 #include <curl/curl.h>
 
+#include "curl_multi_client.h"
+
 namespace plugin_common_curl {
 
-struct ResponseInfo {
-  long http_code = 0;
-  double total_time = 0.0;
-#if LIBCURL_VERSION_NUM >= 0x073700  // 7.55.0
-  curl_off_t download_size = 0;
-  curl_off_t upload_size = 0;
-#else
-  double download_size = 0.0;
-  double upload_size = 0.0;
-#endif
-  long redirect_count = 0;
-  std::string effective_url;
-  std::string content_type;
-  std::map<std::string, std::string> headers;
-};
+class HttpCache;
 
+/**
+ * @brief Blocking HTTP client for one request at a time.
+ *
+ * Requests are sent through the shared CurlMultiClient, so connections, DNS
+ * lookups and TLS sessions are reused across CurlClient instances and
+ * plugins; a new CurlClient per request is cheap. An instance is not safe
+ * for concurrent use. GET requests can be answered from a persistent
+ * HttpCache, see SetCache().
+ */
 class CurlClient {
  public:
   CurlClient();
@@ -89,6 +86,35 @@ class CurlClient {
    */
   const std::vector<uint8_t>& RetrieveContentAsVector(bool verbose = false);
 
+  /**
+   * @brief Function to execute http client, streaming the body
+   * @param on_data receives the body chunk by chunk on the client thread;
+   * returning false aborts the request
+   * @param verbose flag to enable stderr output of curl dialog
+   * @return bool
+   * @retval true if the request succeeded, see IsSuccess()
+   */
+  bool RetrieveContentStreaming(const DataCallback& on_data,
+                                bool verbose = false);
+
+  /**
+   * @brief Downloads a resource to a file without holding it in memory.
+   *
+   * The body is written to |path| with ".part" appended and renamed to
+   * |path| once complete, so |path| never holds a partial download.
+   * @param url The URL to download
+   * @param path Destination file
+   * @param resume Continues an existing partial file with a range request;
+   * a server ignoring the range sends the whole body, which replaces it
+   * @param additional_headers A vector of additional headers to send
+   * @return bool
+   * @retval true if the file was downloaded
+   */
+  bool DownloadToFile(const std::string& url,
+                      const std::string& path,
+                      bool resume = false,
+                      const std::vector<std::string>& additional_headers = {});
+
   /**
    * @brief Function to return last curl response code
    * @return CURLcode
@@ -175,6 +201,22 @@ class CurlClient {
    */
   void SetMaxRedirects(long max_redirects);
 
+  /**
+   * @brief Set a callback reporting the download progress of later requests
+   * @param callback Called on the client thread; returning false aborts the
+   * request. Empty to remove it
+   */
+  void SetProgressCallback(ProgressCallback callback);
+
+  /**
+   * @brief Answers later requests from |cache| where HTTP caching allows,
+   * storing their responses in it
+   * @param cache The cache, e.g. HttpCache::GetShared(), which must outlive
+   * the client; nullptr to stop caching. Requests with a bearer token, a
+   * body or a range are never cached
+   */
+  void SetCache(HttpCache* cache) { mCache = cache; }
+
   /**
    * @brief Function sets the bearer token for the OAuth 2.0 authentication.
    * @param token The authentication token.
@@ -229,86 +271,42 @@ class CurlClient {
   CurlClient& operator=(CurlClient const&) = delete;
 
  private:
-  CURL* mConn{};
-  struct curl_slist* mHeadersList{};
+  HttpRequest mRequest;
+  bool mInitialized = false;
   CURLcode mCode;
-  std::string mUrl;
   std::string mAuthHeader;
-  std::string mPostFields;
-  std::unique_ptr<char[]> mErrorBuffer;
-  std::string mStringBuffer;
+  ProgressCallback mProgress;
+  HttpCache* mCache = nullptr;
   std::vector<uint8_t> mVectorBuffer;
   ResponseInfo mResponseInfo;
-  std::string mHeaderBuffer;
 
   long mTimeout{30};
   long mConnectionTimeout{10};
   long mMaxRedirects{5};
 
   /**
-   * @brief Callback function for curl client
-   * @param data buffer of response
-   * @param size length of buffer
-   * @param num_mem_block number of memory blocks
-   * @param writerData user pointer
-   * @return int
-   * @retval returns back to curl size of write
-   * @relation
-   * google_sign_in
-   */
-  static int StringWriter(const char* data,
-                          size_t size,
-                          size_t num_mem_block,
-                          std::string* writerData);
-
-  /**
-   * @brief Callback function for curl client
-   * @param data buffer of response
-   * @param size length of buffer
-   * @param num_mem_block number of memory blocks
-   * @param writerData user pointer
-   * @return int
-   * @retval returns back to curl size of write
-   * @relation
-   * google_sign_in
-   */
-  static int VectorWriter(char* data,
-                          size_t size,
-                          size_t num_mem_block,
-                          std::vector<uint8_t>* writerData);
-
-  /**
-   * @brief Callback function for curl client header content
-   */
-  static size_t HeaderWriter(char* data,
-                             size_t size,
-                             size_t num_mem_block,
-                             std::string* writerData);
-
-  /**
-   * @brief Internal function to setup common curl options
-   */
-  bool SetupCommonOptions(bool verbose);
-
-  /**
-   * @brief Internal function to extract response information after request
-   */
-  void ExtractResponseInfo();
-
-  /**
-   * @brief Internal function to parse response headers
-   */
-  void ParseHeaders();
-
-  /**
-   * @brief Internal function to reset buffers and state
+   * @brief Internal function to reset buffers and state and prepare the
+   * next request
+   * @return bool
+   * @retval true if the request is valid, false if the URL is empty
    */
-  void ResetState();
+  bool Prepare(const std::string& method,
+               const std::string& url,
+               const std::vector<std::string>& headers,
+               bool follow_location);
 
   /**
-   * @brief Internal function to perform the actual HTTP request
+   * @brief Internal function to perform the prepared request on the shared
+   * client
+   * @param verbose flag to enable stderr output of curl dialog
+   * @param on_data body sink, or empty to collect the body in the response
+   * @param on_body_start called before the first chunk of the body
+   * @return HttpResponse
+   * @retval the response; its body is moved out by the caller
    */
-  bool PerformRequest(bool verbose);
+  HttpResponse PerformRequest(bool verbose,
+                              DataCallback on_data = {},
+                              BodyStartCallback on_body_start = {});
 };
 }  // namespace plugin_common_curl
 
@@ -0,0 +1,507 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "curl_multi_client.h"
+
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+#include "../logging.h"
+
+namespace plugin_common_curl {
+
+namespace {
+
+size_t AppendToString(char* data,
+                      const size_t size,
+                      const size_t num_mem_block,
+                      void* user_data) {
+  static_cast<std::string*>(user_data)->append(data, size * num_mem_block);
+  return size * num_mem_block;
+}
+
+// Bodies are not reserved past this size, whatever Content-Length claims.
+constexpr curl_off_t kMaxReserve = 256 * 1024 * 1024;
+
+}  // namespace
+
+struct CurlMultiClient::Transfer {
+  HttpRequest request;
+  Callback callback;
+  CURL* handle = nullptr;
+  curl_slist* headers = nullptr;
+  std::string raw_headers;
+  bool body_started = false;
+  HttpResponse response;
+  char error[CURL_ERROR_SIZE] = {};
+
+  Transfer() = default;
+  Transfer(const Transfer&) = delete;
+  Transfer& operator=(const Transfer&) = delete;
+
+  ~Transfer() {
+    if (headers) {
+      curl_slist_free_all(headers);
+    }
+  }
+
+  void Complete(CURL* easy, const CURLcode code) {
+    response.code = code;
+    if (code != CURLE_OK) {
+      response.error = error[0] != '\0' ? error : curl_easy_strerror(code);
+      spdlog::error("[CurlMultiClient] Failed to perform request: {} [{}]",
+                    request.url, response.error);
+    }
+    if (easy) {
+      ReadResponseInfo(easy, raw_headers, response.info);
+    }
+  }
+
+  static size_t WriteBody(char* data,
+                          const size_t size,
+                          const size_t num_mem_block,
+                          void* user_data) {
+    auto* transfer = static_cast<Transfer*>(user_data);
+    const size_t length = size * num_mem_block;
+    if (!transfer->body_started && !transfer->StartBody()) {
+      return 0;
+    }
+    if (transfer->request.on_data) {
+      return transfer->request.on_data(data, length) ? length : 0;
+    }
+    transfer->response.body.append(data, length);
+    return length;
+  }
+
+  static int Progress(void* user_data,
+                      const curl_off_t download_total,
+                      const curl_off_t downloaded,
+                      curl_off_t /* upload_total */,
+                      curl_off_t /* uploaded */) {
+    const auto* transfer = static_cast<Transfer*>(user_data);
+    return transfer->request.on_progress(downloaded, download_total) ? 0 : 1;
+  }
+
+  bool StartBody() {
+    body_started = true;
+    long http_code = 0;
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &http_code);
+    curl_off_t content_length = -1;
+#if LIBCURL_VERSION_NUM >= 0x073700  // 7.55.0
+    curl_easy_getinfo(handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+                      &content_length);
+#else
+    double length = -1;
+    curl_easy_getinfo(handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &length);
+    content_length = static_cast<curl_off_t>(length);
+#endif
+    if (request.on_body_start &&
+        !request.on_body_start(http_code, content_length)) {
+      return false;
+    }
+    if (!request.on_data && content_length > 0) {
+      response.body.reserve(
+          static_cast<size_t>(std::min(content_length, kMaxReserve)));
+    }
+    return true;
+  }
+
+  void Notify() {
+    try {
+      callback(std::move(response));
+    } catch (const std::exception& e) {
+      spdlog::error("[CurlMultiClient] Request callback failed: {}", e.what());
+    }
+  }
+};
+
+void ReadResponseInfo(CURL* handle,
+                      const std::string& raw_headers,
+                      ResponseInfo& info) {
+  curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &info.http_code);
+  curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME, &info.total_time);
+
+#if LIBCURL_VERSION_NUM >= 0x073700  // 7.55.0
+  curl_easy_getinfo(handle, CURLINFO_SIZE_DOWNLOAD_T, &info.download_size);
+  curl_easy_getinfo(handle, CURLINFO_SIZE_UPLOAD_T, &info.upload_size);
+#else
+  curl_easy_getinfo(handle, CURLINFO_SIZE_DOWNLOAD, &info.download_size);
+  curl_easy_getinfo(handle, CURLINFO_SIZE_UPLOAD, &info.upload_size);
+#endif
+
+  curl_easy_getinfo(handle, CURLINFO_REDIRECT_COUNT, &info.redirect_count);
+
+  char* effective_url = nullptr;
+  curl_easy_getinfo(handle, CURLINFO_EFFECTIVE_URL, &effective_url);
+  if (effective_url) {
+    info.effective_url = effective_url;
+  }
+
+  char* content_type = nullptr;
+  curl_easy_getinfo(handle, CURLINFO_CONTENT_TYPE, &content_type);
+  if (content_type) {
+    info.content_type = content_type;
+  }
+
+  info.headers.clear();
+  std::istringstream stream(raw_headers);
+  std::string line;
+
+  while (std::getline(stream, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+
+    if (line.empty() || line.find("HTTP/") == 0) {
+      continue;
+    }
+
+    size_t colon_pos = line.find(':');
+    if (colon_pos != std::string::npos) {
+      std::string key = line.substr(0, colon_pos);
+      std::string value = line.substr(colon_pos + 1);
+
+      key.erase(0, key.find_first_not_of(" \t"));
+      key.erase(key.find_last_not_of(" \t") + 1);
+      value.erase(0, value.find_first_not_of(" \t"));
+      value.erase(value.find_last_not_of(" \t") + 1);
+
+      if (!key.empty()) {
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+        info.headers[key] = value;
+      }
+    }
+  }
+}
+
+CurlMultiClient& CurlMultiClient::GetShared() {
+  static CurlMultiClient client;
+  return client;
+}
+
+CurlMultiClient::CurlMultiClient(const Options& options) : mOptions(options) {
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+
+  mShare = curl_share_init();
+  if (mShare) {
+    curl_share_setopt(mShare, CURLSHOPT_LOCKFUNC, LockShare);
+    curl_share_setopt(mShare, CURLSHOPT_UNLOCKFUNC, UnlockShare);
+    curl_share_setopt(mShare, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(mShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(mShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    if (mOptions.share_cookies) {
+      curl_share_setopt(mShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
+    }
+  } else {
+    spdlog::error("[CurlMultiClient] Failed to create share handle");
+  }
+
+  mMulti = curl_multi_init();
+  if (mMulti) {
+    curl_multi_setopt(mMulti, CURLMOPT_MAX_HOST_CONNECTIONS,
+                      mOptions.max_host_connections);
+    curl_multi_setopt(mMulti, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                      mOptions.max_total_connections);
+    curl_multi_setopt(mMulti, CURLMOPT_MAXCONNECTS,
+                      mOptions.max_cached_connections);
+    curl_multi_setopt(
+        mMulti, CURLMOPT_PIPELINING,
+        mOptions.multiplex ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+    mThread = std::thread(&CurlMultiClient::Run, this);
+  } else {
+    // Requests fail right away.
+    spdlog::error("[CurlMultiClient] Failed to create multi handle");
+  }
+}
+
+CurlMultiClient::~CurlMultiClient() {
+  {
+    std::lock_guard lock(mMutex);
+    mStop = true;
+  }
+  Wakeup();
+  if (mThread.joinable()) {
+    mThread.join();
+  }
+
+  for (CURL* handle : mIdleHandles) {
+    curl_easy_cleanup(handle);
+  }
+  if (mMulti) {
+    curl_multi_cleanup(mMulti);
+  }
+  if (mShare) {
+    curl_share_cleanup(mShare);
+  }
+  curl_global_cleanup();
+}
+
+void CurlMultiClient::Send(HttpRequest request, Callback callback) {
+  auto transfer = std::make_unique<Transfer>();
+  transfer->request = std::move(request);
+  transfer->callback = std::move(callback);
+  {
+    std::lock_guard lock(mMutex);
+    if (!mStop && mMulti) {
+      mQueued.push_back(std::move(transfer));
+    }
+  }
+  if (transfer) {
+    transfer->Complete(nullptr, CURLE_ABORTED_BY_CALLBACK);
+    transfer->Notify();
+    return;
+  }
+  Wakeup();
+}
+
+std::future<HttpResponse> CurlMultiClient::Send(HttpRequest request) {
+  auto promise = std::make_shared<std::promise<HttpResponse>>();
+  auto future = promise->get_future();
+  Send(std::move(request), [promise](HttpResponse response) {
+    promise->set_value(std::move(response));
+  });
+  return future;
+}
+
+HttpResponse CurlMultiClient::Perform(HttpRequest request) {
+  if (!RunsOnClientThread()) {
+    return Send(std::move(request)).get();
+  }
+
+  // Waiting for the client thread from itself would never return.
+  Transfer transfer;
+  transfer.request = std::move(request);
+  CURL* handle = AcquireHandle();
+  if (!handle) {
+    transfer.Complete(nullptr, CURLE_FAILED_INIT);
+    return std::move(transfer.response);
+  }
+  CURLcode code = Configure(handle, transfer);
+  if (code == CURLE_OK) {
+    code = curl_easy_perform(handle);
+  }
+  transfer.Complete(handle, code);
+  ReleaseHandle(handle);
+  return std::move(transfer.response);
+}
+
+bool CurlMultiClient::RunsOnClientThread() const {
+  return std::this_thread::get_id() == mThread.get_id();
+}
+
+void CurlMultiClient::Run() {
+  while (true) {
+    {
+      std::lock_guard lock(mMutex);
+      if (mStop) {
+        break;
+      }
+    }
+    StartQueued();
+
+    int running = 0;
+    curl_multi_perform(mMulti, &running);
+
+    int remaining = 0;
+    while (CURLMsg* message = curl_multi_info_read(mMulti, &remaining)) {
+      if (message->msg == CURLMSG_DONE) {
+        Finish(message->easy_handle, message->data.result);
+      }
+    }
+
+#if LIBCURL_VERSION_NUM >= 0x074400  // 7.68.0
+    curl_multi_poll(mMulti, nullptr, 0, 1000, nullptr);
+#else
+    // Without curl_multi_wakeup() new requests are picked up on the next
+    // timeout.
+    curl_multi_wait(mMulti, nullptr, 0, 50, nullptr);
+#endif
+  }
+
+  std::deque<std::unique_ptr<Transfer>> queued;
+  {
+    std::lock_guard lock(mMutex);
+    queued.swap(mQueued);
+  }
+  for (auto& transfer : queued) {
+    transfer->Complete(nullptr, CURLE_ABORTED_BY_CALLBACK);
+    transfer->Notify();
+  }
+  while (!mActive.empty()) {
+    Finish(mActive.begin()->first, CURLE_ABORTED_BY_CALLBACK);
+  }
+}
+
+void CurlMultiClient::StartQueued() {
+  std::deque<std::unique_ptr<Transfer>> queued;
+  {
+    std::lock_guard lock(mMutex);
+    queued.swap(mQueued);
+  }
+
+  for (auto& transfer : queued) {
+    CURL* handle = AcquireHandle();
+    if (!handle) {
+      transfer->Complete(nullptr, CURLE_FAILED_INIT);
+      transfer->Notify();
+      continue;
+    }
+    CURLcode code = Configure(handle, *transfer);
+    if (code == CURLE_OK &&
+        curl_multi_add_handle(mMulti, handle) != CURLM_OK) {
+      code = CURLE_FAILED_INIT;
+    }
+    if (code != CURLE_OK) {
+      transfer->Complete(nullptr, code);
+      ReleaseHandle(handle);
+      transfer->Notify();
+      continue;
+    }
+    mActive.emplace(handle, std::move(transfer));
+  }
+}
+
+void CurlMultiClient::Finish(CURL* handle, const CURLcode code) {
+  curl_multi_remove_handle(mMulti, handle);
+  const auto it = mActive.find(handle);
+  if (it == mActive.end()) {
+    return;
+  }
+  const auto transfer = std::move(it->second);
+  mActive.erase(it);
+
+  transfer->Complete(handle, code);
+  ReleaseHandle(handle);
+  transfer->Notify();
+}
+
+CURL* CurlMultiClient::AcquireHandle() {
+  if (!mIdleHandles.empty()) {
+    CURL* handle = mIdleHandles.back();
+    mIdleHandles.pop_back();
+    return handle;
+  }
+  CURL* handle = curl_easy_init();
+  if (!handle) {
+    spdlog::error("[CurlMultiClient] Failed to create CURL handle");
+  }
+  return handle;
+}
+
+void CurlMultiClient::ReleaseHandle(CURL* handle) {
+  curl_easy_reset(handle);
+  if (mIdleHandles.size() <
+      static_cast<size_t>(std::max(mOptions.max_cached_connections, 1L))) {
+    mIdleHandles.push_back(handle);
+  } else {
+    curl_easy_cleanup(handle);
+  }
+}
+
+CURLcode CurlMultiClient::Configure(CURL* handle, Transfer& transfer) const {
+  const auto& request = transfer.request;
+  transfer.handle = handle;
+  for (const auto& header : request.headers) {
+    transfer.headers = curl_slist_append(transfer.headers, header.c_str());
+  }
+
+  CURLcode code = CURLE_OK;
+  const auto set = [handle, &code](const CURLoption option, auto value) {
+    if (code == CURLE_OK) {
+      code = curl_easy_setopt(handle, option, value);
+    }
+  };
+  set(CURLOPT_URL, request.url.c_str());
+  set(CURLOPT_ERRORBUFFER, transfer.error);
+  set(CURLOPT_VERBOSE, request.verbose ? 1L : 0L);
+  set(CURLOPT_NOSIGNAL, 1L);
+  set(CURLOPT_TIMEOUT, request.timeout);
+  set(CURLOPT_CONNECTTIMEOUT, request.connection_timeout);
+  set(CURLOPT_FOLLOWLOCATION, request.follow_location ? 1L : 0L);
+  set(CURLOPT_MAXREDIRS, request.max_redirects);
+  set(CURLOPT_SSL_VERIFYPEER, 1L);
+  set(CURLOPT_SSL_VERIFYHOST, 2L);
+  set(CURLOPT_TCP_KEEPALIVE, 1L);
+  set(CURLOPT_HEADERFUNCTION, AppendToString);
+  set(CURLOPT_HEADERDATA, &transfer.raw_headers);
+  set(CURLOPT_WRITEFUNCTION, Transfer::WriteBody);
+  set(CURLOPT_WRITEDATA, &transfer);
+  if (!request.range.empty()) {
+    set(CURLOPT_RANGE, request.range.c_str());
+  }
+  if (request.on_progress) {
+    set(CURLOPT_XFERINFOFUNCTION, Transfer::Progress);
+    set(CURLOPT_XFERINFODATA, &transfer);
+    set(CURLOPT_NOPROGRESS, 0L);
+  }
+  if (mShare) {
+    set(CURLOPT_SHARE, mShare);
+  }
+  if (transfer.headers) {
+    set(CURLOPT_HTTPHEADER, transfer.headers);
+  }
+  if (mOptions.multiplex) {
+    set(CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+    // Waits for a connection that may multiplex instead of opening another.
+    set(CURLOPT_PIPEWAIT, 1L);
+  }
+  if (mOptions.share_cookies) {
+    set(CURLOPT_COOKIEFILE, "");
+  }
+
+  if (request.method == "POST") {
+    set(CURLOPT_POST, 1L);
+  } else if (request.method != "GET") {
+    set(CURLOPT_CUSTOMREQUEST, request.method.c_str());
+  }
+  if (request.body || request.method == "POST") {
+    // libcurl does not copy; the body lives as long as the transfer.
+    const char* body = request.body ? request.body->c_str() : "";
+    set(CURLOPT_POSTFIELDSIZE_LARGE,
+        static_cast<curl_off_t>(request.body ? request.body->size() : 0));
+    set(CURLOPT_POSTFIELDS, body);
+  }
+
+  if (code != CURLE_OK) {
+    spdlog::error("[CurlMultiClient] Failed to set up request for {}: {}",
+                  request.url, curl_easy_strerror(code));
+  }
+  return code;
+}
+
+void CurlMultiClient::Wakeup() {
+#if LIBCURL_VERSION_NUM >= 0x074400  // 7.68.0
+  if (mMulti) {
+    curl_multi_wakeup(mMulti);
+  }
+#endif
+}
+
+void CurlMultiClient::LockShare(CURL* /* handle */,
+                                const curl_lock_data data,
+                                curl_lock_access /* access */,
+                                void* user_data) {
+  static_cast<CurlMultiClient*>(user_data)->mShareLocks[data].lock();
+}
+
+void CurlMultiClient::UnlockShare(CURL* /* handle */,
+                                  const curl_lock_data data,
+                                  void* user_data) {
+  static_cast<CurlMultiClient*>(user_data)->mShareLocks[data].unlock();
+}
+
+}  // namespace plugin_common_curl
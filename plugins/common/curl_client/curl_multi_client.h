@@ -0,0 +1,255 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_COMMON_CURL_CLIENT_CURL_MULTI_CLIENT_H_
+#define PLUGINS_COMMON_CURL_CLIENT_CURL_MULTI_CLIENT_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <curl/curl.h>
+
+namespace plugin_common_curl {
+
+struct ResponseInfo {
+  long http_code = 0;
+  double total_time = 0.0;
+#if LIBCURL_VERSION_NUM >= 0x073700  // 7.55.0
+  curl_off_t download_size = 0;
+  curl_off_t upload_size = 0;
+#else
+  double download_size = 0.0;
+  double upload_size = 0.0;
+#endif
+  long redirect_count = 0;
+  std::string effective_url;
+  std::string content_type;
+  std::map<std::string, std::string> headers;
+};
+
+/**
+ * @brief Receives a chunk of a response body.
+ * @return false to abort the transfer with CURLE_WRITE_ERROR
+ */
+using DataCallback = std::function<bool(const char* data, size_t size)>;
+
+/**
+ * @brief Called once before the first chunk of a response body.
+ * @param http_code Status of the response
+ * @param content_length Size of the body from Content-Length, -1 if unknown
+ * @return false to abort the transfer with CURLE_WRITE_ERROR
+ */
+using BodyStartCallback =
+    std::function<bool(long http_code, curl_off_t content_length)>;
+
+/**
+ * @brief Reports download progress.
+ * @param downloaded Bytes of the body received so far
+ * @param total Expected size of the body, 0 if unknown
+ * @return false to abort the transfer with CURLE_ABORTED_BY_CALLBACK
+ */
+using ProgressCallback =
+    std::function<bool(curl_off_t downloaded, curl_off_t total)>;
+
+/**
+ * @brief A request for CurlMultiClient.
+ *
+ * Callbacks run on the thread performing the transfer, normally the client
+ * thread, so they must not block.
+ */
+struct HttpRequest {
+  std::string url;
+  // GET and POST use the standard methods, anything else is sent as a
+  // custom request.
+  std::string method = "GET";
+  std::vector<std::string> headers;
+  // Sent as the request body when set.
+  std::optional<std::string> body;
+  bool follow_location = true;
+  bool verbose = false;
+  long timeout = 30;
+  long connection_timeout = 10;
+  long max_redirects = 5;
+  // Byte range to request, e.g. "1024-" to resume a download or "0-1023";
+  // a server supporting it answers 206 Partial Content.
+  std::string range;
+  // Receives the body instead of HttpResponse::body, so its size does not
+  // bound memory use. Without it the body is collected in a buffer sized
+  // from Content-Length up front.
+  DataCallback on_data;
+  BodyStartCallback on_body_start;
+  ProgressCallback on_progress;
+};
+
+/**
+ * @brief The outcome of a request made through CurlMultiClient.
+ */
+struct HttpResponse {
+  CURLcode code = CURLE_OK;
+  ResponseInfo info;
+  // Empty when the request had an on_data callback.
+  std::string body;
+  // Curl's error message when |code| is not CURLE_OK.
+  std::string error;
+
+  /**
+   * @brief Function to check if request was successful
+   * @return bool
+   * @retval true if the transfer succeeded and the HTTP code is 2xx
+   */
+  [[nodiscard]] bool IsSuccess() const {
+    return code == CURLE_OK && info.http_code >= 200 && info.http_code < 300;
+  }
+};
+
+/**
+ * @brief Fills |info| from a finished transfer.
+ * @param handle The easy handle of the transfer
+ * @param raw_headers Response headers as received, one per line; names are
+ * stored lowercase and later values replace earlier ones
+ * @param info Receives the response information
+ */
+void ReadResponseInfo(CURL* handle,
+                      const std::string& raw_headers,
+                      ResponseInfo& info);
+
+/**
+ * @brief HTTP client running any number of transfers on one thread through a
+ * curl multi handle.
+ *
+ * Connections are kept open in the multi handle's pool and reused by later
+ * requests to the same host, and HTTP/2 requests are multiplexed over a
+ * single connection. DNS lookups and TLS sessions are shared through a
+ * CURLSH, so even a new connection skips the lookup and resumes the TLS
+ * session. Easy handles are recycled between requests.
+ *
+ * GetShared() returns the process-wide instance used by CurlClient, so every
+ * plugin downloads over the same pool.
+ */
+class CurlMultiClient {
+ public:
+  using Callback = std::function<void(HttpResponse)>;
+
+  struct Options {
+    // Connections per host; further requests queue or multiplex.
+    long max_host_connections = 6;
+    // Connections in total; 0 for no limit.
+    long max_total_connections = 0;
+    // Idle connections kept open for reuse.
+    long max_cached_connections = 32;
+    // Negotiates HTTP/2 over TLS and multiplexes requests on it.
+    bool multiplex = true;
+    // Enables cookies, shared by every request of this client.
+    bool share_cookies = false;
+  };
+
+  /**
+   * @brief Gets the process-wide client, created on first use.
+   */
+  static CurlMultiClient& GetShared();
+
+  explicit CurlMultiClient(const Options& options);
+  CurlMultiClient() : CurlMultiClient(Options()) {}
+
+  /**
+   * @brief Fails queued and running requests with CURLE_ABORTED_BY_CALLBACK
+   * and joins the client thread.
+   */
+  ~CurlMultiClient();
+
+  CurlMultiClient(const CurlMultiClient&) = delete;
+  CurlMultiClient& operator=(const CurlMultiClient&) = delete;
+
+  /**
+   * @brief Queues a request.
+   * @param request The request to send
+   * @param callback Receives the response on the client thread, so it must
+   * not block; a synchronous request made from it runs inline
+   */
+  void Send(HttpRequest request, Callback callback);
+
+  /**
+   * @brief Queues a request.
+   * @return std::future<HttpResponse> Becomes ready with the response
+   */
+  std::future<HttpResponse> Send(HttpRequest request);
+
+  /**
+   * @brief Sends a request and waits for the response. On the client thread
+   * the request is performed inline, blocking other transfers meanwhile.
+   */
+  HttpResponse Perform(HttpRequest request);
+
+  /**
+   * @brief Whether the caller is running on the client thread.
+   */
+  [[nodiscard]] bool RunsOnClientThread() const;
+
+ private:
+  struct Transfer;
+
+  Options mOptions;
+  CURLM* mMulti{};
+  CURLSH* mShare{};
+  std::array<std::mutex, CURL_LOCK_DATA_LAST> mShareLocks;
+
+  std::mutex mMutex;
+  std::deque<std::unique_ptr<Transfer>> mQueued;
+  bool mStop = false;
+
+  // Only used on the client thread.
+  std::unordered_map<CURL*, std::unique_ptr<Transfer>> mActive;
+  std::vector<CURL*> mIdleHandles;
+
+  std::thread mThread;
+
+  void Run();
+
+  void StartQueued();
+
+  void Finish(CURL* handle, CURLcode code);
+
+  CURL* AcquireHandle();
+
+  void ReleaseHandle(CURL* handle);
+
+  CURLcode Configure(CURL* handle, Transfer& transfer) const;
+
+  void Wakeup();
+
+  static void LockShare(CURL* handle,
+                        curl_lock_data data,
+                        curl_lock_access access,
+                        void* user_data);
+
+  static void UnlockShare(CURL* handle, curl_lock_data data, void* user_data);
+};
+
+}  // namespace plugin_common_curl
+
+#endif  // PLUGINS_COMMON_CURL_CLIENT_CURL_MULTI_CLIENT_H_
@@ -0,0 +1,823 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "http_cache.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "../logging.h"
+
+namespace plugin_common_curl {
+
+namespace {
+
+constexpr char kJournal[] = "index";
+constexpr char kJournalTemporary[] = "index.tmp";
+constexpr char kBlobs[] = "blobs";
+constexpr char kLock[] = "lock";
+
+constexpr size_t kChunkSize = 64 * 1024;
+// The journal is compacted once it holds this many records more than
+// twice the number of entries.
+constexpr size_t kCompactSlack = 1024;
+constexpr int64_t kMaxHeuristicFreshness = 24 * 60 * 60;
+
+// 64-bit FNV-1a. Blobs with the same name are compared before being shared,
+// so collisions cost a cache miss, never a wrong body.
+constexpr uint64_t kFnvOffset = 14695981039346656037ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+int64_t Now() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string Lowercase(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+  return value;
+}
+
+std::string Trim(const std::string& value) {
+  const auto begin = value.find_first_not_of(" \t");
+  if (begin == std::string::npos) {
+    return {};
+  }
+  return value.substr(begin, value.find_last_not_of(" \t") - begin + 1);
+}
+
+bool HasSeparator(const std::string& value) {
+  return value.find_first_of("\t\r\n") != std::string::npos;
+}
+
+// Splits a journal record, keeping empty fields.
+std::vector<std::string> Split(const std::string& line) {
+  std::vector<std::string> fields;
+  size_t start = 0;
+  while (true) {
+    const auto end = line.find('\t', start);
+    fields.push_back(line.substr(start, end - start));
+    if (end == std::string::npos) {
+      return fields;
+    }
+    start = end + 1;
+  }
+}
+
+std::string GetHeader(const ResponseInfo& info, const std::string& name) {
+  const auto it = info.headers.find(name);
+  return it == info.headers.end() ? std::string() : it->second;
+}
+
+// Returns -1 for a missing or invalid date.
+int64_t ParseDate(const std::string& value) {
+  return value.empty() ? -1
+                       : static_cast<int64_t>(curl_getdate(value.c_str(),
+                                                           nullptr));
+}
+
+struct CacheControl {
+  bool no_store = false;
+  bool no_cache = false;
+  std::optional<int64_t> max_age;
+};
+
+CacheControl ParseCacheControl(const std::string& value) {
+  CacheControl directives;
+  std::istringstream stream(value);
+  std::string directive;
+  while (std::getline(stream, directive, ',')) {
+    directive = Lowercase(Trim(directive));
+    if (directive == "no-store") {
+      directives.no_store = true;
+    } else if (directive.rfind("no-cache", 0) == 0) {
+      directives.no_cache = true;
+    } else if (directive.rfind("max-age=", 0) == 0) {
+      std::string seconds = directive.substr(8);
+      seconds.erase(std::remove(seconds.begin(), seconds.end(), '"'),
+                    seconds.end());
+      char* end = nullptr;
+      const long long parsed = std::strtoll(seconds.c_str(), &end, 10);
+      // An invalid max-age makes the response stale.
+      directives.max_age =
+          end != seconds.c_str() && *end == '\0' ? std::max(parsed, 0LL) : 0;
+    }
+  }
+  return directives;
+}
+
+/**
+ * @brief Computes how long a response stays fresh from |now|.
+ * @return The freshness in seconds, or std::nullopt if the response must not
+ * be stored
+ */
+std::optional<int64_t> GetFreshness(const ResponseInfo& info,
+                                    const int64_t now) {
+  if (const auto vary = Lowercase(Trim(GetHeader(info, "vary")));
+      !vary.empty() && vary != "accept-encoding") {
+    return std::nullopt;
+  }
+  const auto directives = ParseCacheControl(GetHeader(info, "cache-control"));
+  if (directives.no_store) {
+    return std::nullopt;
+  }
+
+  const auto date = ParseDate(GetHeader(info, "date"));
+  const int64_t response_date = date >= 0 ? date : now;
+  int64_t freshness = 0;
+  if (directives.no_cache) {
+    // Stored, but revalidated on every use.
+  } else if (directives.max_age) {
+    freshness = *directives.max_age;
+  } else if (const auto expires = GetHeader(info, "expires");
+             !expires.empty()) {
+    // Invalid dates such as "0" mean already expired.
+    const auto time = ParseDate(expires);
+    freshness = time >= 0 ? time - response_date : 0;
+  } else if (const auto modified =
+                 ParseDate(GetHeader(info, "last-modified"));
+             modified >= 0 && modified < response_date) {
+    freshness =
+        std::min((response_date - modified) / 10, kMaxHeuristicFreshness);
+  }
+
+  const long long age =
+      std::strtoll(GetHeader(info, "age").c_str(), nullptr, 10);
+  return std::max<int64_t>(freshness - std::max(age, 0LL), 0);
+}
+
+bool SameContents(std::istream& stored, const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::vector<char> first(kChunkSize);
+  std::vector<char> second(kChunkSize);
+  do {
+    stored.read(first.data(), kChunkSize);
+    file.read(second.data(), kChunkSize);
+    if (stored.gcount() != file.gcount() ||
+        std::memcmp(first.data(), second.data(),
+                    static_cast<size_t>(stored.gcount())) != 0) {
+      return false;
+    }
+  } while (stored && file);
+  return stored.eof() && file.eof();
+}
+
+}  // namespace
+
+/**
+ * @brief Writes a new blob to a temporary file, hashing it on the way. The
+ * file is removed unless it was moved into place and released.
+ */
+class HttpCache::BlobWriter {
+ public:
+  BlobWriter() = default;
+  ~BlobWriter() { Abort(); }
+
+  BlobWriter(const BlobWriter&) = delete;
+  BlobWriter& operator=(const BlobWriter&) = delete;
+
+  bool Open(std::string path) {
+    Abort();
+    mPath = std::move(path);
+    mFile = std::fopen(mPath.c_str(), "wb");
+    mHash = kFnvOffset;
+    mSize = 0;
+    return mFile != nullptr;
+  }
+
+  [[nodiscard]] bool IsOpen() const { return mFile != nullptr; }
+
+  bool Write(const char* data, const size_t size) {
+    if (!mFile) {
+      return false;
+    }
+    for (size_t i = 0; i < size; i++) {
+      mHash = (mHash ^ static_cast<uint8_t>(data[i])) * kFnvPrime;
+    }
+    mSize += size;
+    if (std::fwrite(data, 1, size, mFile) != size) {
+      Abort();
+      return false;
+    }
+    return true;
+  }
+
+  // Syncs the file to disk and closes it.
+  bool Finish() {
+    if (!mFile) {
+      return false;
+    }
+    const bool synced =
+        std::fflush(mFile) == 0 && fsync(fileno(mFile)) == 0;
+    const bool closed = std::fclose(mFile) == 0;
+    mFile = nullptr;
+    if (!synced || !closed) {
+      Abort();
+      return false;
+    }
+    return true;
+  }
+
+  void Abort() {
+    if (mFile) {
+      std::fclose(mFile);
+      mFile = nullptr;
+    }
+    if (!mPath.empty()) {
+      std::remove(mPath.c_str());
+      mPath.clear();
+    }
+  }
+
+  // Keeps the file after it was moved into place.
+  void Release() { mPath.clear(); }
+
+  [[nodiscard]] std::string GetName() const {
+    return fmt::format("{:016x}-{}", mHash, mSize);
+  }
+
+  [[nodiscard]] const std::string& GetPath() const { return mPath; }
+
+  [[nodiscard]] uint64_t GetSize() const { return mSize; }
+
+ private:
+  std::string mPath;
+  FILE* mFile = nullptr;
+  uint64_t mHash = kFnvOffset;
+  uint64_t mSize = 0;
+};
+
+struct HttpCache::Hit {
+  Entry entry;
+  // Opened under the lock, so eviction cannot remove the blob first.
+  std::ifstream file;
+};
+
+HttpCache& HttpCache::GetShared() {
+  static HttpCache cache(GetDefaultDirectory());
+  return cache;
+}
+
+std::string HttpCache::GetDefaultDirectory() {
+  std::filesystem::path base;
+  if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    base = xdg;
+  } else if (const char* home = std::getenv("HOME"); home && *home) {
+    base = std::filesystem::path(home) / ".cache";
+  } else {
+    return {};
+  }
+  return (base / "plugin_common" / "http").string();
+}
+
+HttpCache::HttpCache(std::string directory, const Options& options)
+    : mDirectory(std::move(directory)), mOptions(options) {
+  if (mDirectory.empty()) {
+    spdlog::error("[HttpCache] No cache directory");
+    return;
+  }
+  std::error_code error;
+  std::filesystem::create_directories(
+      std::filesystem::path(mDirectory) / kBlobs, error);
+  if (error) {
+    spdlog::error("[HttpCache] Failed to create {}: {}", mDirectory,
+                  error.message());
+    return;
+  }
+
+  const auto lock_path = mDirectory + "/" + kLock;
+  mLock = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (mLock < 0 || flock(mLock, LOCK_EX | LOCK_NB) != 0) {
+    spdlog::error("[HttpCache] {} is in use, caching disabled", mDirectory);
+    if (mLock >= 0) {
+      close(mLock);
+      mLock = -1;
+    }
+    return;
+  }
+
+  std::lock_guard lock(mMutex);
+  Load();
+}
+
+HttpCache::~HttpCache() {
+  std::lock_guard lock(mMutex);
+  if (mJournal) {
+    std::fclose(mJournal);
+  }
+  if (mLock >= 0) {
+    close(mLock);
+  }
+}
+
+bool HttpCache::IsOpen() const {
+  std::lock_guard lock(mMutex);
+  return mJournal != nullptr;
+}
+
+bool HttpCache::IsCacheable(const HttpRequest& request) {
+  if (request.method != "GET" || request.body || !request.range.empty() ||
+      HasSeparator(request.url)) {
+    return false;
+  }
+  for (const auto& header : request.headers) {
+    const auto name = Lowercase(header.substr(0, header.find(':')));
+    if (name == "authorization" || name == "range" ||
+        name == "cache-control" || name == "if-none-match" ||
+        name == "if-modified-since") {
+      return false;
+    }
+  }
+  return true;
+}
+
+HttpResponse HttpCache::Fetch(HttpRequest request, const Performer& perform) {
+  if (!IsOpen() || !IsCacheable(request)) {
+    return perform(std::move(request));
+  }
+
+  const auto now = Now();
+  auto hit = Open(request.url, now);
+  if (hit && hit->entry.fresh_until > now) {
+    HttpResponse response;
+    Replay(*hit, request, response);
+    return response;
+  }
+
+  const bool revalidate = hit && (!hit->entry.etag.empty() ||
+                                  !hit->entry.last_modified.empty());
+  if (revalidate) {
+    if (!hit->entry.etag.empty()) {
+      request.headers.push_back("If-None-Match: " + hit->entry.etag);
+    }
+    if (!hit->entry.last_modified.empty()) {
+      request.headers.push_back("If-Modified-Since: " +
+                                hit->entry.last_modified);
+    }
+  }
+
+  // The caller's sinks, for replaying a revalidated body.
+  HttpRequest sinks;
+  sinks.url = request.url;
+  sinks.on_data = request.on_data;
+  sinks.on_body_start = request.on_body_start;
+  sinks.on_progress = request.on_progress;
+
+  BlobWriter writer;
+  if (request.on_data) {
+    // A body that may be stored is copied to a new blob as it streams.
+    auto on_body_start = std::move(request.on_body_start);
+    auto on_data = std::move(request.on_data);
+    request.on_body_start = [this, &writer, on_body_start](
+                                const long http_code,
+                                const curl_off_t content_length) {
+      if (http_code == 200 &&
+          content_length <=
+              static_cast<curl_off_t>(mOptions.max_entry_bytes)) {
+        writer.Open(TemporaryPath());
+      }
+      return !on_body_start || on_body_start(http_code, content_length);
+    };
+    request.on_data = [this, &writer, on_data](const char* data,
+                                               const size_t size) {
+      if (writer.IsOpen() &&
+          (writer.GetSize() + size > mOptions.max_entry_bytes ||
+           !writer.Write(data, size))) {
+        writer.Abort();
+      }
+      return on_data(data, size);
+    };
+  }
+
+  auto response = perform(std::move(request));
+  if (response.code != CURLE_OK) {
+    return response;
+  }
+
+  const auto& info = response.info;
+  if (revalidate && info.http_code == 304) {
+    Refresh(sinks.url, info, now);
+    Replay(*hit, sinks, response);
+    return response;
+  }
+
+  if (info.http_code == 200 && info.redirect_count == 0) {
+    const auto freshness = GetFreshness(info, now);
+    Entry entry;
+    entry.etag = GetHeader(info, "etag");
+    entry.last_modified = GetHeader(info, "last-modified");
+    entry.content_type = info.content_type;
+    // Without validators a stale response would be of no use.
+    const bool storable =
+        freshness && (*freshness > 0 || !entry.etag.empty() ||
+                      !entry.last_modified.empty());
+    if (storable && !sinks.on_data &&
+        response.body.size() <= mOptions.max_entry_bytes &&
+        writer.Open(TemporaryPath())) {
+      writer.Write(response.body.data(), response.body.size());
+    }
+    if (storable && writer.IsOpen()) {
+      entry.fresh_until = now + *freshness;
+      entry.last_access = now;
+      Commit(writer, sinks.url, std::move(entry));
+      return response;
+    }
+  }
+
+  // The stored response is outdated; server errors leave it for later.
+  if (hit && info.http_code < 500) {
+    Remove(sinks.url);
+  }
+  return response;
+}
+
+std::optional<HttpCache::Hit> HttpCache::Open(const std::string& url,
+                                              const int64_t now) {
+  std::lock_guard lock(mMutex);
+  const auto it = mEntries.find(url);
+  if (it == mEntries.end()) {
+    return std::nullopt;
+  }
+  Hit hit;
+  hit.entry = it->second;
+  hit.file.open(BlobPath(it->second.blob), std::ios::binary);
+  if (!hit.file) {
+    spdlog::error("[HttpCache] Missing blob {} of {}", it->second.blob, url);
+    Erase(url);
+    return std::nullopt;
+  }
+  it->second.last_access = now;
+  mLru.splice(mLru.begin(), mLru, it->second.lru);
+  Append(fmt::format("T\t{}\t{}\n", url, now));
+  return hit;
+}
+
+void HttpCache::Replay(Hit& hit,
+                       const HttpRequest& request,
+                       HttpResponse& response) {
+  const auto& entry = hit.entry;
+  auto& info = response.info;
+  response.code = CURLE_OK;
+  response.error.clear();
+  info.http_code = 200;
+  info.download_size = static_cast<decltype(info.download_size)>(entry.size);
+  if (info.effective_url.empty()) {
+    info.effective_url = request.url;
+  }
+  if (info.content_type.empty()) {
+    info.content_type = entry.content_type;
+  }
+  const auto add_header = [&info](const char* name, const std::string& value) {
+    if (!value.empty()) {
+      info.headers.emplace(name, value);
+    }
+  };
+  add_header("content-type", entry.content_type);
+  add_header("etag", entry.etag);
+  add_header("last-modified", entry.last_modified);
+
+  if (!request.on_data) {
+    response.body.resize(entry.size);
+    if (!hit.file.read(response.body.data(),
+                       static_cast<std::streamsize>(entry.size))) {
+      response.code = CURLE_READ_ERROR;
+      response.body.clear();
+    }
+  } else if (entry.size > 0) {
+    if (request.on_body_start &&
+        !request.on_body_start(200, static_cast<curl_off_t>(entry.size))) {
+      response.code = CURLE_WRITE_ERROR;
+      return;
+    }
+    std::vector<char> chunk(std::min<uint64_t>(entry.size, kChunkSize));
+    for (uint64_t remaining = entry.size; remaining > 0;) {
+      const auto length =
+          static_cast<size_t>(std::min<uint64_t>(remaining, kChunkSize));
+      if (!hit.file.read(chunk.data(), static_cast<std::streamsize>(length))) {
+        response.code = CURLE_READ_ERROR;
+        break;
+      }
+      if (!request.on_data(chunk.data(), length)) {
+        response.code = CURLE_WRITE_ERROR;
+        break;
+      }
+      remaining -= length;
+    }
+  }
+
+  if (response.code == CURLE_READ_ERROR) {
+    response.error = "Failed to read cached response";
+    spdlog::error("[HttpCache] Failed to read blob {} of {}", entry.blob,
+                  request.url);
+    Remove(request.url);
+  } else if (response.code == CURLE_OK && request.on_progress) {
+    const auto size = static_cast<curl_off_t>(entry.size);
+    request.on_progress(size, size);
+  }
+}
+
+void HttpCache::Commit(BlobWriter& writer,
+                       const std::string& url,
+                       Entry entry) {
+  if (HasSeparator(entry.etag) || HasSeparator(entry.last_modified) ||
+      HasSeparator(entry.content_type)) {
+    return;
+  }
+  if (!writer.Finish()) {
+    spdlog::error("[HttpCache] Failed to write the response of {}", url);
+    return;
+  }
+  entry.blob = writer.GetName();
+  entry.size = writer.GetSize();
+
+  // A blob of the same name is shared if it has the same contents; they are
+  // compared outside the lock.
+  std::ifstream existing;
+  {
+    std::lock_guard lock(mMutex);
+    if (mBlobReferences.count(entry.blob) > 0) {
+      existing.open(BlobPath(entry.blob), std::ios::binary);
+    }
+  }
+  const bool shared =
+      existing.is_open() && SameContents(existing, writer.GetPath());
+  if (existing.is_open() && !shared) {
+    spdlog::warn("[HttpCache] Blob {} collides, not storing {}", entry.blob,
+                 url);
+    return;
+  }
+
+  std::lock_guard lock(mMutex);
+  if (!shared || mBlobReferences.count(entry.blob) == 0) {
+    std::error_code error;
+    std::filesystem::rename(writer.GetPath(), BlobPath(entry.blob), error);
+    if (error) {
+      spdlog::error("[HttpCache] Failed to store blob {}: {}", entry.blob,
+                    error.message());
+      return;
+    }
+    writer.Release();
+  }
+  Put(url, std::move(entry));
+  Evict();
+}
+
+void HttpCache::Refresh(const std::string& url,
+                        const ResponseInfo& info,
+                        const int64_t now) {
+  const auto freshness = GetFreshness(info, now);
+  std::lock_guard lock(mMutex);
+  const auto it = mEntries.find(url);
+  if (it == mEntries.end()) {
+    return;
+  }
+  if (!freshness) {
+    Erase(url);
+    return;
+  }
+  auto entry = it->second;
+  entry.fresh_until = now + *freshness;
+  // A 304 may carry new validators; the others stay as stored.
+  if (auto etag = GetHeader(info, "etag"); !etag.empty()) {
+    entry.etag = std::move(etag);
+  }
+  if (auto modified = GetHeader(info, "last-modified"); !modified.empty()) {
+    entry.last_modified = std::move(modified);
+  }
+  if (HasSeparator(entry.etag) || HasSeparator(entry.last_modified)) {
+    Erase(url);
+    return;
+  }
+  Put(url, std::move(entry));
+}
+
+void HttpCache::Load() {
+  std::unordered_map<std::string, Entry> entries;
+  std::ifstream journal(mDirectory + "/" + kJournal, std::ios::binary);
+  std::string line;
+  while (std::getline(journal, line)) {
+    if (journal.eof()) {
+      // The last record has no newline; a crash tore it.
+      break;
+    }
+    const auto fields = Split(line);
+    if (fields[0] == "P" && fields.size() == 9) {
+      Entry entry;
+      entry.blob = fields[2];
+      entry.size = std::strtoull(fields[3].c_str(), nullptr, 10);
+      entry.fresh_until = std::strtoll(fields[4].c_str(), nullptr, 10);
+      entry.last_access = std::strtoll(fields[5].c_str(), nullptr, 10);
+      entry.etag = fields[6];
+      entry.last_modified = fields[7];
+      entry.content_type = fields[8];
+      entries[fields[1]] = std::move(entry);
+    } else if (fields[0] == "T" && fields.size() == 3) {
+      if (const auto it = entries.find(fields[1]); it != entries.end()) {
+        it->second.last_access = std::strtoll(fields[2].c_str(), nullptr, 10);
+      }
+    } else if (fields[0] == "D" && fields.size() == 2) {
+      entries.erase(fields[1]);
+    }
+  }
+  journal.close();
+
+  std::vector<std::pair<std::string, Entry>> loaded;
+  loaded.reserve(entries.size());
+  for (auto& [url, entry] : entries) {
+    std::error_code error;
+    const auto size =
+        std::filesystem::file_size(BlobPath(entry.blob), error);
+    if (error || size != entry.size) {
+      continue;
+    }
+    loaded.emplace_back(url, std::move(entry));
+  }
+  std::sort(loaded.begin(), loaded.end(), [](const auto& a, const auto& b) {
+    return a.second.last_access > b.second.last_access;
+  });
+  for (auto& [url, entry] : loaded) {
+    if (++mBlobReferences[entry.blob] == 1) {
+      mSize += entry.size;
+    }
+    entry.lru = mLru.insert(mLru.end(), url);
+    mEntries.emplace(url, std::move(entry));
+  }
+
+  // Removes blobs no entry refers to, e.g. written before a crash.
+  std::error_code error;
+  for (const auto& file : std::filesystem::directory_iterator(
+           std::filesystem::path(mDirectory) / kBlobs, error)) {
+    if (mBlobReferences.count(file.path().filename().string()) == 0) {
+      std::filesystem::remove(file.path(), error);
+    }
+  }
+
+  Compact();
+  Evict();
+  spdlog::debug("[HttpCache] Opened {} with {} entries, {} bytes", mDirectory,
+                mEntries.size(), mSize);
+}
+
+void HttpCache::Compact() {
+  const auto path = mDirectory + "/" + kJournal;
+  const auto temporary = mDirectory + "/" + kJournalTemporary;
+  FILE* file = std::fopen(temporary.c_str(), "wb");
+  if (!file) {
+    spdlog::error("[HttpCache] Failed to create {}", temporary);
+    return;
+  }
+  bool written = true;
+  for (auto it = mLru.rbegin(); it != mLru.rend() && written; ++it) {
+    written = std::fputs(Record(*it, mEntries.at(*it)).c_str(), file) >= 0;
+  }
+  written = written && std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+  written = std::fclose(file) == 0 && written;
+  if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+    spdlog::error("[HttpCache] Failed to write {}", path);
+    std::remove(temporary.c_str());
+    return;
+  }
+
+  if (mJournal) {
+    std::fclose(mJournal);
+  }
+  mJournal = std::fopen(path.c_str(), "ab");
+  mJournalRecords = mEntries.size();
+  if (!mJournal) {
+    spdlog::error("[HttpCache] Failed to open {}", path);
+  }
+}
+
+void HttpCache::Append(const std::string& record) {
+  if (!mJournal) {
+    return;
+  }
+  if (std::fputs(record.c_str(), mJournal) < 0 || std::fflush(mJournal) != 0) {
+    spdlog::error("[HttpCache] Failed to append to the journal");
+  }
+  if (++mJournalRecords > 2 * mEntries.size() + kCompactSlack) {
+    Compact();
+  }
+}
+
+void HttpCache::Put(const std::string& url, Entry entry) {
+  // References the new blob first, as it may be the one being replaced.
+  if (++mBlobReferences[entry.blob] == 1) {
+    mSize += entry.size;
+  }
+  if (const auto it = mEntries.find(url); it != mEntries.end()) {
+    const auto& old = it->second;
+    if (--mBlobReferences[old.blob] == 0) {
+      mBlobReferences.erase(old.blob);
+      mSize -= old.size;
+      std::remove(BlobPath(old.blob).c_str());
+    }
+    mLru.erase(old.lru);
+    mEntries.erase(it);
+  }
+  entry.lru = mLru.insert(mLru.begin(), url);
+  const auto record = Record(url, entry);
+  mEntries.emplace(url, std::move(entry));
+  Append(record);
+}
+
+void HttpCache::Erase(const std::string& url) {
+  const auto it = mEntries.find(url);
+  if (it == mEntries.end()) {
+    return;
+  }
+  const auto& entry = it->second;
+  if (--mBlobReferences[entry.blob] == 0) {
+    mBlobReferences.erase(entry.blob);
+    mSize -= entry.size;
+    std::remove(BlobPath(entry.blob).c_str());
+  }
+  mLru.erase(entry.lru);
+  mEntries.erase(it);
+  Append(fmt::format("D\t{}\n", url));
+}
+
+void HttpCache::Evict() {
+  while (mSize > mOptions.max_bytes && !mLru.empty()) {
+    const std::string url = mLru.back();
+    Erase(url);
+  }
+}
+
+bool HttpCache::Remove(const std::string& url) {
+  std::lock_guard lock(mMutex);
+  if (mEntries.count(url) == 0) {
+    return false;
+  }
+  Erase(url);
+  return true;
+}
+
+void HttpCache::Clear() {
+  std::lock_guard lock(mMutex);
+  while (!mLru.empty()) {
+    const std::string url = mLru.back();
+    Erase(url);
+  }
+  if (mJournal) {
+    Compact();
+  }
+}
+
+uint64_t HttpCache::GetSize() const {
+  std::lock_guard lock(mMutex);
+  return mSize;
+}
+
+size_t HttpCache::GetEntryCount() const {
+  std::lock_guard lock(mMutex);
+  return mEntries.size();
+}
+
+std::string HttpCache::BlobPath(const std::string& blob) const {
+  return mDirectory + "/" + kBlobs + "/" + blob;
+}
+
+std::string HttpCache::TemporaryPath() {
+  return fmt::format("{}/{}/{}.tmp", mDirectory, kBlobs, mNextTemporary++);
+}
+
+std::string HttpCache::Record(const std::string& url, const Entry& entry) {
+  return fmt::format("P\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\n", url, entry.blob,
+                     entry.size, entry.fresh_until, entry.last_access,
+                     entry.etag, entry.last_modified, entry.content_type);
+}
+
+}  // namespace plugin_common_curl
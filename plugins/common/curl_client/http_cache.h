@@ -0,0 +1,200 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_COMMON_CURL_CLIENT_HTTP_CACHE_H_
+#define PLUGINS_COMMON_CURL_CLIENT_HTTP_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "curl_multi_client.h"
+
+namespace plugin_common_curl {
+
+/**
+ * @brief Persistent, size-bounded HTTP response cache on disk.
+ *
+ * GetShared() returns the cache every plugin shares; a CurlClient uses it
+ * once given to CurlClient::SetCache().
+ *
+ * Only GET requests without a body, range, Authorization header or request
+ * Cache-Control are cached, and only 200 responses reached without
+ * redirects. Freshness follows Cache-Control max-age, then Expires, then a
+ * tenth of the age given by Last-Modified, at most a day. no-store
+ * responses are not kept, and responses varying on anything but
+ * Accept-Encoding are not kept either. A stale entry is revalidated with
+ * If-None-Match and If-Modified-Since; on 304 Not Modified it is refreshed
+ * and served from disk as a 200.
+ *
+ * Bodies are stored once per content, in blob files named by hash and size,
+ * so the same file behind several URLs takes space once. The least recently
+ * used entries are evicted to keep the blobs within the budget.
+ *
+ * The index is a journal of records, appended once the blob a record points
+ * to has been synced and renamed into place, and compacted through a
+ * temporary file and a rename. On open, torn records and records whose blob
+ * is missing are dropped and unreferenced blobs deleted, so a crash loses at
+ * most the latest entries. One process at a time may open a directory; in
+ * others the cache stays closed and requests go to the network.
+ */
+class HttpCache {
+ public:
+  // Performs a request on the network, e.g. CurlMultiClient::Perform().
+  using Performer = std::function<HttpResponse(HttpRequest)>;
+
+  struct Options {
+    // Budget for the stored bodies.
+    uint64_t max_bytes = 256 * 1024 * 1024;
+    // Larger bodies are not stored.
+    uint64_t max_entry_bytes = 32 * 1024 * 1024;
+  };
+
+  /**
+   * @brief Gets the process-wide cache in GetDefaultDirectory(), opened on
+   * first use.
+   */
+  static HttpCache& GetShared();
+
+  /**
+   * @brief Gets $XDG_CACHE_HOME/plugin_common/http, falling back to
+   * ~/.cache; empty if neither variable is set.
+   */
+  static std::string GetDefaultDirectory();
+
+  /**
+   * @param directory Directory of the cache, created if missing
+   * @param options Size limits; entries over the budget are evicted on open
+   */
+  HttpCache(std::string directory, const Options& options);
+  explicit HttpCache(std::string directory)
+      : HttpCache(std::move(directory), Options()) {}
+
+  ~HttpCache();
+
+  HttpCache(const HttpCache&) = delete;
+  HttpCache& operator=(const HttpCache&) = delete;
+
+  /**
+   * @brief Whether the directory could be opened and locked.
+   */
+  [[nodiscard]] bool IsOpen() const;
+
+  /**
+   * @brief Answers |request| from the cache, revalidating or performing it
+   * with |perform| when needed, and stores the response when allowed.
+   *
+   * A body served from disk goes to the request's on_body_start and on_data
+   * callbacks on the calling thread, in chunks, or to HttpResponse::body
+   * without them. A body from the network that is being stored is copied to
+   * a new blob as it streams.
+   */
+  HttpResponse Fetch(HttpRequest request, const Performer& perform);
+
+  /**
+   * @brief Whether Fetch() may answer |request| from the cache.
+   */
+  static bool IsCacheable(const HttpRequest& request);
+
+  /**
+   * @brief Removes the entry of |url|.
+   * @return bool
+   * @retval true if there was one
+   */
+  bool Remove(const std::string& url);
+
+  /**
+   * @brief Removes every entry.
+   */
+  void Clear();
+
+  /**
+   * @brief Gets the size of the stored bodies; a blob shared by several
+   * entries counts once.
+   */
+  [[nodiscard]] uint64_t GetSize() const;
+
+  [[nodiscard]] size_t GetEntryCount() const;
+
+ private:
+  struct Entry {
+    std::string blob;
+    uint64_t size = 0;
+    // Unix times in seconds.
+    int64_t fresh_until = 0;
+    int64_t last_access = 0;
+    std::string etag;
+    std::string last_modified;
+    std::string content_type;
+    std::list<std::string>::iterator lru;
+  };
+
+  class BlobWriter;
+  struct Hit;
+
+  const std::string mDirectory;
+  const Options mOptions;
+
+  mutable std::mutex mMutex;
+  int mLock = -1;
+  FILE* mJournal = nullptr;
+  size_t mJournalRecords = 0;
+  std::unordered_map<std::string, Entry> mEntries;
+  // Most recently used first.
+  std::list<std::string> mLru;
+  // Number of entries per blob.
+  std::unordered_map<std::string, size_t> mBlobReferences;
+  uint64_t mSize = 0;
+  std::atomic<uint64_t> mNextTemporary{0};
+
+  std::optional<Hit> Open(const std::string& url, int64_t now);
+
+  void Replay(Hit& hit, const HttpRequest& request, HttpResponse& response);
+
+  // Moves a finished blob into place and records it as the entry of |url|.
+  void Commit(BlobWriter& writer, const std::string& url, Entry entry);
+
+  void Refresh(const std::string& url, const ResponseInfo& info, int64_t now);
+
+  void Load();
+
+  void Compact();
+
+  void Append(const std::string& record);
+
+  void Put(const std::string& url, Entry entry);
+
+  void Erase(const std::string& url);
+
+  void Evict();
+
+  [[nodiscard]] std::string BlobPath(const std::string& blob) const;
+
+  [[nodiscard]] std::string TemporaryPath();
+
+  static std::string Record(const std::string& url, const Entry& entry);
+};
+
+}  // namespace plugin_common_curl
+
+#endif  // PLUGINS_COMMON_CURL_CLIENT_HTTP_CACHE_H_
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <curl/curl.h>
+
+#include <filesystem>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "../curl_client.h"
+#include "../curl_multi_client.h"
+#include "../http_cache.h"
+#include "local_http_server.h"
+
+using namespace plugin_common_curl;
+
+namespace {
+
+constexpr int64_t kSmallBody = 256;
+constexpr int64_t kLargeBody = 1024 * 1024;
+constexpr int kBatchSize = 16;
+
+LocalHttpServer& Server() {
+  static LocalHttpServer server;
+  return server;
+}
+
+size_t Append(char* data,
+              const size_t size,
+              const size_t num_mem_block,
+              void* user_data) {
+  static_cast<std::string*>(user_data)->append(data, size * num_mem_block);
+  return size * num_mem_block;
+}
+
+// A new easy handle, and so a new connection, per request, as CurlClient
+// used to do.
+void BM_EasyHandlePerRequest(benchmark::State& state) {
+  const auto url = Server().Url("/bytes/" + std::to_string(state.range(0)));
+  for (auto _ : state) {
+    std::string body;
+    CURL* handle = curl_easy_init();
+    curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, Append);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &body);
+    benchmark::DoNotOptimize(curl_easy_perform(handle));
+    curl_easy_cleanup(handle);
+    benchmark::DoNotOptimize(body);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// A new CurlClient per request, sharing the pooled connections.
+void BM_CurlClient(benchmark::State& state) {
+  const auto url = Server().Url("/bytes/" + std::to_string(state.range(0)));
+  for (auto _ : state) {
+    CurlClient client;
+    benchmark::DoNotOptimize(client.Get(url));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// A CurlClient answered from a fresh entry of the disk cache.
+void BM_CachedCurlClient(benchmark::State& state) {
+  const auto directory =
+      std::filesystem::temp_directory_path() / "curl_client_benchmark_cache";
+  std::filesystem::remove_all(directory);
+  HttpCache cache(directory.string());
+  const auto url =
+      Server().Url("/cached/3600/" + std::to_string(state.range(0)));
+  for (auto _ : state) {
+    CurlClient client;
+    client.SetCache(&cache);
+    benchmark::DoNotOptimize(client.Get(url));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+  std::filesystem::remove_all(directory);
+}
+
+// Batches of concurrent requests on the shared client.
+void BM_MultiClientBatch(benchmark::State& state) {
+  auto& client = CurlMultiClient::GetShared();
+  HttpRequest request;
+  request.url = Server().Url("/bytes/" + std::to_string(state.range(0)));
+  std::vector<std::future<HttpResponse>> futures;
+  for (auto _ : state) {
+    futures.clear();
+    for (int i = 0; i < kBatchSize; i++) {
+      futures.push_back(client.Send(request));
+    }
+    for (auto& future : futures) {
+      benchmark::DoNotOptimize(future.get());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+  state.SetBytesProcessed(state.iterations() * kBatchSize * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_EasyHandlePerRequest)->Arg(kSmallBody)->Arg(kLargeBody);
+BENCHMARK(BM_CurlClient)->Arg(kSmallBody)->Arg(kLargeBody);
+BENCHMARK(BM_CachedCurlClient)->Arg(kSmallBody)->Arg(kLargeBody);
+BENCHMARK(BM_MultiClientBatch)->Arg(kSmallBody)->Arg(kLargeBody);
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_COMMON_CURL_CLIENT_TEST_LOCAL_HTTP_SERVER_H_
+#define PLUGINS_COMMON_CURL_CLIENT_TEST_LOCAL_HTTP_SERVER_H_
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Minimal HTTP/1.1 server on 127.0.0.1 for tests and benchmarks that
+ * must not depend on the network.
+ *
+ * Connections are kept alive and served by a thread each. Routes:
+ * - /bytes/N: Bytes(N), honouring a "Range: bytes=start-" header
+ * - /status/N: an empty response with status N
+ * - /cached/AGE/N: Bytes(N) with "Cache-Control: max-age=AGE" and an ETag,
+ *   or 304 Not Modified if the request has that ETag in If-None-Match
+ * - /delay/MS: "ok" after MS milliseconds
+ * - /echo: the method, a newline and the request body
+ * - anything else: "ok"
+ */
+class LocalHttpServer {
+ public:
+  LocalHttpServer() {
+    mListener = socket(AF_INET, SOCK_STREAM, 0);
+    if (mListener < 0) {
+      throw std::runtime_error("socket failed");
+    }
+    const int reuse = 1;
+    setsockopt(mListener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t length = sizeof(address);
+    if (bind(mListener, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+        listen(mListener, 64) != 0 ||
+        getsockname(mListener, reinterpret_cast<sockaddr*>(&address),
+                    &length) != 0) {
+      close(mListener);
+      throw std::runtime_error("bind failed");
+    }
+    mPort = ntohs(address.sin_port);
+    mAcceptor = std::thread(&LocalHttpServer::Accept, this);
+  }
+
+  ~LocalHttpServer() {
+    mStop = true;
+    shutdown(mListener, SHUT_RDWR);
+    close(mListener);
+    mAcceptor.join();
+    {
+      std::lock_guard lock(mMutex);
+      for (const int socket : mSockets) {
+        shutdown(socket, SHUT_RDWR);
+      }
+    }
+    for (auto& thread : mConnections) {
+      thread.join();
+    }
+  }
+
+  LocalHttpServer(const LocalHttpServer&) = delete;
+  LocalHttpServer& operator=(const LocalHttpServer&) = delete;
+
+  // The body of /bytes/|size|: a repeating alphabet, so misplaced ranges
+  // show.
+  static std::string Bytes(const size_t size) {
+    std::string bytes(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+      bytes[i] = static_cast<char>('a' + i % 26);
+    }
+    return bytes;
+  }
+
+  [[nodiscard]] std::string Url(const std::string& path) const {
+    return "http://127.0.0.1:" + std::to_string(mPort) + path;
+  }
+
+  // Number of TCP connections accepted so far.
+  [[nodiscard]] int GetConnectionCount() const { return mConnectionCount; }
+
+  // Number of requests answered so far.
+  [[nodiscard]] int GetRequestCount() const { return mRequestCount; }
+
+  // Number of 304 Not Modified answers so far.
+  [[nodiscard]] int GetNotModifiedCount() const { return mNotModifiedCount; }
+
+ private:
+  int mListener = -1;
+  int mPort = 0;
+  std::atomic<bool> mStop{false};
+  std::atomic<int> mConnectionCount{0};
+  std::atomic<int> mRequestCount{0};
+  std::atomic<int> mNotModifiedCount{0};
+  std::thread mAcceptor;
+  std::mutex mMutex;
+  std::vector<int> mSockets;
+  std::vector<std::thread> mConnections;
+
+  struct Response {
+    int status = 200;
+    std::string headers;
+    std::string body;
+  };
+
+  void Accept() {
+    while (!mStop) {
+      const int socket = accept(mListener, nullptr, nullptr);
+      if (socket < 0) {
+        continue;
+      }
+      ++mConnectionCount;
+      std::lock_guard lock(mMutex);
+      mSockets.push_back(socket);
+      mConnections.emplace_back(&LocalHttpServer::Serve, this, socket);
+    }
+  }
+
+  void Serve(const int socket) {
+    std::string buffer;
+    char chunk[16 * 1024];
+    const auto receive = [&] {
+      const ssize_t received = recv(socket, chunk, sizeof(chunk), 0);
+      if (received <= 0) {
+        return false;
+      }
+      buffer.append(chunk, static_cast<size_t>(received));
+      return true;
+    };
+
+    while (true) {
+      size_t header_end;
+      while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (!receive()) {
+          close(socket);
+          return;
+        }
+      }
+      std::string head = buffer.substr(0, header_end);
+      std::transform(head.begin(), head.end(), head.begin(), ::tolower);
+      size_t content_length = 0;
+      if (const auto field = head.find("\r\ncontent-length:");
+          field != std::string::npos) {
+        content_length = std::stoul(head.substr(field + 17));
+      }
+      const size_t request_size = header_end + 4 + content_length;
+      while (buffer.size() < request_size) {
+        if (!receive()) {
+          close(socket);
+          return;
+        }
+      }
+
+      std::istringstream request_line(buffer.substr(0, header_end));
+      std::string method;
+      std::string target;
+      request_line >> method >> target;
+      const std::string body =
+          buffer.substr(header_end + 4, content_length);
+      buffer.erase(0, request_size);
+
+      const auto content = Respond(method, target, head, body);
+      const std::string response =
+          "HTTP/1.1 " + std::to_string(content.status) +
+          " Status\r\nContent-Type: application/octet-stream\r\n"
+          "Content-Length: " +
+          std::to_string(content.body.size()) + "\r\n" + content.headers +
+          "\r\n" + content.body;
+      ++mRequestCount;
+      size_t sent = 0;
+      while (sent < response.size()) {
+        const ssize_t written = send(socket, response.data() + sent,
+                                     response.size() - sent, MSG_NOSIGNAL);
+        if (written <= 0) {
+          close(socket);
+          return;
+        }
+        sent += static_cast<size_t>(written);
+      }
+    }
+  }
+
+  // |head| is lowercase.
+  Response Respond(const std::string& method,
+                          const std::string& target,
+                          const std::string& head,
+                          const std::string& body) {
+    if (target.rfind("/bytes/", 0) == 0) {
+      const size_t size = std::stoul(target.substr(7));
+      constexpr std::string_view kRange = "\r\nrange: bytes=";
+      const auto range = head.find(kRange);
+      if (range == std::string::npos) {
+        return {200, "", Bytes(size)};
+      }
+      const size_t start = std::stoul(head.substr(range + kRange.size()));
+      if (start >= size) {
+        return {416, "Content-Range: bytes */" + std::to_string(size) + "\r\n",
+                ""};
+      }
+      return {206,
+              "Content-Range: bytes " + std::to_string(start) + "-" +
+                  std::to_string(size - 1) + "/" + std::to_string(size) +
+                  "\r\n",
+              Bytes(size).substr(start)};
+    }
+    if (target.rfind("/cached/", 0) == 0) {
+      const auto max_age = std::stoul(target.substr(8));
+      const size_t size = std::stoul(target.substr(target.find('/', 8) + 1));
+      const auto etag = "\"" + std::to_string(size) + "\"";
+      const auto headers = "Cache-Control: max-age=" +
+                           std::to_string(max_age) + "\r\nETag: " + etag +
+                           "\r\n";
+      if (head.find("\r\nif-none-match: " + etag) != std::string::npos) {
+        ++mNotModifiedCount;
+        return {304, headers, ""};
+      }
+      return {200, headers, Bytes(size)};
+    }
+    if (target.rfind("/status/", 0) == 0) {
+      return {std::stoi(target.substr(8)), "", ""};
+    }
+    if (target.rfind("/delay/", 0) == 0) {
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(std::stoul(target.substr(7))));
+      return {200, "", "ok"};
+    }
+    if (target == "/echo") {
+      return {200, "", method + "\n" + body};
+    }
+    return {200, "", "ok"};
+  }
+};
+
+#endif  // PLUGINS_COMMON_CURL_CLIENT_TEST_LOCAL_HTTP_SERVER_H_
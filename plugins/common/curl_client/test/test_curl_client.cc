@@ -20,8 +20,10 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <future>
+#include <iterator>
 #include <memory>
 #include <random>
 #include <sstream>
@@ -32,6 +34,9 @@
 #include "gtest/gtest.h"
 
 #include "../curl_client.h"
+#include "../curl_multi_client.h"
+#include "../http_cache.h"
+#include "local_http_server.h"
 
 using namespace plugin_common_curl;
 using namespace testing;
@@ -393,6 +398,282 @@ TEST_F(CurlClientTest, StressTestAllMethods) {
   }
 }
 
+// The tests below run against a server on the loopback interface.
+
+TEST(CurlMultiClientTest, ConcurrentRequestsReuseConnections) {
+  LocalHttpServer server;
+  CurlMultiClient::Options options;
+  options.max_host_connections = 2;
+  CurlMultiClient client(options);
+
+  constexpr int num_requests = 20;
+  std::vector<std::future<HttpResponse>> futures;
+  futures.reserve(num_requests);
+  for (int i = 0; i < num_requests; ++i) {
+    HttpRequest request;
+    request.url = server.Url("/bytes/" + std::to_string(1024 + i));
+    futures.push_back(client.Send(std::move(request)));
+  }
+
+  for (int i = 0; i < num_requests; ++i) {
+    const auto response = futures[i].get();
+    EXPECT_TRUE(response.IsSuccess());
+    EXPECT_EQ(response.body.size(), static_cast<size_t>(1024 + i));
+    EXPECT_EQ(response.info.headers.at("content-type"),
+              "application/octet-stream");
+  }
+  EXPECT_EQ(server.GetRequestCount(), num_requests);
+  EXPECT_LE(server.GetConnectionCount(), 2);
+}
+
+TEST(CurlMultiClientTest, SendsMethodAndBody) {
+  LocalHttpServer server;
+  CurlMultiClient client;
+
+  HttpRequest request;
+  request.url = server.Url("/echo");
+  request.method = "PUT";
+  request.body = "payload";
+  const auto response = client.Perform(request);
+  EXPECT_TRUE(response.IsSuccess());
+  EXPECT_EQ(response.body, "PUT\npayload");
+}
+
+TEST(CurlMultiClientTest, CallbackMayPerformInline) {
+  LocalHttpServer server;
+  CurlMultiClient client;
+
+  std::promise<std::string> nested;
+  HttpRequest request;
+  request.url = server.Url("/bytes/4");
+  client.Send(request, [&](HttpResponse) {
+    EXPECT_TRUE(client.RunsOnClientThread());
+    HttpRequest next;
+    next.url = server.Url("/bytes/8");
+    nested.set_value(client.Perform(next).body);
+  });
+  EXPECT_EQ(nested.get_future().get(), LocalHttpServer::Bytes(8));
+}
+
+TEST(CurlMultiClientTest, DestructionAbortsQueuedRequests) {
+  LocalHttpServer server;
+  std::future<HttpResponse> future;
+  {
+    CurlMultiClient client;
+    HttpRequest request;
+    request.url = server.Url("/delay/2000");
+    future = client.Send(request);
+  }
+  EXPECT_EQ(future.get().code, CURLE_ABORTED_BY_CALLBACK);
+}
+
+TEST(CurlMultiClientTest, ClientsShareConnections) {
+  LocalHttpServer server;
+  for (int i = 0; i < 10; ++i) {
+    CurlClient client;
+    EXPECT_EQ(client.Get(server.Url("/bytes/16")), LocalHttpServer::Bytes(16));
+    EXPECT_TRUE(client.IsSuccess());
+
+    EXPECT_EQ(client.Post(server.Url("/echo"), {{"a b", "c&d"}}),
+              "POST\na%20b=c%26d");
+  }
+  EXPECT_EQ(server.GetConnectionCount(), 1);
+}
+
+TEST(CurlMultiClientTest, StreamsBodyWithProgress) {
+  LocalHttpServer server;
+  constexpr size_t size = 4 * 1024 * 1024;
+  CurlClient client;
+  curl_off_t last_downloaded = 0;
+  curl_off_t last_total = 0;
+  client.SetProgressCallback([&](const curl_off_t downloaded,
+                                 const curl_off_t total) {
+    last_downloaded = downloaded;
+    last_total = total;
+    return true;
+  });
+  ASSERT_TRUE(
+      client.Init(server.Url("/bytes/" + std::to_string(size)), {}, {}));
+
+  std::string body;
+  int chunks = 0;
+  EXPECT_TRUE(client.RetrieveContentStreaming(
+      [&](const char* data, const size_t length) {
+        body.append(data, length);
+        ++chunks;
+        return true;
+      }));
+  EXPECT_EQ(body, LocalHttpServer::Bytes(size));
+  EXPECT_GT(chunks, 1);
+  EXPECT_EQ(last_downloaded, static_cast<curl_off_t>(size));
+  EXPECT_EQ(last_total, static_cast<curl_off_t>(size));
+
+  // Returning false aborts the request.
+  client.SetProgressCallback(
+      [](curl_off_t downloaded, curl_off_t) { return downloaded == 0; });
+  ASSERT_TRUE(
+      client.Init(server.Url("/bytes/" + std::to_string(size)), {}, {}));
+  EXPECT_TRUE(client.RetrieveContentAsVector().empty());
+  EXPECT_EQ(client.GetCode(), CURLE_ABORTED_BY_CALLBACK);
+}
+
+TEST(CurlMultiClientTest, DownloadToFileResumes) {
+  LocalHttpServer server;
+  const auto directory =
+      std::filesystem::temp_directory_path() / "curl_client_download_test";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  const auto path = (directory / "asset.bin").string();
+  const auto expected = LocalHttpServer::Bytes(100000);
+  const auto url = server.Url("/bytes/100000");
+
+  std::ofstream(path + ".part", std::ios::binary) << expected.substr(0, 4000);
+  CurlClient client;
+  ASSERT_TRUE(client.DownloadToFile(url, path, true));
+  EXPECT_EQ(client.GetHttpCode(), 206);
+  EXPECT_FALSE(std::filesystem::exists(path + ".part"));
+  std::ifstream file(path, std::ios::binary);
+  EXPECT_EQ(std::string(std::istreambuf_iterator<char>(file), {}), expected);
+
+  // A partial file as large as the resource is stale; it is replaced.
+  std::ofstream(path + ".part", std::ios::binary) << expected;
+  ASSERT_TRUE(client.DownloadToFile(url, path, true));
+  EXPECT_EQ(client.GetHttpCode(), 200);
+  EXPECT_EQ(std::filesystem::file_size(path), expected.size());
+
+  // Error pages are not written.
+  const auto missing = (directory / "missing.bin").string();
+  EXPECT_FALSE(client.DownloadToFile(server.Url("/status/404"), missing));
+  EXPECT_EQ(client.GetHttpCode(), 404);
+  EXPECT_FALSE(std::filesystem::exists(missing));
+  EXPECT_FALSE(std::filesystem::exists(missing + ".part"));
+
+  std::filesystem::remove_all(directory);
+}
+
+class HttpCacheTest : public Test {
+ protected:
+  void SetUp() override {
+    directory = (std::filesystem::temp_directory_path() /
+                 "curl_client_http_cache_test")
+                    .string();
+    std::filesystem::remove_all(directory);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(directory); }
+
+  std::string directory;
+  LocalHttpServer server;
+};
+
+TEST_F(HttpCacheTest, ServesFreshResponsesFromDisk) {
+  const auto url = server.Url("/cached/60/5000");
+  {
+    HttpCache cache(directory);
+    ASSERT_TRUE(cache.IsOpen());
+    CurlClient client;
+    client.SetCache(&cache);
+    EXPECT_EQ(client.Get(url), LocalHttpServer::Bytes(5000));
+    EXPECT_EQ(client.Get(url), LocalHttpServer::Bytes(5000));
+    EXPECT_TRUE(client.IsSuccess());
+
+    // The directory is locked while in use.
+    const HttpCache second(directory);
+    EXPECT_FALSE(second.IsOpen());
+  }
+  EXPECT_EQ(server.GetRequestCount(), 1);
+
+  // Kept across restarts, and streamed to sinks as well.
+  HttpCache cache(directory);
+  EXPECT_EQ(cache.GetEntryCount(), 1u);
+  CurlClient client;
+  client.SetCache(&cache);
+  ASSERT_TRUE(client.Init(url, {}, {}));
+  const auto& body = client.RetrieveContentAsVector();
+  EXPECT_EQ(std::string(body.begin(), body.end()),
+            LocalHttpServer::Bytes(5000));
+  EXPECT_EQ(client.GetHttpCode(), 200);
+  EXPECT_EQ(server.GetRequestCount(), 1);
+}
+
+TEST_F(HttpCacheTest, RevalidatesStaleResponses) {
+  HttpCache cache(directory);
+  CurlClient client;
+  client.SetCache(&cache);
+  const auto url = server.Url("/cached/0/3000");
+
+  ASSERT_TRUE(client.Init(url, {}, {}));
+  std::string streamed;
+  EXPECT_TRUE(client.RetrieveContentStreaming(
+      [&streamed](const char* data, const size_t size) {
+        streamed.append(data, size);
+        return true;
+      }));
+  EXPECT_EQ(streamed, LocalHttpServer::Bytes(3000));
+  EXPECT_EQ(cache.GetEntryCount(), 1u);
+
+  EXPECT_EQ(client.Get(url), LocalHttpServer::Bytes(3000));
+  EXPECT_EQ(client.GetHttpCode(), 200);
+  EXPECT_EQ(server.GetRequestCount(), 2);
+  EXPECT_EQ(server.GetNotModifiedCount(), 1);
+
+  // Requests with credentials bypass the cache.
+  client.SetBearerToken("token");
+  EXPECT_EQ(client.Get(url), LocalHttpServer::Bytes(3000));
+  EXPECT_EQ(server.GetRequestCount(), 3);
+  EXPECT_EQ(server.GetNotModifiedCount(), 1);
+}
+
+TEST_F(HttpCacheTest, SharesBlobsAndEvictsLeastRecentlyUsed) {
+  HttpCache::Options options;
+  options.max_bytes = 2500;
+  HttpCache cache(directory, options);
+  CurlClient client;
+  client.SetCache(&cache);
+
+  // The same content behind two URLs is stored once.
+  client.Get(server.Url("/cached/60/1000?a"));
+  client.Get(server.Url("/cached/60/1000?b"));
+  EXPECT_EQ(cache.GetEntryCount(), 2u);
+  EXPECT_EQ(cache.GetSize(), 1000u);
+
+  client.Get(server.Url("/cached/60/1200"));
+  client.Get(server.Url("/cached/60/1000?a"));
+  // Evicts ?b, whose blob stays in use, then 1200.
+  client.Get(server.Url("/cached/60/1300"));
+  EXPECT_EQ(cache.GetEntryCount(), 2u);
+  EXPECT_EQ(cache.GetSize(), 2300u);
+
+  const int requests = server.GetRequestCount();
+  EXPECT_EQ(client.Get(server.Url("/cached/60/1000?a")),
+            LocalHttpServer::Bytes(1000));
+  EXPECT_EQ(server.GetRequestCount(), requests);
+  client.Get(server.Url("/cached/60/1200"));
+  EXPECT_EQ(server.GetRequestCount(), requests + 1);
+}
+
+TEST_F(HttpCacheTest, RecoversAfterCrash) {
+  const auto url = server.Url("/cached/60/100");
+  {
+    HttpCache cache(directory);
+    CurlClient client;
+    client.SetCache(&cache);
+    client.Get(url);
+  }
+  // A record torn while being appended, and a blob never recorded.
+  std::ofstream(directory + "/index", std::ios::app) << "P\thttp://torn";
+  const auto orphan = directory + "/blobs/0.tmp";
+  std::ofstream(orphan) << "partial";
+
+  HttpCache cache(directory);
+  EXPECT_EQ(cache.GetEntryCount(), 1u);
+  EXPECT_FALSE(std::filesystem::exists(orphan));
+  CurlClient client;
+  client.SetCache(&cache);
+  EXPECT_EQ(client.Get(url), LocalHttpServer::Bytes(100));
+  EXPECT_EQ(server.GetRequestCount(), 1);
+}
+
 int main(int argc, char** argv) {
   InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -17,133 +17,187 @@
 #include "appstream_catalog.h"
 
 #include <algorithm>
-#include <fstream>
 
-#include <libxml/parser.h>
+#include <libxml/xmlreader.h>
 #include <libxml/xmlstring.h>
 #include <zlib.h>
 
+#include "appstream_snapshot.h"
 #include "plugins/common/common.h"
 
+namespace {
+
+// xmlReaderForIO callbacks; gzread passes uncompressed files through as-is.
+int readGz(void* context, char* buffer, const int len) {
+  return gzread(static_cast<gzFile>(context), buffer,
+                static_cast<unsigned>(len));
+}
+
+int closeGz(void* context) {
+  return gzclose(static_cast<gzFile>(context)) == Z_OK ? 0 : -1;
+}
+
+}  // namespace
+
 AppstreamCatalog::AppstreamCatalog(const std::string& filePath,
-                                   std::string language)
+                                   std::string language,
+                                   const std::string& snapshotPath)
     : language_(std::move(language)) {
-  parseXmlFile(filePath);
+  // Stamp before parsing, so a catalog replaced mid-parse is not recorded as
+  // current.
+  const auto stamp = snapshotPath.empty()
+                         ? std::nullopt
+                         : AppstreamSnapshot::stamp(filePath);
+  if (stamp && AppstreamSnapshot::load(snapshotPath, *stamp, *this)) {
+    spdlog::debug("Loaded {} components from {}", components_.size(),
+                  snapshotPath);
+  } else {
+    parseXmlFile(filePath);
+    if (stamp && !components_.empty()) {
+      AppstreamSnapshot::save(snapshotPath, *stamp, *this);
+    }
+  }
 }
 
 AppstreamCatalog::~AppstreamCatalog() = default;
 
 void AppstreamCatalog::parseXmlFile(const std::string& filePath) {
-  xmlDoc* document = xmlReadFile(filePath.c_str(), nullptr, 0);
-  if (document == nullptr) {
+  const auto gz = gzopen(filePath.c_str(), "rb");
+  if (!gz) {
+    spdlog::error("Failed to open {} for reading", filePath);
+    return;
+  }
+  gzbuffer(gz, 128 * 1024);
+
+  // The reader owns |gz| from here on and closes it, also on failure.
+  xmlTextReaderPtr reader = xmlReaderForIO(readGz, closeGz, gz,
+                                           filePath.c_str(), nullptr,
+                                           XML_PARSE_NONET | XML_PARSE_COMPACT);
+  if (reader == nullptr) {
     spdlog::error("Failed to parse {}", filePath);
     return;
   }
 
-  const xmlNode* root = xmlDocGetRootElement(document);
-  for (const xmlNode* node = root->children; node; node = node->next) {
-    if (node->type == XML_ELEMENT_NODE &&
-        xmlStrEqual(node->name,
-                    reinterpret_cast<const xmlChar*>("component"))) {
-      Component component(node, language_);
-      components_.push_back(component);
-
-      if (component.getCategories()) {
-        const auto& componentCategories = component.getCategories().value();
-        uniqueCategories_.insert(componentCategories.begin(),
-                                 componentCategories.end());
-      }
-      if (component.getKeywords()) {
-        const auto& componentKeywords = component.getKeywords().value();
-        uniqueKeywords_.insert(componentKeywords.begin(),
-                               componentKeywords.end());
+  const auto componentName = reinterpret_cast<const xmlChar*>("component");
+  int rc = xmlTextReaderRead(reader);
+  while (rc == 1) {
+    if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT &&
+        xmlTextReaderDepth(reader) == 1 &&
+        xmlStrEqual(xmlTextReaderConstLocalName(reader), componentName)) {
+      // Materialize only this subtree; the reader frees it once we move on.
+      if (const xmlNode* node = xmlTextReaderExpand(reader)) {
+        addComponent(Component(node, language_));
       }
+      rc = xmlTextReaderNext(reader);
+      continue;
     }
+    rc = xmlTextReaderRead(reader);
+  }
+  if (rc < 0) {
+    spdlog::error("Failed to parse {} after {} components", filePath,
+                  components_.size());
   }
 
-  xmlFreeDoc(document);
-  xmlCleanupParser();
+  xmlFreeTextReader(reader);
 }
 
-void AppstreamCatalog::decompressGzFile(const std::string& gzPath,
-                                        const std::string& xmlPath) {
-  const auto gz = gzopen(gzPath.c_str(), "rb");
-  if (!gz) {
-    spdlog::error("Failed to open {} for reading", gzPath);
-    return;
+void AppstreamCatalog::addComponent(Component component) {
+  const size_t index = components_.size();
+  // The first occurrence of an id wins, as it did for the linear lookup.
+  idIndex_.emplace(component.getId(), index);
+  if (const auto& categories = component.getCategories()) {
+    for (const auto& category : categories.value()) {
+      categoryIndex_[category].push_back(index);
+    }
   }
+  if (const auto& keywords = component.getKeywords()) {
+    for (const auto& keyword : keywords.value()) {
+      keywordIndex_[keyword].push_back(index);
+    }
+  }
+  components_.push_back(std::move(component));
+}
 
-  std::ofstream outFile(xmlPath, std::ios::binary);
-  if (!outFile) {
-    spdlog::error("Failed to open {} for writing", xmlPath);
-    gzclose(gz);
-    return;
+std::vector<const Component*> AppstreamCatalog::lookup(
+    const Index& index,
+    const std::string& term,
+    const bool sorted,
+    const std::string& key) const {
+  std::vector<const Component*> results;
+  const auto it = index.find(term);
+  if (it == index.end()) {
+    return results;
+  }
+  results.reserve(it->second.size());
+  for (const size_t position : it->second) {
+    results.push_back(&components_[position]);
+  }
+  if (!sorted) {
+    return results;
   }
 
-  char buffer[8192];
-  int bytesRead;
-  while ((bytesRead = gzread(gz, buffer, sizeof(buffer))) > 0) {
-    outFile.write(buffer, bytesRead);
+  const std::string& (Component::*field)() const = nullptr;
+  if (key == "name") {
+    field = &Component::getName;
+  } else if (key == "id") {
+    field = &Component::getId;
+  } else if (key == "summary") {
+    field = &Component::getSummary;
+  } else {
+    spdlog::warn("Unsupported sort key '{}', keeping catalog order", key);
+    return results;
   }
+  std::stable_sort(results.begin(), results.end(),
+                   [field](const Component* a, const Component* b) {
+                     return (a->*field)() < (b->*field)();
+                   });
+  return results;
+}
 
-  outFile.close();
-  gzclose(gz);
+std::unordered_set<std::string> AppstreamCatalog::indexTerms(
+    const Index& index) {
+  std::unordered_set<std::string> terms;
+  terms.reserve(index.size());
+  for (const auto& [term, positions] : index) {
+    terms.insert(term);
+  }
+  return terms;
 }
 
-std::vector<Component> AppstreamCatalog::searchByCategory(
+std::vector<const Component*> AppstreamCatalog::searchByCategory(
     const std::string& category,
     const bool sorted,
     const std::string& key) const {
-  std::vector<Component> results;
-  for (const auto& component : components_) {
-    if (component.getCategories() &&
-        component.getCategories().value().count(category)) {
-      results.push_back(component);
-    }
-  }
-  if (sorted) {
-    std::sort(results.begin(), results.end(),
-              [&key](const Component& a, const Component& b) {
-                if (key == "name") {
-                  return a.getName() < b.getName();
-                }
-                return false;
-              });
-  }
-  return results;
+  return lookup(categoryIndex_, category, sorted, key);
 }
 
-std::vector<Component> AppstreamCatalog::searchByKeyword(
+std::vector<const Component*> AppstreamCatalog::searchByKeyword(
     const std::string& keyword,
     const bool sorted,
     const std::string& key) const {
-  std::vector<Component> results;
-  for (const auto& component : components_) {
-    if (component.getKeywords() &&
-        component.getKeywords().value().count(keyword)) {
-      results.push_back(component);
-    }
-  }
-  if (sorted) {
-    std::sort(results.begin(), results.end(),
-              [&key](const Component& a, const Component& b) {
-                if (key == "name") {
-                  return a.getName() < b.getName();
-                }
-                return false;
-              });
-  }
-  return results;
+  return lookup(keywordIndex_, keyword, sorted, key);
 }
 
-std::optional<Component> AppstreamCatalog::searchById(
-    const std::string& id) const {
-  for (const auto& component : components_) {
-    if (component.getId() == id) {
-      return component;
-    }
+const Component* AppstreamCatalog::searchById(const std::string& id) const {
+  const auto it = idIndex_.find(id);
+  return it != idIndex_.end() ? &components_[it->second] : nullptr;
+}
+
+std::vector<const Component*> AppstreamCatalog::search(
+    const std::string& query,
+    const size_t limit) const {
+  // Building the index costs about as much as restoring a snapshot, so
+  // catalogs that are never searched do not pay for it.
+  std::call_once(searchIndexOnce_,
+                 [this] { searchIndex_ = AppstreamSearchIndex(components_); });
+
+  std::vector<const Component*> results;
+  const auto hits = searchIndex_.search(query, limit);
+  results.reserve(hits.size());
+  for (const auto& hit : hits) {
+    results.push_back(&components_[hit.component]);
   }
-  return std::nullopt;
+  return results;
 }
 
 size_t AppstreamCatalog::getTotalComponentCount() const {
@@ -151,11 +205,11 @@ size_t AppstreamCatalog::getTotalComponentCount() const {
 }
 
 std::unordered_set<std::string> AppstreamCatalog::getUniqueCategories() const {
-  return uniqueCategories_;
+  return indexTerms(categoryIndex_);
 }
 
 std::unordered_set<std::string> AppstreamCatalog::getUniqueKeywords() const {
-  return uniqueKeywords_;
+  return indexTerms(keywordIndex_);
 }
 
 const std::vector<Component>& AppstreamCatalog::getComponents() const {
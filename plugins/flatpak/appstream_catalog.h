@@ -17,33 +17,63 @@
 #ifndef PLUGINS_FLATPAK_APPSTREAM_CATALOG_H
 #define PLUGINS_FLATPAK_APPSTREAM_CATALOG_H
 
+#include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "appstream_search_index.h"
 #include "component.h"
 
+/**
+ * @brief In-memory AppStream catalog.
+ *
+ * The (optionally gzip compressed) catalog is streamed through an
+ * xmlTextReader, so only one <component> subtree is materialized at a time.
+ * Lookups by id, category and keyword go through inverted indexes holding
+ * positions in getComponents(); results point into the catalog and stay
+ * valid for its lifetime. search() answers ranked free text and type-ahead
+ * queries from an AppstreamSearchIndex built on first use.
+ */
 class AppstreamCatalog {
  public:
-  explicit AppstreamCatalog(const std::string& filePath, std::string language);
+  /**
+   * @param filePath AppStream catalog, plain or gzip compressed
+   * @param language Language used for localized fields
+   * @param snapshotPath Optional binary snapshot that is loaded instead of
+   * parsing while it matches the catalog, and (re)written otherwise
+   */
+  explicit AppstreamCatalog(const std::string& filePath,
+                            std::string language,
+                            const std::string& snapshotPath = "");
 
   ~AppstreamCatalog();
 
   [[nodiscard]] const std::vector<Component>& getComponents() const;
 
-  [[nodiscard]] std::vector<Component> searchByCategory(
+  [[nodiscard]] std::vector<const Component*> searchByCategory(
       const std::string& category,
       bool sorted = false,
       const std::string& key = "") const;
 
-  [[nodiscard]] std::vector<Component> searchByKeyword(
+  [[nodiscard]] std::vector<const Component*> searchByKeyword(
       const std::string& keyword,
       bool sorted = false,
       const std::string& key = "") const;
 
-  [[nodiscard]] std::optional<Component> searchById(
-      const std::string& id) const;
+  [[nodiscard]] const Component* searchById(const std::string& id) const;
+
+  /**
+   * @brief Ranked full-text search over names, ids, keywords, summaries and
+   * descriptions. The last query word also matches as a prefix.
+   * @param query Free text query
+   * @param limit Maximum number of results
+   * @return The best matches, most relevant first
+   */
+  [[nodiscard]] std::vector<const Component*> search(const std::string& query,
+                                                     size_t limit = 20) const;
 
   [[nodiscard]] size_t getTotalComponentCount() const;
 
@@ -52,16 +82,30 @@ class AppstreamCatalog {
   [[nodiscard]] std::unordered_set<std::string> getUniqueKeywords() const;
 
  private:
+  friend class AppstreamSnapshot;
+
+  using Index = std::unordered_map<std::string, std::vector<size_t>>;
+
   std::string language_;
 
   void parseXmlFile(const std::string& filePath);
 
-  static void decompressGzFile(const std::string& gzPath,
-                               const std::string& xmlPath);
+  void addComponent(Component component);
+
+  [[nodiscard]] std::vector<const Component*> lookup(
+      const Index& index,
+      const std::string& term,
+      bool sorted,
+      const std::string& key) const;
+
+  static std::unordered_set<std::string> indexTerms(const Index& index);
 
   std::vector<Component> components_;
-  std::unordered_set<std::string> uniqueCategories_;
-  std::unordered_set<std::string> uniqueKeywords_;
+  std::unordered_map<std::string, size_t> idIndex_;
+  Index categoryIndex_;
+  Index keywordIndex_;
+  mutable std::once_flag searchIndexOnce_;
+  mutable AppstreamSearchIndex searchIndex_;
 };
 
 #endif  // APPSTREAM_CATALOG_H
@@ -0,0 +1,321 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "appstream_search_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+
+// Field weights for the term frequencies (BM25F style).
+constexpr float kNameWeight = 3.0f;
+constexpr float kKeywordWeight = 2.0f;
+constexpr float kSummaryWeight = 1.5f;
+constexpr float kIdWeight = 1.0f;
+constexpr float kDescriptionWeight = 1.0f;
+
+// BM25 saturation and length normalization.
+constexpr float kK1 = 1.2f;
+constexpr float kB = 0.75f;
+
+// Score factor for terms that only match a typed prefix.
+constexpr float kPrefixMatchFactor = 0.75f;
+
+// Decodes one UTF-8 sequence at |pos|. Invalid bytes decode to 0 and are
+// skipped one at a time.
+uint32_t decodeUtf8(const std::string& text, size_t& pos) {
+  const auto byte = [&text](const size_t i) {
+    return static_cast<unsigned char>(text[i]);
+  };
+  const unsigned char lead = byte(pos);
+  size_t length = 1;
+  uint32_t codepoint = 0;
+  if (lead < 0x80) {
+    codepoint = lead;
+  } else if ((lead & 0xE0) == 0xC0) {
+    length = 2;
+    codepoint = lead & 0x1F;
+  } else if ((lead & 0xF0) == 0xE0) {
+    length = 3;
+    codepoint = lead & 0x0F;
+  } else if ((lead & 0xF8) == 0xF0) {
+    length = 4;
+    codepoint = lead & 0x07;
+  } else {
+    pos++;
+    return 0;
+  }
+  if (pos + length > text.size()) {
+    pos++;
+    return 0;
+  }
+  for (size_t i = 1; i < length; i++) {
+    if ((byte(pos + i) & 0xC0) != 0x80) {
+      pos++;
+      return 0;
+    }
+    codepoint = (codepoint << 6) | (byte(pos + i) & 0x3F);
+  }
+  pos += length;
+  return codepoint;
+}
+
+void appendUtf8(std::string& out, const uint32_t codepoint) {
+  if (codepoint < 0x80) {
+    out += static_cast<char>(codepoint);
+  } else if (codepoint < 0x800) {
+    out += static_cast<char>(0xC0 | (codepoint >> 6));
+    out += static_cast<char>(0x80 | (codepoint & 0x3F));
+  } else if (codepoint < 0x10000) {
+    out += static_cast<char>(0xE0 | (codepoint >> 12));
+    out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (codepoint & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (codepoint >> 18));
+    out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (codepoint & 0x3F));
+  }
+}
+
+// Simple case folding for the scripts AppStream catalogs mostly use.
+uint32_t foldCase(const uint32_t c) {
+  if (c >= 'A' && c <= 'Z') {
+    return c + 0x20;
+  }
+  if (c < 0xC0) {
+    return c;
+  }
+  if (c <= 0xDE && c != 0xD7) {
+    return c + 0x20;
+  }
+  if ((c >= 0x100 && c <= 0x137) || (c >= 0x14A && c <= 0x177)) {
+    return c | 1;
+  }
+  if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E)) {
+    return (c & 1) ? c + 1 : c;
+  }
+  if (c == 0x178) {
+    return 0xFF;
+  }
+  if (c == 0x386) {
+    return 0x3AC;
+  }
+  if (c >= 0x388 && c <= 0x38A) {
+    return c + 0x25;
+  }
+  if (c == 0x38C) {
+    return 0x3CC;
+  }
+  if (c == 0x38E || c == 0x38F) {
+    return c + 0x3F;
+  }
+  if (c >= 0x391 && c <= 0x3A9 && c != 0x3A2) {
+    return c + 0x20;
+  }
+  if (c == 0x3C2) {
+    return 0x3C3;
+  }
+  if (c >= 0x400 && c <= 0x40F) {
+    return c + 0x50;
+  }
+  if (c >= 0x410 && c <= 0x42F) {
+    return c + 0x20;
+  }
+  return c;
+}
+
+bool isWordCharacter(const uint32_t c) {
+  if (c < 0x80) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+           (c >= 'A' && c <= 'Z');
+  }
+  // Latin-1 punctuation, multiplication/division signs, general punctuation
+  // and symbol blocks, CJK punctuation and fullwidth ASCII punctuation.
+  return !(c < 0xC0 || c == 0xD7 || c == 0xF7 ||
+           (c >= 0x2000 && c <= 0x2BFF) || (c >= 0x3000 && c <= 0x303F) ||
+           (c >= 0xFE30 && c <= 0xFE4F) || (c >= 0xFF00 && c <= 0xFF0F));
+}
+
+bool startsWith(const std::string& value, const std::string& prefix) {
+  return value.compare(0, prefix.size(), prefix) == 0;
+}
+
+}  // namespace
+
+AppstreamSearchIndex::AppstreamSearchIndex(
+    const std::vector<Component>& components) {
+  std::unordered_map<std::string, std::vector<Posting>> postings;
+  std::unordered_map<std::string, float> frequencies;
+  double totalLength = 0.0;
+  lengths_.reserve(components.size());
+
+  for (size_t i = 0; i < components.size(); i++) {
+    const auto& component = components[i];
+    frequencies.clear();
+    float length = 0.0f;
+    const auto add = [&](const std::string& text, const float weight) {
+      for (auto& token : tokenize(text)) {
+        frequencies[std::move(token)] += weight;
+        length += weight;
+      }
+    };
+
+    add(component.getName(), kNameWeight);
+    add(component.getId(), kIdWeight);
+    add(component.getSummary(), kSummaryWeight);
+    if (const auto& keywords = component.getKeywords()) {
+      for (const auto& keyword : keywords.value()) {
+        add(keyword, kKeywordWeight);
+      }
+    }
+    if (const auto& description = component.getDescription()) {
+      add(description.value(), kDescriptionWeight);
+    }
+
+    for (const auto& [term, frequency] : frequencies) {
+      postings[term].push_back({static_cast<uint32_t>(i), frequency});
+    }
+    lengths_.push_back(length);
+    totalLength += length;
+  }
+  if (!components.empty()) {
+    averageLength_ = static_cast<float>(totalLength / components.size());
+  }
+
+  terms_.reserve(postings.size());
+  for (const auto& [term, list] : postings) {
+    terms_.push_back(term);
+  }
+  std::sort(terms_.begin(), terms_.end());
+
+  offsets_.reserve(terms_.size() + 1);
+  for (const auto& term : terms_) {
+    offsets_.push_back(static_cast<uint32_t>(postings_.size()));
+    const auto& list = postings[term];
+    postings_.insert(postings_.end(), list.begin(), list.end());
+  }
+  offsets_.push_back(static_cast<uint32_t>(postings_.size()));
+}
+
+std::vector<std::string> AppstreamSearchIndex::tokenize(
+    const std::string& text) {
+  std::vector<std::string> tokens;
+  std::string token;
+  size_t pos = 0;
+  while (pos < text.size()) {
+    if (const uint32_t codepoint = decodeUtf8(text, pos);
+        isWordCharacter(codepoint)) {
+      appendUtf8(token, foldCase(codepoint));
+    } else if (!token.empty()) {
+      tokens.push_back(std::move(token));
+      token.clear();
+    }
+  }
+  if (!token.empty()) {
+    tokens.push_back(std::move(token));
+  }
+  return tokens;
+}
+
+float AppstreamSearchIndex::score(const Posting& posting,
+                                  const float idf) const {
+  const float norm =
+      kK1 * (1.0f - kB + kB * lengths_[posting.component] / averageLength_);
+  return idf * posting.frequency * (kK1 + 1.0f) / (posting.frequency + norm);
+}
+
+std::vector<AppstreamSearchIndex::Hit> AppstreamSearchIndex::search(
+    const std::string& query,
+    const size_t limit) const {
+  const auto tokens = tokenize(query);
+  if (tokens.empty() || limit == 0 || lengths_.empty()) {
+    return {};
+  }
+
+  const auto documents = static_cast<float>(lengths_.size());
+  std::vector<float> scores(lengths_.size(), 0.0f);
+  std::vector<uint16_t> matches(lengths_.size(), 0);
+  // Best score per component for the current token, so several completions
+  // of a prefix do not add up.
+  std::vector<float> tokenScores(lengths_.size(), 0.0f);
+  std::vector<uint32_t> touched;
+  std::vector<uint32_t> candidates;
+
+  for (size_t t = 0; t < tokens.size(); t++) {
+    const auto& token = tokens[t];
+    const bool prefix = t + 1 == tokens.size();
+    auto first = std::lower_bound(terms_.begin(), terms_.end(), token);
+    auto last = first;
+    if (prefix) {
+      while (last != terms_.end() && startsWith(*last, token)) {
+        ++last;
+      }
+    } else if (last != terms_.end() && *last == token) {
+      ++last;
+    }
+
+    touched.clear();
+    for (auto term = first; term != last; ++term) {
+      const auto index = static_cast<size_t>(term - terms_.begin());
+      const uint32_t begin = offsets_[index];
+      const uint32_t end = offsets_[index + 1];
+      const auto df = static_cast<float>(end - begin);
+      float idf = std::log(1.0f + (documents - df + 0.5f) / (df + 0.5f));
+      if (term->size() != token.size()) {
+        idf *= kPrefixMatchFactor;
+      }
+      for (uint32_t p = begin; p < end; p++) {
+        const auto& posting = postings_[p];
+        const float value = score(posting, idf);
+        float& best = tokenScores[posting.component];
+        if (best == 0.0f) {
+          touched.push_back(posting.component);
+        }
+        best = std::max(best, value);
+      }
+    }
+
+    for (const uint32_t component : touched) {
+      scores[component] += tokenScores[component];
+      matches[component]++;
+      tokenScores[component] = 0.0f;
+    }
+    if (t == 0) {
+      candidates = touched;
+    }
+  }
+
+  std::vector<Hit> hits;
+  for (const uint32_t component : candidates) {
+    if (matches[component] == tokens.size()) {
+      hits.push_back({component, scores[component]});
+    }
+  }
+  const auto ranked = [](const Hit& a, const Hit& b) {
+    return a.score != b.score ? a.score > b.score : a.component < b.component;
+  };
+  if (hits.size() > limit) {
+    std::partial_sort(hits.begin(), hits.begin() + static_cast<long>(limit),
+                      hits.end(), ranked);
+    hits.resize(limit);
+  } else {
+    std::sort(hits.begin(), hits.end(), ranked);
+  }
+  return hits;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_APPSTREAM_SEARCH_INDEX_H
+#define PLUGINS_FLATPAK_APPSTREAM_SEARCH_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "component.h"
+
+/**
+ * @brief Ranked full-text index over AppStream components.
+ *
+ * Names, ids, keywords, summaries and descriptions are tokenized on word
+ * boundaries and case-folded (ASCII, Latin-1, Latin Extended-A, Greek and
+ * Cyrillic). Terms live in a sorted dictionary, so a prefix maps to one
+ * contiguous term range. Matches are ranked with BM25 over the weighted
+ * field frequencies. The index is immutable after construction and safe for
+ * concurrent searches.
+ */
+class AppstreamSearchIndex {
+ public:
+  struct Hit {
+    size_t component;
+    float score;
+  };
+
+  AppstreamSearchIndex() = default;
+
+  explicit AppstreamSearchIndex(const std::vector<Component>& components);
+
+  /**
+   * @brief Finds the best matching components.
+   *
+   * Every query token has to match. The last token also matches as a prefix
+   * so results update while typing; prefix-only matches rank below exact
+   * ones.
+   * @param query Free text query
+   * @param limit Maximum number of hits
+   * @return Hits ordered by descending score, ties by catalog order
+   */
+  [[nodiscard]] std::vector<Hit> search(const std::string& query,
+                                        size_t limit) const;
+
+  /**
+   * @brief Splits text into case-folded UTF-8 tokens.
+   * @param text UTF-8 text
+   * @return The tokens in order of appearance
+   */
+  static std::vector<std::string> tokenize(const std::string& text);
+
+  [[nodiscard]] size_t getTermCount() const { return terms_.size(); }
+
+ private:
+  struct Posting {
+    uint32_t component;
+    float frequency;
+  };
+
+  [[nodiscard]] float score(const Posting& posting, float idf) const;
+
+  // The postings of terms_[i] are postings_[offsets_[i], offsets_[i + 1]).
+  std::vector<std::string> terms_;
+  std::vector<uint32_t> offsets_;
+  std::vector<Posting> postings_;
+  std::vector<float> lengths_;
+  float averageLength_ = 0.0f;
+};
+
+#endif  // PLUGINS_FLATPAK_APPSTREAM_SEARCH_INDEX_H
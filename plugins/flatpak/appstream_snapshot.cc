@@ -0,0 +1,818 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "appstream_snapshot.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "appstream_catalog.h"
+#include "plugins/common/common.h"
+
+namespace {
+
+// All records are host-endian PODs made of 32-bit fields. Bump the version
+// whenever a record or the set of sections changes.
+constexpr char kMagic[8] = {'F', 'P', 'A', 'S', 'N', 'A', 'P', '\0'};
+constexpr uint32_t kFormatVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+constexpr int32_t kNoNumber = std::numeric_limits<int32_t>::min();
+
+struct StringRef {
+  uint32_t offset;
+  uint32_t length;
+};
+
+struct Range {
+  uint32_t first;
+  uint32_t count;
+};
+
+constexpr StringRef kNoString{kNone, 0};
+constexpr Range kNoRange{kNone, 0};
+
+struct IconRecord {
+  StringRef type;
+  int32_t width;
+  int32_t height;
+  int32_t scale;
+  StringRef path;
+};
+
+struct ReleaseRecord {
+  StringRef version;
+  StringRef timestamp;
+  StringRef description;
+  StringRef downloadSize;
+};
+
+struct ImageRecord {
+  StringRef type;
+  int32_t width;
+  int32_t height;
+  StringRef url;
+};
+
+struct VideoRecord {
+  StringRef container;
+  StringRef codec;
+  int32_t width;
+  int32_t height;
+  StringRef url;
+};
+
+struct ScreenshotRecord {
+  StringRef type;
+  Range captions;
+  Range images;
+  uint32_t video;
+  uint32_t reserved;
+};
+
+struct RatingRecord {
+  StringRef attribute;
+  int32_t value;
+  uint32_t reserved;
+};
+
+struct ComponentRecord {
+  StringRef id;
+  StringRef name;
+  StringRef summary;
+  StringRef pkgname;
+  StringRef version;
+  StringRef origin;
+  StringRef mediaBaseurl;
+  StringRef architecture;
+  StringRef projectLicense;
+  StringRef description;
+  StringRef url;
+  StringRef projectGroup;
+  StringRef sourcePkgname;
+  StringRef bundle;
+  StringRef contentRatingType;
+  StringRef agreement;
+  Range categories;
+  Range keywords;
+  Range languages;
+  Range suggests;
+  Range provides;
+  Range compulsoryForDesktop;
+  Range developer;
+  Range launchable;
+  Range icons;
+  Range releases;
+  Range screenshots;
+  Range contentRating;
+};
+
+struct IdRecord {
+  StringRef id;
+  uint32_t component;
+  uint32_t reserved;
+};
+
+struct TermRecord {
+  StringRef term;
+  Range positions;
+};
+
+enum Section : uint32_t {
+  kStrings,
+  kStringLists,
+  kIcons,
+  kReleases,
+  kImages,
+  kVideos,
+  kScreenshots,
+  kRatings,
+  kComponents,
+  kIdIndex,
+  kCategoryIndex,
+  kKeywordIndex,
+  kPositions,
+  kSectionCount
+};
+
+struct SectionEntry {
+  uint64_t offset;
+  uint64_t size;
+};
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint64_t sourceSize;
+  int64_t sourceMtimeNs;
+  StringRef language;
+  uint32_t componentCount;
+  uint32_t reserved;
+  SectionEntry sections[kSectionCount];
+};
+
+static_assert(std::is_trivially_copyable_v<Header>);
+static_assert(std::is_trivially_copyable_v<ComponentRecord>);
+
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      if (void* data = mmap(nullptr, static_cast<size_t>(st.st_size),
+                            PROT_READ, MAP_PRIVATE, fd, 0);
+          data != MAP_FAILED) {
+        data_ = static_cast<const char*>(data);
+        size_ = static_cast<size_t>(st.st_size);
+      }
+    }
+    close(fd);
+  }
+
+  ~MappedFile() {
+    if (data_) {
+      munmap(const_cast<char*>(data_), size_);
+    }
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  [[nodiscard]] const char* data() const { return data_; }
+  [[nodiscard]] size_t size() const { return size_; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+template <typename T>
+struct Span {
+  const T* data = nullptr;
+  size_t size = 0;
+};
+
+}  // namespace
+
+// Flattens a catalog into the record sections. Repeated strings such as
+// categories, licenses and media URLs are stored once.
+class AppstreamSnapshotWriter {
+ public:
+  StringRef string(const std::string& value) {
+    const auto [it, inserted] = stringOffsets_.try_emplace(
+        value, static_cast<uint32_t>(strings_.size()));
+    if (inserted) {
+      strings_ += value;
+    }
+    return {it->second, static_cast<uint32_t>(value.size())};
+  }
+
+  StringRef string(const std::optional<std::string>& value) {
+    return value ? string(*value) : kNoString;
+  }
+
+  static int32_t number(const std::optional<int>& value) {
+    return value ? *value : kNoNumber;
+  }
+
+  template <typename Container>
+  Range stringList(const Container& values) {
+    const Range range{static_cast<uint32_t>(stringLists_.size()),
+                      static_cast<uint32_t>(values.size())};
+    for (const auto& value : values) {
+      stringLists_.push_back(string(value));
+    }
+    return range;
+  }
+
+  template <typename Container>
+  Range stringList(const std::optional<Container>& values) {
+    return values ? stringList(*values) : kNoRange;
+  }
+
+  Range icons(const std::optional<std::vector<Icon>>& icons) {
+    if (!icons) {
+      return kNoRange;
+    }
+    const Range range{static_cast<uint32_t>(icons_.size()),
+                      static_cast<uint32_t>(icons->size())};
+    for (const auto& icon : *icons) {
+      icons_.push_back({string(icon.type_), number(icon.width_),
+                        number(icon.height_), number(icon.scale_),
+                        string(icon.path_)});
+    }
+    return range;
+  }
+
+  Range releases(const std::optional<std::vector<Release>>& releases) {
+    if (!releases) {
+      return kNoRange;
+    }
+    const Range range{static_cast<uint32_t>(releases_.size()),
+                      static_cast<uint32_t>(releases->size())};
+    for (const auto& release : *releases) {
+      releases_.push_back({string(release.version_),
+                           string(release.timestamp_),
+                           string(release.description_),
+                           string(release.downloadSize_)});
+    }
+    return range;
+  }
+
+  Range screenshots(const std::optional<std::vector<Screenshot>>& screenshots) {
+    if (!screenshots) {
+      return kNoRange;
+    }
+    // Nested images, captions and videos land in their own sections, so the
+    // screenshot records of one component stay contiguous.
+    std::vector<ScreenshotRecord> records;
+    records.reserve(screenshots->size());
+    for (const auto& screenshot : *screenshots) {
+      ScreenshotRecord record{string(screenshot.type_),
+                              stringList(screenshot.captions_), kNoRange,
+                              kNone, 0};
+      if (screenshot.images_) {
+        record.images = {static_cast<uint32_t>(images_.size()),
+                         static_cast<uint32_t>(screenshot.images_->size())};
+        for (const auto& image : *screenshot.images_) {
+          images_.push_back({string(image.type_), number(image.width_),
+                             number(image.height_), string(image.url_)});
+        }
+      }
+      if (const auto& video = screenshot.video_) {
+        record.video = static_cast<uint32_t>(videos_.size());
+        videos_.push_back({string(video->container_), string(video->codec_),
+                           number(video->width_), number(video->height_),
+                           string(video->url_)});
+      }
+      records.push_back(record);
+    }
+    const Range range{static_cast<uint32_t>(screenshots_.size()),
+                      static_cast<uint32_t>(records.size())};
+    screenshots_.insert(screenshots_.end(), records.begin(), records.end());
+    return range;
+  }
+
+  Range contentRating(
+      const std::optional<std::map<std::string, Component::ContentRatingValue>>&
+          rating) {
+    if (!rating) {
+      return kNoRange;
+    }
+    const Range range{static_cast<uint32_t>(ratings_.size()),
+                      static_cast<uint32_t>(rating->size())};
+    for (const auto& [attribute, value] : *rating) {
+      ratings_.push_back({string(attribute), value, 0});
+    }
+    return range;
+  }
+
+  void component(const Component& c) {
+    components_.push_back(
+        {string(c.id_),
+         string(c.name_),
+         string(c.summary_),
+         string(c.pkgname_),
+         string(c.version_),
+         string(c.origin_),
+         string(c.mediaBaseurl_),
+         string(c.architecture_),
+         string(c.projectLicense_),
+         string(c.description_),
+         string(c.url_),
+         string(c.projectGroup_),
+         string(c.sourcePkgname_),
+         string(c.bundle_),
+         string(c.contentRatingType_),
+         string(c.agreement_),
+         stringList(c.categories_),
+         stringList(c.keywords_),
+         stringList(c.languages_),
+         stringList(c.suggests_),
+         stringList(c.provides_),
+         stringList(c.compulsoryForDesktop_),
+         stringList(c.developer_),
+         stringList(c.launchable_),
+         icons(c.icons_),
+         releases(c.releases_),
+         screenshots(c.screenshots_),
+         contentRating(c.contentRating_)});
+  }
+
+  void idIndex(const std::unordered_map<std::string, size_t>& index) {
+    for (const auto& [id, position] : index) {
+      idIndex_.push_back({string(id), static_cast<uint32_t>(position), 0});
+    }
+  }
+
+  std::vector<TermRecord> termIndex(
+      const std::unordered_map<std::string, std::vector<size_t>>& index) {
+    std::vector<TermRecord> records;
+    records.reserve(index.size());
+    for (const auto& [term, positions] : index) {
+      records.push_back({string(term),
+                         {static_cast<uint32_t>(positions_.size()),
+                          static_cast<uint32_t>(positions.size())}});
+      for (const size_t position : positions) {
+        positions_.push_back(static_cast<uint32_t>(position));
+      }
+    }
+    return records;
+  }
+
+  std::string serialize(Header header,
+                        const std::vector<TermRecord>& categoryIndex,
+                        const std::vector<TermRecord>& keywordIndex) const {
+    std::string file(sizeof(Header), '\0');
+    const auto append = [&](const Section section, const void* data,
+                            const size_t bytes) {
+      file.resize((file.size() + 7) & ~size_t{7}, '\0');
+      header.sections[section] = {file.size(), bytes};
+      file.append(static_cast<const char*>(data), bytes);
+    };
+    const auto appendRecords = [&](const Section section, const auto& records) {
+      append(section, records.data(),
+             records.size() * sizeof(typename std::decay_t<
+                                     decltype(records)>::value_type));
+    };
+
+    append(kStrings, strings_.data(), strings_.size());
+    appendRecords(kStringLists, stringLists_);
+    appendRecords(kIcons, icons_);
+    appendRecords(kReleases, releases_);
+    appendRecords(kImages, images_);
+    appendRecords(kVideos, videos_);
+    appendRecords(kScreenshots, screenshots_);
+    appendRecords(kRatings, ratings_);
+    appendRecords(kComponents, components_);
+    appendRecords(kIdIndex, idIndex_);
+    appendRecords(kCategoryIndex, categoryIndex);
+    appendRecords(kKeywordIndex, keywordIndex);
+    appendRecords(kPositions, positions_);
+
+    header.componentCount = static_cast<uint32_t>(components_.size());
+    std::memcpy(file.data(), &header, sizeof(Header));
+    return file;
+  }
+
+  [[nodiscard]] size_t stringTableSize() const { return strings_.size(); }
+
+ private:
+  std::string strings_;
+  std::unordered_map<std::string, uint32_t> stringOffsets_;
+  std::vector<StringRef> stringLists_;
+  std::vector<IconRecord> icons_;
+  std::vector<ReleaseRecord> releases_;
+  std::vector<ImageRecord> images_;
+  std::vector<VideoRecord> videos_;
+  std::vector<ScreenshotRecord> screenshots_;
+  std::vector<RatingRecord> ratings_;
+  std::vector<ComponentRecord> components_;
+  std::vector<IdRecord> idIndex_;
+  std::vector<uint32_t> positions_;
+};
+
+// Rebuilds catalog objects from a mapped snapshot. Every reference is bounds
+// checked; any violation marks the snapshot as corrupt.
+class AppstreamSnapshotReader {
+ public:
+  AppstreamSnapshotReader(const char* data, const size_t size)
+      : data_(data), size_(size) {}
+
+  bool readHeader(Header& header) {
+    if (size_ < sizeof(Header)) {
+      return false;
+    }
+    std::memcpy(&header, data_, sizeof(Header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.version != kFormatVersion ||
+        header.byteOrder != kByteOrderMark) {
+      return false;
+    }
+    strings_ = section<char>(header, kStrings);
+    stringLists_ = section<StringRef>(header, kStringLists);
+    icons_ = section<IconRecord>(header, kIcons);
+    releases_ = section<ReleaseRecord>(header, kReleases);
+    images_ = section<ImageRecord>(header, kImages);
+    videos_ = section<VideoRecord>(header, kVideos);
+    screenshots_ = section<ScreenshotRecord>(header, kScreenshots);
+    ratings_ = section<RatingRecord>(header, kRatings);
+    components_ = section<ComponentRecord>(header, kComponents);
+    idIndex_ = section<IdRecord>(header, kIdIndex);
+    categoryIndex_ = section<TermRecord>(header, kCategoryIndex);
+    keywordIndex_ = section<TermRecord>(header, kKeywordIndex);
+    positions_ = section<uint32_t>(header, kPositions);
+    return ok_ && components_.size == header.componentCount;
+  }
+
+  std::string string(const StringRef ref) {
+    if (ref.offset > strings_.size ||
+        ref.length > strings_.size - ref.offset) {
+      ok_ = false;
+      return {};
+    }
+    return {strings_.data + ref.offset, ref.length};
+  }
+
+  std::optional<std::string> optionalString(const StringRef ref) {
+    if (ref.offset == kNone) {
+      return std::nullopt;
+    }
+    return string(ref);
+  }
+
+  static std::optional<int> number(const int32_t value) {
+    if (value == kNoNumber) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+  std::vector<std::string> stringList(const Range range) {
+    std::vector<std::string> values;
+    if (const auto* refs = at(stringLists_, range)) {
+      values.reserve(range.count);
+      for (uint32_t i = 0; i < range.count; i++) {
+        values.push_back(string(refs[i]));
+      }
+    }
+    return values;
+  }
+
+  std::optional<std::unordered_set<std::string>> stringSet(const Range range) {
+    if (range.first == kNone) {
+      return std::nullopt;
+    }
+    auto values = stringList(range);
+    return std::unordered_set<std::string>(
+        std::make_move_iterator(values.begin()),
+        std::make_move_iterator(values.end()));
+  }
+
+  std::optional<std::vector<Icon>> icons(const Range range) {
+    return records(icons_, range, [this](const IconRecord& record) {
+      Icon icon;
+      icon.type_ = optionalString(record.type);
+      icon.width_ = number(record.width);
+      icon.height_ = number(record.height);
+      icon.scale_ = number(record.scale);
+      icon.path_ = optionalString(record.path);
+      return icon;
+    });
+  }
+
+  std::optional<std::vector<Release>> releases(const Range range) {
+    return records(releases_, range, [this](const ReleaseRecord& record) {
+      Release release;
+      release.version_ = string(record.version);
+      release.timestamp_ = string(record.timestamp);
+      release.description_ = optionalString(record.description);
+      release.downloadSize_ = optionalString(record.downloadSize);
+      return release;
+    });
+  }
+
+  std::optional<std::vector<Screenshot>> screenshots(const Range range) {
+    return records(screenshots_, range, [this](const ScreenshotRecord& record) {
+      Screenshot screenshot;
+      screenshot.type_ = optionalString(record.type);
+      screenshot.captions_ = stringList(record.captions);
+      screenshot.images_ =
+          records(images_, record.images, [this](const ImageRecord& image) {
+            Image result;
+            result.type_ = optionalString(image.type);
+            result.width_ = number(image.width);
+            result.height_ = number(image.height);
+            result.url_ = optionalString(image.url);
+            return result;
+          });
+      if (record.video != kNone) {
+        if (record.video >= videos_.size) {
+          ok_ = false;
+        } else {
+          const auto& video = videos_.data[record.video];
+          Video result;
+          result.container_ = optionalString(video.container);
+          result.codec_ = optionalString(video.codec);
+          result.width_ = number(video.width);
+          result.height_ = number(video.height);
+          result.url_ = optionalString(video.url);
+          screenshot.video_ = std::move(result);
+        }
+      }
+      return screenshot;
+    });
+  }
+
+  std::optional<std::map<std::string, Component::ContentRatingValue>>
+  contentRating(const Range range) {
+    if (range.first == kNone) {
+      return std::nullopt;
+    }
+    std::map<std::string, Component::ContentRatingValue> rating;
+    if (const auto* records = at(ratings_, range)) {
+      for (uint32_t i = 0; i < range.count; i++) {
+        rating[string(records[i].attribute)] =
+            static_cast<Component::ContentRatingValue>(records[i].value);
+      }
+    }
+    return rating;
+  }
+
+  Component component(const ComponentRecord& r, const std::string& language) {
+    Component c;
+    c.language_ = language;
+    c.id_ = string(r.id);
+    c.name_ = string(r.name);
+    c.summary_ = string(r.summary);
+    c.pkgname_ = string(r.pkgname);
+    c.version_ = optionalString(r.version);
+    c.origin_ = optionalString(r.origin);
+    c.mediaBaseurl_ = optionalString(r.mediaBaseurl);
+    c.architecture_ = optionalString(r.architecture);
+    c.projectLicense_ = optionalString(r.projectLicense);
+    c.description_ = optionalString(r.description);
+    c.url_ = optionalString(r.url);
+    c.projectGroup_ = optionalString(r.projectGroup);
+    c.sourcePkgname_ = optionalString(r.sourcePkgname);
+    c.bundle_ = optionalString(r.bundle);
+    c.contentRatingType_ = optionalString(r.contentRatingType);
+    c.agreement_ = optionalString(r.agreement);
+    c.categories_ = stringSet(r.categories);
+    c.keywords_ = stringSet(r.keywords);
+    c.languages_ = stringSet(r.languages);
+    c.suggests_ = stringSet(r.suggests);
+    c.provides_ = stringSet(r.provides);
+    c.compulsoryForDesktop_ = stringSet(r.compulsoryForDesktop);
+    c.developer_ = stringSet(r.developer);
+    c.launchable_ = stringSet(r.launchable);
+    c.icons_ = icons(r.icons);
+    c.releases_ = releases(r.releases);
+    c.screenshots_ = screenshots(r.screenshots);
+    c.contentRating_ = contentRating(r.contentRating);
+    return c;
+  }
+
+  bool termIndex(const Span<TermRecord>& records,
+                 const size_t componentCount,
+                 std::unordered_map<std::string, std::vector<size_t>>& index) {
+    index.reserve(records.size);
+    for (size_t i = 0; i < records.size; i++) {
+      const auto& record = records.data[i];
+      auto& positions = index[string(record.term)];
+      if (const auto* first = at(positions_, record.positions)) {
+        positions.assign(first, first + record.positions.count);
+      }
+      for (const size_t position : positions) {
+        if (position >= componentCount) {
+          ok_ = false;
+        }
+      }
+    }
+    return ok_;
+  }
+
+  [[nodiscard]] bool ok() const { return ok_; }
+
+  Span<ComponentRecord> components_;
+  Span<IdRecord> idIndex_;
+  Span<TermRecord> categoryIndex_;
+  Span<TermRecord> keywordIndex_;
+
+ private:
+  template <typename T>
+  Span<T> section(const Header& header, const Section section) {
+    const auto& entry = header.sections[section];
+    if (entry.offset > size_ || entry.size > size_ - entry.offset ||
+        entry.offset % alignof(T) != 0 || entry.size % sizeof(T) != 0) {
+      ok_ = false;
+      return {};
+    }
+    return {reinterpret_cast<const T*>(data_ + entry.offset),
+            entry.size / sizeof(T)};
+  }
+
+  template <typename T>
+  const T* at(const Span<T>& span, const Range range) {
+    if (range.first == kNone || range.count == 0) {
+      return nullptr;
+    }
+    if (range.first > span.size || range.count > span.size - range.first) {
+      ok_ = false;
+      return nullptr;
+    }
+    return span.data + range.first;
+  }
+
+  template <typename Record, typename Convert>
+  auto records(const Span<Record>& span, const Range range, Convert convert)
+      -> std::optional<std::vector<decltype(convert(*span.data))>> {
+    if (range.first == kNone) {
+      return std::nullopt;
+    }
+    std::vector<decltype(convert(*span.data))> values;
+    if (const auto* first = at(span, range)) {
+      values.reserve(range.count);
+      for (uint32_t i = 0; i < range.count; i++) {
+        values.push_back(convert(first[i]));
+      }
+    }
+    return values;
+  }
+
+  const char* data_;
+  size_t size_;
+  bool ok_ = true;
+  Span<char> strings_;
+  Span<StringRef> stringLists_;
+  Span<IconRecord> icons_;
+  Span<ReleaseRecord> releases_;
+  Span<ImageRecord> images_;
+  Span<VideoRecord> videos_;
+  Span<ScreenshotRecord> screenshots_;
+  Span<RatingRecord> ratings_;
+  Span<uint32_t> positions_;
+};
+
+std::optional<AppstreamSnapshot::SourceStamp> AppstreamSnapshot::stamp(
+    const std::string& sourcePath) {
+  struct stat st {};
+  if (stat(sourcePath.c_str(), &st) != 0) {
+    return std::nullopt;
+  }
+  return SourceStamp{static_cast<uint64_t>(st.st_size),
+                     static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                         st.st_mtim.tv_nsec};
+}
+
+bool AppstreamSnapshot::load(const std::string& snapshotPath,
+                             const SourceStamp& source,
+                             AppstreamCatalog& catalog) {
+  const MappedFile file(snapshotPath);
+  if (!file.data()) {
+    return false;
+  }
+
+  AppstreamSnapshotReader reader(file.data(), file.size());
+  Header header{};
+  if (!reader.readHeader(header)) {
+    spdlog::warn("Ignoring invalid AppStream snapshot {}", snapshotPath);
+    return false;
+  }
+  if (header.sourceSize != source.size ||
+      header.sourceMtimeNs != source.mtimeNs ||
+      reader.string(header.language) != catalog.language_) {
+    spdlog::debug("AppStream snapshot {} is out of date", snapshotPath);
+    return false;
+  }
+
+  // Fill local containers first so |catalog| stays empty on failure.
+  const size_t count = reader.components_.size;
+  std::vector<Component> components;
+  components.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    components.push_back(
+        reader.component(reader.components_.data[i], catalog.language_));
+  }
+  std::unordered_map<std::string, size_t> idIndex;
+  idIndex.reserve(reader.idIndex_.size);
+  bool valid = true;
+  for (size_t i = 0; i < reader.idIndex_.size; i++) {
+    const auto& record = reader.idIndex_.data[i];
+    valid = valid && record.component < count;
+    idIndex.emplace(reader.string(record.id), record.component);
+  }
+  AppstreamCatalog::Index categoryIndex;
+  AppstreamCatalog::Index keywordIndex;
+  valid = valid &&
+          reader.termIndex(reader.categoryIndex_, count, categoryIndex) &&
+          reader.termIndex(reader.keywordIndex_, count, keywordIndex) &&
+          reader.ok();
+  if (!valid) {
+    spdlog::warn("Ignoring corrupt AppStream snapshot {}", snapshotPath);
+    return false;
+  }
+
+  catalog.components_ = std::move(components);
+  catalog.idIndex_ = std::move(idIndex);
+  catalog.categoryIndex_ = std::move(categoryIndex);
+  catalog.keywordIndex_ = std::move(keywordIndex);
+  return true;
+}
+
+bool AppstreamSnapshot::save(const std::string& snapshotPath,
+                             const SourceStamp& source,
+                             const AppstreamCatalog& catalog) {
+  AppstreamSnapshotWriter writer;
+  for (const auto& component : catalog.components_) {
+    writer.component(component);
+  }
+  writer.idIndex(catalog.idIndex_);
+  const auto categoryIndex = writer.termIndex(catalog.categoryIndex_);
+  const auto keywordIndex = writer.termIndex(catalog.keywordIndex_);
+
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kFormatVersion;
+  header.byteOrder = kByteOrderMark;
+  header.sourceSize = source.size;
+  header.sourceMtimeNs = source.mtimeNs;
+  header.language = writer.string(catalog.language_);
+  if (writer.stringTableSize() > kNone) {
+    spdlog::error("AppStream catalog is too large for a snapshot");
+    return false;
+  }
+  const std::string contents =
+      writer.serialize(header, categoryIndex, keywordIndex);
+
+  // Write next to the destination and rename, so readers never map a
+  // partially written file.
+  const std::string tempPath = snapshotPath + ".tmp";
+  {
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out || !out.write(contents.data(),
+                           static_cast<std::streamsize>(contents.size()))) {
+      spdlog::error("Failed to write AppStream snapshot {}", tempPath);
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tempPath, snapshotPath, ec);
+  if (ec) {
+    spdlog::error("Failed to replace AppStream snapshot {}: {}", snapshotPath,
+                  ec.message());
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+  spdlog::debug("Wrote AppStream snapshot {} ({} components, {} bytes)",
+                snapshotPath, catalog.components_.size(), contents.size());
+  return true;
+}
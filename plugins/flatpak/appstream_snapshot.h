@@ -0,0 +1,72 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_APPSTREAM_SNAPSHOT_H
+#define PLUGINS_FLATPAK_APPSTREAM_SNAPSHOT_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+class AppstreamCatalog;
+
+/**
+ * @brief Compact binary snapshot of a parsed AppstreamCatalog.
+ *
+ * The file holds a header, a deduplicated string table, fixed-size records
+ * for components and their nested elements, and the id/category/keyword
+ * index sections. It is memory-mapped on load, so a catalog can be restored
+ * without running the XML parser. A snapshot is only used while the size and
+ * modification time of its source catalog and the catalog language match.
+ */
+class AppstreamSnapshot {
+ public:
+  struct SourceStamp {
+    uint64_t size;
+    int64_t mtimeNs;
+  };
+
+  /**
+   * @brief Reads the stamp of a source catalog file.
+   * @param sourcePath The AppStream catalog
+   * @return The stamp, or std::nullopt if the file cannot be stat'ed
+   */
+  static std::optional<SourceStamp> stamp(const std::string& sourcePath);
+
+  /**
+   * @brief Restores |catalog| from a snapshot.
+   * @param snapshotPath The snapshot file
+   * @param source The current stamp of the source catalog
+   * @param catalog An empty catalog; left empty on failure
+   * @return true if the snapshot was current and valid
+   */
+  static bool load(const std::string& snapshotPath,
+                   const SourceStamp& source,
+                   AppstreamCatalog& catalog);
+
+  /**
+   * @brief Writes a snapshot of |catalog|, replacing any previous one.
+   * @param snapshotPath The snapshot file
+   * @param source The stamp of the source catalog taken before parsing
+   * @param catalog The parsed catalog
+   * @return true on success
+   */
+  static bool save(const std::string& snapshotPath,
+                   const SourceStamp& source,
+                   const AppstreamCatalog& catalog);
+};
+
+#endif  // PLUGINS_FLATPAK_APPSTREAM_SNAPSHOT_H
@@ -23,6 +23,9 @@
 #include <cstdint>
 #include <string>
 
+#include "interfaces/compression_codec.h"
+#include "metrics/latency_metrics.h"
+
 namespace flatpak_plugin {
 
 /**
@@ -32,8 +35,17 @@ namespace flatpak_plugin {
  * - NETWORK_FIRST: Prefer network, fallback to cache if network fails.
  * - CACHE_ONLY: Use cache exclusively.
  * - NETWORK_ONLY: Use network exclusively.
+ * - STALE_WHILE_REVALIDATE: Like CACHE_FIRST, but an expired entry that has
+ *   not been cleaned up yet is served immediately and refreshed in the
+ *   background.
  */
-enum class CachePolicy { CACHE_FIRST, NETWORK_FIRST, CACHE_ONLY, NETWORK_ONLY };
+enum class CachePolicy {
+  CACHE_FIRST,
+  NETWORK_FIRST,
+  CACHE_ONLY,
+  NETWORK_ONLY,
+  STALE_WHILE_REVALIDATE
+};
 
 /**
  * @struct CacheConfig
@@ -42,24 +54,57 @@ enum class CachePolicy { CACHE_FIRST, NETWORK_FIRST, CACHE_ONLY, NETWORK_ONLY };
  * @var default_ttl Default time-to-live for cached entries (in seconds).
  * @var policy Cache access strategy.
  * @var enable_compression Enable compression for cached data.
+ * @var compression_type Codec for new entries; falls back to zlib when zstd
+ * is not available.
+ * @var compression_level Codec specific compression level.
+ * @var enable_compression_dictionary Train a shared dictionary from stored
+ * entries (zstd only).
  * @var max_cache_size_mb Maximum cache size in megabytes.
  * @var network_timeout Network operation timeout (in seconds).
  * @var max_retries Maximum number of network retries.
  * @var enable_auto_cleanup Enable automatic cache cleanup.
  * @var cleanup_interval Interval for automatic cleanup (in minutes).
  * @var enable_metrics Enable cache metrics collection.
+ * @var write_behind_interval Group-commit window for queued writes; zero
+ * writes synchronously.
+ * @var memory_cache_size_mb Budget of the in-memory tier of decoded values;
+ * zero disables it.
+ * @var memory_cache_ttl Maximum lifetime of an in-memory entry, capped by
+ * default_ttl.
+ * @var enable_installation_monitor Invalidate installation entries when the
+ * Flatpak installations change on disk.
+ * @var monitored_ttl Time-to-live of installation entries while they are
+ * kept up to date by the installation monitor.
+ * @var enable_thumbnails Make icon and screenshot thumbnails on a worker
+ * pool and keep them in the cache storage.
+ * @var thumbnail_workers Number of threads decoding and scaling images.
+ * @var thumbnail_ttl Time-to-live of thumbnails and their source images.
+ * @var thumbnail_memory_cache_mb Budget of the in-memory tier of finished
+ * thumbnails; zero disables it.
  */
 struct CacheConfig {
   std::string db_path = ":memory:";
   std::chrono::seconds default_ttl{3600};
   CachePolicy policy = CachePolicy::CACHE_FIRST;
   bool enable_compression = false;
+  CompressionType compression_type = CompressionType::ZSTD;
+  int compression_level = 3;
+  bool enable_compression_dictionary = false;
   size_t max_cache_size_mb = 100;
   std::chrono::seconds network_timeout{30};
   int max_retries = 3;
   bool enable_auto_cleanup = true;
   std::chrono::minutes cleanup_interval{60};
   bool enable_metrics = true;
+  std::chrono::milliseconds write_behind_interval{0};
+  size_t memory_cache_size_mb = 8;
+  std::chrono::seconds memory_cache_ttl{60};
+  bool enable_installation_monitor = false;
+  std::chrono::seconds monitored_ttl{7 * 24 * 3600};
+  bool enable_thumbnails = false;
+  size_t thumbnail_workers = 2;
+  std::chrono::seconds thumbnail_ttl{7 * 24 * 3600};
+  size_t thumbnail_memory_cache_mb = 16;
 };
 
 /**
@@ -68,8 +113,13 @@ struct CacheConfig {
  *
  * This structure tracks various metrics related to cache usage, including
  * hit/miss counts, network calls, cache size, expired entries, and network
- * errors. All counters are atomic for thread-safe updates. It also records the
- * cache start time for uptime calculation.
+ * errors. Hits and misses are also broken down per tier: the in-memory LRU
+ * and the persistent storage behind it. Stale hits count expired entries
+ * served under STALE_WHILE_REVALIDATE, and coalesced requests count callers
+ * that joined a fetch already in flight for the same key. All counters are
+ * atomic for thread-safe updates. Latency histograms of storage, codec and
+ * network operations are kept per key class. It also records the cache start
+ * time for uptime calculation.
  */
 struct CacheMetrics {
   std::atomic<uint64_t> hits{0};
@@ -78,6 +128,14 @@ struct CacheMetrics {
   std::atomic<uint64_t> cache_size_bytes{0};
   std::atomic<uint64_t> expired_entries{0};
   std::atomic<uint64_t> network_errors{0};
+  std::atomic<uint64_t> memory_hits{0};
+  std::atomic<uint64_t> memory_misses{0};
+  std::atomic<uint64_t> storage_hits{0};
+  std::atomic<uint64_t> storage_misses{0};
+  std::atomic<uint64_t> stale_hits{0};
+  std::atomic<uint64_t> coalesced_requests{0};
+
+  LatencyMetrics latency;
 
   std::chrono::system_clock::time_point start_time{
       std::chrono::system_clock::now()};
@@ -15,8 +15,10 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <chrono>
 #include <exception>
+#include <filesystem>
 #include <fstream>
 #include <future>
 #include <memory>
@@ -35,9 +37,13 @@
 #include "flatpak_installation_cache_operation.h"
 #include "interfaces/cache_observer.h"
 #include "interfaces/cache_storage.h"
+#include "monitors/installation_monitor.h"
 #include "network/curl_network_fetcher.h"
+#include "storage/cache_snapshot.h"
 #include "plugins/flatpak/flatpak_shim.h"
 #include "storage/sqlite_cache_storage.h"
+#include "thumbnails/thumbnail_channel.h"
+#include "thumbnails/thumbnail_service.h"
 
 namespace flatpak_plugin {
 
@@ -57,6 +63,19 @@ CacheManager::CacheManager(CacheConfig config,
 }
 
 CacheManager::~CacheManager() noexcept {
+  if (installation_monitor_) {
+    installation_monitor_->Stop();
+  }
+
+  {
+    std::lock_guard lock(refresh_mutex_);
+    stop_refresh_ = true;
+  }
+  refresh_cv_.notify_all();
+  if (refresh_thread_.joinable()) {
+    refresh_thread_.join();
+  }
+
   stop_cleanup_.store(true);
   cleanup_cv_.notify_all();
   if (cleanup_thread_.joinable()) {
@@ -74,14 +93,18 @@ bool CacheManager::Initialize() {
         static_cast<int>(config_.policy), config_.max_cache_size_mb);
 
     if (!storage_) {
-      storage_ = std::make_unique<SQLiteCacheStorage>(
-          config_.db_path, config_.enable_compression);
+      storage_ = CreateDefaultStorage(config_);
     }
     if (!storage_->Initialize()) {
       spdlog::error("Failed to initialize cache storage");
       return false;
     }
 
+    if (config_.memory_cache_size_mb > 0 && !memory_cache_) {
+      memory_cache_ = std::make_unique<MemoryCache>(
+          config_.memory_cache_size_mb * 1024 * 1024);
+    }
+
     if (!network_fetcher_) {
       network_fetcher_ = std::make_unique<CurlNetworkFetcher>(
           config_.network_timeout, config_.max_retries);
@@ -93,6 +116,13 @@ bool CacheManager::Initialize() {
       metrics_.cache_size_bytes = 0;
       metrics_.network_calls = 0;
       metrics_.network_errors = 0;
+      metrics_.memory_hits = 0;
+      metrics_.memory_misses = 0;
+      metrics_.storage_hits = 0;
+      metrics_.storage_misses = 0;
+      metrics_.stale_hits = 0;
+      metrics_.coalesced_requests = 0;
+      metrics_.latency.Reset();
       metrics_.start_time = std::chrono::system_clock::now();
     }
 
@@ -104,6 +134,19 @@ bool CacheManager::Initialize() {
     cleanup_thread_ = std::thread(&CacheManager::CleanupWorker, this);
   }
 
+  if (config_.enable_installation_monitor && !installation_monitor_) {
+    installation_monitor_ = std::make_unique<InstallationMonitor>(
+        [this](const std::string& installation_id) {
+          InvalidateInstallation(installation_id);
+        });
+    if (!installation_monitor_->Start()) {
+      spdlog::warn(
+          "No installation could be monitored, installation entries expire "
+          "after {}s",
+          config_.default_ttl.count());
+    }
+  }
+
   return true;
 }
 
@@ -119,7 +162,7 @@ std::optional<flutter::EncodableList> CacheManager::GetApplicationsInstalled(
     InvalidateKey(key);
   }
 
-  EncodableListCacheOperation cache_operation(this);
+  EncodableListCacheOperation cache_operation(this, GetInstallationTtl());
 
   auto network_ops = [this]() -> std::optional<flutter::EncodableList> {
     std::lock_guard lock(flatpak_mutex_);
@@ -184,6 +227,10 @@ std::optional<flutter::EncodableList> CacheManager::GetApplicationsRemote(
   if (force_refresh) {
     InvalidateKey(key);
   }
+  {
+    std::lock_guard lock(remote_ids_mutex_);
+    remote_ids_.insert(remote_id);
+  }
 
   EncodableListCacheOperation cache_operation(this);
 
@@ -255,7 +302,7 @@ std::optional<flutter::EncodableList> CacheManager::GetSystemInstallations(
     InvalidateKey(key);
   }
 
-  EncodableListCacheOperation cache_operation(this);
+  EncodableListCacheOperation cache_operation(this, GetInstallationTtl());
 
   auto network_ops = [this]() -> std::optional<flutter::EncodableList> {
     std::lock_guard lock(flatpak_mutex_);
@@ -320,7 +367,7 @@ std::optional<flutter::EncodableList> CacheManager::GetRemotes(
     InvalidateKey(key);
   }
 
-  EncodableListCacheOperation cache_operation(this);
+  EncodableListCacheOperation cache_operation(this, GetInstallationTtl());
 
   auto network_ops =
       [this, installation_id]() -> std::optional<flutter::EncodableList> {
@@ -366,7 +413,7 @@ std::optional<Installation> CacheManager::GetUserInstallation(
     InvalidateKey(key);
   }
 
-  InstallationCacheOperation cache_operation(this);
+  InstallationCacheOperation cache_operation(this, GetInstallationTtl());
 
   auto network_ops = [this]() -> std::optional<Installation> {
     std::lock_guard lock(flatpak_mutex_);
@@ -479,6 +526,9 @@ void CacheManager::CleanupWorker() {
           cleaned = storage_->CleanupExpired();
         }
       }
+      if (memory_cache_) {
+        memory_cache_->CleanupExpired();
+      }
 
       if (cleaned > 0) {
         spdlog::info("Cleaned up {} expired cache entries", cleaned);
@@ -495,6 +545,34 @@ void CacheManager::CleanupWorker() {
   spdlog::info("Cleanup thread finished");
 }
 
+void CacheManager::RefreshWorker() {
+  std::unique_lock lock(refresh_mutex_);
+  while (true) {
+    refresh_cv_.wait(
+        lock, [this] { return stop_refresh_ || !refresh_queue_.empty(); });
+    if (stop_refresh_) {
+      break;
+    }
+
+    auto [key, task] = std::move(refresh_queue_.front());
+    refresh_queue_.pop_front();
+    lock.unlock();
+
+    try {
+      spdlog::debug("Refreshing stale cache key: {}", key);
+      task();
+    } catch (const std::exception& e) {
+      spdlog::error("Background refresh failed for key {}: {}", key, e.what());
+    } catch (...) {
+      spdlog::error("Background refresh failed for key {}", key);
+    }
+
+    lock.lock();
+    refreshing_keys_.erase(key);
+  }
+  spdlog::debug("Refresh thread finished");
+}
+
 template <typename T>
 std::optional<T> CacheManager::PerformCacheOperation(
     const std::string& key,
@@ -524,7 +602,8 @@ std::optional<T> CacheManager::PerformCacheOperation(
     }
 
     case CachePolicy::NETWORK_ONLY: {
-      result = TryNetworkOperation(key, network_operation);
+      result = SingleFlight<T>(
+          key, [&] { return TryNetworkOperation(key, network_operation); });
       break;
     }
 
@@ -538,15 +617,41 @@ std::optional<T> CacheManager::PerformCacheOperation(
         IncrementMetric(MetricType::MISS);
         NotifyObservers(
             [key](ICacheObserver* observer) { observer->OnCacheMiss(key); });
-        result = TryNetworkAndCache(key, network_operation, cache_operation);
+        result = SingleFlight<T>(key, [&] {
+          return TryNetworkAndCache(key, network_operation, cache_operation);
+        });
+      }
+      break;
+    }
+
+    case CachePolicy::STALE_WHILE_REVALIDATE: {
+      result = GetFromCache<T>(key, cache_operation);
+      if (!result.has_value()) {
+        result = GetStaleFromCache<T>(key, cache_operation);
+        if (result.has_value()) {
+          ScheduleRefresh(key, network_operation, cache_operation);
+        }
+      }
+      if (result.has_value()) {
+        IncrementMetric(MetricType::HIT);
+        NotifyObservers(
+            [key](ICacheObserver* observer) { observer->OnCacheHit(key, 0); });
+      } else {
+        IncrementMetric(MetricType::MISS);
+        NotifyObservers(
+            [key](ICacheObserver* observer) { observer->OnCacheMiss(key); });
+        result = SingleFlight<T>(key, [&] {
+          return TryNetworkAndCache(key, network_operation, cache_operation);
+        });
       }
       break;
     }
 
     case CachePolicy::NETWORK_FIRST: {
-      result = TryNetworkOperation(key, network_operation);
+      result = SingleFlight<T>(
+          key, [&] { return TryNetworkOperation(key, network_operation); });
       if (!result.has_value()) {
-        result = cache_operation->RetrieveData(key, storage_.get());
+        result = GetFromCache<T>(key, cache_operation);
         if (result.has_value()) {
           NotifyObservers([key](ICacheObserver* observer) {
             observer->OnCacheHit(key, 0);
@@ -564,11 +669,60 @@ template <typename T>
 std::optional<T> CacheManager::GetFromCache(
     const std::string& key,
     CacheOperationTemplate<T>* cache_operation) {
+  if (memory_cache_) {
+    if (auto value = memory_cache_->Get<T>(key); value.has_value()) {
+      if (config_.enable_metrics) {
+        ++metrics_.memory_hits;
+      }
+      return value;
+    }
+    if (config_.enable_metrics) {
+      ++metrics_.memory_misses;
+    }
+  }
+
+  // The memory tier is filled under |storage_mutex_| so it cannot race with
+  // an invalidation and resurrect a removed entry.
   std::lock_guard lock(storage_mutex_);
   if (!storage_) {
     return std::nullopt;
   }
-  return cache_operation->RetrieveData(key, storage_.get());
+  size_t size_bytes = 0;
+  auto result = cache_operation->RetrieveData(key, storage_.get(), &size_bytes,
+                                              false, GetLatencyMetrics());
+  if (result.has_value()) {
+    if (config_.enable_metrics) {
+      ++metrics_.storage_hits;
+    }
+    StoreInMemoryCache(key, result.value(), size_bytes);
+  } else if (config_.enable_metrics) {
+    ++metrics_.storage_misses;
+  }
+  return result;
+}
+
+template <typename T>
+std::optional<T> CacheManager::GetStaleFromCache(
+    const std::string& key,
+    CacheOperationTemplate<T>* cache_operation) {
+  std::optional<T> result;
+  {
+    // Stale values are deliberately not promoted to the memory tier, which
+    // would otherwise serve them as fresh.
+    std::lock_guard lock(storage_mutex_);
+    if (!storage_) {
+      return std::nullopt;
+    }
+    result = cache_operation->RetrieveData(key, storage_.get(), nullptr, true,
+                                           GetLatencyMetrics());
+  }
+  if (result.has_value()) {
+    if (config_.enable_metrics) {
+      ++metrics_.stale_hits;
+    }
+    spdlog::debug("Serving stale cache entry for key: {}", key);
+  }
+  return result;
 }
 
 template <typename T>
@@ -576,10 +730,55 @@ bool CacheManager::StoreInCache(const std::string& key,
                                 const T& data,
                                 CacheOperationTemplate<T>* cache_operation) {
   std::lock_guard lock(storage_mutex_);
-  if (!storage_) {
+  size_t size_bytes = 0;
+  if (!storage_ || !cache_operation->CacheData(key, data, storage_.get(),
+                                               &size_bytes,
+                                               GetLatencyMetrics())) {
     return false;
   }
-  return cache_operation->CacheData(key, data, storage_.get());
+  StoreInMemoryCache(key, data, size_bytes);
+  return true;
+}
+
+template <typename T>
+void CacheManager::StoreInMemoryCache(const std::string& key,
+                                      const T& data,
+                                      const size_t size_bytes) {
+  if (memory_cache_) {
+    memory_cache_->Put(key, data, size_bytes, GetMemoryCacheExpiry());
+  }
+}
+
+std::unique_ptr<ICacheStorage> CacheManager::CreateDefaultStorage(
+    const CacheConfig& config) {
+  CompressionOptions compression;
+  compression.type = config.compression_type;
+  compression.level = config.compression_level;
+  compression.use_dictionary = config.enable_compression_dictionary;
+  return std::make_unique<SQLiteCacheStorage>(
+      config.db_path,
+      config.enable_compression &&
+          config.compression_type != CompressionType::NONE,
+      config.write_behind_interval, compression);
+}
+
+MemoryCache::Clock::time_point CacheManager::GetMemoryCacheExpiry() const {
+  // Entries read back from storage have an unknown remaining lifetime, so the
+  // in-memory tier never outlives the shortest configured TTL.
+  return MemoryCache::Clock::now() +
+         std::min<std::chrono::seconds>(config_.memory_cache_ttl,
+                                        config_.default_ttl);
+}
+
+LatencyMetrics* CacheManager::GetLatencyMetrics() const {
+  return config_.enable_metrics ? &metrics_.latency : nullptr;
+}
+
+std::chrono::seconds CacheManager::GetInstallationTtl() const {
+  if (installation_monitor_ && installation_monitor_->IsActive()) {
+    return std::max(config_.monitored_ttl, config_.default_ttl);
+  }
+  return config_.default_ttl;
 }
 
 template <typename T>
@@ -594,7 +793,11 @@ std::optional<T> CacheManager::TryNetworkOperation(
     if (config_.enable_metrics) {
       ++metrics_.network_calls;
     }
-    auto result = network_operation();
+    std::optional<T> result;
+    {
+      ScopedLatency timer(GetLatencyMetrics(), key, LatencyOperation::NETWORK);
+      result = network_operation();
+    }
     if (result.has_value()) {
       NotifyObservers([](ICacheObserver* observer) {
         observer->OnNetworkFallback("Data fetched from Network");
@@ -619,14 +822,88 @@ std::optional<T> CacheManager::TryNetworkAndCache(
     std::function<std::optional<T>()> network_operation,
     CacheOperationTemplate<T>* cache_operation) {
   auto result = TryNetworkOperation(key, std::move(network_operation));
-  if (result.has_value() && storage_) {
-    if (!cache_operation->CacheData(key, result.value(), storage_.get())) {
-      spdlog::error("Failed to cache data for Key: {}", key);
+  // Refreshes run on a background thread, so storing goes through the same
+  // lock as every other storage access.
+  if (result.has_value() &&
+      !StoreInCache(key, result.value(), cache_operation)) {
+    spdlog::error("Failed to cache data for Key: {}", key);
+  }
+  return result;
+}
+
+template <typename T>
+std::optional<T> CacheManager::SingleFlight(
+    const std::string& key,
+    const std::function<std::optional<T>()>& fetch) {
+  std::promise<std::any> promise;
+  std::shared_future<std::any> in_flight;
+  {
+    std::lock_guard lock(inflight_mutex_);
+    if (const auto it = inflight_.find(key); it != inflight_.end()) {
+      in_flight = it->second;
+    } else {
+      inflight_.emplace(key, promise.get_future().share());
+    }
+  }
+
+  if (in_flight.valid()) {
+    if (config_.enable_metrics) {
+      ++metrics_.coalesced_requests;
+    }
+    spdlog::debug("Joining in-flight fetch for key: {}", key);
+    const auto& shared = in_flight.get();
+    if (const auto* value = std::any_cast<std::optional<T>>(&shared)) {
+      return *value;
     }
+    return std::nullopt;
   }
+
+  std::optional<T> result;
+  try {
+    result = fetch();
+  } catch (...) {
+    {
+      std::lock_guard lock(inflight_mutex_);
+      inflight_.erase(key);
+    }
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+  {
+    std::lock_guard lock(inflight_mutex_);
+    inflight_.erase(key);
+  }
+  promise.set_value(result);
   return result;
 }
 
+template <typename T>
+void CacheManager::ScheduleRefresh(
+    const std::string& key,
+    std::function<std::optional<T>()> network_operation,
+    const CacheOperationTemplate<T>* cache_operation) {
+  // The caller's operation lives on its stack, so the refresh gets its own.
+  std::shared_ptr<CacheOperationTemplate<T>> operation =
+      cache_operation->Clone();
+  {
+    std::lock_guard lock(refresh_mutex_);
+    if (stop_refresh_ || !refreshing_keys_.insert(key).second) {
+      return;
+    }
+    refresh_queue_.emplace_back(
+        key, [this, key, network_operation = std::move(network_operation),
+              operation] {
+          SingleFlight<T>(key, [&] {
+            return TryNetworkAndCache(key, network_operation, operation.get());
+          });
+        });
+    if (!refresh_thread_.joinable()) {
+      refresh_thread_ = std::thread(&CacheManager::RefreshWorker, this);
+    }
+  }
+  refresh_cv_.notify_one();
+}
+
 void CacheManager::IncrementMetric(MetricType type) const {
   std::lock_guard lock(metrics_mutex_);
 
@@ -656,6 +933,9 @@ void CacheManager::InvalidateAll() const {
     if (storage_) {
       storage_->Invalidate("");
     }
+    if (memory_cache_) {
+      memory_cache_->Invalidate("");
+    }
   }
   NotifyObservers(
       [](ICacheObserver*) { spdlog::info("All cache entries invalidated"); });
@@ -667,12 +947,35 @@ void CacheManager::InvalidateKey(const std::string& key) const {
     if (storage_) {
       storage_->Invalidate(key);
     }
+    if (memory_cache_) {
+      memory_cache_->Invalidate(key);
+    }
   }
   spdlog::info("Invalidated cache key: '{}'", key);
   NotifyObservers(
       [&key](ICacheObserver* observer) { observer->OnCacheExpired(key); });
 }
 
+void CacheManager::InvalidateInstallation(
+    const std::string& installation_id) const {
+  InvalidateKey(GenerateKey("applications_installed"));
+  InvalidateKey(GenerateKey("remotes", {installation_id}));
+  if (installation_id != "user") {
+    InvalidateKey(GenerateKey("system_installations"));
+    return;
+  }
+
+  InvalidateKey(GenerateKey("user_installation"));
+  std::vector<std::string> remote_ids;
+  {
+    std::lock_guard lock(remote_ids_mutex_);
+    remote_ids.assign(remote_ids_.begin(), remote_ids_.end());
+  }
+  for (const auto& remote_id : remote_ids) {
+    InvalidateKey(GenerateKey("applications_remote", {remote_id}));
+  }
+}
+
 bool CacheManager::IsHealthy() const {
   std::lock_guard lock(storage_mutex_);
   if (!storage_) {
@@ -716,6 +1019,9 @@ CachePolicy CacheManager::GetCachePolicy() const {
 size_t CacheManager::ForceCleanup() const {
   std::lock_guard lock(storage_mutex_);
   size_t cleaned = storage_->CleanupExpired();
+  if (memory_cache_) {
+    memory_cache_->CleanupExpired();
+  }
   NotifyObservers([cleaned](ICacheObserver* observer) {
     observer->OnCacheCleanup(cleaned);
   });
@@ -723,18 +1029,66 @@ size_t CacheManager::ForceCleanup() const {
   return cleaned;
 }
 
+std::string CacheManager::GetMetricsJson() const {
+  return fmt::format(
+      "{{\"uptime_s\":{},\"hit_ratio\":{:.2f},\"counters\":{{"
+      "\"hits\":{},\"misses\":{},\"memory_hits\":{},"
+      "\"memory_misses\":{},\"storage_hits\":{},\"storage_misses\":{},"
+      "\"stale_hits\":{},\"coalesced_requests\":{},\"network_calls\":{},"
+      "\"network_errors\":{},\"expired_entries\":{}}},\"latency\":{}}}",
+      metrics_.GetUptime().count(), metrics_.GetHitRatio(),
+      metrics_.hits.load(), metrics_.misses.load(),
+      metrics_.memory_hits.load(), metrics_.memory_misses.load(),
+      metrics_.storage_hits.load(), metrics_.storage_misses.load(),
+      metrics_.stale_hits.load(), metrics_.coalesced_requests.load(),
+      metrics_.network_calls.load(), metrics_.network_errors.load(),
+      metrics_.expired_entries.load(), metrics_.latency.ToJson());
+}
+
 const CacheConfig& CacheManager::GetConfig() const {
   return config_;
 }
 
 bool CacheManager::ExportCache(const std::string& filepath) const {
   std::lock_guard lock(storage_mutex_);
+  if (!storage_) {
+    return false;
+  }
   try {
-    if (const std::ofstream file(filepath, std::ios::binary); !file.is_open()) {
-      spdlog::error("Failed to open export file: {}", filepath);
+    // Write next to the destination and rename, so an interrupted export
+    // never leaves a truncated snapshot behind.
+    const std::string temp_path = filepath + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      spdlog::error("Failed to open export file: {}", temp_path);
+      return false;
+    }
+
+    const auto now = std::chrono::system_clock::now();
+    CacheSnapshotWriter writer(file, config_.compression_type,
+                               config_.compression_level, now);
+    const bool exported = storage_->ForEachEntry(
+        [&writer, now](const CacheWrite& entry) {
+          return entry.expiry <= now || writer.Add(entry);
+        });
+    const bool finished = exported && writer.Finish();
+    file.close();
+
+    std::error_code ec;
+    if (!finished || file.fail()) {
+      spdlog::error("Failed to export cache to {}", filepath);
+      std::filesystem::remove(temp_path, ec);
       return false;
     }
-    spdlog::info("Cache exported to {}", filepath);
+    std::filesystem::rename(temp_path, filepath, ec);
+    if (ec) {
+      spdlog::error("Failed to replace export file {}: {}", filepath,
+                    ec.message());
+      std::filesystem::remove(temp_path, ec);
+      return false;
+    }
+    spdlog::info("Cache exported to {} ({} entries)", filepath,
+                 writer.GetEntryCount());
     return true;
   } catch (const std::exception& e) {
     spdlog::error("Failed to export cache: {}", e.what());
@@ -744,11 +1098,54 @@ bool CacheManager::ExportCache(const std::string& filepath) const {
 
 bool CacheManager::ImportCache(const std::string& filepath) const {
   std::lock_guard lock(storage_mutex_);
+  if (!storage_) {
+    return false;
+  }
   try {
-    if (const std::ifstream file(filepath, std::ios::binary); !file.is_open()) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
       spdlog::error("Failed to open import file: {}", filepath);
       return false;
     }
+
+    CacheSnapshotReader reader(file);
+    if (!reader.IsValid()) {
+      spdlog::error("Invalid cache snapshot: {}", filepath);
+      return false;
+    }
+
+    // Snapshots are usually built long before the first boot, so keep each
+    // entry's remaining lifetime rather than its absolute expiry.
+    const auto now = std::chrono::system_clock::now();
+    const auto exported_at = reader.GetExportTime();
+    std::vector<CacheWrite> entries;
+    size_t expired = 0;
+    while (auto entry = reader.Next()) {
+      const auto remaining = entry->expiry - exported_at;
+      if (remaining <= std::chrono::system_clock::duration::zero()) {
+        expired++;
+        continue;
+      }
+      entry->expiry = now + remaining;
+      entries.push_back(std::move(*entry));
+    }
+    if (!reader.IsComplete()) {
+      spdlog::error("Corrupt cache snapshot: {}", filepath);
+      return false;
+    }
+
+    // One batch, so a failed import leaves the cache untouched.
+    if (!entries.empty() && !storage_->StoreMany(entries)) {
+      spdlog::error("Failed to store imported cache entries");
+      return false;
+    }
+    if (memory_cache_) {
+      for (const auto& entry : entries) {
+        memory_cache_->Invalidate(entry.key);
+      }
+    }
+    spdlog::info("Cache imported from {} ({} entries, {} expired)", filepath,
+                 entries.size(), expired);
     return true;
   } catch (const std::exception& e) {
     spdlog::error("Failed to import cache: {}", e.what());
@@ -758,16 +1155,33 @@ bool CacheManager::ImportCache(const std::string& filepath) const {
 
 std::unique_ptr<CacheManager> CacheManager::Builder::Build() {
   if (!storage_) {
-    storage_ = std::make_unique<SQLiteCacheStorage>(config_.db_path,
-                                                    config_.enable_compression);
+    storage_ = CreateDefaultStorage(config_);
   }
   if (!fetcher_) {
     fetcher_ = std::make_unique<CurlNetworkFetcher>(config_.network_timeout,
                                                     config_.max_retries);
   }
 
-  return std::make_unique<CacheManager>(std::move(config_), std::move(storage_),
-                                        std::move(fetcher_));
+  auto manager = std::make_unique<CacheManager>(
+      std::move(config_), std::move(storage_), std::move(fetcher_));
+  if (const auto& config = manager->config_; config.enable_thumbnails) {
+    // A fetcher of its own, since CurlClient is not shared across threads.
+    manager->thumbnail_service_ = std::make_unique<ThumbnailService>(
+        manager->storage_.get(),
+        std::make_unique<CurlNetworkFetcher>(config.network_timeout,
+                                             config.max_retries),
+        config.thumbnail_workers, config.thumbnail_ttl,
+        config.thumbnail_memory_cache_mb * 1024 * 1024);
+    if (thumbnail_messenger_) {
+      manager->thumbnail_channel_ = std::make_unique<ThumbnailChannel>(
+          thumbnail_messenger_, manager->thumbnail_service_.get());
+    }
+  }
+  if (metrics_messenger_) {
+    manager->metrics_channel_ = std::make_unique<CacheMetricsChannel>(
+        metrics_messenger_, manager.get());
+  }
+  return manager;
 }
 
 template std::optional<flutter::EncodableList>
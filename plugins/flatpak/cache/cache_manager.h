@@ -18,15 +18,21 @@
 #ifndef PLUGINS_FLATPAK_CACHE_CACHE_MANAGER_H
 #define PLUGINS_FLATPAK_CACHE_CACHE_MANAGER_H
 
+#include <any>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <flutter/encodable_value.h>
@@ -35,11 +41,16 @@
 #include "interfaces/cache_observer.h"
 #include "interfaces/cache_storage.h"
 #include "interfaces/network_fetcher.h"
+#include "metrics/cache_metrics_channel.h"
 #include "operations/cache_operation_template.h"
 #include "plugins/flatpak/messages.g.h"
+#include "storage/memory_cache.h"
 
 namespace flatpak_plugin {
 
+class InstallationMonitor;
+class ThumbnailChannel;
+class ThumbnailService;
 struct flatpak_application_cache_operation;
 struct ApplicationCacheOperation;
 struct InstallationCacheOperation;
@@ -136,6 +147,15 @@ class CacheManager {
    */
   void InvalidateKey(const std::string& key) const;
 
+  /**
+   * @brief Invalidate the entries derived from one installation: the
+   * installed applications, the installation itself and its remotes. The
+   * remote application lists are dropped too when the user installation
+   * changes, since they are read through it.
+   * @param installation_id Id of the installation that changed
+   */
+  void InvalidateInstallation(const std::string& installation_id) const;
+
   /**
    * @brief Check if cache is healthy
    * @return true if cache is functioning properly
@@ -172,6 +192,17 @@ class CacheManager {
    */
   const CacheMetrics& GetMetrics() const { return metrics_; }
 
+  /**
+   * @brief Dump counters and latency percentiles per key class as JSON
+   * @return A JSON object with "counters" and "latency" members
+   */
+  std::string GetMetricsJson() const;
+
+  /**
+   * @brief Clear the latency histograms, e.g. before a measurement
+   */
+  void ResetLatencyMetrics() const { metrics_.latency.Reset(); }
+
   /**
    * @brief Get cache configuration
    * @return Current cache configuration
@@ -179,14 +210,23 @@ class CacheManager {
   const CacheConfig& GetConfig() const;
 
   /**
-   * @brief Export cache to file
-   * @param filepath Path to export file
+   * @brief Export live cache entries to a snapshot file
+   *
+   * Entries are read from one consistent view of the storage and written
+   * compressed with a checksum each. Used to pre-seed the cache of a system
+   * image.
+   * @param filepath Path to export file; replaced atomically
    * @return true if export successful
    */
   bool ExportCache(const std::string& filepath) const;
 
   /**
-   * @brief Import cache from file
+   * @brief Import a snapshot written by ExportCache()
+   *
+   * Expiries are re-based to keep the lifetime each entry had left at export
+   * time; entries that had already expired are skipped. All entries are
+   * stored in one batch and replace existing ones, and nothing is stored if
+   * any record is corrupt.
    * @param filepath Path to import file
    * @return true if import successful
    */
@@ -194,11 +234,22 @@ class CacheManager {
 
   CacheMetrics* GetMetricsPtr() const { return &metrics_; }
 
+  /**
+   * @brief Get the icon and screenshot thumbnail service
+   * @return The service, or null unless enabled with
+   * Builder::WithThumbnails()
+   */
+  ThumbnailService* GetThumbnailService() const {
+    return thumbnail_service_.get();
+  }
+
   class Builder {
    private:
     CacheConfig config_;
     std::unique_ptr<ICacheStorage> storage_;
     std::unique_ptr<INetworkFetcher> fetcher_;
+    flutter::BinaryMessenger* metrics_messenger_ = nullptr;
+    flutter::BinaryMessenger* thumbnail_messenger_ = nullptr;
 
    public:
     Builder& WithStorage(std::unique_ptr<ICacheStorage> storage) {
@@ -231,6 +282,16 @@ class CacheManager {
       return *this;
     }
 
+    Builder& WithCompressionCodec(const CompressionType type,
+                                  const int level,
+                                  const bool use_dictionary = false) {
+      config_.enable_compression = type != CompressionType::NONE;
+      config_.compression_type = type;
+      config_.compression_level = level;
+      config_.enable_compression_dictionary = use_dictionary;
+      return *this;
+    }
+
     Builder& WithMaxCacheSize(size_t size_mb) {
       config_.max_cache_size_mb = size_mb;
       return *this;
@@ -259,6 +320,52 @@ class CacheManager {
       return *this;
     }
 
+    Builder& WithWriteBehind(const std::chrono::milliseconds interval) {
+      config_.write_behind_interval = interval;
+      return *this;
+    }
+
+    Builder& WithMemoryCache(
+        const size_t size_mb,
+        const std::chrono::seconds ttl = std::chrono::seconds(60)) {
+      config_.memory_cache_size_mb = size_mb;
+      config_.memory_cache_ttl = ttl;
+      return *this;
+    }
+
+    Builder& WithInstallationMonitor(
+        const bool enable = true,
+        const std::chrono::seconds ttl = std::chrono::hours(24 * 7)) {
+      config_.enable_installation_monitor = enable;
+      config_.monitored_ttl = ttl;
+      return *this;
+    }
+
+    /**
+     * @brief Serve GetMetricsJson() on the "flatpak_plugin/cache_metrics"
+     * method channel
+     */
+    Builder& WithMetricsChannel(flutter::BinaryMessenger* messenger) {
+      metrics_messenger_ = messenger;
+      return *this;
+    }
+
+    /**
+     * @brief Make icon and screenshot thumbnails with the cache storage,
+     * served by GetThumbnailService() and, given a messenger, on the
+     * "flatpak_plugin/thumbnails" method channel
+     */
+    Builder& WithThumbnails(
+        flutter::BinaryMessenger* messenger = nullptr,
+        const size_t workers = 2,
+        const std::chrono::seconds ttl = std::chrono::hours(24 * 7)) {
+      config_.enable_thumbnails = true;
+      config_.thumbnail_workers = workers;
+      config_.thumbnail_ttl = ttl;
+      thumbnail_messenger_ = messenger;
+      return *this;
+    }
+
     std::unique_ptr<CacheManager> Build();
   };
 
@@ -269,6 +376,8 @@ class CacheManager {
 
  private:
   std::unique_ptr<ICacheStorage> storage_;
+  // Decoded values in front of |storage_|; null when disabled.
+  std::unique_ptr<MemoryCache> memory_cache_;
   std::unique_ptr<INetworkFetcher> network_fetcher_;
   mutable std::vector<std::unique_ptr<ICacheObserver>> observers_;
   CacheConfig config_;
@@ -289,6 +398,37 @@ class CacheManager {
 
   mutable CacheMetrics metrics_;
 
+  // Network fetches in flight, keyed by cache key. Each future holds a
+  // std::optional<T> for the T of the operation that started it.
+  std::mutex inflight_mutex_;
+  std::unordered_map<std::string, std::shared_future<std::any>> inflight_;
+
+  // Background refreshes for STALE_WHILE_REVALIDATE. The worker is started on
+  // first use; |refreshing_keys_| prevents queueing a key twice.
+  std::thread refresh_thread_;
+  std::mutex refresh_mutex_;
+  std::condition_variable refresh_cv_;
+  std::deque<std::pair<std::string, std::function<void()>>> refresh_queue_;
+  std::unordered_set<std::string> refreshing_keys_;
+  bool stop_refresh_ = false;
+
+  // Watches the installations when enabled; see InvalidateInstallation().
+  std::unique_ptr<InstallationMonitor> installation_monitor_;
+
+  // Remotes whose application list has been requested, so they can be
+  // invalidated when the user installation changes.
+  mutable std::mutex remote_ids_mutex_;
+  std::unordered_set<std::string> remote_ids_;
+
+  // Reads and writes |storage_|, so it is declared after it; the channel
+  // goes first.
+  std::unique_ptr<ThumbnailService> thumbnail_service_;
+  std::unique_ptr<ThumbnailChannel> thumbnail_channel_;
+
+  // Declared last so it stops serving calls before anything else is torn
+  // down.
+  std::unique_ptr<CacheMetricsChannel> metrics_channel_;
+
   static std::string GenerateKey(const std::string& base_key,
                                  const std::vector<std::string>& params = {});
 
@@ -297,8 +437,29 @@ class CacheManager {
 
   void CleanupWorker();
 
+  void RefreshWorker();
+
   void IncrementMetric(MetricType type) const;
 
+  MemoryCache::Clock::time_point GetMemoryCacheExpiry() const;
+
+  // Latency histograms to record into; null when metrics are disabled.
+  LatencyMetrics* GetLatencyMetrics() const;
+
+  /**
+   * @brief TTL of installation entries: monitored_ttl while the installation
+   * monitor invalidates them on change, default_ttl otherwise.
+   */
+  std::chrono::seconds GetInstallationTtl() const;
+
+  static std::unique_ptr<ICacheStorage> CreateDefaultStorage(
+      const CacheConfig& config);
+
+  template <typename T>
+  void StoreInMemoryCache(const std::string& key,
+                          const T& data,
+                          size_t size_bytes);
+
   template <typename T>
   std::optional<T> PerformCacheOperation(
       const std::string& key,
@@ -324,6 +485,24 @@ class CacheManager {
       const std::string& key,
       std::function<std::optional<T>()> network_operation,
       CacheOperationTemplate<T>* cache_operation);
+
+  /**
+   * @brief Runs |fetch| unless a fetch for |key| is already in flight, in
+   * which case the caller waits for and shares that fetch's result.
+   */
+  template <typename T>
+  std::optional<T> SingleFlight(const std::string& key,
+                                const std::function<std::optional<T>()>& fetch);
+
+  template <typename T>
+  std::optional<T> GetStaleFromCache(
+      const std::string& key,
+      CacheOperationTemplate<T>* cache_operation);
+
+  template <typename T>
+  void ScheduleRefresh(const std::string& key,
+                       std::function<std::optional<T>()> network_operation,
+                       const CacheOperationTemplate<T>* cache_operation);
 };
 
 }  // namespace flatpak_plugin
@@ -19,8 +19,21 @@
 #define PLUGINS_FLATPAK_CACHE_CACHE_STORAGE_H
 
 #include <chrono>
+#include <functional>
 #include <optional>
 #include <string>
+#include <vector>
+
+/**
+ * @brief A single entry for batched cache writes.
+ */
+struct CacheWrite {
+  std::string key;
+  std::string data;
+  std::chrono::system_clock::time_point expiry;
+  // Opaque revalidation data, see ICacheStorage::StoreWithValidators().
+  std::string validators;
+};
 
 /**
  * @brief Cache Storage Strategy interface
@@ -43,6 +56,66 @@ class ICacheStorage {
                      const std::string& data,
                      std::chrono::system_clock::time_point expiry) = 0;
 
+  /**
+   * @brief Stores data together with validators, an opaque string used to
+   * revalidate the entry with its origin once it expires (e.g. packed
+   * HttpValidators). Store() clears the validators of an entry.
+   *
+   * The default drops the validators.
+   * @return true if the data was successfully stored, false otherwise
+   */
+  virtual bool StoreWithValidators(const std::string& key,
+                                   const std::string& data,
+                                   std::chrono::system_clock::time_point expiry,
+                                   const std::string& /* validators */) {
+    return Store(key, data, expiry);
+  }
+
+  /**
+   * @brief Retrieves the validators stored with an entry, expired entries
+   * included.
+   * @return The validators, or std::nullopt if the entry is gone or has none
+   */
+  virtual std::optional<std::string> RetrieveValidators(
+      const std::string& /* key */) {
+    return std::nullopt;
+  }
+
+  /**
+   * @brief Moves the expiry of a stored entry, expired ones included, e.g.
+   * once its origin answered that it did not change.
+   *
+   * The default stores the entry again through StoreWithValidators().
+   * @param key The key of the entry
+   * @param expiry The new expiry
+   * @param validators Replacement validators; empty keeps the stored ones
+   * @return true if the entry was found and updated, false otherwise
+   */
+  virtual bool ExtendExpiry(const std::string& key,
+                            std::chrono::system_clock::time_point expiry,
+                            const std::string& validators = {}) {
+    const auto data = RetrieveStale(key);
+    return data && StoreWithValidators(key, *data, expiry, validators);
+  }
+
+  /**
+   * @brief Stores several entries at once.
+   *
+   * Implementations backed by a transactional store should commit the whole
+   * batch at once. The default stores each entry individually.
+   * @param entries The entries to store
+   * @return true if every entry was stored, false otherwise
+   */
+  virtual bool StoreMany(const std::vector<CacheWrite>& entries) {
+    bool ok = true;
+    for (const auto& entry : entries) {
+      ok = StoreWithValidators(entry.key, entry.data, entry.expiry,
+                               entry.validators) &&
+           ok;
+    }
+    return ok;
+  }
+
   /**
    * @brief Retrieves a value from the cache storage using the specified key.
    * @param key The key string used to look up the cached value
@@ -51,6 +124,62 @@ class ICacheStorage {
    */
   virtual std::optional<std::string> Retrieve(const std::string& key) = 0;
 
+  /**
+   * @brief Retrieves a value even if it has expired, as long as it has not
+   * been removed by cleanup or invalidation yet.
+   *
+   * Used to serve stale data while it is being refreshed. The default only
+   * returns live entries.
+   * @param key The key string used to look up the cached value
+   * @return std::optional<std::string> The cached value if present,
+   * std::nullopt otherwise
+   */
+  virtual std::optional<std::string> RetrieveStale(const std::string& key) {
+    return Retrieve(key);
+  }
+
+  /**
+   * @brief Passes an entry's data to |visitor| without copying it where the
+   * storage allows, e.g. straight from a database row.
+   *
+   * The data is only valid during the call. Implementations must not hold
+   * their locks while calling |visitor|, so a slow decode cannot stall other
+   * readers and writers. The default visits the result of Retrieve() or
+   * RetrieveStale() after they return, which suffices for storages that
+   * decode straight from their backing store into that result.
+   * @param key The key string used to look up the cached value
+   * @param visitor Receives the data and its size if the entry is present
+   * @param include_expired Whether expired entries that are still stored
+   * count as present
+   * @return true if |visitor| was called
+   */
+  virtual bool RetrieveInPlace(
+      const std::string& key,
+      const std::function<void(const char* data, size_t size)>& visitor,
+      const bool include_expired = false) {
+    const auto data = include_expired ? RetrieveStale(key) : Retrieve(key);
+    if (!data) {
+      return false;
+    }
+    visitor(data->data(), data->size());
+    return true;
+  }
+
+  /**
+   * @brief Visits every stored entry, expired ones included, from one
+   * consistent view of the storage.
+   *
+   * Used to export snapshots. The default does not support iteration.
+   * @param visitor Receives each entry with its uncompressed data; returning
+   * false stops the iteration
+   * @return true if every entry was visited, false if iteration is
+   * unsupported, failed or was stopped by |visitor|
+   */
+  virtual bool ForEachEntry(
+      const std::function<bool(const CacheWrite&)>& /* visitor */) {
+    return false;
+  }
+
   /**
    * @brief Checks if a cache entry has expired based on its key.
    * @param key The unique identifier of the cache entry to check for expiration
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_CACHE_COMPRESSION_CODEC_H
+#define PLUGINS_FLATPAK_CACHE_COMPRESSION_CODEC_H
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+/**
+ * @enum CompressionType
+ * @brief Identifies the codec an entry was compressed with. The values are
+ * persisted alongside each entry and must not change.
+ */
+enum class CompressionType : int { NONE = 0, ZLIB = 1, ZSTD = 2 };
+
+/**
+ * @struct CompressionOptions
+ * @brief Codec selection for a cache storage backend.
+ * @var type Codec used for new entries.
+ * @var level Codec specific compression level.
+ * @var use_dictionary Train and use a shared dictionary if the codec
+ * supports it.
+ * @var dictionary_size Maximum size of a trained dictionary in bytes.
+ */
+struct CompressionOptions {
+  CompressionType type = CompressionType::ZSTD;
+  int level = 3;
+  bool use_dictionary = false;
+  size_t dictionary_size = 16 * 1024;
+};
+
+/**
+ * @brief Compression Codec Strategy interface
+ *
+ * Codecs are stateful (they may reuse compression contexts and hold a
+ * dictionary) and are not thread-safe; callers serialize access.
+ */
+class ICompressionCodec {
+ public:
+  virtual ~ICompressionCodec() = default;
+
+  /**
+   * @brief Gets the identifier persisted with entries from this codec.
+   * @return The codec type
+   */
+  [[nodiscard]] virtual CompressionType GetType() const = 0;
+
+  /**
+   * @brief Compresses a buffer.
+   * @param data The uncompressed data
+   * @return The compressed data, or std::nullopt on failure
+   */
+  virtual std::optional<std::string> Compress(const std::string& data) = 0;
+
+  /**
+   * @brief Decompresses a buffer in a single pass, straight into the
+   * returned string.
+   * @param data The compressed data, e.g. a database blob
+   * @param size The size of the compressed data
+   * @param original_size The exact size of the uncompressed data
+   * @return The uncompressed data, or std::nullopt on failure or size mismatch
+   */
+  virtual std::optional<std::string> Decompress(const char* data,
+                                                size_t size,
+                                                size_t original_size) = 0;
+
+  /**
+   * @brief Decompresses a buffer in a single pass.
+   * @param data The compressed data
+   * @param original_size The exact size of the uncompressed data
+   * @return The uncompressed data, or std::nullopt on failure or size mismatch
+   */
+  std::optional<std::string> Decompress(const std::string& data,
+                                        const size_t original_size) {
+    return Decompress(data.data(), data.size(), original_size);
+  }
+
+  /**
+   * @brief Whether SetDictionary() can succeed.
+   * @return true if the codec supports dictionaries
+   */
+  [[nodiscard]] virtual bool SupportsDictionary() const { return false; }
+
+  /**
+   * @brief Installs a dictionary used for both directions.
+   * @param dictionary The raw dictionary content
+   * @return true if the codec supports dictionaries and accepted it
+   */
+  virtual bool SetDictionary(const std::string& /* dictionary */) {
+    return false;
+  }
+};
+
+#endif  // PLUGINS_FLATPAK_CACHE_COMPRESSION_CODEC_H
@@ -18,11 +18,61 @@
 #ifndef PLUGINS_FLATPAK_CACHE_NETWORK_FETCHER_H
 #define PLUGINS_FLATPAK_CACHE_NETWORK_FETCHER_H
 
+#include <functional>
 #include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+/**
+ * @brief Validators of a cached HTTP response, sent back to the origin to ask
+ * whether the response changed.
+ */
+struct HttpValidators {
+  std::string etag;
+  std::string last_modified;
+
+  bool IsEmpty() const { return etag.empty() && last_modified.empty(); }
+
+  /**
+   * @brief Packs the validators into a string suitable for cache storage.
+   * Header values cannot contain line breaks, so a newline separates them.
+   */
+  std::string Serialize() const { return etag + '\n' + last_modified; }
+
+  /**
+   * @brief Unpacks validators packed by Serialize().
+   */
+  static HttpValidators Parse(const std::string& packed) {
+    HttpValidators validators;
+    const auto separator = packed.find('\n');
+    validators.etag = packed.substr(0, separator);
+    if (separator != std::string::npos) {
+      validators.last_modified = packed.substr(separator + 1);
+    }
+    return validators;
+  }
+};
+
+/**
+ * @brief Outcome of a conditional GET request.
+ * @var status The final HTTP status code, or 0 if no response was received
+ * @var body The response body on a 2xx response
+ * @var validators Validators of a 2xx response, to store with the body; on a
+ * 304 response, validators the origin sent to replace the stored ones
+ */
+struct FetchResult {
+  long status = 0;
+  std::optional<std::string> body;
+  HttpValidators validators;
+
+  /**
+   * @brief Whether the origin confirmed the cached response is still current,
+   * so its expiry can be extended without downloading it again.
+   */
+  bool IsNotModified() const { return status == 304; }
+};
+
 /**
  * @brief Network Fetcher Strategy interface
  *
@@ -45,6 +95,42 @@ class INetworkFetcher {
       const std::string& url,
       const std::vector<std::string>& headers) = 0;
 
+  /**
+   * @brief Performs an HTTP GET request that the origin can answer with 304
+   * Not Modified if the response matching |validators| is still current.
+   *
+   * The default sends an unconditional request through Fetch().
+   * @param url The target URL to fetch data from
+   * @param headers Optional HTTP headers to include in the request
+   * @param validators Validators of the cached response; empty for an
+   * unconditional request
+   * @return FetchResult The status, body and validators of the response
+   */
+  virtual FetchResult FetchConditional(
+      const std::string& url,
+      const std::vector<std::string>& headers,
+      const HttpValidators& /* validators */) {
+    FetchResult result;
+    result.body = Fetch(url, headers);
+    result.status = result.body ? 200 : GetLastResponseCode();
+    return result;
+  }
+
+  /**
+   * @brief Asynchronous FetchConditional(). Retries are scheduled instead of
+   * waited for, so no thread blocks during backoff.
+   *
+   * The default runs FetchConditional() on the calling thread.
+   * @param callback Receives the result, possibly on another thread
+   */
+  virtual void FetchConditionalAsync(
+      const std::string& url,
+      const std::vector<std::string>& headers,
+      const HttpValidators& validators,
+      std::function<void(FetchResult)> callback) {
+    callback(FetchConditional(url, headers, validators));
+  }
+
   /**
    * @brief Performs an HTTP POST request with form data
    *
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cache_metrics_channel.h"
+
+#include <flutter/method_channel.h>
+#include <flutter/standard_method_codec.h>
+
+#include "flatpak/cache/cache_manager.h"
+
+namespace flatpak_plugin {
+
+CacheMetricsChannel::CacheMetricsChannel(flutter::BinaryMessenger* messenger,
+                                         const CacheManager* manager)
+    : channel_(std::make_unique<flutter::MethodChannel<>>(
+          messenger,
+          "flatpak_plugin/cache_metrics",
+          &flutter::StandardMethodCodec::GetInstance())) {
+  channel_->SetMethodCallHandler(
+      [manager](const flutter::MethodCall<>& call,
+                std::unique_ptr<flutter::MethodResult<>> result) {
+        if (call.method_name() == "getMetrics") {
+          result->Success(flutter::EncodableValue(manager->GetMetricsJson()));
+        } else if (call.method_name() == "resetLatency") {
+          manager->ResetLatencyMetrics();
+          result->Success();
+        } else {
+          result->NotImplemented();
+        }
+      });
+}
+
+CacheMetricsChannel::~CacheMetricsChannel() {
+  channel_->SetMethodCallHandler(nullptr);
+}
+
+}  // namespace flatpak_plugin
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_CACHE_CACHE_METRICS_CHANNEL_H
+#define PLUGINS_FLATPAK_CACHE_CACHE_METRICS_CHANNEL_H
+
+#include <memory>
+
+#include <flutter/encodable_value.h>
+
+namespace flutter {
+class BinaryMessenger;
+template <typename T>
+class MethodChannel;
+}  // namespace flutter
+
+namespace flatpak_plugin {
+
+class CacheManager;
+
+/**
+ * @brief Serves cache metrics on the "flatpak_plugin/cache_metrics" method
+ * channel.
+ *
+ * "getMetrics" answers with CacheManager::GetMetricsJson() as a string and
+ * "resetLatency" clears the latency histograms.
+ */
+class CacheMetricsChannel {
+ public:
+  /**
+   * @param messenger Messenger to register the channel with
+   * @param manager Cache manager to report on; must outlive the channel
+   */
+  CacheMetricsChannel(flutter::BinaryMessenger* messenger,
+                      const CacheManager* manager);
+
+  ~CacheMetricsChannel();
+
+  CacheMetricsChannel(const CacheMetricsChannel&) = delete;
+  CacheMetricsChannel& operator=(const CacheMetricsChannel&) = delete;
+
+ private:
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> channel_;
+};
+
+}  // namespace flatpak_plugin
+
+#endif  // PLUGINS_FLATPAK_CACHE_CACHE_METRICS_CHANNEL_H
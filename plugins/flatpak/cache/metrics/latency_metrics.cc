@@ -0,0 +1,250 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "latency_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <spdlog/fmt/fmt.h>
+
+namespace flatpak_plugin {
+
+namespace {
+
+constexpr std::string_view kOtherKeyClass = "other";
+
+void AppendJsonString(std::string& out, const std::string_view value) {
+  out.push_back('"');
+  for (const char c : value) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+      out.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out += fmt::format("\\u{:04x}", static_cast<int>(c));
+    } else {
+      out.push_back(c);
+    }
+  }
+  out.push_back('"');
+}
+
+}  // namespace
+
+size_t LatencyHistogram::GetBucketIndex(uint64_t value_us) {
+  value_us = std::min(value_us, kMaxValue);
+  if (value_us < kSubBucketCount) {
+    return static_cast<size_t>(value_us);
+  }
+  unsigned magnitude = 0;
+  for (uint64_t v = value_us; v > 1; v >>= 1) {
+    magnitude++;
+  }
+  // Keep the top kSubBucketBits + 1 bits; each shift step starts a new run
+  // of kSubBucketCount buckets.
+  const unsigned shift = magnitude - kSubBucketBits;
+  return static_cast<size_t>((uint64_t{shift} << kSubBucketBits) +
+                             (value_us >> shift));
+}
+
+uint64_t LatencyHistogram::GetBucketLowerBound(const size_t index) {
+  if (index < 2 * kSubBucketCount) {
+    return index;
+  }
+  const auto shift = static_cast<unsigned>(index >> kSubBucketBits) - 1;
+  const uint64_t sub_bucket = (index & (kSubBucketCount - 1)) + kSubBucketCount;
+  return sub_bucket << shift;
+}
+
+void LatencyHistogram::Record(const std::chrono::nanoseconds latency) {
+  const auto value_us = static_cast<uint64_t>(std::max<int64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(latency).count(),
+      0));
+  buckets_[GetBucketIndex(value_us)].fetch_add(1, std::memory_order_relaxed);
+  sum_us_.fetch_add(value_us, std::memory_order_relaxed);
+  uint64_t max = max_us_.load(std::memory_order_relaxed);
+  while (value_us > max && !max_us_.compare_exchange_weak(
+                               max, value_us, std::memory_order_relaxed)) {
+  }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::GetSnapshot() const {
+  Snapshot snapshot;
+  // The count is derived from the buckets so percentiles add up even while
+  // other threads are recording.
+  for (size_t i = 0; i < kBucketCount; i++) {
+    snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.count += snapshot.buckets[i];
+  }
+  snapshot.sum_us = sum_us_.load(std::memory_order_relaxed);
+  snapshot.max_us = max_us_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+void LatencyHistogram::Reset() {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  sum_us_.store(0, std::memory_order_relaxed);
+  max_us_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Snapshot::ValueAtPercentile(
+    const double percentile) const {
+  if (count == 0) {
+    return 0;
+  }
+  const auto rank = static_cast<uint64_t>(std::max(
+      1.0, std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 *
+                     static_cast<double>(count))));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; i++) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      const uint64_t lower = GetBucketLowerBound(i);
+      const uint64_t upper = i + 1 < kBucketCount
+                                 ? GetBucketLowerBound(i + 1) - 1
+                                 : kMaxValue;
+      return std::min(lower + (upper - lower) / 2, std::max(max_us, lower));
+    }
+  }
+  return max_us;
+}
+
+LatencyMetrics::~LatencyMetrics() {
+  for (size_t i = 0; i < class_count_.load(std::memory_order_acquire); i++) {
+    delete classes_[i].load(std::memory_order_relaxed);
+  }
+}
+
+std::string_view LatencyMetrics::GetKeyClass(const std::string_view key) {
+  return key.substr(0, key.find(':'));
+}
+
+const char* LatencyMetrics::GetOperationName(
+    const LatencyOperation operation) {
+  switch (operation) {
+    case LatencyOperation::STORAGE_READ:
+      return "storage_read";
+    case LatencyOperation::STORAGE_WRITE:
+      return "storage_write";
+    case LatencyOperation::SERIALIZE:
+      return "serialize";
+    case LatencyOperation::DESERIALIZE:
+      return "deserialize";
+    case LatencyOperation::NETWORK:
+      return "network";
+    case LatencyOperation::kCount:
+      break;
+  }
+  return "unknown";
+}
+
+LatencyMetrics::KeyClass* LatencyMetrics::FindKeyClass(
+    const std::string_view name) const {
+  const size_t count = class_count_.load(std::memory_order_acquire);
+  for (size_t i = 0; i < count; i++) {
+    if (KeyClass* key_class = classes_[i].load(std::memory_order_relaxed);
+        key_class->name == name) {
+      return key_class;
+    }
+  }
+  return nullptr;
+}
+
+LatencyMetrics::KeyClass* LatencyMetrics::FindOrAddKeyClass(
+    std::string_view name) {
+  if (KeyClass* key_class = FindKeyClass(name)) {
+    return key_class;
+  }
+
+  std::lock_guard lock(register_mutex_);
+  const size_t count = class_count_.load(std::memory_order_relaxed);
+  // The last slot is reserved for everything that does not fit.
+  if (count >= kMaxKeyClasses - 1) {
+    name = kOtherKeyClass;
+  }
+  // Another thread may have added it meanwhile.
+  if (KeyClass* key_class = FindKeyClass(name)) {
+    return key_class;
+  }
+
+  auto* key_class = new KeyClass{std::string(name), {}};
+  classes_[count].store(key_class, std::memory_order_relaxed);
+  class_count_.store(count + 1, std::memory_order_release);
+  return key_class;
+}
+
+void LatencyMetrics::Record(const std::string_view key,
+                            const LatencyOperation operation,
+                            const std::chrono::nanoseconds latency) {
+  if (operation >= LatencyOperation::kCount) {
+    return;
+  }
+  FindOrAddKeyClass(GetKeyClass(key))
+      ->histograms[static_cast<size_t>(operation)]
+      .Record(latency);
+}
+
+std::string LatencyMetrics::ToJson() const {
+  std::string json = "{";
+  bool first_class = true;
+  const size_t count = class_count_.load(std::memory_order_acquire);
+  for (size_t i = 0; i < count; i++) {
+    const KeyClass* key_class = classes_[i].load(std::memory_order_relaxed);
+    std::string operations;
+    for (size_t op = 0; op < key_class->histograms.size(); op++) {
+      const auto snapshot = key_class->histograms[op].GetSnapshot();
+      if (snapshot.count == 0) {
+        continue;
+      }
+      if (!operations.empty()) {
+        operations.push_back(',');
+      }
+      AppendJsonString(operations,
+                       GetOperationName(static_cast<LatencyOperation>(op)));
+      operations += fmt::format(
+          ":{{\"count\":{},\"mean_us\":{:.1f},\"p50_us\":{},\"p90_us\":{},"
+          "\"p99_us\":{},\"max_us\":{}}}",
+          snapshot.count, snapshot.GetMean(), snapshot.ValueAtPercentile(50),
+          snapshot.ValueAtPercentile(90), snapshot.ValueAtPercentile(99),
+          snapshot.max_us);
+    }
+    if (operations.empty()) {
+      continue;
+    }
+    if (!first_class) {
+      json.push_back(',');
+    }
+    first_class = false;
+    AppendJsonString(json, key_class->name);
+    json += ":{" + operations + "}";
+  }
+  json.push_back('}');
+  return json;
+}
+
+void LatencyMetrics::Reset() {
+  const size_t count = class_count_.load(std::memory_order_acquire);
+  for (size_t i = 0; i < count; i++) {
+    KeyClass* key_class = classes_[i].load(std::memory_order_relaxed);
+    for (auto& histogram : key_class->histograms) {
+      histogram.Reset();
+    }
+  }
+}
+
+}  // namespace flatpak_plugin
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_CACHE_LATENCY_METRICS_H
+#define PLUGINS_FLATPAK_CACHE_LATENCY_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace flatpak_plugin {
+
+/**
+ * @brief Lock-free latency histogram with HDR-style log-linear buckets.
+ *
+ * Values are recorded in microseconds. Every power of two is split into 32
+ * linear sub-buckets, so any reported value is within about 3% of the
+ * recorded one; values below 64 µs are exact. Recording is a handful of
+ * relaxed atomic operations and never allocates.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr unsigned kSubBucketBits = 5;
+  static constexpr uint64_t kSubBucketCount = 1u << kSubBucketBits;
+  static constexpr unsigned kMaxValueBits = 36;
+  // Larger values (about 19 hours) are clamped.
+  static constexpr uint64_t kMaxValue = (uint64_t{1} << kMaxValueBits) - 1;
+  static constexpr size_t kBucketCount =
+      ((kMaxValueBits - 1 - kSubBucketBits) << kSubBucketBits) +
+      2 * kSubBucketCount;
+
+  /**
+   * @brief A consistent-enough copy of the histogram for reporting.
+   */
+  struct Snapshot {
+    uint64_t count = 0;
+    uint64_t sum_us = 0;
+    uint64_t max_us = 0;
+    std::array<uint64_t, kBucketCount> buckets{};
+
+    /**
+     * @brief Gets the value at a percentile.
+     * @param percentile In the range [0, 100]
+     * @return The midpoint of the bucket holding the percentile, capped by
+     * the maximum recorded value; zero when empty
+     */
+    [[nodiscard]] uint64_t ValueAtPercentile(double percentile) const;
+
+    [[nodiscard]] double GetMean() const {
+      return count > 0
+                 ? static_cast<double>(sum_us) / static_cast<double>(count)
+                 : 0.0;
+    }
+  };
+
+  void Record(std::chrono::nanoseconds latency);
+
+  [[nodiscard]] Snapshot GetSnapshot() const;
+
+  void Reset();
+
+  static size_t GetBucketIndex(uint64_t value_us);
+
+  static uint64_t GetBucketLowerBound(size_t index);
+
+ private:
+  std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+  std::atomic<uint64_t> sum_us_{0};
+  std::atomic<uint64_t> max_us_{0};
+};
+
+/**
+ * @enum LatencyOperation
+ * @brief The timed stages of a cache lookup or store.
+ */
+enum class LatencyOperation : size_t {
+  STORAGE_READ,
+  STORAGE_WRITE,
+  SERIALIZE,
+  DESERIALIZE,
+  NETWORK,
+  kCount
+};
+
+/**
+ * @brief Latency histograms per operation and key class.
+ *
+ * The key class is the part of a cache key before the first ':', i.e. the
+ * base key passed to CacheManager::GenerateKey(), so all remotes share one
+ * "applications_remote" class. Recording into a known class is lock-free; a
+ * mutex is only taken the first time a class is seen. Classes beyond
+ * kMaxKeyClasses are recorded as "other".
+ */
+class LatencyMetrics {
+ public:
+  static constexpr size_t kMaxKeyClasses = 32;
+
+  LatencyMetrics() = default;
+
+  ~LatencyMetrics();
+
+  LatencyMetrics(const LatencyMetrics&) = delete;
+  LatencyMetrics& operator=(const LatencyMetrics&) = delete;
+
+  /**
+   * @brief Records one operation.
+   * @param key The full cache key
+   * @param operation The timed stage
+   * @param latency The time it took
+   */
+  void Record(std::string_view key,
+              LatencyOperation operation,
+              std::chrono::nanoseconds latency);
+
+  /**
+   * @brief Dumps count, mean, p50, p90, p99 and max (in microseconds) of
+   * every non-empty histogram as a JSON object keyed by key class and then
+   * operation.
+   */
+  [[nodiscard]] std::string ToJson() const;
+
+  /**
+   * @brief Clears all histograms. Key classes stay registered.
+   */
+  void Reset();
+
+  static std::string_view GetKeyClass(std::string_view key);
+
+  static const char* GetOperationName(LatencyOperation operation);
+
+ private:
+  struct KeyClass {
+    std::string name;
+    std::array<LatencyHistogram, static_cast<size_t>(LatencyOperation::kCount)>
+        histograms;
+  };
+
+  KeyClass* FindKeyClass(std::string_view name) const;
+
+  KeyClass* FindOrAddKeyClass(std::string_view name);
+
+  // Published with release order once fully constructed; never removed.
+  std::array<std::atomic<KeyClass*>, kMaxKeyClasses> classes_{};
+  std::atomic<size_t> class_count_{0};
+  std::mutex register_mutex_;
+};
+
+/**
+ * @brief Records the time from construction to destruction. Does nothing
+ * when constructed without metrics.
+ */
+class ScopedLatency {
+ public:
+  ScopedLatency(LatencyMetrics* metrics,
+                std::string_view key,
+                LatencyOperation operation)
+      : metrics_(metrics),
+        key_(key),
+        operation_(operation),
+        start_(metrics ? std::chrono::steady_clock::now()
+                       : std::chrono::steady_clock::time_point()) {}
+
+  ~ScopedLatency() {
+    if (metrics_) {
+      metrics_->Record(key_, operation_,
+                       std::chrono::steady_clock::now() - start_);
+    }
+  }
+
+  ScopedLatency(const ScopedLatency&) = delete;
+  ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+ private:
+  LatencyMetrics* metrics_;
+  std::string_view key_;
+  LatencyOperation operation_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace flatpak_plugin
+
+#endif  // PLUGINS_FLATPAK_CACHE_LATENCY_METRICS_H
@@ -0,0 +1,223 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "installation_monitor.h"
+
+#include <future>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include "plugins/flatpak/flatpak_shim.h"
+
+namespace flatpak_plugin {
+
+struct InstallationWatch {
+  std::string installation_id;
+  FlatpakInstallation* installation = nullptr;
+  GFileMonitor* monitor = nullptr;
+  // Settle timer of the latest burst of events, if one is pending.
+  GSource* pending = nullptr;
+  guint settle_delay_ms = 0;
+  const InstallationMonitor::ChangeCallback* on_changed = nullptr;
+
+  ~InstallationWatch() {
+    if (pending) {
+      g_source_destroy(pending);
+      g_source_unref(pending);
+    }
+    if (monitor) {
+      g_signal_handlers_disconnect_by_data(monitor, this);
+      g_file_monitor_cancel(monitor);
+      g_object_unref(monitor);
+    }
+    if (installation) {
+      g_object_unref(installation);
+    }
+  }
+};
+
+namespace {
+
+gboolean OnInstallationSettled(const gpointer user_data) {
+  auto* watch = static_cast<InstallationWatch*>(user_data);
+  g_source_unref(watch->pending);
+  watch->pending = nullptr;
+
+  // The shared installation objects keep remotes and refs in memory.
+  GError* error = nullptr;
+  if (!flatpak_installation_drop_caches(watch->installation, nullptr,
+                                        &error)) {
+    spdlog::warn("[FlatpakPlugin] Failed to drop caches of installation {}: {}",
+                 watch->installation_id,
+                 error ? error->message : "unknown error");
+    g_clear_error(&error);
+  }
+
+  spdlog::debug("[FlatpakPlugin] Installation {} changed",
+                watch->installation_id);
+  try {
+    (*watch->on_changed)(watch->installation_id);
+  } catch (const std::exception& e) {
+    spdlog::error("[FlatpakPlugin] Installation change handler failed: {}",
+                  e.what());
+  }
+  return G_SOURCE_REMOVE;
+}
+
+void OnInstallationChanged(GFileMonitor* /* monitor */,
+                           GFile* /* file */,
+                           GFile* /* other_file */,
+                           GFileMonitorEvent /* event_type */,
+                           const gpointer user_data) {
+  auto* watch = static_cast<InstallationWatch*>(user_data);
+  if (watch->pending) {
+    g_source_destroy(watch->pending);
+    g_source_unref(watch->pending);
+  }
+  watch->pending = g_timeout_source_new(watch->settle_delay_ms);
+  g_source_set_callback(watch->pending, OnInstallationSettled, watch, nullptr);
+  g_source_attach(watch->pending, g_main_context_get_thread_default());
+}
+
+gboolean QuitLoop(const gpointer user_data) {
+  g_main_loop_quit(static_cast<GMainLoop*>(user_data));
+  return G_SOURCE_REMOVE;
+}
+
+}  // namespace
+
+InstallationMonitor::InstallationMonitor(
+    ChangeCallback on_changed,
+    const std::chrono::milliseconds settle_delay)
+    : on_changed_(std::move(on_changed)), settle_delay_(settle_delay) {}
+
+InstallationMonitor::~InstallationMonitor() {
+  Stop();
+}
+
+bool InstallationMonitor::Start() {
+  if (thread_.joinable()) {
+    return active_.load();
+  }
+
+  std::promise<bool> started;
+  auto watching = started.get_future();
+  thread_ = std::thread([this, &started] {
+    Run([&started](const bool ok) { started.set_value(ok); });
+  });
+  return watching.get();
+}
+
+void InstallationMonitor::Stop() {
+  {
+    // The loop may not be running yet, so quit from inside it rather than
+    // calling g_main_loop_quit() directly.
+    std::lock_guard lock(mutex_);
+    if (loop_) {
+      GSource* source = g_idle_source_new();
+      g_source_set_callback(source, QuitLoop, g_main_loop_ref(loop_),
+                            reinterpret_cast<GDestroyNotify>(g_main_loop_unref));
+      g_source_attach(source, context_);
+      g_source_unref(source);
+    }
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void InstallationMonitor::Run(const std::function<void(bool)>& started) {
+  // File monitors deliver their signals to the thread-default context that
+  // is current when they are created.
+  GMainContext* context = g_main_context_new();
+  g_main_context_push_thread_default(context);
+  GMainLoop* loop = g_main_loop_new(context, FALSE);
+
+  AddWatches();
+  const bool watching = !watches_.empty();
+  {
+    std::lock_guard lock(mutex_);
+    context_ = context;
+    loop_ = loop;
+  }
+  active_.store(watching);
+  started(watching);
+
+  if (watching) {
+    spdlog::info("[FlatpakPlugin] Monitoring {} installation(s) for changes",
+                 watches_.size());
+    g_main_loop_run(loop);
+  }
+
+  active_.store(false);
+  watches_.clear();
+  {
+    std::lock_guard lock(mutex_);
+    context_ = nullptr;
+    loop_ = nullptr;
+  }
+  g_main_loop_unref(loop);
+  g_main_context_pop_thread_default(context);
+  g_main_context_unref(context);
+}
+
+void InstallationMonitor::AddWatches() {
+  const auto add = [this](FlatpakInstallation* installation) {
+    const char* id = flatpak_installation_get_id(installation);
+    GError* error = nullptr;
+    GFileMonitor* monitor =
+        flatpak_installation_create_monitor(installation, nullptr, &error);
+    if (!monitor) {
+      spdlog::warn("[FlatpakPlugin] Failed to monitor installation {}: {}",
+                   id ? id : "", error ? error->message : "unknown error");
+      g_clear_error(&error);
+      return;
+    }
+
+    auto watch = std::make_unique<InstallationWatch>();
+    watch->installation_id = id ? id : "";
+    watch->installation =
+        static_cast<FlatpakInstallation*>(g_object_ref(installation));
+    watch->monitor = monitor;
+    watch->settle_delay_ms = static_cast<guint>(settle_delay_.count());
+    watch->on_changed = &on_changed_;
+    g_signal_connect(monitor, "changed", G_CALLBACK(OnInstallationChanged),
+                     watch.get());
+    watches_.push_back(std::move(watch));
+  };
+
+  GError* error = nullptr;
+  if (FlatpakInstallation* installation =
+          FlatpakShim::get_user_installation(&error)) {
+    add(installation);
+    g_object_unref(installation);
+  } else {
+    spdlog::warn("[FlatpakPlugin] Failed to get user installation: {}",
+                 error ? error->message : "unknown error");
+    g_clear_error(&error);
+  }
+
+  if (GPtrArray* installations = FlatpakShim::get_system_installations()) {
+    for (guint i = 0; i < installations->len; i++) {
+      add(static_cast<FlatpakInstallation*>(
+          g_ptr_array_index(installations, i)));
+    }
+    g_ptr_array_unref(installations);
+  }
+}
+
+}  // namespace flatpak_plugin
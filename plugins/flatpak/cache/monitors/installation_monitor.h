@@ -0,0 +1,106 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_CACHE_MONITORS_INSTALLATION_MONITOR_H
+#define PLUGINS_FLATPAK_CACHE_MONITORS_INSTALLATION_MONITOR_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef struct _GMainContext GMainContext;
+typedef struct _GMainLoop GMainLoop;
+
+namespace flatpak_plugin {
+
+struct InstallationWatch;
+
+/**
+ * @class InstallationMonitor
+ * @brief Watches the user and system Flatpak installations for changes.
+ *
+ * Every installation gets a file monitor from
+ * flatpak_installation_create_monitor(), which fires when a ref is
+ * installed, updated or uninstalled or a remote is modified. The monitors
+ * run on a private GLib main context so no application main loop is needed.
+ * Bursts of events (a transaction touches the installation several times)
+ * are coalesced, then the installation's in-memory caches are dropped and
+ * the callback is invoked once with the installation id.
+ */
+class InstallationMonitor {
+ public:
+  using ChangeCallback = std::function<void(const std::string&)>;
+
+  /**
+   * @brief Creates a stopped monitor.
+   * @param on_changed Called on the monitor thread with the id of the
+   * installation that changed
+   * @param settle_delay Quiet period after the last event before
+   * |on_changed| runs
+   */
+  explicit InstallationMonitor(
+      ChangeCallback on_changed,
+      std::chrono::milliseconds settle_delay = std::chrono::milliseconds(500));
+
+  ~InstallationMonitor();
+
+  InstallationMonitor(const InstallationMonitor&) = delete;
+  InstallationMonitor& operator=(const InstallationMonitor&) = delete;
+
+  /**
+   * @brief Starts the monitor thread and watches every installation.
+   * @return true if at least one installation is watched
+   */
+  bool Start();
+
+  /**
+   * @brief Stops watching and joins the monitor thread. Pending change
+   * notifications are dropped.
+   */
+  void Stop();
+
+  /**
+   * @brief Check if installations are being watched
+   * @return true while the monitor is running
+   */
+  bool IsActive() const { return active_.load(); }
+
+ private:
+  void Run(const std::function<void(bool)>& started);
+
+  void AddWatches();
+
+  ChangeCallback on_changed_;
+  std::chrono::milliseconds settle_delay_;
+
+  std::mutex mutex_;
+  GMainContext* context_ = nullptr;
+  GMainLoop* loop_ = nullptr;
+  std::thread thread_;
+  std::atomic<bool> active_{false};
+
+  // Only touched on the monitor thread.
+  std::vector<std::unique_ptr<InstallationWatch>> watches_;
+};
+
+}  // namespace flatpak_plugin
+
+#endif  // PLUGINS_FLATPAK_CACHE_MONITORS_INSTALLATION_MONITOR_H
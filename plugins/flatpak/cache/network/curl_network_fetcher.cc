@@ -14,134 +14,230 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-
+#include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <exception>
+#include <future>
+#include <map>
 #include <memory>
 #include <optional>
-#include <thread>
 
 #include "curl_network_fetcher.h"
 #include "plugins/common/common.h"
 
+namespace {
+
+constexpr std::chrono::milliseconds kRetryBaseDelay(1000);
+constexpr std::chrono::milliseconds kMaxRetryDelay(30000);
+
+// Statuses worth another attempt; 0 means no response was received.
+bool IsTransient(const long status) {
+  return status == 0 || status >= 500 || status == 408 || status == 429;
+}
+
+// Only the delta-seconds form of Retry-After is honored.
+std::chrono::seconds ParseRetryAfter(
+    const std::map<std::string, std::string>& headers) {
+  const auto it = headers.find("retry-after");
+  if (it == headers.end() || it->second.empty() ||
+      !std::all_of(it->second.begin(), it->second.end(),
+                   [](const unsigned char c) { return std::isdigit(c); })) {
+    return std::chrono::seconds(0);
+  }
+  return std::chrono::seconds(std::stoll(it->second.substr(0, 9)));
+}
+
+std::string GetHeader(const std::map<std::string, std::string>& headers,
+                      const std::string& name) {
+  const auto it = headers.find(name);
+  return it != headers.end() ? it->second : std::string();
+}
+
+}  // namespace
+
+struct CurlNetworkFetcher::Request {
+  std::string url;
+  std::vector<std::string> headers;
+  HttpValidators validators;
+  // Set for POST requests.
+  std::optional<std::vector<std::pair<std::string, std::string>>> form_data;
+  std::function<void(FetchResult)> callback;
+  int retries = 0;
+};
+
 CurlNetworkFetcher::CurlNetworkFetcher(std::chrono::seconds /* timeout */,
                                        const int max_retries)
-    : max_retries_(max_retries) {
+    : max_retries_(max_retries), random_(std::random_device{}()) {
   curl_client_ = std::make_unique<plugin_common_curl::CurlClient>();
 }
 
-CurlNetworkFetcher::~CurlNetworkFetcher() = default;
-
-template <typename Operation>
-std::optional<std::string> CurlNetworkFetcher::PerformWithRetry(
-    Operation&& operation) {
-  int attempts = 0;
+CurlNetworkFetcher::~CurlNetworkFetcher() {
+  stopping_.store(true);
+}
 
-  while (attempts <= max_retries_) {
-    try {
-      if (auto result = operation(); result.has_value()) {
-        return result;
-      }
-
-      const long response_code = last_response_code_.load();
-      if (response_code >= 200 && response_code < 300) {
-        // success
-        return std::nullopt;
-      }
-
-      if (response_code >= 500 || response_code == 408 ||
-          response_code == 429) {
-        ++attempts;
-        if (attempts <= max_retries_) {
-          // exponential backoff
-          std::this_thread::sleep_for(
-              std::chrono::seconds(1 << (attempts - 1)));
-          continue;
-        }
-        return std::nullopt;
-      }
-    } catch (std::exception& e) {
-      spdlog::error("Network operation failed: {}", e.what());
-      ++attempts;
-      spdlog::error("Retrying network operation (attempt {})", attempts);
-      if (attempts <= max_retries_) {
-        // exponential backoff
-        std::this_thread::sleep_for(std::chrono::seconds(1 << (attempts - 1)));
-        continue;
-      }
-      break;
-    }
-  }
-  return std::nullopt;
+std::chrono::milliseconds CurlNetworkFetcher::GetRetryDelay(
+    const int retry,
+    const std::chrono::seconds retry_after,
+    const double jitter) {
+  const int shift = std::clamp(retry - 1, 0, 16);
+  const auto backoff =
+      std::min(kMaxRetryDelay, kRetryBaseDelay * (int64_t{1} << shift));
+  const auto half = backoff / 2;
+  const auto delay =
+      half + std::chrono::milliseconds(static_cast<int64_t>(
+                 std::clamp(jitter, 0.0, 1.0) * (backoff - half).count()));
+  return std::max(
+      delay, std::min<std::chrono::milliseconds>(retry_after, kMaxRetryDelay));
 }
 
 std::optional<std::string> CurlNetworkFetcher::Fetch(
     const std::string& url,
     const std::vector<std::string>& headers) {
-  auto operation = [this, &url, &headers]() -> std::optional<std::string> {
-    try {
-      std::vector<std::string> processed_headers;
-      ProcessHeaders(headers, processed_headers);
-
-      auto response = curl_client_->Get(url);
-      last_response_code_.store(curl_client_->GetHttpCode());
-
-      if (const long response_code = last_response_code_.load();
-          response_code >= 200 && response_code < 300) {
-        // success
-        return response;
-      }
+  return FetchConditional(url, headers, {}).body;
+}
 
-      return std::nullopt;
-    } catch (const std::exception& e) {
-      spdlog::error("Network operation failed: {}", e.what());
-      return std::nullopt;
-    }
-  };
+FetchResult CurlNetworkFetcher::FetchConditional(
+    const std::string& url,
+    const std::vector<std::string>& headers,
+    const HttpValidators& validators) {
+  auto request = std::make_shared<Request>();
+  request->url = url;
+  request->headers = headers;
+  request->validators = validators;
+  return Wait(std::move(request));
+}
 
-  return PerformWithRetry(std::move(operation));
+void CurlNetworkFetcher::FetchConditionalAsync(
+    const std::string& url,
+    const std::vector<std::string>& headers,
+    const HttpValidators& validators,
+    std::function<void(FetchResult)> callback) {
+  auto request = std::make_shared<Request>();
+  request->url = url;
+  request->headers = headers;
+  request->validators = validators;
+  request->callback = std::move(callback);
+  runner_.Post([this, request = std::move(request)] { Attempt(request); });
 }
 
 std::optional<std::string> CurlNetworkFetcher::Post(
     const std::string& url,
     const std::vector<std::pair<std::string, std::string>>& form_data,
     const std::vector<std::string>& headers) {
-  auto operation = [this, &url, &form_data,
-                    &headers]() -> std::optional<std::string> {
-    try {
-      std::vector<std::string> processed_headers;
-      ProcessHeaders(headers, processed_headers);
+  auto request = std::make_shared<Request>();
+  request->url = url;
+  request->headers = headers;
+  request->form_data = form_data;
+  return Wait(std::move(request)).body;
+}
 
-      auto response = curl_client_->Post(url, form_data, headers);
-      last_response_code_.store(curl_client_->GetHttpCode());
+FetchResult CurlNetworkFetcher::Wait(std::shared_ptr<Request> request) {
+  if (runner_.RunsTasksOnCurrentThread()) {
+    // Waiting for a scheduled retry here would block the thread running it.
+    std::chrono::seconds retry_after{};
+    try {
+      return Perform(*request, retry_after);
+    } catch (const std::exception& e) {
+      spdlog::error("Network operation failed: {}", e.what());
+      return {};
+    }
+  }
 
-      if (const long response_code = last_response_code_.load();
-          response_code >= 200 && response_code < 300) {
-        // success
-        return response;
-      }
+  std::promise<FetchResult> promise;
+  auto future = promise.get_future();
+  request->callback = [&promise](FetchResult result) {
+    promise.set_value(std::move(result));
+  };
+  runner_.Post([this, request = std::move(request)] { Attempt(request); });
+  return future.get();
+}
 
-      return std::nullopt;
+void CurlNetworkFetcher::Attempt(const std::shared_ptr<Request>& request) {
+  FetchResult result;
+  std::chrono::seconds retry_after{};
+  bool retry = false;
+  if (!stopping_.load()) {
+    try {
+      result = Perform(*request, retry_after);
+      retry = IsTransient(result.status);
     } catch (const std::exception& e) {
       spdlog::error("Network operation failed: {}", e.what());
-      return std::nullopt;
+      retry = true;
     }
-  };
+  }
 
-  return PerformWithRetry(std::move(operation));
+  if (retry && request->retries < max_retries_) {
+    ++request->retries;
+    const auto delay = GetRetryDelay(
+        request->retries, retry_after,
+        std::uniform_real_distribution<double>(0.0, 1.0)(random_));
+    spdlog::debug("Retrying network operation (attempt {}) in {} ms",
+                  request->retries, delay.count());
+    runner_.PostDelayed(delay, [this, request] { Attempt(request); });
+    return;
+  }
+  request->callback(std::move(result));
+}
+
+FetchResult CurlNetworkFetcher::Perform(const Request& request,
+                                        std::chrono::seconds& retry_after) {
+  std::vector<std::string> processed_headers;
+  ProcessHeaders(request.headers, processed_headers);
+  if (!request.validators.etag.empty()) {
+    processed_headers.push_back("If-None-Match: " + request.validators.etag);
+  }
+  if (!request.validators.last_modified.empty()) {
+    processed_headers.push_back("If-Modified-Since: " +
+                                request.validators.last_modified);
+  }
+
+  auto response =
+      request.form_data
+          ? curl_client_->Post(request.url, *request.form_data,
+                               processed_headers)
+          : curl_client_->Get(request.url, processed_headers);
+
+  FetchResult result;
+  result.status = curl_client_->GetHttpCode();
+  last_response_code_.store(result.status);
+
+  const auto& response_headers = curl_client_->GetResponseInfo().headers;
+  retry_after = ParseRetryAfter(response_headers);
+  if ((result.status >= 200 && result.status < 300) || result.status == 304) {
+    result.validators.etag = GetHeader(response_headers, "etag");
+    result.validators.last_modified =
+        GetHeader(response_headers, "last-modified");
+  }
+  if (result.status >= 200 && result.status < 300) {
+    // success
+    result.body = std::move(response);
+  }
+  return result;
 }
 
 bool CurlNetworkFetcher::IsNetworkAvailable() {
-  try {
-    auto result = curl_client_->Get("https://www.google.com");
-    const long response_code = curl_client_->GetHttpCode();
-    last_response_code_.store(response_code);
+  const auto check = [this] {
+    try {
+      auto result = curl_client_->Get("https://www.google.com");
+      const long response_code = curl_client_->GetHttpCode();
+      last_response_code_.store(response_code);
 
-    return response_code > 0;
-  } catch (const std::exception& e) {
-    spdlog::error("Network operation failed: {}", e.what());
-    return false;
+      return response_code > 0;
+    } catch (const std::exception& e) {
+      spdlog::error("Network operation failed: {}", e.what());
+      return false;
+    }
+  };
+  if (runner_.RunsTasksOnCurrentThread()) {
+    return check();
   }
+
+  // The check shares the client with queued requests.
+  std::promise<bool> promise;
+  auto future = promise.get_future();
+  runner_.Post([&promise, &check] { promise.set_value(check()); });
+  return future.get();
 }
 
 long CurlNetworkFetcher::GetLastResponseCode() {
@@ -149,7 +245,8 @@ long CurlNetworkFetcher::GetLastResponseCode() {
 }
 
 void CurlNetworkFetcher::SetBearerToken(const std::string& token) {
-  curl_client_->SetBearerToken(token);
+  // Applies to requests queued after this call.
+  runner_.Post([this, token] { curl_client_->SetBearerToken(token); });
 }
 
 std::optional<flutter::EncodableList> CurlNetworkFetcher::FetchRemotes(
@@ -20,8 +20,10 @@
 
 #include <atomic>
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -30,12 +32,19 @@
 #include <flatpak/flatpak_plugin.h>
 #include "common/curl_client/curl_client.h"
 #include "flatpak/cache/interfaces/network_fetcher.h"
+#include "plugins/flatpak/delayed_task_runner.h"
 
 /**
  * @brief Curl-based network fetcher implementation
  *
  * Integrates with existing CurlClient to provide network operations
  * with proper error handling and retry logic.
+ *
+ * Requests run one at a time on a dedicated thread, which owns the
+ * CurlClient; its connections come from the process-wide CurlMultiClient
+ * pool. Failed attempts are rescheduled on that thread with a
+ * jittered exponential backoff instead of sleeping, so asynchronous callers
+ * are never blocked and synchronous ones only wait for their own request.
  */
 class CurlNetworkFetcher final : public INetworkFetcher {
  public:
@@ -52,6 +61,10 @@ class CurlNetworkFetcher final : public INetworkFetcher {
       std::chrono::seconds timeout = std::chrono::seconds(30),
       int max_retries = 3);
 
+  /**
+   * @brief Fails scheduled retries without sending them and waits for the
+   * request in progress.
+   */
   ~CurlNetworkFetcher() override;
 
   // INetworkFetcher implementation
@@ -59,6 +72,25 @@ class CurlNetworkFetcher final : public INetworkFetcher {
       const std::string& url,
       const std::vector<std::string>& headers) override;
 
+  /**
+   * @brief Sends If-None-Match and If-Modified-Since from |validators| and
+   * waits for the result. Called from a callback, which runs on the request
+   * thread, it makes a single attempt since it cannot wait for retries.
+   */
+  FetchResult FetchConditional(const std::string& url,
+                               const std::vector<std::string>& headers,
+                               const HttpValidators& validators) override;
+
+  /**
+   * @brief Queues a conditional request; |callback| runs on the request
+   * thread and should hand off any long work.
+   */
+  void FetchConditionalAsync(
+      const std::string& url,
+      const std::vector<std::string>& headers,
+      const HttpValidators& validators,
+      std::function<void(FetchResult)> callback) override;
+
   std::optional<std::string> Post(
       const std::string& url,
       const std::vector<std::pair<std::string, std::string>>& form_data,
@@ -73,24 +105,57 @@ class CurlNetworkFetcher final : public INetworkFetcher {
   std::optional<flutter::EncodableList> FetchRemotes(
       const std::string& installation_id) override;
 
+  /**
+   * @brief Computes the delay before a retry.
+   *
+   * The backoff doubles from one second per retry up to 30 seconds, and a
+   * random half of it is added on top of the other half ("equal jitter"), so
+   * clients that failed together do not retry together. A Retry-After from
+   * the server raises the delay, within the same cap.
+   * @param retry The number of the retry, starting at 1
+   * @param retry_after Delay asked for by the server; zero if none
+   * @param jitter A uniformly distributed number in [0, 1)
+   */
+  static std::chrono::milliseconds GetRetryDelay(
+      int retry,
+      std::chrono::seconds retry_after,
+      double jitter);
+
  private:
+  struct Request;
+
   std::unique_ptr<plugin_common_curl::CurlClient> curl_client_;
   std::atomic<long> last_response_code_{0};
   int max_retries_{3};
 
+  // Only used on the request thread.
+  std::mt19937 random_;
+  std::atomic<bool> stopping_{false};
+
+  // Declared last so queued requests finish before the members above go.
+  flatpak_plugin::DelayedTaskRunner runner_;
+
   /**
-   * @brief Performs a network operation with automatic retry logic
-   * @param operation The operation to be executed with retry logic. Should
-   * return a string on success or indicate failure through the retry mechanism
-   *
-   * @return std::optional<std::string> The result of the operation if
-   * successful, or std::nullopt if all retry attempts failed
+   * @brief Runs |request| and waits for its result, retrying transient
+   * failures as configured.
+   */
+  FetchResult Wait(std::shared_ptr<Request> request);
+
+  /**
+   * @brief Makes one attempt of |request| on the request thread and either
+   * schedules a retry or passes the result to its callback.
+   */
+  void Attempt(const std::shared_ptr<Request>& request);
+
+  /**
+   * @brief Sends |request| once through the CurlClient.
+   * @param retry_after Set to the Retry-After delay of the response, if any
    */
-  template <typename Operation>
-  std::optional<std::string> PerformWithRetry(Operation&& operation);
+  FetchResult Perform(const Request& request,
+                      std::chrono::seconds& retry_after);
 
   void ProcessHeaders(const std::vector<std::string>& headers,
                       std::vector<std::string>& non_auth_headers) const;
 };
 
-#endif  // PLUGINS_FLATPAK_CACHE_CURL_NETWORK_FETCHER_H
\ No newline at end of file
+#endif  // PLUGINS_FLATPAK_CACHE_CURL_NETWORK_FETCHER_H
@@ -32,8 +32,10 @@ void MetricsCacheObserver::OnCacheHit(const std::string& key,
   metrics_->cache_size_bytes += data_size;
   double hit_ratio = metrics_->GetHitRatio();
   spdlog::info(
-      "Cache hit for key: {}, size: {}. Total hits: {}, Hit ratio: {:.2f}%",
-      key, data_size, metrics_->hits.load(), hit_ratio);
+      "Cache hit for key: {}, size: {}. Total hits: {}, Hit ratio: {:.2f}% "
+      "(memory: {}, storage: {})",
+      key, data_size, metrics_->hits.load(), hit_ratio,
+      metrics_->memory_hits.load(), metrics_->storage_hits.load());
 }
 
 void MetricsCacheObserver::OnCacheMiss(const std::string& key) {
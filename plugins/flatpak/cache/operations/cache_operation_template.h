@@ -20,11 +20,13 @@
 
 #include <chrono>
 #include <exception>
+#include <memory>
 #include <optional>
 #include <string>
 #include "plugins/common/common.h"
 
 #include "flatpak/cache/interfaces/cache_storage.h"
+#include "flatpak/cache/metrics/latency_metrics.h"
 
 /**
  * @brief Template class for cache operations providing a framework for data
@@ -38,6 +40,10 @@
 template <typename T>
 class CacheOperationTemplate {
  protected:
+  // Larger serialization buffers are released after use instead of being
+  // kept for the next store on the same thread.
+  static constexpr size_t kMaxRetainedBufferSize = 16 * 1024 * 1024;
+
   /**
    * @brief Validates if the provided key is acceptable for cache operations.
    * @param key The string key to validate
@@ -62,6 +68,33 @@ class CacheOperationTemplate {
   virtual std::optional<T> DeserializeData(
       const std::string& serialized_data) = 0;
 
+  /**
+   * @brief Serializes the given data object into a caller-owned buffer.
+   *
+   * CacheData() reuses one buffer per thread, so overrides that append to it
+   * avoid reallocating for every store. The default copies the result of
+   * SerializeData().
+   * @param data The data object of type T to be serialized
+   * @param buffer Empty buffer, possibly with capacity left from earlier calls
+   * @return true if serialization succeeded
+   */
+  virtual bool SerializeInto(const T& data, std::string& buffer) {
+    buffer = SerializeData(data);
+    return true;
+  }
+
+  /**
+   * @brief Deserializes from a borrowed buffer, e.g. a blob still owned by
+   * the storage, which is only valid during the call. The default copies it
+   * for DeserializeData().
+   * @param data Start of the serialized data
+   * @param size Size of the serialized data in bytes
+   * @return std::optional<T> The deserialized object, or std::nullopt
+   */
+  virtual std::optional<T> DeserializeFrom(const char* data, size_t size) {
+    return DeserializeData(std::string(data, size));
+  }
+
   /**
    * @brief Gets the expiry time for the cache operation.
    * @return std::chrono::system_clock::time_point The expiry time of the cache
@@ -80,6 +113,13 @@ class CacheOperationTemplate {
  public:
   virtual ~CacheOperationTemplate() = default;
 
+  /**
+   * @brief Creates an independent copy of this operation, used when the
+   * operation has to outlive the caller, e.g. for a background refresh.
+   * @return A new operation bound to the same cache manager
+   */
+  virtual std::unique_ptr<CacheOperationTemplate> Clone() const = 0;
+
   /**
    * @brief Caches data with the specified key using the provided storage
    * interface
@@ -88,21 +128,47 @@ class CacheOperationTemplate {
    * @param data The data object to be stored in the cache
    * @param storage Pointer to the cache storage interface for persistence
    * operations
+   * @param serialized_size Optional output for the serialized size in bytes
+   * @param latency Optional histograms for serialization and storage write
+   * times
    *
    * @return true if the data was successfully cached, false if validation
    * failed or an exception occurred during the caching process
    */
   bool CacheData(const std::string& key,
                  const T& data,
-                 ICacheStorage* storage) {
+                 ICacheStorage* storage,
+                 size_t* serialized_size = nullptr,
+                 flatpak_plugin::LatencyMetrics* latency = nullptr) {
     if (!ValidateKey(key) || !ValidateData(data) || !storage) {
       return false;
     }
 
     try {
-      auto serialized = SerializeData(data);
+      // Reused per thread, so large lists are encoded without reallocating.
+      thread_local std::string serialized;
+      serialized.clear();
+      {
+        flatpak_plugin::ScopedLatency timer(
+            latency, key, flatpak_plugin::LatencyOperation::SERIALIZE);
+        if (!SerializeInto(data, serialized)) {
+          return false;
+        }
+      }
       auto expiry = GetExpiryTime();
-      return storage->Store(key, serialized, expiry);
+      if (serialized_size) {
+        *serialized_size = serialized.size();
+      }
+      bool stored;
+      {
+        flatpak_plugin::ScopedLatency timer(
+            latency, key, flatpak_plugin::LatencyOperation::STORAGE_WRITE);
+        stored = storage->Store(key, serialized, expiry);
+      }
+      if (serialized.capacity() > kMaxRetainedBufferSize) {
+        std::string().swap(serialized);
+      }
+      return stored;
     } catch (const std::exception& e) {
       spdlog::error("[CacheOperation] Failed to cache data: {}", e.what());
       return false;
@@ -115,22 +181,52 @@ class CacheOperationTemplate {
    * @tparam T The type of data to retrieve and deserialize
    * @param key The cache key used to identify the stored data
    * @param storage Pointer to the cache storage interface for data retrieval
+   * @param serialized_size Optional output for the serialized size in bytes
+   * @param include_expired If true, an expired entry that is still stored is
+   * returned as well
+   * @param latency Optional histograms for storage read and deserialization
+   * times
    * @return std::optional<T> The deserialized data if successful, std::nullopt
    * otherwise
    */
   std::optional<T> RetrieveData(const std::string& key,
-                                ICacheStorage* storage) {
+                                ICacheStorage* storage,
+                                size_t* serialized_size = nullptr,
+                                const bool include_expired = false,
+                                flatpak_plugin::LatencyMetrics* latency =
+                                    nullptr) {
     if (!ValidateKey(key) || !storage) {
       return std::nullopt;
     }
 
     try {
-      const auto serialized = storage->Retrieve(key);
-      if (!serialized.has_value()) {
-        return std::nullopt;
-      }
+      // Decodes straight from the storage's buffer; the read time excludes
+      // decoding, which happens inside the visitor.
+      const auto start = std::chrono::steady_clock::now();
+      bool read_recorded = false;
+      const auto record_read = [&] {
+        if (latency && !read_recorded) {
+          latency->Record(key, flatpak_plugin::LatencyOperation::STORAGE_READ,
+                          std::chrono::steady_clock::now() - start);
+        }
+        read_recorded = true;
+      };
 
-      return DeserializeData(serialized.value());
+      std::optional<T> result;
+      storage->RetrieveInPlace(
+          key,
+          [&](const char* serialized, const size_t size) {
+            record_read();
+            if (serialized_size) {
+              *serialized_size = size;
+            }
+            flatpak_plugin::ScopedLatency timer(
+                latency, key, flatpak_plugin::LatencyOperation::DESERIALIZE);
+            result = DeserializeFrom(serialized, size);
+          },
+          include_expired);
+      record_read();
+      return result;
     } catch (const std::exception& e) {
       spdlog::error("[CacheOperation] Failed to retrieve data: {}", e.what());
       return std::nullopt;
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_CACHE_ENCODABLE_BYTE_STREAMS_H
+#define PLUGINS_FLATPAK_CACHE_ENCODABLE_BYTE_STREAMS_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <flutter/byte_streams.h>
+
+namespace flatpak_plugin {
+
+/**
+ * @brief Appends standard codec output to a caller-owned string, so a buffer
+ * reused across calls keeps its capacity.
+ *
+ * Alignment is relative to the start of the buffer, as with the codec's own
+ * writer, so the output is byte-identical to StandardMessageCodec.
+ */
+class BufferStreamWriter final : public flutter::ByteStreamWriter {
+ public:
+  explicit BufferStreamWriter(std::string& buffer) : buffer_(buffer) {}
+
+  void WriteByte(const uint8_t byte) override {
+    buffer_.push_back(static_cast<char>(byte));
+  }
+
+  void WriteBytes(const uint8_t* bytes, const size_t length) override {
+    buffer_.append(reinterpret_cast<const char*>(bytes), length);
+  }
+
+  void WriteAlignment(const uint8_t alignment) override {
+    if (const size_t mod = buffer_.size() % alignment; mod != 0) {
+      buffer_.append(alignment - mod, '\0');
+    }
+  }
+
+ private:
+  std::string& buffer_;
+};
+
+/**
+ * @brief Reads standard codec input from a borrowed byte range, e.g. a blob
+ * still owned by SQLite, without copying it.
+ *
+ * Throws std::out_of_range when reading past the end, so a truncated entry
+ * fails to decode instead of yielding zeros.
+ */
+class BlobStreamReader final : public flutter::ByteStreamReader {
+ public:
+  BlobStreamReader(const char* data, const size_t size)
+      : data_(reinterpret_cast<const uint8_t*>(data)), size_(size) {}
+
+  uint8_t ReadByte() override {
+    Require(1);
+    return data_[position_++];
+  }
+
+  void ReadBytes(uint8_t* buffer, const size_t length) override {
+    Require(length);
+    std::memcpy(buffer, data_ + position_, length);
+    position_ += length;
+  }
+
+  void ReadAlignment(const uint8_t alignment) override {
+    if (const size_t mod = position_ % alignment; mod != 0) {
+      position_ += alignment - mod;
+    }
+  }
+
+ private:
+  void Require(const size_t length) const {
+    if (length > size_ || position_ > size_ - length) {
+      throw std::out_of_range("truncated standard codec data");
+    }
+  }
+
+  const uint8_t* data_;
+  size_t size_;
+  size_t position_ = 0;
+};
+
+/**
+ * @brief Writes the type byte and size prefix of a standard codec list, so
+ * its elements can be written one by one without first copying them into an
+ * EncodableValue.
+ */
+inline void WriteStandardCodecListHeader(const size_t size,
+                                         flutter::ByteStreamWriter* stream) {
+  // Type byte and variable-length size as in StandardCodecSerializer.
+  constexpr uint8_t kListType = 12;
+  stream->WriteByte(kListType);
+  if (size < 254) {
+    stream->WriteByte(static_cast<uint8_t>(size));
+  } else if (size <= 0xffff) {
+    stream->WriteByte(254);
+    const auto value = static_cast<uint16_t>(size);
+    stream->WriteBytes(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+  } else {
+    stream->WriteByte(255);
+    const auto value = static_cast<uint32_t>(size);
+    stream->WriteBytes(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+  }
+}
+
+}  // namespace flatpak_plugin
+
+#endif  // PLUGINS_FLATPAK_CACHE_ENCODABLE_BYTE_STREAMS_H
@@ -20,10 +20,15 @@
 
 #include <spdlog/spdlog.h>
 #include <chrono>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
 
 #include <flutter/encodable_value.h>
 
 #include "cache_operation_template.h"
+#include "encodable_byte_streams.h"
 #include "flatpak/cache/cache_manager.h"
 #include "flatpak/messages.g.h"
 
@@ -33,56 +38,74 @@ struct EncodableListCacheOperation
     : public CacheOperationTemplate<flutter::EncodableList> {
  public:
   CacheManager* manager;
-  explicit EncodableListCacheOperation(CacheManager* manager)
-      : manager(manager) {}
+  // Overrides the manager's default TTL when set.
+  std::optional<std::chrono::seconds> ttl;
+
+  explicit EncodableListCacheOperation(
+      CacheManager* manager,
+      const std::optional<std::chrono::seconds> ttl = std::nullopt)
+      : manager(manager), ttl(ttl) {}
+
+  std::unique_ptr<CacheOperationTemplate<flutter::EncodableList>> Clone()
+      const override {
+    return std::make_unique<EncodableListCacheOperation>(manager, ttl);
+  }
 
   bool ValidateKey(const std::string& key) override { return !key.empty(); }
 
   std::string SerializeData(const flutter::EncodableList& data) override {
+    std::string serialized;
+    if (!SerializeInto(data, serialized)) {
+      return "";
+    }
+    return serialized;
+  }
+
+  std::optional<flutter::EncodableList> DeserializeData(
+      const std::string& serialized_data) override {
+    return DeserializeFrom(serialized_data.data(), serialized_data.size());
+  }
+
+  // Writes the list header and then each element with the pigeon
+  // serializer, which yields the same bytes as encoding the list through
+  // FlatpakApi::GetCodec() without first copying it into an EncodableValue.
+  bool SerializeInto(const flutter::EncodableList& data,
+                     std::string& buffer) override {
     try {
-      const auto& codec = FlatpakApi::GetCodec();
-      flutter::EncodableList data_copy{data};
-      const flutter::EncodableValue encodable_data(std::move(data_copy));
-      const auto encoded = codec.EncodeMessage(encodable_data);
-      if (!encoded) {
-        spdlog::error("Failed to encode encodable list");
-        return "";
+      const auto& serializer = PigeonInternalCodecSerializer::GetInstance();
+      BufferStreamWriter stream(buffer);
+      WriteStandardCodecListHeader(data.size(), &stream);
+      for (const auto& value : data) {
+        serializer.WriteValue(value, &stream);
       }
-      return {encoded->begin(), encoded->end()};
+      return true;
     } catch (const std::exception& e) {
       spdlog::error("Failed to serialize encodable list: {}", e.what());
-      return "";
+      return false;
     } catch (...) {
       spdlog::error("Failed to serialize encodable list");
-      return "";
+      return false;
     }
   }
 
-  std::optional<flutter::EncodableList> DeserializeData(
-      const std::string& serialized_data) override {
-    if (serialized_data.empty()) {
+  // Decodes straight from the storage's buffer instead of first copying it
+  // into a std::vector for StandardMessageCodec::DecodeMessage().
+  std::optional<flutter::EncodableList> DeserializeFrom(
+      const char* data,
+      const size_t size) override {
+    if (size == 0) {
       return flutter::EncodableList{};
     }
     try {
-      if (serialized_data.empty()) {
-        spdlog::warn("Attempting to deserialize empty encodable list");
-        return flutter::EncodableList{};
-      }
-
-      const auto& codec = FlatpakApi::GetCodec();
-      std::vector<uint8_t> buffer(serialized_data.begin(),
-                                  serialized_data.end());
-      const auto decoded = codec.DecodeMessage(buffer);
-
-      if (!decoded) {
-        spdlog::error("Failed to decode message");
-        return std::nullopt;
-      }
-      if (!std::holds_alternative<flutter::EncodableList>(*decoded)) {
+      BlobStreamReader stream(data, size);
+      auto decoded =
+          PigeonInternalCodecSerializer::GetInstance().ReadValue(&stream);
+      auto* list = std::get_if<flutter::EncodableList>(&decoded);
+      if (!list) {
         spdlog::error("Decoded message is not EncodableList");
         return std::nullopt;
       }
-      return std::get<flutter::EncodableList>(*decoded);
+      return std::move(*list);
     } catch (const std::exception& e) {
       spdlog::error("Failed to deserialize message: {}", e.what());
       return std::nullopt;
@@ -93,7 +116,8 @@ struct EncodableListCacheOperation
   }
 
   std::chrono::system_clock::time_point GetExpiryTime() override {
-    return std::chrono::system_clock::now() + manager->config_.default_ttl;
+    return std::chrono::system_clock::now() +
+           ttl.value_or(manager->config_.default_ttl);
   }
 
   bool ValidateData(const flutter::EncodableList& /* data */) override {
@@ -45,6 +45,11 @@ struct ApplicationCacheOperation : CacheOperationTemplate<Application> {
       : manager(manager),
         operation(std::make_unique<EncodableListCacheOperation>(manager)) {}
 
+  std::unique_ptr<CacheOperationTemplate<Application>> Clone()
+      const override {
+    return std::make_unique<ApplicationCacheOperation>(manager);
+  }
+
  protected:
   bool ValidateKey(const std::string& key) override { return !key.empty(); }
 
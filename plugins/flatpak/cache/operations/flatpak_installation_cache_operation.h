@@ -19,6 +19,7 @@
 #define PLUGINS_FLATPAK_CACHE_INSTALLATION_CACHE_OPERATION_H
 
 #include <chrono>
+#include <optional>
 
 #include "cache_operation_template.h"
 #include "encodablelist_cache_operation.h"
@@ -38,10 +39,20 @@ namespace flatpak_plugin {
 struct InstallationCacheOperation final : CacheOperationTemplate<Installation> {
   CacheManager* manager;
   std::unique_ptr<EncodableListCacheOperation> operation;
+  // Overrides the manager's default TTL when set.
+  std::optional<std::chrono::seconds> ttl;
 
-  explicit InstallationCacheOperation(CacheManager* manager)
+  explicit InstallationCacheOperation(
+      CacheManager* manager,
+      const std::optional<std::chrono::seconds> ttl = std::nullopt)
       : manager(manager),
-        operation(std::make_unique<EncodableListCacheOperation>(manager)) {}
+        operation(std::make_unique<EncodableListCacheOperation>(manager)),
+        ttl(ttl) {}
+
+  std::unique_ptr<CacheOperationTemplate<Installation>> Clone()
+      const override {
+    return std::make_unique<InstallationCacheOperation>(manager, ttl);
+  }
 
  protected:
   bool ValidateKey(const std::string& key) override { return !key.empty(); }
@@ -77,7 +88,8 @@ struct InstallationCacheOperation final : CacheOperationTemplate<Installation> {
   }
 
   std::chrono::system_clock::time_point GetExpiryTime() override {
-    return std::chrono::system_clock::now() + manager->config_.default_ttl;
+    return std::chrono::system_clock::now() +
+           ttl.value_or(manager->config_.default_ttl);
   }
 
   bool ValidateData(const Installation& data) override {
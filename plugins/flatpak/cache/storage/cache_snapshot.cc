@@ -0,0 +1,317 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cache_snapshot.h"
+
+#include <cstring>
+#include <type_traits>
+
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+
+#include "compression_codecs.h"
+
+namespace {
+
+// Bump the version whenever a record layout changes.
+constexpr char kMagic[8] = {'F', 'P', 'C', 'A', 'C', 'H', 'E', '\0'};
+constexpr uint32_t kFormatVersion = 2;
+// Entries gained validators in version 2.
+constexpr uint32_t kMinFormatVersion = 1;
+
+constexpr uint8_t kEntryTag = 1;
+constexpr uint8_t kTrailerTag = 0;
+
+// Upper bounds that keep a corrupt size field from triggering a huge
+// allocation before its checksum can be verified.
+constexpr uint32_t kMaxKeySize = 4 * 1024;
+constexpr uint32_t kMaxValidatorsSize = 16 * 1024;
+constexpr uint64_t kMaxDataSize = 256 * 1024 * 1024;
+
+int64_t ToSeconds(const std::chrono::system_clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             time.time_since_epoch())
+      .count();
+}
+
+std::chrono::system_clock::time_point FromSeconds(const int64_t seconds) {
+  return std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
+}
+
+uint32_t Crc32(const std::string& data) {
+  return static_cast<uint32_t>(
+      crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(data.data()),
+            static_cast<uInt>(data.size())));
+}
+
+template <typename T>
+void Put(std::string& buffer, const T value) {
+  static_assert(std::is_unsigned_v<T>);
+  for (size_t i = 0; i < sizeof(T); i++) {
+    buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+void PutBytes(std::string& buffer, const std::string& bytes) {
+  buffer.append(bytes);
+}
+
+/**
+ * @brief Reads little-endian fields and keeps the bytes of the current
+ * record for its checksum.
+ */
+class RecordReader {
+ public:
+  explicit RecordReader(std::istream& in) : in_(in) {}
+
+  template <typename T>
+  bool Get(T& value) {
+    static_assert(std::is_unsigned_v<T>);
+    char bytes[sizeof(T)];
+    if (!in_.read(bytes, sizeof(T))) {
+      return false;
+    }
+    record_.append(bytes, sizeof(T));
+    value = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+      value |= static_cast<T>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+    }
+    return true;
+  }
+
+  bool GetBytes(std::string& bytes, const size_t size) {
+    bytes.resize(size);
+    if (size > 0 &&
+        !in_.read(bytes.data(), static_cast<std::streamsize>(size))) {
+      return false;
+    }
+    record_.append(bytes);
+    return true;
+  }
+
+  /**
+   * @brief Reads the stored checksum and compares it with the record.
+   */
+  bool VerifyChecksum() {
+    const uint32_t expected = Crc32(record_);
+    char bytes[sizeof(uint32_t)];
+    if (!in_.read(bytes, sizeof(bytes))) {
+      return false;
+    }
+    uint32_t stored = 0;
+    for (size_t i = 0; i < sizeof(uint32_t); i++) {
+      stored |= static_cast<uint32_t>(static_cast<uint8_t>(bytes[i]))
+                << (8 * i);
+    }
+    return stored == expected;
+  }
+
+ private:
+  std::istream& in_;
+  std::string record_;
+};
+
+}  // namespace
+
+CacheSnapshotWriter::CacheSnapshotWriter(
+    std::ostream& out,
+    const CompressionType compression,
+    const int level,
+    const std::chrono::system_clock::time_point exported_at)
+    : out_(out), codec_(CreateCompressionCodec(compression, level)) {
+  if (!codec_ && compression != CompressionType::NONE) {
+    codec_ = CreateCompressionCodec(CompressionType::ZLIB, level);
+  }
+
+  std::string header(kMagic, sizeof(kMagic));
+  Put(header, kFormatVersion);
+  Put(header, static_cast<uint64_t>(ToSeconds(exported_at)));
+  out_.write(header.data(), static_cast<std::streamsize>(header.size()));
+}
+
+CacheSnapshotWriter::~CacheSnapshotWriter() = default;
+
+bool CacheSnapshotWriter::Add(const CacheWrite& entry) {
+  if (finished_ || !out_ || entry.key.size() > kMaxKeySize ||
+      entry.validators.size() > kMaxValidatorsSize ||
+      entry.data.size() > kMaxDataSize) {
+    return false;
+  }
+
+  auto type = CompressionType::NONE;
+  std::optional<std::string> compressed;
+  if (codec_) {
+    compressed = codec_->Compress(entry.data);
+    if (compressed && compressed->size() < entry.data.size()) {
+      type = codec_->GetType();
+    }
+  }
+  const std::string& blob =
+      type == CompressionType::NONE ? entry.data : *compressed;
+
+  std::string record;
+  record.reserve(blob.size() + entry.key.size() + entry.validators.size() +
+                 36);
+  Put(record, kEntryTag);
+  Put(record, static_cast<uint32_t>(entry.key.size()));
+  PutBytes(record, entry.key);
+  Put(record, static_cast<uint64_t>(ToSeconds(entry.expiry)));
+  Put(record, static_cast<uint32_t>(entry.validators.size()));
+  PutBytes(record, entry.validators);
+  Put(record, static_cast<uint8_t>(type));
+  Put(record, static_cast<uint64_t>(entry.data.size()));
+  Put(record, static_cast<uint32_t>(blob.size()));
+  PutBytes(record, blob);
+  Put(record, Crc32(record));
+
+  if (!out_.write(record.data(),
+                  static_cast<std::streamsize>(record.size()))) {
+    return false;
+  }
+  entry_count_++;
+  return true;
+}
+
+bool CacheSnapshotWriter::Finish() {
+  if (finished_) {
+    return false;
+  }
+  finished_ = true;
+
+  std::string trailer;
+  Put(trailer, kTrailerTag);
+  Put(trailer, entry_count_);
+  Put(trailer, Crc32(trailer));
+  out_.write(trailer.data(), static_cast<std::streamsize>(trailer.size()));
+  out_.flush();
+  return static_cast<bool>(out_);
+}
+
+CacheSnapshotReader::CacheSnapshotReader(std::istream& in) : in_(in) {
+  char magic[sizeof(kMagic)];
+  if (!in_.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+    spdlog::error("[CacheSnapshot] Not a cache snapshot");
+    return;
+  }
+
+  RecordReader reader(in_);
+  uint32_t version = 0;
+  uint64_t exported_at = 0;
+  if (!reader.Get(version) || !reader.Get(exported_at)) {
+    spdlog::error("[CacheSnapshot] Truncated header");
+    return;
+  }
+  if (version < kMinFormatVersion || version > kFormatVersion) {
+    spdlog::error("[CacheSnapshot] Unsupported snapshot version {}", version);
+    return;
+  }
+  version_ = version;
+  exported_at_ = FromSeconds(static_cast<int64_t>(exported_at));
+  valid_ = true;
+}
+
+CacheSnapshotReader::~CacheSnapshotReader() = default;
+
+ICompressionCodec* CacheSnapshotReader::GetCodec(const CompressionType type) {
+  if (type != CompressionType::ZLIB && type != CompressionType::ZSTD) {
+    return nullptr;
+  }
+  auto& codec = type == CompressionType::ZSTD ? zstd_ : zlib_;
+  if (!codec) {
+    codec = CreateCompressionCodec(type, 0);
+  }
+  return codec.get();
+}
+
+std::optional<CacheWrite> CacheSnapshotReader::Next() {
+  if (!valid_ || complete_) {
+    return std::nullopt;
+  }
+  // Any failure below leaves the snapshot unusable.
+  valid_ = false;
+
+  RecordReader reader(in_);
+  uint8_t tag = 0;
+  if (!reader.Get(tag)) {
+    spdlog::error("[CacheSnapshot] Missing trailer");
+    return std::nullopt;
+  }
+
+  if (tag == kTrailerTag) {
+    uint64_t count = 0;
+    if (!reader.Get(count) || !reader.VerifyChecksum()) {
+      spdlog::error("[CacheSnapshot] Corrupt trailer");
+    } else if (count != entry_count_) {
+      spdlog::error("[CacheSnapshot] Expected {} entries, read {}", count,
+                    entry_count_);
+    } else {
+      valid_ = true;
+      complete_ = true;
+    }
+    return std::nullopt;
+  }
+  if (tag != kEntryTag) {
+    spdlog::error("[CacheSnapshot] Unknown record tag {}", tag);
+    return std::nullopt;
+  }
+
+  uint32_t key_size = 0;
+  CacheWrite entry;
+  uint64_t expiry = 0;
+  uint32_t validators_size = 0;
+  uint8_t type = 0;
+  uint64_t data_size = 0;
+  uint32_t blob_size = 0;
+  std::string blob;
+  if (!reader.Get(key_size) || key_size > kMaxKeySize ||
+      !reader.GetBytes(entry.key, key_size) || !reader.Get(expiry) ||
+      (version_ >= 2 &&
+       (!reader.Get(validators_size) ||
+        validators_size > kMaxValidatorsSize ||
+        !reader.GetBytes(entry.validators, validators_size))) ||
+      !reader.Get(type) || !reader.Get(data_size) ||
+      data_size > kMaxDataSize || !reader.Get(blob_size) ||
+      blob_size > kMaxDataSize || !reader.GetBytes(blob, blob_size) ||
+      !reader.VerifyChecksum()) {
+    spdlog::error("[CacheSnapshot] Corrupt entry after {} entries",
+                  entry_count_);
+    return std::nullopt;
+  }
+
+  entry.expiry = FromSeconds(static_cast<int64_t>(expiry));
+  if (const auto compression = static_cast<CompressionType>(type);
+      compression == CompressionType::NONE) {
+    entry.data = std::move(blob);
+  } else {
+    ICompressionCodec* codec = GetCodec(compression);
+    auto data = codec ? codec->Decompress(blob, data_size) : std::nullopt;
+    if (!data) {
+      spdlog::error("[CacheSnapshot] Failed to decompress entry {}",
+                    entry.key);
+      return std::nullopt;
+    }
+    entry.data = std::move(*data);
+  }
+  if (entry.data.size() != data_size) {
+    spdlog::error("[CacheSnapshot] Size mismatch for entry {}", entry.key);
+    return std::nullopt;
+  }
+
+  entry_count_++;
+  valid_ = true;
+  return entry;
+}
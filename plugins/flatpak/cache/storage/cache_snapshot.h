@@ -0,0 +1,147 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_CACHE_CACHE_SNAPSHOT_H
+#define PLUGINS_FLATPAK_CACHE_CACHE_SNAPSHOT_H
+
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+
+#include "flatpak/cache/interfaces/cache_storage.h"
+#include "flatpak/cache/interfaces/compression_codec.h"
+
+/**
+ * @brief Writes a cache snapshot to a stream one entry at a time.
+ *
+ * A snapshot is a header followed by one record per entry and a trailer.
+ * All integers are little-endian so snapshots built on another host can be
+ * restored on the target:
+ *
+ *   header:  "FPCACHE\0", u32 version, i64 export time (unix seconds)
+ *   entry:   u8 tag, u32 key size, key, i64 expiry (unix seconds),
+ *            u32 validators size, validators, u8 compression type,
+ *            u64 data size, u32 blob size, blob, u32 CRC-32 of the record
+ *   trailer: u8 tag, u64 entry count, u32 CRC-32 of the trailer
+ *
+ * Blobs that do not shrink when compressed are stored as is. Version 1
+ * snapshots, whose entries have no validators, are still read.
+ */
+class CacheSnapshotWriter {
+ public:
+  /**
+   * @brief Creates a writer and writes the snapshot header.
+   * @param out Destination stream, opened in binary mode
+   * @param compression Codec for entry blobs; NONE stores them as is
+   * @param level Codec specific compression level
+   * @param exported_at Time the entry expiries are relative to
+   */
+  CacheSnapshotWriter(std::ostream& out,
+                      CompressionType compression,
+                      int level,
+                      std::chrono::system_clock::time_point exported_at);
+
+  ~CacheSnapshotWriter();
+
+  CacheSnapshotWriter(const CacheSnapshotWriter&) = delete;
+  CacheSnapshotWriter& operator=(const CacheSnapshotWriter&) = delete;
+
+  /**
+   * @brief Appends one entry.
+   * @param entry The entry with its uncompressed data
+   * @return true if the record was written
+   */
+  bool Add(const CacheWrite& entry);
+
+  /**
+   * @brief Writes the trailer and flushes the stream. No entries may be
+   * added afterwards.
+   * @return true if the whole snapshot was written
+   */
+  bool Finish();
+
+  /**
+   * @brief Gets the number of entries added so far.
+   */
+  [[nodiscard]] uint64_t GetEntryCount() const { return entry_count_; }
+
+ private:
+  std::ostream& out_;
+  std::unique_ptr<ICompressionCodec> codec_;
+  uint64_t entry_count_ = 0;
+  bool finished_ = false;
+};
+
+/**
+ * @brief Reads a snapshot written by CacheSnapshotWriter one entry at a
+ * time, verifying the checksum of every record.
+ */
+class CacheSnapshotReader {
+ public:
+  /**
+   * @brief Creates a reader and reads the snapshot header.
+   * @param in Source stream, opened in binary mode
+   */
+  explicit CacheSnapshotReader(std::istream& in);
+
+  ~CacheSnapshotReader();
+
+  CacheSnapshotReader(const CacheSnapshotReader&) = delete;
+  CacheSnapshotReader& operator=(const CacheSnapshotReader&) = delete;
+
+  /**
+   * @brief Whether the header was read and no record has failed so far.
+   */
+  [[nodiscard]] bool IsValid() const { return valid_; }
+
+  /**
+   * @brief Gets the time the snapshot was exported at.
+   */
+  [[nodiscard]] std::chrono::system_clock::time_point GetExportTime() const {
+    return exported_at_;
+  }
+
+  /**
+   * @brief Reads the next entry with its data decompressed and its expiry
+   * and validators as stored in the snapshot.
+   * @return The entry, or std::nullopt at the end of the snapshot or on
+   * error; IsComplete() tells the two apart
+   */
+  std::optional<CacheWrite> Next();
+
+  /**
+   * @brief Whether the trailer was reached and matched the entry count.
+   */
+  [[nodiscard]] bool IsComplete() const { return complete_; }
+
+ private:
+  std::istream& in_;
+  std::chrono::system_clock::time_point exported_at_;
+  std::unique_ptr<ICompressionCodec> zlib_;
+  std::unique_ptr<ICompressionCodec> zstd_;
+  uint32_t version_ = 0;
+  uint64_t entry_count_ = 0;
+  bool valid_ = false;
+  bool complete_ = false;
+
+  ICompressionCodec* GetCodec(CompressionType type);
+};
+
+#endif  // PLUGINS_FLATPAK_CACHE_CACHE_SNAPSHOT_H
@@ -0,0 +1,230 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compression_codecs.h"
+
+#include <zlib.h>
+#include <algorithm>
+
+#if defined(ENABLE_ZSTD)
+#include <zdict.h>
+#include <zstd.h>
+#endif
+
+#include "plugins/common/common.h"
+
+namespace {
+
+class ZlibCodec final : public ICompressionCodec {
+ public:
+  explicit ZlibCodec(const int level)
+      : level_(std::clamp(level, Z_BEST_SPEED, Z_BEST_COMPRESSION)) {}
+
+  [[nodiscard]] CompressionType GetType() const override {
+    return CompressionType::ZLIB;
+  }
+
+  std::optional<std::string> Compress(const std::string& data) override {
+    uLongf compressed_size = compressBound(data.size());
+    std::string compressed(compressed_size, '\0');
+
+    if (const int rc = compress2(reinterpret_cast<Bytef*>(compressed.data()),
+                                 &compressed_size,
+                                 reinterpret_cast<const Bytef*>(data.data()),
+                                 data.size(), level_);
+        rc != Z_OK) {
+      spdlog::error("[CompressionCodec] zlib compression failed: {}", rc);
+      return std::nullopt;
+    }
+    compressed.resize(compressed_size);
+    return compressed;
+  }
+
+  std::optional<std::string> Decompress(const char* data,
+                                        const size_t size,
+                                        const size_t original_size) override {
+    std::string decompressed(original_size, '\0');
+    uLongf decompressed_size = original_size;
+
+    if (const int rc = uncompress(
+            reinterpret_cast<Bytef*>(decompressed.data()), &decompressed_size,
+            reinterpret_cast<const Bytef*>(data), size);
+        rc != Z_OK || decompressed_size != original_size) {
+      spdlog::error(
+          "[CompressionCodec] zlib decompression failed: {} ({} of {} bytes)",
+          rc, decompressed_size, original_size);
+      return std::nullopt;
+    }
+    return decompressed;
+  }
+
+ private:
+  const int level_;
+};
+
+#if defined(ENABLE_ZSTD)
+class ZstdCodec final : public ICompressionCodec {
+ public:
+  explicit ZstdCodec(const int level)
+      : level_(std::clamp(level, 1, ZSTD_maxCLevel())),
+        cctx_(ZSTD_createCCtx()),
+        dctx_(ZSTD_createDCtx()) {}
+
+  ~ZstdCodec() override {
+    ZSTD_freeCDict(cdict_);
+    ZSTD_freeDDict(ddict_);
+    ZSTD_freeCCtx(cctx_);
+    ZSTD_freeDCtx(dctx_);
+  }
+
+  ZstdCodec(const ZstdCodec&) = delete;
+  ZstdCodec& operator=(const ZstdCodec&) = delete;
+
+  [[nodiscard]] CompressionType GetType() const override {
+    return CompressionType::ZSTD;
+  }
+
+  std::optional<std::string> Compress(const std::string& data) override {
+    std::string compressed(ZSTD_compressBound(data.size()), '\0');
+
+    const size_t compressed_size =
+        cdict_ ? ZSTD_compress_usingCDict(cctx_, compressed.data(),
+                                          compressed.size(), data.data(),
+                                          data.size(), cdict_)
+               : ZSTD_compressCCtx(cctx_, compressed.data(), compressed.size(),
+                                   data.data(), data.size(), level_);
+    if (ZSTD_isError(compressed_size)) {
+      spdlog::error("[CompressionCodec] zstd compression failed: {}",
+                    ZSTD_getErrorName(compressed_size));
+      return std::nullopt;
+    }
+    compressed.resize(compressed_size);
+    return compressed;
+  }
+
+  std::optional<std::string> Decompress(const char* data,
+                                        const size_t size,
+                                        const size_t original_size) override {
+    // Entries written before a dictionary was trained carry no dictionary ID
+    // and decode without one. Storage re-encodes entries when it replaces
+    // the dictionary, so any other ID is unknown.
+    const unsigned frame_dict_id =
+        ZSTD_getDictID_fromFrame(data, size);
+    if (frame_dict_id != 0 && (!ddict_ || frame_dict_id != dict_id_)) {
+      spdlog::error("[CompressionCodec] zstd entry uses unknown dictionary {}",
+                    frame_dict_id);
+      return std::nullopt;
+    }
+
+    std::string decompressed(original_size, '\0');
+    const size_t decompressed_size =
+        frame_dict_id != 0
+            ? ZSTD_decompress_usingDDict(dctx_, decompressed.data(),
+                                         decompressed.size(), data, size,
+                                         ddict_)
+            : ZSTD_decompressDCtx(dctx_, decompressed.data(),
+                                  decompressed.size(), data, size);
+    if (ZSTD_isError(decompressed_size) ||
+        decompressed_size != original_size) {
+      spdlog::error("[CompressionCodec] zstd decompression failed: {}",
+                    ZSTD_isError(decompressed_size)
+                        ? ZSTD_getErrorName(decompressed_size)
+                        : "size mismatch");
+      return std::nullopt;
+    }
+    return decompressed;
+  }
+
+  [[nodiscard]] bool SupportsDictionary() const override { return true; }
+
+  bool SetDictionary(const std::string& dictionary) override {
+    ZSTD_CDict* cdict =
+        ZSTD_createCDict(dictionary.data(), dictionary.size(), level_);
+    ZSTD_DDict* ddict = ZSTD_createDDict(dictionary.data(), dictionary.size());
+    if (!cdict || !ddict) {
+      ZSTD_freeCDict(cdict);
+      ZSTD_freeDDict(ddict);
+      spdlog::error("[CompressionCodec] Failed to load zstd dictionary");
+      return false;
+    }
+
+    ZSTD_freeCDict(cdict_);
+    ZSTD_freeDDict(ddict_);
+    cdict_ = cdict;
+    ddict_ = ddict;
+    dict_id_ = ZSTD_getDictID_fromDDict(ddict_);
+    return true;
+  }
+
+ private:
+  const int level_;
+  ZSTD_CCtx* cctx_;
+  ZSTD_DCtx* dctx_;
+  ZSTD_CDict* cdict_ = nullptr;
+  ZSTD_DDict* ddict_ = nullptr;
+  unsigned dict_id_ = 0;
+};
+#endif
+
+}  // namespace
+
+std::unique_ptr<ICompressionCodec> CreateCompressionCodec(
+    const CompressionType type,
+    const int level) {
+  switch (type) {
+    case CompressionType::NONE:
+      return nullptr;
+    case CompressionType::ZLIB:
+      return std::make_unique<ZlibCodec>(level);
+    case CompressionType::ZSTD:
+#if defined(ENABLE_ZSTD)
+      return std::make_unique<ZstdCodec>(level);
+#else
+      return nullptr;
+#endif
+  }
+  return nullptr;
+}
+
+std::optional<std::string> TrainCompressionDictionary(
+    const std::vector<std::string>& samples,
+    const size_t max_size) {
+#if defined(ENABLE_ZSTD)
+  std::string sample_buffer;
+  std::vector<size_t> sample_sizes;
+  sample_sizes.reserve(samples.size());
+  for (const auto& sample : samples) {
+    sample_buffer += sample;
+    sample_sizes.push_back(sample.size());
+  }
+
+  std::string dictionary(max_size, '\0');
+  const size_t dictionary_size = ZDICT_trainFromBuffer(
+      dictionary.data(), dictionary.size(), sample_buffer.data(),
+      sample_sizes.data(), static_cast<unsigned>(sample_sizes.size()));
+  if (ZDICT_isError(dictionary_size)) {
+    spdlog::warn("[CompressionCodec] Dictionary training failed: {}",
+                 ZDICT_getErrorName(dictionary_size));
+    return std::nullopt;
+  }
+  dictionary.resize(dictionary_size);
+  return dictionary;
+#else
+  (void)samples;
+  (void)max_size;
+  return std::nullopt;
+#endif
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_CACHE_COMPRESSION_CODECS_H
+#define PLUGINS_FLATPAK_CACHE_COMPRESSION_CODECS_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "flatpak/cache/interfaces/compression_codec.h"
+
+/**
+ * @brief Creates a codec.
+ * @param type The codec to create
+ * @param level Codec specific level; clamped to the codec's range
+ * @return The codec, or nullptr if |type| is NONE or not compiled in (zstd
+ * requires ENABLE_ZSTD)
+ */
+std::unique_ptr<ICompressionCodec> CreateCompressionCodec(CompressionType type,
+                                                          int level);
+
+/**
+ * @brief Trains a dictionary from sample entries.
+ *
+ * Works best with many small, similar samples such as serialized application
+ * lists. Only available for zstd.
+ * @param samples Uncompressed sample entries
+ * @param max_size Maximum dictionary size in bytes
+ * @return The dictionary, or std::nullopt if training is unsupported or
+ * failed (e.g. too few samples)
+ */
+std::optional<std::string> TrainCompressionDictionary(
+    const std::vector<std::string>& samples,
+    size_t max_size);
+
+#endif  // PLUGINS_FLATPAK_CACHE_COMPRESSION_CODECS_H
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_CACHE_MEMORY_CACHE_H
+#define PLUGINS_FLATPAK_CACHE_MEMORY_CACHE_H
+
+#include <any>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @brief In-process LRU of already decoded cache values.
+ *
+ * Sits in front of an ICacheStorage so repeated reads skip both the storage
+ * backend and deserialization. Entries are bounded by an approximate byte
+ * size (the serialized size of the value) and expire independently of the
+ * backing store. Values of any copyable type are held; a lookup with a
+ * different type than was stored is treated as a miss.
+ */
+class MemoryCache {
+ public:
+  using Clock = std::chrono::system_clock;
+
+  explicit MemoryCache(const size_t max_bytes) : max_bytes_(max_bytes) {}
+
+  /**
+   * @brief Looks up a live entry and marks it most recently used.
+   * @param key The cache key
+   * @return A copy of the value, or std::nullopt on miss or expiry
+   */
+  template <typename T>
+  std::optional<T> Get(const std::string& key,
+                       const Clock::time_point now = Clock::now()) {
+    std::lock_guard lock(mutex_);
+    const auto it = index_.find(key);
+    if (it == index_.end()) {
+      return std::nullopt;
+    }
+    if (now >= it->second->expiry) {
+      EraseLocked(it);
+      return std::nullopt;
+    }
+    const auto* value = std::any_cast<T>(&it->second->value);
+    if (!value) {
+      return std::nullopt;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return *value;
+  }
+
+  /**
+   * @brief Inserts or replaces an entry, evicting least recently used entries
+   * until the cache fits within its byte budget.
+   * @param key The cache key
+   * @param value The decoded value
+   * @param size_bytes Approximate size of the value
+   * @param expiry When the entry stops being served
+   */
+  template <typename T>
+  void Put(const std::string& key,
+           T value,
+           const size_t size_bytes,
+           const Clock::time_point expiry) {
+    std::lock_guard lock(mutex_);
+    if (const auto it = index_.find(key); it != index_.end()) {
+      EraseLocked(it);
+    }
+    if (size_bytes > max_bytes_) {
+      return;
+    }
+    entries_.push_front({key, std::move(value), size_bytes, expiry});
+    index_[key] = entries_.begin();
+    size_bytes_ += size_bytes;
+    while (size_bytes_ > max_bytes_ && !entries_.empty()) {
+      EraseLocked(index_.find(entries_.back().key));
+    }
+  }
+
+  /**
+   * @brief Drops an entry.
+   * @param key The cache key; an empty key drops every entry
+   */
+  void Invalidate(const std::string& key) {
+    std::lock_guard lock(mutex_);
+    if (key.empty()) {
+      entries_.clear();
+      index_.clear();
+      size_bytes_ = 0;
+    } else if (const auto it = index_.find(key); it != index_.end()) {
+      EraseLocked(it);
+    }
+  }
+
+  /**
+   * @brief Drops all expired entries.
+   * @return The number of entries removed
+   */
+  size_t CleanupExpired(const Clock::time_point now = Clock::now()) {
+    std::lock_guard lock(mutex_);
+    size_t removed = 0;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (now >= it->expiry) {
+        size_bytes_ -= it->size_bytes;
+        index_.erase(it->key);
+        it = entries_.erase(it);
+        removed++;
+      } else {
+        ++it;
+      }
+    }
+    return removed;
+  }
+
+  size_t GetSizeBytes() const {
+    std::lock_guard lock(mutex_);
+    return size_bytes_;
+  }
+
+  size_t GetEntryCount() const {
+    std::lock_guard lock(mutex_);
+    return entries_.size();
+  }
+
+ private:
+  struct Entry {
+    std::string key;
+    std::any value;
+    size_t size_bytes;
+    Clock::time_point expiry;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  void EraseLocked(
+      const std::unordered_map<std::string, EntryList::iterator>::iterator it) {
+    size_bytes_ -= it->second->size_bytes;
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+
+  const size_t max_bytes_;
+  mutable std::mutex mutex_;
+  EntryList entries_;
+  std::unordered_map<std::string, EntryList::iterator> index_;
+  size_t size_bytes_ = 0;
+};
+
+#endif  // PLUGINS_FLATPAK_CACHE_MEMORY_CACHE_H
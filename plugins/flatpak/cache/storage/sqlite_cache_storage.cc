@@ -15,19 +15,139 @@
  * limitations under the License.
  */
 
-#include <zlib.h>
 #include <cstddef>
+#include <string_view>
 
+#include "compression_codecs.h"
 #include "sqlite_cache_storage.h"
 
-SQLiteCacheStorage::SQLiteCacheStorage(std::string db_path,
-                                       const bool enable_compression)
+namespace {
+
+constexpr std::array<const char*, 22> kStatementSql = {
+    // kInsert
+    R"(
+        INSERT OR REPLACE INTO cache_entries
+        (key, data, expiry_time, created_time, data_size, is_compressed,
+         validators)
+        VALUES (?, ?, ?, ?, ?, ?, ?);
+    )",
+    // kSelect
+    "SELECT data, expiry_time, is_compressed, data_size FROM cache_entries "
+    "WHERE key = ?;",
+    // kSelectExpiry
+    "SELECT expiry_time FROM cache_entries WHERE key = ?;",
+    // kSelectSize
+    "SELECT data_size FROM cache_entries WHERE key = ?;",
+    // kDelete
+    "DELETE FROM cache_entries WHERE key = ?;",
+    // kDeleteAll
+    "DELETE FROM cache_entries;",
+    // kSelectExpiredSize
+    "SELECT COALESCE(SUM(data_size), 0) FROM cache_entries "
+    "WHERE expiry_time <= ?;",
+    // kDeleteExpired
+    "DELETE FROM cache_entries WHERE expiry_time <= ?;",
+    // kStatistics
+    R"(
+        SELECT
+            COUNT(*) as entry_count,
+            SUM(data_size) as total_size,
+            AVG(data_size) as avg_size,
+            SUM(CASE WHEN is_compressed <> 0 THEN 1 ELSE 0 END) as compressed_count
+        FROM cache_entries;
+    )",
+    // kCountExpired
+    "SELECT COUNT(*) FROM cache_entries WHERE expiry_time <= ?;",
+    // kBegin
+    "BEGIN IMMEDIATE;",
+    // kCommit
+    "COMMIT;",
+    // kRollback
+    "ROLLBACK;",
+    // kSelectMetadata
+    "SELECT value FROM cache_metadata WHERE name = ?;",
+    // kInsertMetadata
+    "INSERT OR REPLACE INTO cache_metadata (name, value) VALUES (?, ?);",
+    // kSelectSamples
+    "SELECT data, is_compressed, data_size FROM cache_entries "
+    "ORDER BY created_time DESC LIMIT ?;",
+    // kBeginRead
+    "BEGIN DEFERRED;",
+    // kSelectAll
+    "SELECT key, data, expiry_time, is_compressed, data_size, validators "
+    "FROM cache_entries ORDER BY key;",
+    // kSelectValidators
+    "SELECT validators FROM cache_entries WHERE key = ?;",
+    // kUpdateExpiry
+    "UPDATE cache_entries SET expiry_time = ?, "
+    "validators = COALESCE(?, validators) WHERE key = ?;",
+    // kSelectKeysByCompression
+    "SELECT key FROM cache_entries WHERE is_compressed = ?;",
+    // kUpdateData
+    "UPDATE cache_entries SET data = ? WHERE key = ?;",
+};
+
+constexpr auto kDictionaryMetadataKey = "compression_dictionary";
+
+// Fewer samples rarely produce a useful dictionary.
+constexpr int kMinDictionarySamples = 8;
+constexpr int kMaxDictionarySamples = 1000;
+
+/**
+ * @brief Resets a cached statement and clears its bindings on scope exit so
+ * it can be reused by the next call.
+ */
+class StatementScope {
+ public:
+  explicit StatementScope(sqlite3_stmt* stmt) : stmt_(stmt) {}
+
+  ~StatementScope() {
+    if (stmt_) {
+      sqlite3_reset(stmt_);
+      sqlite3_clear_bindings(stmt_);
+    }
+  }
+
+  StatementScope(const StatementScope&) = delete;
+  StatementScope& operator=(const StatementScope&) = delete;
+
+ private:
+  sqlite3_stmt* stmt_;
+};
+
+int64_t NowSeconds() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+SQLiteCacheStorage::SQLiteCacheStorage(
+    std::string db_path,
+    const bool enable_compression,
+    const std::chrono::milliseconds write_behind_interval,
+    const CompressionOptions& compression_options)
     : db_(nullptr),
       db_path_(std::move(db_path)),
-      enable_compression_(enable_compression) {}
+      enable_compression_(enable_compression),
+      compression_options_(compression_options),
+      write_behind_interval_(write_behind_interval) {
+  static_assert(kStatementSql.size() == kStatementCount);
+}
 
 SQLiteCacheStorage::~SQLiteCacheStorage() {
+  if (writer_thread_.joinable()) {
+    {
+      std::lock_guard lock(queue_mutex_);
+      stop_writer_ = true;
+    }
+    queue_cv_.notify_all();
+    writer_thread_.join();
+  }
   if (db_) {
+    Flush();
+    FinalizeStatements();
     sqlite3_close(db_);
   }
 }
@@ -68,7 +188,16 @@ bool SQLiteCacheStorage::Initialize() {
     throw std::runtime_error("failed to create database schema");
   }
 
+  // Full scan once; inserts and deletes keep the size current afterwards.
   UpdateCacheSize();
+
+  if (enable_compression_) {
+    InitializeCompressionLocked();
+  }
+
+  if (write_behind_interval_.count() > 0 && !writer_thread_.joinable()) {
+    writer_thread_ = std::thread(&SQLiteCacheStorage::WriterLoop, this);
+  }
   return true;
 }
 
@@ -76,112 +205,161 @@ bool SQLiteCacheStorage::Store(
     const std::string& key,
     const std::string& data,
     const std::chrono::system_clock::time_point expiry) {
+  return StoreWithValidators(key, data, expiry, {});
+}
+
+bool SQLiteCacheStorage::StoreWithValidators(
+    const std::string& key,
+    const std::string& data,
+    const std::chrono::system_clock::time_point expiry,
+    const std::string& validators) {
+  if (write_behind_interval_.count() > 0) {
+    {
+      std::lock_guard lock(queue_mutex_);
+      pending_writes_.insert_or_assign(key,
+                                       PendingWrite{data, expiry, validators});
+    }
+    queue_cv_.notify_one();
+    return true;
+  }
+
   std::lock_guard lock(db_mutex_);
+  int64_t size_delta = 0;
+  if (!StoreLocked(key, data, expiry, validators, size_delta)) {
+    return false;
+  }
+  cache_size.fetch_add(static_cast<size_t>(size_delta));
+  return true;
+}
 
-  std::string processed_data = data;
-  bool is_compressed = false;
+bool SQLiteCacheStorage::StoreMany(const std::vector<CacheWrite>& entries) {
+  std::lock_guard lock(db_mutex_);
+  return StoreManyLocked(entries);
+}
 
-  if (enable_compression_) {
-    if (const std::string compressed_data = CompressData(data);
-        compressed_data.size() < data.size()) {
-      processed_data = compressed_data;
-      is_compressed = true;
+bool SQLiteCacheStorage::StoreManyLocked(
+    const std::vector<CacheWrite>& entries) {
+  if (entries.empty()) {
+    return true;
+  }
+  if (!Execute(kBegin)) {
+    return false;
+  }
+
+  int64_t size_delta = 0;
+  for (const auto& entry : entries) {
+    int64_t entry_delta = 0;
+    if (!StoreLocked(entry.key, entry.data, entry.expiry, entry.validators,
+                     entry_delta)) {
+      Execute(kRollback);
+      return false;
+    }
+    size_delta += entry_delta;
+  }
+
+  if (!Execute(kCommit)) {
+    Execute(kRollback);
+    return false;
+  }
+  cache_size.fetch_add(static_cast<size_t>(size_delta));
+  return true;
+}
+
+bool SQLiteCacheStorage::StoreLocked(
+    const std::string& key,
+    const std::string& data,
+    const std::chrono::system_clock::time_point expiry,
+    const std::string& validators,
+    int64_t& size_delta) {
+  std::optional<std::string> compressed_data;
+  const std::string* processed_data = &data;
+  auto compression_type = CompressionType::NONE;
+
+  if (codec_ && !data.empty()) {
+    compressed_data = codec_->Compress(data);
+    if (compressed_data && compressed_data->size() < data.size()) {
+      processed_data = &compressed_data.value();
+      compression_type = codec_->GetType();
     }
   }
 
   const auto expiry_time = std::chrono::duration_cast<std::chrono::seconds>(
                                expiry.time_since_epoch())
                                .count();
-  const auto created_time =
-      std::chrono::duration_cast<std::chrono::seconds>(
-          std::chrono::system_clock::now().time_since_epoch())
-          .count();
-
-  const auto insert_sql = R"(
-        INSERT OR REPLACE INTO cache_entries 
-        (key, data, expiry_time, created_time, data_size, is_compressed) 
-        VALUES (?, ?, ?, ?, ?, ?);
-    )";
+  const auto created_time = NowSeconds();
+  const int64_t previous_size = GetEntrySizeLocked(key).value_or(0);
 
-  sqlite3_stmt* stmt;
-  int rc = sqlite3_prepare_v2(db_, insert_sql, -1, &stmt, nullptr);
-
-  if (rc != SQLITE_OK) {
-    spdlog::error("[SQLiteCacheStorage] Failed to prepare statement : {} ({})",
-                  sqlite3_errmsg(db_), rc);
+  sqlite3_stmt* stmt = GetStatement(kInsert);
+  if (!stmt) {
     return false;
   }
+  StatementScope scope(stmt);
 
   sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
-  sqlite3_bind_blob(stmt, 2, processed_data.c_str(),
-                    static_cast<int>(processed_data.size()), SQLITE_STATIC);
+  sqlite3_bind_blob(stmt, 2, processed_data->data(),
+                    static_cast<int>(processed_data->size()), SQLITE_STATIC);
   sqlite3_bind_int64(stmt, 3, expiry_time);
   sqlite3_bind_int64(stmt, 4, created_time);
   sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(data.size()));
-  sqlite3_bind_int(stmt, 6, is_compressed ? 1 : 0);
-
-  rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  sqlite3_bind_int(stmt, 6, static_cast<int>(compression_type));
+  if (!validators.empty()) {
+    sqlite3_bind_text(stmt, 7, validators.c_str(), -1, SQLITE_STATIC);
+  }
 
-  if (rc != SQLITE_DONE) {
+  if (const int rc = sqlite3_step(stmt); rc != SQLITE_DONE) {
     spdlog::error("[SQLiteCacheStorage] Failed to execute statement : {} ({})",
                   sqlite3_errmsg(db_), rc);
     return false;
   }
 
-  UpdateCacheSize();
+  size_delta = static_cast<int64_t>(data.size()) - previous_size;
   return true;
 }
 
 std::optional<std::string> SQLiteCacheStorage::Retrieve(
     const std::string& key) {
-  std::lock_guard lock(db_mutex_);
+  return RetrieveEntry(key, false);
+}
 
-  const auto select_sql = R"(
-        SELECT data, expiry_time, is_compressed 
-        FROM cache_entries 
-        WHERE key = ?;
-    )";
+std::optional<std::string> SQLiteCacheStorage::RetrieveStale(
+    const std::string& key) {
+  return RetrieveEntry(key, true);
+}
 
-  sqlite3_stmt* stmt;
-  int rc = sqlite3_prepare_v2(db_, select_sql, -1, &stmt, nullptr);
-  if (rc != SQLITE_OK) {
-    spdlog::error("[SQLiteCacheStorage] Failed to prepare statement : {} ({})",
-                  sqlite3_errmsg(db_), rc);
+std::optional<std::string> SQLiteCacheStorage::RetrieveEntry(
+    const std::string& key,
+    const bool include_expired) {
+  if (write_behind_interval_.count() > 0) {
+    std::lock_guard lock(queue_mutex_);
+    if (const auto it = pending_writes_.find(key);
+        it != pending_writes_.end()) {
+      if (include_expired ||
+          std::chrono::system_clock::now() < it->second.expiry) {
+        return it->second.data;
+      }
+      return std::nullopt;
+    }
+  }
+
+  std::lock_guard lock(db_mutex_);
+
+  sqlite3_stmt* stmt = GetStatement(kSelect);
+  if (!stmt) {
     return std::nullopt;
   }
+  StatementScope scope(stmt);
 
   sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
 
   std::optional<std::string> result = std::nullopt;
 
-  rc = sqlite3_step(stmt);
-  if (rc == SQLITE_ROW) {
-    const auto current_time =
-        std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::system_clock::now().time_since_epoch())
-            .count();
-
+  if (const int rc = sqlite3_step(stmt); rc == SQLITE_ROW) {
     if (const int64_t expiry_time = sqlite3_column_int64(stmt, 1);
-        current_time < expiry_time) {
-      const void* data = sqlite3_column_blob(stmt, 0);
-      const int data_size = sqlite3_column_bytes(stmt, 0);
-      const bool is_compressed = sqlite3_column_int(stmt, 2) != 0;
-
-      std::string raw_data(static_cast<const char*>(data),
-                           static_cast<size_t>(data_size));
-
-      if (is_compressed) {
-        if (std::string decompressed = DecompressData(raw_data);
-            !decompressed.empty()) {
-          result = decompressed;
-        } else {
-          spdlog::error(
-              "[SQLiteCacheStorage] Failed to decompress data for key: {}",
-              key);
-        }
-      } else {
-        result = raw_data;
+        include_expired || NowSeconds() < expiry_time) {
+      result = ReadDataLocked(stmt, 0, 2, 3);
+      if (!result) {
+        spdlog::error(
+            "[SQLiteCacheStorage] Failed to decompress data for key: {}", key);
       }
     }
   } else if (rc != SQLITE_DONE) {
@@ -189,72 +367,197 @@ std::optional<std::string> SQLiteCacheStorage::Retrieve(
                   sqlite3_errmsg(db_), rc);
   }
 
-  sqlite3_finalize(stmt);
   return result;
 }
 
-bool SQLiteCacheStorage::IsExpired(const std::string& key) {
+bool SQLiteCacheStorage::ForEachEntry(
+    const std::function<bool(const CacheWrite&)>& visitor) {
+  Flush();
+
   std::lock_guard lock(db_mutex_);
 
-  const auto select_sql =
-      "SELECT expiry_time FROM cache_entries WHERE key = ?;";
-  sqlite3_stmt* stmt;
+  sqlite3_stmt* stmt = GetStatement(kSelectAll);
+  if (!stmt || !Execute(kBeginRead)) {
+    return false;
+  }
 
-  int rc = sqlite3_prepare_v2(db_, select_sql, -1, &stmt, nullptr);
-  if (rc != SQLITE_OK) {
-    spdlog::error("[SQLiteCacheStorage] Failed to prepare statement : {} ({})",
+  bool complete = true;
+  {
+    StatementScope scope(stmt);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+      const auto* key =
+          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+      auto data = ReadDataLocked(stmt, 1, 3, 4);
+      if (!key || !data) {
+        spdlog::warn("[SQLiteCacheStorage] Skipping unreadable entry: {}",
+                     key ? key : "");
+        continue;
+      }
+      const auto* validators =
+          reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
+      const CacheWrite entry{
+          key, std::move(*data),
+          std::chrono::system_clock::time_point(
+              std::chrono::seconds(sqlite3_column_int64(stmt, 2))),
+          validators ? validators : ""};
+      if (!visitor(entry)) {
+        complete = false;
+        break;
+      }
+    }
+    if (complete && rc != SQLITE_DONE) {
+      spdlog::error("[SQLiteCacheStorage] Failed to iterate entries : {} ({})",
+                    sqlite3_errmsg(db_), rc);
+      complete = false;
+    }
+  }
+
+  // Read-only, so ending it cannot fail in a way that loses data.
+  Execute(kCommit);
+  return complete;
+}
+
+std::optional<std::string> SQLiteCacheStorage::RetrieveValidators(
+    const std::string& key) {
+  if (write_behind_interval_.count() > 0) {
+    std::lock_guard lock(queue_mutex_);
+    if (const auto it = pending_writes_.find(key);
+        it != pending_writes_.end()) {
+      if (it->second.validators.empty()) {
+        return std::nullopt;
+      }
+      return it->second.validators;
+    }
+  }
+
+  std::lock_guard lock(db_mutex_);
+
+  sqlite3_stmt* stmt = GetStatement(kSelectValidators);
+  if (!stmt) {
+    return std::nullopt;
+  }
+  StatementScope scope(stmt);
+
+  sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+
+  if (sqlite3_step(stmt) != SQLITE_ROW ||
+      sqlite3_column_type(stmt, 0) == SQLITE_NULL) {
+    return std::nullopt;
+  }
+  return std::string(
+      reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+      static_cast<size_t>(sqlite3_column_bytes(stmt, 0)));
+}
+
+bool SQLiteCacheStorage::ExtendExpiry(
+    const std::string& key,
+    const std::chrono::system_clock::time_point expiry,
+    const std::string& validators) {
+  if (write_behind_interval_.count() > 0) {
+    std::lock_guard lock(queue_mutex_);
+    if (const auto it = pending_writes_.find(key);
+        it != pending_writes_.end()) {
+      it->second.expiry = expiry;
+      if (!validators.empty()) {
+        it->second.validators = validators;
+      }
+      return true;
+    }
+  }
+
+  std::lock_guard lock(db_mutex_);
+
+  sqlite3_stmt* stmt = GetStatement(kUpdateExpiry);
+  if (!stmt) {
+    return false;
+  }
+  StatementScope scope(stmt);
+
+  sqlite3_bind_int64(stmt, 1,
+                     std::chrono::duration_cast<std::chrono::seconds>(
+                         expiry.time_since_epoch())
+                         .count());
+  if (!validators.empty()) {
+    sqlite3_bind_text(stmt, 2, validators.c_str(), -1, SQLITE_STATIC);
+  }
+  sqlite3_bind_text(stmt, 3, key.c_str(), -1, SQLITE_STATIC);
+
+  if (const int rc = sqlite3_step(stmt); rc != SQLITE_DONE) {
+    spdlog::error("[SQLiteCacheStorage] Failed to execute update : {} ({})",
                   sqlite3_errmsg(db_), rc);
+    return false;
+  }
+  return sqlite3_changes(db_) > 0;
+}
+
+bool SQLiteCacheStorage::IsExpired(const std::string& key) {
+  if (write_behind_interval_.count() > 0) {
+    std::lock_guard lock(queue_mutex_);
+    if (const auto it = pending_writes_.find(key);
+        it != pending_writes_.end()) {
+      return std::chrono::system_clock::now() >= it->second.expiry;
+    }
+  }
+
+  std::lock_guard lock(db_mutex_);
+
+  sqlite3_stmt* stmt = GetStatement(kSelectExpiry);
+  if (!stmt) {
     return true;
   }
+  StatementScope scope(stmt);
 
   sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
 
   bool expired = true;
 
-  rc = sqlite3_step(stmt);
-  if (rc == SQLITE_ROW) {
-    const auto current_time =
-        std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::system_clock::now().time_since_epoch())
-            .count();
-
+  if (const int rc = sqlite3_step(stmt); rc == SQLITE_ROW) {
     const int64_t expiry_time = sqlite3_column_int64(stmt, 0);
-    expired = current_time >= expiry_time;
+    expired = NowSeconds() >= expiry_time;
   } else if (rc != SQLITE_DONE) {
     spdlog::error("[SQLiteCacheStorage] Failed to execute select : {} ({})",
                   sqlite3_errmsg(db_), rc);
   }
 
-  sqlite3_finalize(stmt);
   return expired;
 }
 
 void SQLiteCacheStorage::Invalidate(const std::string& key) {
   std::lock_guard lock(db_mutex_);
 
-  const char* delete_sql;
-  sqlite3_stmt* stmt;
-  int rc;
+  {
+    std::lock_guard queue_lock(queue_mutex_);
+    if (key.empty()) {
+      pending_writes_.clear();
+    } else {
+      pending_writes_.erase(key);
+    }
+  }
 
   if (key.empty()) {
     // Delete all entries
-    delete_sql = "DELETE FROM cache_entries;";
-    rc = sqlite3_prepare_v2(db_, delete_sql, -1, &stmt, nullptr);
-  } else {
-    // Delete specific entry
-    delete_sql = "DELETE FROM cache_entries WHERE key = ?;";
-    rc = sqlite3_prepare_v2(db_, delete_sql, -1, &stmt, nullptr);
-    if (rc == SQLITE_OK) {
-      sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_stmt* stmt = GetStatement(kDeleteAll)) {
+      StatementScope scope(stmt);
+      if (sqlite3_step(stmt) == SQLITE_DONE) {
+        cache_size.store(0);
+      }
     }
+    return;
   }
 
-  if (rc == SQLITE_OK) {
-    sqlite3_step(stmt);
+  // Delete specific entry
+  const auto previous_size = GetEntrySizeLocked(key);
+  if (!previous_size) {
+    return;
+  }
+  if (sqlite3_stmt* stmt = GetStatement(kDelete)) {
+    StatementScope scope(stmt);
+    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt) == SQLITE_DONE && sqlite3_changes(db_) > 0) {
+      cache_size.fetch_sub(static_cast<size_t>(*previous_size));
+    }
   }
-  sqlite3_finalize(stmt);
-
-  UpdateCacheSize();
 }
 
 size_t SQLiteCacheStorage::GetCacheSize() {
@@ -264,39 +567,54 @@ size_t SQLiteCacheStorage::GetCacheSize() {
 size_t SQLiteCacheStorage::CleanupExpired() {
   std::lock_guard lock(db_mutex_);
 
-  const auto current_time =
-      std::chrono::duration_cast<std::chrono::seconds>(
-          std::chrono::system_clock::now().time_since_epoch())
-          .count();
+  const auto current_time = NowSeconds();
 
-  const auto delete_sql = "DELETE FROM cache_entries WHERE expiry_time <= ?;";
-  sqlite3_stmt* stmt;
-
-  int rc = sqlite3_prepare_v2(db_, delete_sql, -1, &stmt, nullptr);
-  if (rc != SQLITE_OK) {
-    spdlog::error("[SQLiteCacheStorage] Failed to prepare statement : {} ({})",
-                  sqlite3_errmsg(db_), rc);
+  if (!Execute(kBegin)) {
     return 0;
   }
 
-  sqlite3_bind_int64(stmt, 1, current_time);
+  int64_t expired_size = 0;
+  if (sqlite3_stmt* stmt = GetStatement(kSelectExpiredSize)) {
+    StatementScope scope(stmt);
+    sqlite3_bind_int64(stmt, 1, current_time);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+      expired_size = sqlite3_column_int64(stmt, 0);
+    }
+  }
+
+  sqlite3_stmt* stmt = GetStatement(kDeleteExpired);
+  if (!stmt) {
+    Execute(kRollback);
+    return 0;
+  }
 
-  rc = sqlite3_step(stmt);
   size_t deleted_count = 0;
+  {
+    StatementScope scope(stmt);
+    sqlite3_bind_int64(stmt, 1, current_time);
 
-  if (rc == SQLITE_DONE) {
-    deleted_count = static_cast<size_t>(sqlite3_changes(db_));
-  } else {
-    spdlog::error("[SQLiteCacheStorage] Failed to execute delete : {} ({})",
-                  sqlite3_errmsg(db_), rc);
+    if (const int rc = sqlite3_step(stmt); rc == SQLITE_DONE) {
+      deleted_count = static_cast<size_t>(sqlite3_changes(db_));
+    } else {
+      spdlog::error("[SQLiteCacheStorage] Failed to execute delete : {} ({})",
+                    sqlite3_errmsg(db_), rc);
+      Execute(kRollback);
+      return 0;
+    }
   }
 
-  sqlite3_finalize(stmt);
-
-  if (deleted_count > 0) {
-    UpdateCacheSize();
+  if (!Execute(kCommit)) {
+    Execute(kRollback);
+    return 0;
   }
 
+  cache_size.fetch_sub(static_cast<size_t>(expired_size));
+
+  // Cleanup runs periodically, so it doubles as the retry point for a
+  // dictionary that could not be trained yet for lack of entries.
+  if (compression_options_.use_dictionary && !has_dictionary_) {
+    TrainDictionaryLocked();
+  }
   return deleted_count;
 }
 
@@ -305,55 +623,134 @@ std::map<std::string, int64_t> SQLiteCacheStorage::GetStatistics() const {
 
   std::map<std::string, int64_t> stats;
 
-  const auto stats_sql = R"(
-        SELECT 
-            COUNT(*) as entry_count,
-            SUM(data_size) as total_size,
-            AVG(data_size) as avg_size,
-            SUM(CASE WHEN is_compressed = 1 THEN 1 ELSE 0 END) as compressed_count
-        FROM cache_entries;
-    )";
-
-  sqlite3_stmt* stmt;
-  int rc = sqlite3_prepare_v2(db_, stats_sql, -1, &stmt, nullptr);
-  if (rc != SQLITE_OK) {
-    spdlog::error("[SQLiteCacheStorage] Failed to prepare statement : {} ({})",
-                  sqlite3_errmsg(db_), rc);
+  sqlite3_stmt* stmt = GetStatement(kStatistics);
+  if (!stmt) {
     return stats;
   }
 
-  rc = sqlite3_step(stmt);
-  if (rc == SQLITE_ROW) {
-    stats["entries"] = sqlite3_column_int64(stmt, 0);
-    stats["total_size"] = sqlite3_column_int64(stmt, 1);
-    stats["avg_size"] = sqlite3_column_int64(stmt, 2);
-    stats["compressed_count"] = sqlite3_column_int64(stmt, 3);
-  } else if (rc != SQLITE_DONE) {
-    spdlog::error(
-        "[SQLiteCacheStorage] Failed to execute stats query : {} ({})",
-        sqlite3_errmsg(db_), rc);
+  {
+    StatementScope scope(stmt);
+    if (const int rc = sqlite3_step(stmt); rc == SQLITE_ROW) {
+      stats["entries"] = sqlite3_column_int64(stmt, 0);
+      stats["total_size"] = sqlite3_column_int64(stmt, 1);
+      stats["avg_size"] = sqlite3_column_int64(stmt, 2);
+      stats["compressed_count"] = sqlite3_column_int64(stmt, 3);
+    } else if (rc != SQLITE_DONE) {
+      spdlog::error(
+          "[SQLiteCacheStorage] Failed to execute stats query : {} ({})",
+          sqlite3_errmsg(db_), rc);
+    }
   }
 
-  sqlite3_finalize(stmt);
+  if (sqlite3_stmt* expired = GetStatement(kCountExpired)) {
+    StatementScope scope(expired);
+    sqlite3_bind_int64(expired, 1, NowSeconds());
+    if (sqlite3_step(expired) == SQLITE_ROW) {
+      stats["expired_count"] = sqlite3_column_int64(expired, 0);
+    }
+  }
 
-  const auto current_time =
-      std::chrono::duration_cast<std::chrono::seconds>(
-          std::chrono::system_clock::now().time_since_epoch())
-          .count();
+  return stats;
+}
 
-  const auto expired_sql =
-      "SELECT COUNT(*) FROM cache_entries WHERE expiry_time <= ?;";
-  rc = sqlite3_prepare_v2(db_, expired_sql, -1, &stmt, nullptr);
-  if (rc == SQLITE_OK) {
-    sqlite3_bind_int64(stmt, 1, current_time);
-    rc = sqlite3_step(stmt);
-    if (rc == SQLITE_ROW) {
-      stats["expired_count"] = sqlite3_column_int64(stmt, 0);
+size_t SQLiteCacheStorage::Flush() {
+  std::lock_guard lock(db_mutex_);
+
+  std::unordered_map<std::string, PendingWrite> pending;
+  {
+    std::lock_guard queue_lock(queue_mutex_);
+    pending.swap(pending_writes_);
+  }
+  if (pending.empty()) {
+    return 0;
+  }
+
+  std::vector<CacheWrite> entries;
+  entries.reserve(pending.size());
+  for (auto& [key, write] : pending) {
+    entries.push_back({key, std::move(write.data), write.expiry,
+                       std::move(write.validators)});
+  }
+
+  if (!StoreManyLocked(entries)) {
+    spdlog::error("[SQLiteCacheStorage] Failed to flush {} queued entries",
+                  entries.size());
+    return 0;
+  }
+  return entries.size();
+}
+
+void SQLiteCacheStorage::WriterLoop() {
+  std::unique_lock lock(queue_mutex_);
+  while (!stop_writer_) {
+    queue_cv_.wait(lock,
+                   [this] { return stop_writer_ || !pending_writes_.empty(); });
+    if (stop_writer_) {
+      break;
     }
-    sqlite3_finalize(stmt);
+    // Let writes accumulate so they are committed as one transaction.
+    queue_cv_.wait_for(lock, write_behind_interval_,
+                       [this] { return stop_writer_; });
+    lock.unlock();
+    Flush();
+    lock.lock();
   }
+}
 
-  return stats;
+sqlite3_stmt* SQLiteCacheStorage::GetStatement(
+    const Statement statement) const {
+  if (sqlite3_stmt* stmt = statements_[statement]) {
+    return stmt;
+  }
+
+  sqlite3_stmt* stmt = nullptr;
+  if (const int rc =
+          sqlite3_prepare_v3(db_, kStatementSql[statement], -1,
+                             SQLITE_PREPARE_PERSISTENT, &stmt, nullptr);
+      rc != SQLITE_OK) {
+    spdlog::error("[SQLiteCacheStorage] Failed to prepare statement : {} ({})",
+                  sqlite3_errmsg(db_), rc);
+    return nullptr;
+  }
+  statements_[statement] = stmt;
+  return stmt;
+}
+
+bool SQLiteCacheStorage::Execute(const Statement statement) const {
+  sqlite3_stmt* stmt = GetStatement(statement);
+  if (!stmt) {
+    return false;
+  }
+  StatementScope scope(stmt);
+  if (const int rc = sqlite3_step(stmt); rc != SQLITE_DONE) {
+    spdlog::error("[SQLiteCacheStorage] Failed to execute statement : {} ({})",
+                  sqlite3_errmsg(db_), rc);
+    return false;
+  }
+  return true;
+}
+
+void SQLiteCacheStorage::FinalizeStatements() const {
+  for (auto& stmt : statements_) {
+    if (stmt) {
+      sqlite3_finalize(stmt);
+      stmt = nullptr;
+    }
+  }
+}
+
+std::optional<int64_t> SQLiteCacheStorage::GetEntrySizeLocked(
+    const std::string& key) const {
+  sqlite3_stmt* stmt = GetStatement(kSelectSize);
+  if (!stmt) {
+    return std::nullopt;
+  }
+  StatementScope scope(stmt);
+  sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    return sqlite3_column_int64(stmt, 0);
+  }
+  return std::nullopt;
 }
 
 bool SQLiteCacheStorage::CreateTables() const {
@@ -364,7 +761,13 @@ bool SQLiteCacheStorage::CreateTables() const {
             expiry_time INTEGER NOT NULL,
             created_time INTEGER NOT NULL,
             data_size INTEGER NOT NULL,
-            is_compressed INTEGER NOT NULL DEFAULT 0
+            is_compressed INTEGER NOT NULL DEFAULT 0,
+            validators TEXT
+        );
+
+        CREATE TABLE IF NOT EXISTS cache_metadata (
+            name TEXT PRIMARY KEY,
+            value BLOB NOT NULL
         );
         
         CREATE INDEX IF NOT EXISTS idx_expiry_time ON cache_entries(expiry_time);
@@ -380,64 +783,258 @@ bool SQLiteCacheStorage::CreateTables() const {
     sqlite3_free(error_msg);
     return false;
   }
-  return true;
+  return MigrateTables();
 }
 
-std::string SQLiteCacheStorage::CompressData(const std::string& data) const {
-  if (!enable_compression_ || data.empty()) {
-    return data;
+bool SQLiteCacheStorage::MigrateTables() const {
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v2(db_, "PRAGMA table_info(cache_entries);", -1, &stmt,
+                         nullptr) != SQLITE_OK) {
+    spdlog::error("[SQLiteCacheStorage] Failed to read schema : {}",
+                  sqlite3_errmsg(db_));
+    return false;
+  }
+  bool has_validators = false;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    const auto* name =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    if (name && std::string_view(name) == "validators") {
+      has_validators = true;
+    }
+  }
+  sqlite3_finalize(stmt);
+  if (has_validators) {
+    return true;
   }
 
-  uLongf compressed_size = compressBound(data.size());
-  std::string compressed_data(compressed_size, '\0');
+  // Databases from before revalidation support; existing rows get NULL.
+  char* error_msg = nullptr;
+  if (const int rc = sqlite3_exec(
+          db_, "ALTER TABLE cache_entries ADD COLUMN validators TEXT;",
+          nullptr, nullptr, &error_msg);
+      rc != SQLITE_OK) {
+    spdlog::error("[SQLiteCacheStorage] SQL Error: {}", error_msg);
+    sqlite3_free(error_msg);
+    return false;
+  }
+  return true;
+}
 
-  int result =
-      compress(reinterpret_cast<Bytef*>(&compressed_data[0]), &compressed_size,
-               reinterpret_cast<const Bytef*>(data.c_str()), data.size());
+void SQLiteCacheStorage::InitializeCompressionLocked() {
+  codec_ = CreateCompressionCodec(compression_options_.type,
+                                  compression_options_.level);
+  if (!codec_ && compression_options_.type != CompressionType::ZLIB) {
+    spdlog::warn(
+        "[SQLiteCacheStorage] Compression type {} unavailable, using zlib",
+        static_cast<int>(compression_options_.type));
+    codec_ = CreateCompressionCodec(CompressionType::ZLIB,
+                                    compression_options_.level);
+  }
+  if (!codec_ || !compression_options_.use_dictionary) {
+    return;
+  }
 
-  if (result != Z_OK) {
-    spdlog::error("[SQLiteCacheStorage] Compression failed with error: {}",
-                  result);
-    return data;
+  if (sqlite3_stmt* stmt = GetStatement(kSelectMetadata)) {
+    StatementScope scope(stmt);
+    sqlite3_bind_text(stmt, 1, kDictionaryMetadataKey, -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+      const auto* dictionary =
+          static_cast<const char*>(sqlite3_column_blob(stmt, 0));
+      const auto dictionary_size =
+          static_cast<size_t>(sqlite3_column_bytes(stmt, 0));
+      if (dictionary && dictionary_size > 0) {
+        has_dictionary_ =
+            codec_->SetDictionary(std::string(dictionary, dictionary_size));
+      }
+    }
   }
+  if (!has_dictionary_) {
+    TrainDictionaryLocked();
+  }
+}
 
-  compressed_data.resize(compressed_size);
-  return compressed_data;
+bool SQLiteCacheStorage::TrainDictionary() {
+  std::lock_guard lock(db_mutex_);
+  return TrainDictionaryLocked();
 }
 
-std::string SQLiteCacheStorage::DecompressData(const std::string& data) const {
-  if (!enable_compression_ || data.empty()) {
-    return data;
+bool SQLiteCacheStorage::TrainDictionaryLocked() {
+  if (!codec_ || !codec_->SupportsDictionary()) {
+    return false;
+  }
+
+  std::vector<std::string> samples;
+  if (sqlite3_stmt* stmt = GetStatement(kSelectSamples)) {
+    StatementScope scope(stmt);
+    sqlite3_bind_int(stmt, 1, kMaxDictionarySamples);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      if (auto sample = ReadDataLocked(stmt, 0, 1, 2); sample) {
+        samples.push_back(std::move(*sample));
+      }
+    }
+  }
+  if (samples.size() < kMinDictionarySamples) {
+    spdlog::debug(
+        "[SQLiteCacheStorage] {} samples are not enough to train a "
+        "dictionary",
+        samples.size());
+    return false;
+  }
+
+  const auto dictionary = TrainCompressionDictionary(
+      samples, compression_options_.dictionary_size);
+  if (!dictionary) {
+    return false;
+  }
+  // Load the dictionary into a second codec so entries can be decoded with
+  // the current one while they are re-encoded with the new one.
+  auto next_codec = CreateCompressionCodec(codec_->GetType(),
+                                           compression_options_.level);
+  if (!next_codec || !next_codec->SetDictionary(*dictionary)) {
+    return false;
+  }
+
+  if (!Execute(kBegin)) {
+    return false;
+  }
+  int64_t removed_size = 0;
+  if (!StoreDictionaryLocked(*dictionary) ||
+      !RecompressEntriesLocked(*next_codec, removed_size)) {
+    Execute(kRollback);
+    return false;
+  }
+  if (!Execute(kCommit)) {
+    Execute(kRollback);
+    return false;
   }
 
-  // Try different buffer sizes for decompression
-  const std::vector<uLongf> buffer_sizes = {data.size() * 4, data.size() * 10,
-                                            data.size() * 50, 1024 * 1024};
+  // Switch only once the dictionary and the entries using it are on disk.
+  codec_ = std::move(next_codec);
+  cache_size.fetch_sub(static_cast<size_t>(removed_size));
+  has_dictionary_ = true;
+  spdlog::info(
+      "[SQLiteCacheStorage] Trained {} byte compression dictionary from {} "
+      "entries",
+      dictionary->size(), samples.size());
+  return true;
+}
 
-  for (const uLongf buffer_size : buffer_sizes) {
-    std::string decompressed_data(buffer_size, '\0');
-    uLongf decompressed_size = buffer_size;
+bool SQLiteCacheStorage::StoreDictionaryLocked(const std::string& dictionary) {
+  sqlite3_stmt* stmt = GetStatement(kInsertMetadata);
+  if (!stmt) {
+    return false;
+  }
+  StatementScope scope(stmt);
+  sqlite3_bind_text(stmt, 1, kDictionaryMetadataKey, -1, SQLITE_STATIC);
+  sqlite3_bind_blob(stmt, 2, dictionary.data(),
+                    static_cast<int>(dictionary.size()), SQLITE_STATIC);
+  if (const int rc = sqlite3_step(stmt); rc != SQLITE_DONE) {
+    spdlog::error("[SQLiteCacheStorage] Failed to store dictionary : {} ({})",
+                  sqlite3_errmsg(db_), rc);
+    return false;
+  }
+  return true;
+}
 
-    int result = uncompress(
-        reinterpret_cast<Bytef*>(&decompressed_data[0]), &decompressed_size,
-        reinterpret_cast<const Bytef*>(data.c_str()), data.size());
+bool SQLiteCacheStorage::RecompressEntriesLocked(ICompressionCodec& codec,
+                                                 int64_t& removed_size) {
+  std::vector<std::string> keys;
+  if (sqlite3_stmt* stmt = GetStatement(kSelectKeysByCompression)) {
+    StatementScope scope(stmt);
+    sqlite3_bind_int(stmt, 1, static_cast<int>(codec.GetType()));
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      if (const auto* key = sqlite3_column_text(stmt, 0)) {
+        keys.emplace_back(reinterpret_cast<const char*>(key));
+      }
+    }
+  } else {
+    return false;
+  }
 
-    if (result == Z_OK) {
-      decompressed_data.resize(decompressed_size);
-      return decompressed_data;
+  for (const auto& key : keys) {
+    std::optional<std::string> compressed;
+    int64_t data_size = 0;
+    if (sqlite3_stmt* stmt = GetStatement(kSelect)) {
+      StatementScope scope(stmt);
+      sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+      if (sqlite3_step(stmt) != SQLITE_ROW) {
+        continue;
+      }
+      data_size = sqlite3_column_int64(stmt, 3);
+      if (const auto data = ReadDataLocked(stmt, 0, 2, 3)) {
+        compressed = codec.Compress(*data);
+        if (!compressed) {
+          return false;
+        }
+      }
+    }
+
+    // An entry that cannot be decoded would only ever miss; drop it rather
+    // than keep it on disk and in the cache size.
+    sqlite3_stmt* stmt = GetStatement(compressed ? kUpdateData : kDelete);
+    if (!stmt) {
+      return false;
+    }
+    StatementScope scope(stmt);
+    if (compressed) {
+      sqlite3_bind_blob(stmt, 1, compressed->data(),
+                        static_cast<int>(compressed->size()), SQLITE_STATIC);
+      sqlite3_bind_text(stmt, 2, key.c_str(), -1, SQLITE_STATIC);
+    } else {
+      sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
     }
-    if (result == Z_BUF_ERROR) {
-      // Buffer too small
-      continue;
+    if (const int rc = sqlite3_step(stmt); rc != SQLITE_DONE) {
+      spdlog::error(
+          "[SQLiteCacheStorage] Failed to re-encode entry : {} ({})",
+          sqlite3_errmsg(db_), rc);
+      return false;
+    }
+    if (!compressed) {
+      removed_size += data_size;
     }
-    // stop trying
-    spdlog::error("[SQLiteCacheStorage] Decompression failed with error: {}",
-                  result);
-    break;
   }
+  return true;
+}
+
+ICompressionCodec* SQLiteCacheStorage::GetCodecLocked(
+    const CompressionType type) {
+  if (codec_ && codec_->GetType() == type) {
+    return codec_.get();
+  }
+  auto& decoder = decoders_[static_cast<int>(type)];
+  if (!decoder) {
+    decoder = CreateCompressionCodec(type, compression_options_.level);
+  }
+  return decoder.get();
+}
 
-  spdlog::error("[SQLiteCacheStorage] All decompression attempts failed");
-  return "";
+std::optional<std::string> SQLiteCacheStorage::ReadDataLocked(
+    sqlite3_stmt* stmt,
+    const int data_column,
+    const int type_column,
+    const int size_column) {
+  const auto* data =
+      static_cast<const char*>(sqlite3_column_blob(stmt, data_column));
+  const auto data_size =
+      static_cast<size_t>(sqlite3_column_bytes(stmt, data_column));
+
+  const auto type =
+      static_cast<CompressionType>(sqlite3_column_int(stmt, type_column));
+  if (type == CompressionType::NONE) {
+    return data ? std::string(data, data_size) : std::string();
+  }
+
+  ICompressionCodec* codec = GetCodecLocked(type);
+  if (!codec) {
+    spdlog::error("[SQLiteCacheStorage] No codec for compression type {}",
+                  static_cast<int>(type));
+    return std::nullopt;
+  }
+  // Decode straight from the row's blob; data_size holds the uncompressed
+  // size, so a single exact pass suffices.
+  return codec->Decompress(
+      data, data_size,
+      static_cast<size_t>(sqlite3_column_int64(stmt, size_column)));
 }
 
 void SQLiteCacheStorage::UpdateCacheSize() {
@@ -18,15 +18,22 @@
 #ifndef PLUGINS_FLATPAK_CACHE_SQLITE_CACHE_STORAGE_H
 #define PLUGINS_FLATPAK_CACHE_SQLITE_CACHE_STORAGE_H
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <sqlite3.h>
 
 #include "flatpak/cache/interfaces/cache_storage.h"
+#include "flatpak/cache/interfaces/compression_codec.h"
 #include "plugins/common/common.h"
 
 /**
@@ -36,11 +43,29 @@
  * This class provides persistent cache storage functionality by leveraging
  * SQLite. It supports optional data compression, thread-safe operations, and
  * cache size management.
+ *
+ * Statements are prepared once per connection and reused. The cache size is
+ * maintained incrementally from inserts and deletes. With a non-zero write
+ * behind interval, Store() queues the entry and a writer thread group-commits
+ * pending entries in one transaction; reads see queued entries immediately.
+ *
+ * Compressed entries record their codec and uncompressed size, so reads
+ * decompress in one exact-size pass and entries from another codec remain
+ * readable. With a dictionary enabled, one is trained from stored entries
+ * and persisted in the database.
+ *
+ * Entries may carry validators for revalidating them with their origin;
+ * databases created before the validators column existed are migrated when
+ * opened.
  */
 class SQLiteCacheStorage final : public ICacheStorage {
  public:
-  explicit SQLiteCacheStorage(std::string db_path,
-                              bool enable_compression = false);
+  explicit SQLiteCacheStorage(
+      std::string db_path,
+      bool enable_compression = false,
+      std::chrono::milliseconds write_behind_interval =
+          std::chrono::milliseconds(0),
+      const CompressionOptions& compression_options = {});
 
   ~SQLiteCacheStorage() override;
 
@@ -50,8 +75,34 @@ class SQLiteCacheStorage final : public ICacheStorage {
              const std::string& data,
              std::chrono::system_clock::time_point expiry) override;
 
+  bool StoreWithValidators(const std::string& key,
+                           const std::string& data,
+                           std::chrono::system_clock::time_point expiry,
+                           const std::string& validators) override;
+
+  bool StoreMany(const std::vector<CacheWrite>& entries) override;
+
   std::optional<std::string> Retrieve(const std::string& key) override;
 
+  std::optional<std::string> RetrieveStale(const std::string& key) override;
+
+  /**
+   * @brief Flushes queued writes and visits all entries inside a single read
+   * transaction.
+   */
+  bool ForEachEntry(
+      const std::function<bool(const CacheWrite&)>& visitor) override;
+
+  std::optional<std::string> RetrieveValidators(
+      const std::string& key) override;
+
+  /**
+   * @brief Updates the expiry column in place, without rewriting the data.
+   */
+  bool ExtendExpiry(const std::string& key,
+                    std::chrono::system_clock::time_point expiry,
+                    const std::string& validators = {}) override;
+
   bool IsExpired(const std::string& key) override;
 
   void Invalidate(const std::string& key) override;
@@ -66,18 +117,119 @@ class SQLiteCacheStorage final : public ICacheStorage {
    */
   std::map<std::string, int64_t> GetStatistics() const;
 
+  /**
+   * @brief Writes all queued write-behind entries in a single transaction.
+   * @return The number of entries written.
+   */
+  size_t Flush();
+
+  /**
+   * @brief Trains a compression dictionary from the most recent entries and
+   * persists it. Entries compressed with the previous dictionary are
+   * re-encoded with the new one in the same transaction, and entries that
+   * cannot be decoded are deleted, so the cost grows with the number of
+   * compressed entries.
+   * @return true if a dictionary was trained and installed.
+   */
+  bool TrainDictionary();
+
  private:
+  enum Statement : size_t {
+    kInsert,
+    kSelect,
+    kSelectExpiry,
+    kSelectSize,
+    kDelete,
+    kDeleteAll,
+    kSelectExpiredSize,
+    kDeleteExpired,
+    kStatistics,
+    kCountExpired,
+    kBegin,
+    kCommit,
+    kRollback,
+    kSelectMetadata,
+    kInsertMetadata,
+    kSelectSamples,
+    kBeginRead,
+    kSelectAll,
+    kSelectValidators,
+    kUpdateExpiry,
+    kSelectKeysByCompression,
+    kUpdateData,
+    kStatementCount
+  };
+
+  struct PendingWrite {
+    std::string data;
+    std::chrono::system_clock::time_point expiry;
+    std::string validators;
+  };
+
   sqlite3* db_;
   std::string db_path_;
   mutable std::mutex db_mutex_;
   std::atomic<size_t> cache_size{0};
   bool enable_compression_;
 
+  // Codec for new entries and decoders for entries written with other codecs,
+  // keyed by CompressionType. Guarded by |db_mutex_|.
+  CompressionOptions compression_options_;
+  std::unique_ptr<ICompressionCodec> codec_;
+  std::unordered_map<int, std::unique_ptr<ICompressionCodec>> decoders_;
+  bool has_dictionary_ = false;
+
+  // Lazily prepared statements, guarded by |db_mutex_|.
+  mutable std::array<sqlite3_stmt*, kStatementCount> statements_{};
+
+  // Write-behind queue. Lock order is |db_mutex_| before |queue_mutex_|.
+  std::chrono::milliseconds write_behind_interval_;
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  std::unordered_map<std::string, PendingWrite> pending_writes_;
+  std::thread writer_thread_;
+  bool stop_writer_ = false;
+
   bool CreateTables() const;
 
-  std::string CompressData(const std::string& data) const;
+  bool MigrateTables() const;
+
+  sqlite3_stmt* GetStatement(Statement statement) const;
+
+  bool Execute(Statement statement) const;
+
+  void FinalizeStatements() const;
+
+  bool StoreLocked(const std::string& key,
+                   const std::string& data,
+                   std::chrono::system_clock::time_point expiry,
+                   const std::string& validators,
+                   int64_t& size_delta);
+
+  bool StoreManyLocked(const std::vector<CacheWrite>& entries);
+
+  std::optional<std::string> RetrieveEntry(const std::string& key,
+                                           bool include_expired);
+
+  std::optional<int64_t> GetEntrySizeLocked(const std::string& key) const;
+
+  void WriterLoop();
+
+  void InitializeCompressionLocked();
+
+  bool TrainDictionaryLocked();
+
+  bool StoreDictionaryLocked(const std::string& dictionary);
+
+  bool RecompressEntriesLocked(ICompressionCodec& codec,
+                               int64_t& removed_size);
+
+  ICompressionCodec* GetCodecLocked(CompressionType type);
 
-  std::string DecompressData(const std::string& data) const;
+  std::optional<std::string> ReadDataLocked(sqlite3_stmt* stmt,
+                                            int data_column,
+                                            int type_column,
+                                            int size_column);
 
   void UpdateCacheSize();
 };
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flatpak/cache/storage/sqlite_cache_storage.h"
+
+namespace {
+
+constexpr int64_t kSmallEntry = 256;
+constexpr int64_t kLargeEntry = 1024 * 1024;
+constexpr int kKeyCount = 64;
+
+std::string DatabasePath() {
+  return (std::filesystem::temp_directory_path() /
+          "flatpak_cache_benchmark.db")
+      .string();
+}
+
+std::unique_ptr<SQLiteCacheStorage> CreateStorage(
+    const std::chrono::milliseconds write_behind =
+        std::chrono::milliseconds(0)) {
+  const auto path = DatabasePath();
+  for (const auto* suffix : {"", "-wal", "-shm"}) {
+    std::filesystem::remove(path + suffix);
+  }
+  auto storage =
+      std::make_unique<SQLiteCacheStorage>(path, false, write_behind);
+  storage->Initialize();
+  return storage;
+}
+
+std::chrono::system_clock::time_point Expiry() {
+  return std::chrono::system_clock::now() + std::chrono::hours(1);
+}
+
+void BM_Store(benchmark::State& state) {
+  const auto storage = CreateStorage();
+  const std::string data(static_cast<size_t>(state.range(0)), 'x');
+  const auto expiry = Expiry();
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        storage->Store("key" + std::to_string(i++ % kKeyCount), data, expiry));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_StoreMany(benchmark::State& state) {
+  const auto storage = CreateStorage();
+  const std::string data(static_cast<size_t>(state.range(0)), 'x');
+  const auto expiry = Expiry();
+  std::vector<CacheWrite> batch;
+  for (int i = 0; i < kKeyCount; i++) {
+    batch.push_back({"key" + std::to_string(i), data, expiry});
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(storage->StoreMany(batch));
+  }
+  state.SetItemsProcessed(state.iterations() * kKeyCount);
+  state.SetBytesProcessed(state.iterations() * kKeyCount * state.range(0));
+}
+
+void BM_StoreWriteBehind(benchmark::State& state) {
+  const auto storage = CreateStorage(std::chrono::milliseconds(5));
+  const std::string data(static_cast<size_t>(state.range(0)), 'x');
+  const auto expiry = Expiry();
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        storage->Store("key" + std::to_string(i++ % kKeyCount), data, expiry));
+  }
+  storage->Flush();
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_Retrieve(benchmark::State& state) {
+  const auto storage = CreateStorage();
+  const std::string data(static_cast<size_t>(state.range(0)), 'x');
+  const auto expiry = Expiry();
+  for (int i = 0; i < kKeyCount; i++) {
+    storage->Store("key" + std::to_string(i), data, expiry);
+  }
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        storage->Retrieve("key" + std::to_string(i++ % kKeyCount)));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+void BM_IsExpired(benchmark::State& state) {
+  const auto storage = CreateStorage();
+  const auto expiry = Expiry();
+  for (int i = 0; i < kKeyCount; i++) {
+    storage->Store("key" + std::to_string(i), "data", expiry);
+  }
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        storage->IsExpired("key" + std::to_string(i++ % kKeyCount)));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_Store)->Arg(kSmallEntry)->Arg(kLargeEntry);
+BENCHMARK(BM_StoreMany)->Arg(kSmallEntry)->Arg(kLargeEntry);
+BENCHMARK(BM_StoreWriteBehind)->Arg(kSmallEntry)->Arg(kLargeEntry);
+BENCHMARK(BM_Retrieve)->Arg(kSmallEntry)->Arg(kLargeEntry);
+BENCHMARK(BM_IsExpired);
@@ -3,7 +3,11 @@
 #include <filesystem>
 #include <fstream>
 #include <memory>
+#include <set>
+#include <sstream>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <flutter/encodable_value.h>
 
@@ -12,6 +16,11 @@
 #include "flatpak/cache/interfaces/cache_observer.h"
 #include "flatpak/cache/interfaces/cache_storage.h"
 #include "flatpak/cache/interfaces/network_fetcher.h"
+#include "flatpak/cache/network/curl_network_fetcher.h"
+#include "flatpak/cache/operations/encodablelist_cache_operation.h"
+#include "flatpak/cache/storage/cache_snapshot.h"
+#include "flatpak/cache/storage/memory_cache.h"
+#include "flatpak/cache/storage/sqlite_cache_storage.h"
 
 using namespace flatpak_plugin;
 
@@ -179,6 +188,8 @@ class TestNetworkFetcher : public INetworkFetcher {
   std::string bearer_token_;
   bool simulate_network_failure_ = false;
   long last_response_code_ = 200;
+  std::chrono::milliseconds fetch_delay_{0};
+  std::atomic<int> fetch_remotes_calls_{0};
 
  public:
   void SetBearerToken(const std::string& token) override {
@@ -226,6 +237,14 @@ class TestNetworkFetcher : public INetworkFetcher {
     return std::string("post_response_for_" + url);
   }
 
+  void SetFetchDelay(const std::chrono::milliseconds delay) {
+    fetch_delay_ = delay;
+  }
+
+  [[nodiscard]] int GetFetchRemotesCalls() const {
+    return fetch_remotes_calls_.load();
+  }
+
   bool IsNetworkAvailable() override { return !simulate_network_failure_; }
 
   long GetLastResponseCode() override { return last_response_code_; }
@@ -341,6 +360,8 @@ class TestNetworkFetcher : public INetworkFetcher {
 
   std::optional<flutter::EncodableList> FetchRemotes(
       const std::string& /* installation_id */) override {
+    ++fetch_remotes_calls_;
+    std::this_thread::sleep_for(fetch_delay_);
     if (simulate_network_failure_) {
       return std::nullopt;
     }
@@ -599,6 +620,26 @@ TEST_F(CacheManagerIntegrationTest, CacheHitOnSecondRequest) {
   EXPECT_TRUE(has_cache_interaction);
 }
 
+TEST_F(CacheManagerIntegrationTest, RepeatedReadsServedFromMemory) {
+  CreateCacheManager();
+
+  ASSERT_TRUE(cache_manager_->GetApplicationsInstalled(false).has_value());
+  const auto& metrics = cache_manager_->GetMetrics();
+  const auto storage_hits = metrics.storage_hits.load();
+
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(cache_manager_->GetApplicationsInstalled(false).has_value());
+  }
+  EXPECT_EQ(metrics.memory_hits.load(), 3u);
+  EXPECT_EQ(metrics.storage_hits.load(), storage_hits);
+
+  // Invalidation drops the in-memory copy as well.
+  cache_manager_->InvalidateKey("applications_installed");
+  observer_ptr_->ClearEvents();
+  ASSERT_TRUE(cache_manager_->GetApplicationsInstalled(false).has_value());
+  EXPECT_TRUE(observer_ptr_->HasEvent("miss"));
+}
+
 TEST_F(CacheManagerIntegrationTest, ForceRefreshBypassesCache) {
   CreateCacheManager();
   EXPECT_TRUE(cache_manager_->IsHealthy());
@@ -663,6 +704,33 @@ TEST_F(CacheManagerIntegrationTest, CacheInvalidation) {
   EXPECT_TRUE(observer_ptr_->HasEvent("miss"));
 }
 
+TEST_F(CacheManagerIntegrationTest, InstallationChangeInvalidatesItsEntries) {
+  CreateCacheManager();
+  const auto expired_keys = [this] {
+    std::set<std::string> keys;
+    for (const auto& event : observer_ptr_->events) {
+      if (event.type == "expired") {
+        keys.insert(event.key);
+      }
+    }
+    return keys;
+  };
+
+  cache_manager_->GetApplicationsRemote("flathub", false);
+  observer_ptr_->ClearEvents();
+  cache_manager_->InvalidateInstallation("user");
+  EXPECT_EQ(expired_keys(),
+            (std::set<std::string>{"applications_installed", "remotes:user",
+                                   "user_installation",
+                                   "applications_remote:flathub"}));
+
+  observer_ptr_->ClearEvents();
+  cache_manager_->InvalidateInstallation("default");
+  EXPECT_EQ(expired_keys(),
+            (std::set<std::string>{"applications_installed", "remotes:default",
+                                   "system_installations"}));
+}
+
 TEST_F(CacheManagerIntegrationTest, ClearAllCache) {
   CreateCacheManager();
   EXPECT_TRUE(cache_manager_->IsHealthy());
@@ -819,4 +887,529 @@ TEST_F(CacheManagerIntegrationTest, DataPresistanceAcrossRestarts) {
 
   auto result = cache_manager_->GetApplicationsInstalled(false);
   EXPECT_TRUE(result.has_value());
-}
\ No newline at end of file
+}
+
+TEST_F(CacheManagerIntegrationTest, ConcurrentRequestsShareOneFetch) {
+  fetcher_ptr_->SetFetchDelay(std::chrono::milliseconds(200));
+  CreateCacheManager();
+
+  std::vector<std::thread> callers;
+  std::vector<std::optional<flutter::EncodableList>> results(4);
+  for (size_t i = 0; i < results.size(); ++i) {
+    callers.emplace_back([this, &results, i] {
+      results[i] = cache_manager_->GetRemotes("system", false);
+    });
+  }
+  for (auto& caller : callers) {
+    caller.join();
+  }
+
+  EXPECT_EQ(fetcher_ptr_->GetFetchRemotesCalls(), 1);
+  for (const auto& result : results) {
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->size(), 2u);
+  }
+  EXPECT_EQ(cache_manager_->GetMetrics().coalesced_requests.load(), 3u);
+}
+
+TEST_F(CacheManagerIntegrationTest, StaleWhileRevalidateServesExpiredEntry) {
+  // A zero TTL makes every stored entry expire immediately, while the row
+  // stays in SQLite until the next cleanup.
+  config_.policy = CachePolicy::STALE_WHILE_REVALIDATE;
+  config_.default_ttl = std::chrono::seconds(0);
+  cache_manager_ = std::make_unique<CacheManager>(
+      config_, std::make_unique<SQLiteCacheStorage>(":memory:"),
+      std::move(fetcher_));
+
+  ASSERT_TRUE(cache_manager_->GetRemotes("system", false).has_value());
+  EXPECT_EQ(fetcher_ptr_->GetFetchRemotesCalls(), 1);
+
+  // The expired entry is returned right away and refreshed in the background.
+  const auto stale = cache_manager_->GetRemotes("system", false);
+  ASSERT_TRUE(stale.has_value());
+  EXPECT_EQ(stale->size(), 2u);
+  EXPECT_EQ(cache_manager_->GetMetrics().stale_hits.load(), 1u);
+
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (fetcher_ptr_->GetFetchRemotesCalls() < 2 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(fetcher_ptr_->GetFetchRemotesCalls(), 2);
+}
+
+TEST_F(CacheManagerIntegrationTest, SnapshotSeedsCacheAfterExpiryRebase) {
+  const std::string exported_path = test_db_path_ + ".snapshot";
+  const std::string aged_path = test_db_path_ + ".aged";
+  cache_manager_ = std::make_unique<CacheManager>(
+      config_, std::make_unique<SQLiteCacheStorage>(":memory:"),
+      std::move(fetcher_));
+  ASSERT_TRUE(cache_manager_->GetRemotes("system", false).has_value());
+  ASSERT_TRUE(cache_manager_->ExportCache(exported_path));
+
+  // Pretend the snapshot was built 30 days ago, so every absolute expiry in
+  // it has long passed while the remaining lifetimes are unchanged.
+  const auto age = std::chrono::hours(24 * 30);
+  {
+    std::ifstream in(exported_path, std::ios::binary);
+    CacheSnapshotReader reader(in);
+    ASSERT_TRUE(reader.IsValid());
+    std::ofstream out(aged_path, std::ios::binary);
+    CacheSnapshotWriter writer(out, CompressionType::ZLIB, 6,
+                               reader.GetExportTime() - age);
+    while (auto entry = reader.Next()) {
+      entry->expiry -= age;
+      ASSERT_TRUE(writer.Add(*entry));
+    }
+    ASSERT_TRUE(reader.IsComplete());
+    EXPECT_EQ(writer.GetEntryCount(), 1u);
+    ASSERT_TRUE(writer.Finish());
+  }
+
+  auto fetcher = std::make_unique<TestNetworkFetcher>();
+  const auto* fetcher_ptr = fetcher.get();
+  CacheManager restored(config_,
+                        std::make_unique<SQLiteCacheStorage>(":memory:"),
+                        std::move(fetcher));
+  ASSERT_TRUE(restored.ImportCache(aged_path));
+  const auto remotes = restored.GetRemotes("system", false);
+  ASSERT_TRUE(remotes.has_value());
+  EXPECT_EQ(remotes->size(), 2u);
+  EXPECT_EQ(fetcher_ptr->GetFetchRemotesCalls(), 0);
+
+  // A single flipped byte rejects the whole snapshot.
+  {
+    std::fstream file(aged_path,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    file.seekg(30);
+    const char byte = static_cast<char>(file.get());
+    file.seekp(30);
+    file.put(static_cast<char>(byte ^ 0x01));
+  }
+  EXPECT_FALSE(restored.ImportCache(aged_path));
+
+  std::filesystem::remove(exported_path);
+  std::filesystem::remove(aged_path);
+}
+
+TEST_F(CacheManagerIntegrationTest, LatencyIsRecordedPerKeyClass) {
+  // Without the memory tier the second read is decoded from storage.
+  config_.memory_cache_size_mb = 0;
+  CreateCacheManager();
+  ASSERT_TRUE(cache_manager_->GetApplicationsInstalled(false).has_value());
+  ASSERT_TRUE(cache_manager_->GetApplicationsInstalled(false).has_value());
+  ASSERT_TRUE(cache_manager_->GetRemotes("system", false).has_value());
+  ASSERT_TRUE(cache_manager_->GetRemotes("user", false).has_value());
+
+  const auto json = cache_manager_->GetMetricsJson();
+  EXPECT_NE(json.find("\"applications_installed\":{\"storage_read\""),
+            std::string::npos);
+  // Both remotes share the "remotes" class.
+  EXPECT_NE(json.find("\"remotes\":{"), std::string::npos);
+  EXPECT_EQ(json.find("remotes:system"), std::string::npos);
+  for (const auto* operation :
+       {"storage_write", "serialize", "deserialize", "network"}) {
+    EXPECT_NE(json.find(operation), std::string::npos) << operation;
+  }
+
+  cache_manager_->ResetLatencyMetrics();
+  EXPECT_NE(cache_manager_->GetMetricsJson().find("\"latency\":{}"),
+            std::string::npos);
+}
+
+TEST_F(CacheManagerIntegrationTest, EncodableListEncodesInPlace) {
+  CreateCacheManager();
+  EncodableListCacheOperation operation(cache_manager_.get());
+
+  // More than 254 elements needs the extended size prefix.
+  flutter::EncodableList list;
+  for (int i = 0; i < 300; i++) {
+    list.emplace_back(flutter::EncodableList{
+        flutter::EncodableValue("app" + std::to_string(i)),
+        flutter::EncodableValue(int64_t{i} << 40),
+        flutter::EncodableValue(i * 0.5)});
+  }
+
+  std::string buffer;
+  ASSERT_TRUE(operation.SerializeInto(list, buffer));
+  const auto encoded =
+      FlatpakApi::GetCodec().EncodeMessage(flutter::EncodableValue(list));
+  ASSERT_TRUE(encoded);
+  EXPECT_EQ(buffer, std::string(encoded->begin(), encoded->end()));
+
+  const std::string db_path = test_db_path_ + ".inplace";
+  {
+    SQLiteCacheStorage storage(db_path);
+    ASSERT_TRUE(storage.Initialize());
+    ASSERT_TRUE(operation.CacheData("apps", list, &storage));
+    EXPECT_EQ(operation.RetrieveData("apps", &storage), list);
+  }
+
+  EXPECT_FALSE(operation.DeserializeFrom(buffer.data(), buffer.size() / 2));
+  for (const auto* suffix : {"", "-wal", "-shm"}) {
+    std::filesystem::remove(db_path + suffix);
+  }
+}
+
+TEST(LatencyHistogramTest, PercentilesStayWithinBucketPrecision) {
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 1000; i++) {
+    histogram.Record(std::chrono::microseconds(i * 100));
+  }
+  const auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.count, 1000u);
+  EXPECT_EQ(snapshot.max_us, 100000u);
+  EXPECT_NEAR(snapshot.GetMean(), 50050.0, 0.1);
+  EXPECT_NEAR(static_cast<double>(snapshot.ValueAtPercentile(50)), 50000.0,
+              50000.0 * 0.04);
+  EXPECT_NEAR(static_cast<double>(snapshot.ValueAtPercentile(99)), 99000.0,
+              99000.0 * 0.04);
+  EXPECT_LE(snapshot.ValueAtPercentile(100), snapshot.max_us);
+
+  // Small values are exact, out of range values are clamped.
+  EXPECT_EQ(LatencyHistogram::GetBucketIndex(63), 63u);
+  const auto lower = LatencyHistogram::GetBucketLowerBound(
+      LatencyHistogram::GetBucketIndex(12345));
+  EXPECT_LE(lower, 12345u);
+  EXPECT_GE(lower, 12345u - 12345u / LatencyHistogram::kSubBucketCount);
+  EXPECT_EQ(LatencyHistogram::GetBucketIndex(UINT64_MAX),
+            LatencyHistogram::kBucketCount - 1);
+}
+
+TEST(MemoryCacheTest, EvictsLeastRecentlyUsedByBytes) {
+  MemoryCache cache(100);
+  const auto expiry = MemoryCache::Clock::now() + std::chrono::hours(1);
+
+  cache.Put<std::string>("a", "a", 40, expiry);
+  cache.Put<std::string>("b", "b", 40, expiry);
+  EXPECT_EQ(cache.Get<std::string>("a"), "a");
+
+  // "b" is now least recently used and is evicted to make room.
+  cache.Put<std::string>("c", "c", 40, expiry);
+  EXPECT_FALSE(cache.Get<std::string>("b").has_value());
+  EXPECT_EQ(cache.Get<std::string>("a"), "a");
+  EXPECT_EQ(cache.Get<std::string>("c"), "c");
+  EXPECT_EQ(cache.GetSizeBytes(), 80u);
+
+  // Oversized values are not cached at all.
+  cache.Put<std::string>("d", "d", 200, expiry);
+  EXPECT_FALSE(cache.Get<std::string>("d").has_value());
+  EXPECT_EQ(cache.GetEntryCount(), 2u);
+}
+
+TEST(MemoryCacheTest, ExpiryInvalidationAndTypeMismatch) {
+  MemoryCache cache(1024);
+  const auto now = MemoryCache::Clock::now();
+
+  cache.Put<std::string>("a", "a", 1, now + std::chrono::seconds(1));
+  cache.Put<int>("b", 42, 1, now + std::chrono::hours(1));
+  EXPECT_FALSE(
+      cache.Get<std::string>("a", now + std::chrono::seconds(2)).has_value());
+  EXPECT_FALSE(cache.Get<std::string>("b").has_value());
+  EXPECT_EQ(cache.Get<int>("b"), 42);
+
+  cache.Invalidate("b");
+  EXPECT_FALSE(cache.Get<int>("b").has_value());
+
+  cache.Put<int>("c", 1, 1, now + std::chrono::seconds(1));
+  cache.Put<int>("d", 2, 1, now + std::chrono::hours(1));
+  EXPECT_EQ(cache.CleanupExpired(now + std::chrono::seconds(2)), 1u);
+  cache.Invalidate("");
+  EXPECT_EQ(cache.GetEntryCount(), 0u);
+  EXPECT_EQ(cache.GetSizeBytes(), 0u);
+}
+
+class SQLiteCacheStorageTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    test_db_path_ =
+        "/tmp/sqlite_cache_storage_test_" +
+        std::to_string(
+            std::chrono::steady_clock::now().time_since_epoch().count()) +
+        ".db";
+    expiry_ = std::chrono::system_clock::now() + std::chrono::hours(1);
+  }
+
+  void TearDown() override {
+    for (const auto* suffix : {"", "-wal", "-shm"}) {
+      std::filesystem::remove(test_db_path_ + suffix);
+    }
+  }
+
+  std::string test_db_path_;
+  std::chrono::system_clock::time_point expiry_;
+};
+
+TEST_F(SQLiteCacheStorageTest, CacheSizeTracksInsertsAndDeletes) {
+  SQLiteCacheStorage storage(test_db_path_, true);
+  ASSERT_TRUE(storage.Initialize());
+
+  EXPECT_TRUE(storage.Store("a", std::string(1000, 'a'), expiry_));
+  EXPECT_EQ(storage.GetCacheSize(), 1000u);
+
+  // Replacing an entry only accounts for the difference.
+  EXPECT_TRUE(storage.Store("a", std::string(400, 'a'), expiry_));
+  EXPECT_EQ(storage.GetCacheSize(), 400u);
+  EXPECT_EQ(storage.Retrieve("a"), std::string(400, 'a'));
+
+  EXPECT_TRUE(storage.Store("b", "bb", expiry_));
+  storage.Invalidate("missing");
+  EXPECT_EQ(storage.GetCacheSize(), 402u);
+
+  storage.Invalidate("a");
+  EXPECT_EQ(storage.GetCacheSize(), 2u);
+
+  storage.Invalidate("");
+  EXPECT_EQ(storage.GetCacheSize(), 0u);
+}
+
+TEST_F(SQLiteCacheStorageTest, StoreManyAndCleanupExpired) {
+  SQLiteCacheStorage storage(test_db_path_);
+  ASSERT_TRUE(storage.Initialize());
+
+  const auto expired = std::chrono::system_clock::now() - std::chrono::hours(1);
+  EXPECT_TRUE(storage.StoreMany({{"a", "aaa", expiry_},
+                                 {"b", "bb", expiry_},
+                                 {"c", "c", expired}}));
+  EXPECT_EQ(storage.GetCacheSize(), 6u);
+  EXPECT_EQ(storage.Retrieve("b"), "bb");
+  EXPECT_TRUE(storage.IsExpired("c"));
+
+  EXPECT_EQ(storage.CleanupExpired(), 1u);
+  EXPECT_EQ(storage.GetCacheSize(), 5u);
+}
+
+TEST_F(SQLiteCacheStorageTest, WriteBehindIsVisibleAndPersisted) {
+  {
+    SQLiteCacheStorage storage(test_db_path_, false,
+                               std::chrono::milliseconds(50));
+    ASSERT_TRUE(storage.Initialize());
+
+    for (int i = 0; i < 10; i++) {
+      EXPECT_TRUE(storage.Store("key" + std::to_string(i), "v", expiry_));
+    }
+    // Queued entries are readable before they are committed.
+    EXPECT_EQ(storage.Retrieve("key3"), "v");
+    EXPECT_FALSE(storage.IsExpired("key3"));
+
+    storage.Store("gone", "v", expiry_);
+    storage.Invalidate("gone");
+    EXPECT_FALSE(storage.Retrieve("gone").has_value());
+
+    storage.Flush();
+    EXPECT_EQ(storage.GetCacheSize(), 10u);
+  }
+
+  SQLiteCacheStorage reopened(test_db_path_);
+  ASSERT_TRUE(reopened.Initialize());
+  EXPECT_EQ(reopened.GetCacheSize(), 10u);
+  EXPECT_EQ(reopened.Retrieve("key9"), "v");
+}
+
+TEST_F(SQLiteCacheStorageTest, RetrieveStaleReturnsExpiredUntilCleanup) {
+  SQLiteCacheStorage storage(test_db_path_);
+  ASSERT_TRUE(storage.Initialize());
+
+  const auto expired = std::chrono::system_clock::now() - std::chrono::hours(1);
+  EXPECT_TRUE(storage.Store("a", "old", expired));
+  EXPECT_FALSE(storage.Retrieve("a").has_value());
+  EXPECT_EQ(storage.RetrieveStale("a"), "old");
+
+  EXPECT_EQ(storage.CleanupExpired(), 1u);
+  EXPECT_FALSE(storage.RetrieveStale("a").has_value());
+}
+
+TEST_F(SQLiteCacheStorageTest, CompressedEntryRoundTripsAtAnySize) {
+  SQLiteCacheStorage storage(test_db_path_, true);
+  ASSERT_TRUE(storage.Initialize());
+
+  // Highly compressible payloads used to overflow the fixed decode buffer.
+  const std::string large(4 * 1024 * 1024, 'x');
+  EXPECT_TRUE(storage.Store("large", large, expiry_));
+  EXPECT_EQ(storage.Retrieve("large"), large);
+  EXPECT_EQ(storage.GetCacheSize(), large.size());
+}
+
+TEST_F(SQLiteCacheStorageTest, ReadsEntriesWrittenByAnotherCodec) {
+  {
+    CompressionOptions zlib;
+    zlib.type = CompressionType::ZLIB;
+    SQLiteCacheStorage storage(test_db_path_, true,
+                               std::chrono::milliseconds(0), zlib);
+    ASSERT_TRUE(storage.Initialize());
+    EXPECT_TRUE(storage.Store("a", std::string(2048, 'a'), expiry_));
+  }
+
+  SQLiteCacheStorage reopened(test_db_path_, true);
+  ASSERT_TRUE(reopened.Initialize());
+  EXPECT_EQ(reopened.Retrieve("a"), std::string(2048, 'a'));
+  EXPECT_TRUE(reopened.Store("b", std::string(2048, 'b'), expiry_));
+  EXPECT_EQ(reopened.Retrieve("b"), std::string(2048, 'b'));
+
+  // Without a codec compressed rows are still decoded.
+  SQLiteCacheStorage uncompressed(test_db_path_);
+  ASSERT_TRUE(uncompressed.Initialize());
+  EXPECT_EQ(uncompressed.Retrieve("a"), std::string(2048, 'a'));
+}
+
+#if defined(ENABLE_ZSTD)
+TEST_F(SQLiteCacheStorageTest, RetrainedDictionaryKeepsEntriesReadable) {
+  CompressionOptions options;
+  options.type = CompressionType::ZSTD;
+  options.use_dictionary = true;
+  options.dictionary_size = 4096;
+  auto entry = [](const int i, const char* kind) {
+    std::string data;
+    for (int field = 0; field < 16; ++field) {
+      data += "{\"" + std::string(kind) + "\": \"org.example.App" +
+              std::to_string(i * 31 + field) + "\", \"branch\": \"stable\"}";
+    }
+    return data;
+  };
+
+  size_t cache_size = 0;
+  {
+    SQLiteCacheStorage storage(test_db_path_, true,
+                               std::chrono::milliseconds(0), options);
+    ASSERT_TRUE(storage.Initialize());
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_TRUE(
+          storage.Store("app" + std::to_string(i), entry(i, "app"), expiry_));
+    }
+    ASSERT_TRUE(storage.TrainDictionary());
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_TRUE(storage.Store("remote" + std::to_string(i),
+                                entry(i, "remote"), expiry_));
+    }
+    ASSERT_TRUE(storage.TrainDictionary());
+
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_EQ(storage.Retrieve("app" + std::to_string(i)), entry(i, "app"));
+      EXPECT_EQ(storage.Retrieve("remote" + std::to_string(i)),
+                entry(i, "remote"));
+    }
+    cache_size = storage.GetCacheSize();
+  }
+
+  // The persisted dictionary is the one the entries were re-encoded with.
+  SQLiteCacheStorage reopened(test_db_path_, true,
+                              std::chrono::milliseconds(0), options);
+  ASSERT_TRUE(reopened.Initialize());
+  EXPECT_EQ(reopened.Retrieve("app0"), entry(0, "app"));
+  EXPECT_EQ(reopened.Retrieve("remote99"), entry(99, "remote"));
+  EXPECT_EQ(reopened.GetCacheSize(), cache_size);
+}
+#endif
+
+TEST_F(SQLiteCacheStorageTest, ValidatorsKeptUntilReplaced) {
+  for (const auto interval :
+       {std::chrono::milliseconds(0), std::chrono::milliseconds(50)}) {
+    SQLiteCacheStorage storage(test_db_path_, false, interval);
+    ASSERT_TRUE(storage.Initialize());
+    storage.Invalidate("");
+
+    const auto expired =
+        std::chrono::system_clock::now() - std::chrono::hours(1);
+    EXPECT_TRUE(storage.StoreWithValidators("a", "old", expired, "v1"));
+    EXPECT_EQ(storage.RetrieveValidators("a"), "v1");
+    EXPECT_FALSE(storage.Retrieve("a").has_value());
+
+    // Extending keeps the data and, unless replaced, the validators.
+    EXPECT_TRUE(storage.ExtendExpiry("a", expiry_));
+    EXPECT_EQ(storage.Retrieve("a"), "old");
+    EXPECT_EQ(storage.RetrieveValidators("a"), "v1");
+    storage.Flush();
+    EXPECT_TRUE(storage.ExtendExpiry("a", expiry_, "v2"));
+    EXPECT_EQ(storage.RetrieveValidators("a"), "v2");
+
+    EXPECT_TRUE(storage.Store("a", "new", expiry_));
+    EXPECT_FALSE(storage.RetrieveValidators("a").has_value());
+    EXPECT_FALSE(storage.ExtendExpiry("missing", expiry_));
+  }
+}
+
+TEST_F(SQLiteCacheStorageTest, SnapshotKeepsValidators) {
+  SQLiteCacheStorage storage(":memory:");
+  ASSERT_TRUE(storage.Initialize());
+  ASSERT_TRUE(storage.StoreWithValidators("a", "data", expiry_, "v1"));
+  ASSERT_TRUE(storage.Store("b", "data", expiry_));
+
+  std::stringstream snapshot;
+  {
+    CacheSnapshotWriter writer(snapshot, CompressionType::NONE, 0,
+                               std::chrono::system_clock::now());
+    ASSERT_TRUE(storage.ForEachEntry(
+        [&writer](const CacheWrite& entry) { return writer.Add(entry); }));
+    ASSERT_TRUE(writer.Finish());
+  }
+
+  CacheSnapshotReader reader(snapshot);
+  ASSERT_TRUE(reader.IsValid());
+  std::vector<CacheWrite> entries;
+  while (auto entry = reader.Next()) {
+    entries.push_back(std::move(*entry));
+  }
+  ASSERT_TRUE(reader.IsComplete());
+
+  SQLiteCacheStorage restored(":memory:");
+  ASSERT_TRUE(restored.Initialize());
+  ASSERT_TRUE(restored.StoreMany(entries));
+  EXPECT_EQ(restored.RetrieveValidators("a"), "v1");
+  EXPECT_FALSE(restored.RetrieveValidators("b").has_value());
+
+  // The validators are covered by the record checksum.
+  std::string bytes = snapshot.str();
+  const auto pos = bytes.find("v1");
+  ASSERT_NE(pos, std::string::npos);
+  bytes[pos] = 'w';
+  std::stringstream corrupt(bytes);
+  CacheSnapshotReader corrupt_reader(corrupt);
+  ASSERT_TRUE(corrupt_reader.IsValid());
+  EXPECT_FALSE(corrupt_reader.Next().has_value());
+  EXPECT_FALSE(corrupt_reader.IsComplete());
+}
+
+TEST_F(SQLiteCacheStorageTest, MigratesDatabaseWithoutValidators) {
+  sqlite3* db = nullptr;
+  ASSERT_EQ(sqlite3_open(test_db_path_.c_str(), &db), SQLITE_OK);
+  ASSERT_EQ(sqlite3_exec(db, R"(
+        CREATE TABLE cache_entries (
+            key TEXT PRIMARY KEY,
+            data BLOB NOT NULL,
+            expiry_time INTEGER NOT NULL,
+            created_time INTEGER NOT NULL,
+            data_size INTEGER NOT NULL,
+            is_compressed INTEGER NOT NULL DEFAULT 0
+        );
+        INSERT INTO cache_entries VALUES ('a', 'old', 4102444800, 0, 3, 0);
+    )",
+                         nullptr, nullptr, nullptr),
+            SQLITE_OK);
+  sqlite3_close(db);
+
+  SQLiteCacheStorage storage(test_db_path_);
+  ASSERT_TRUE(storage.Initialize());
+  EXPECT_EQ(storage.Retrieve("a"), "old");
+  EXPECT_FALSE(storage.RetrieveValidators("a").has_value());
+  EXPECT_TRUE(storage.StoreWithValidators("b", "new", expiry_, "v"));
+  EXPECT_EQ(storage.RetrieveValidators("b"), "v");
+}
+
+TEST(CurlNetworkFetcherTest, RetryDelayIsJitteredAndCapped) {
+  using std::chrono::milliseconds;
+  using std::chrono::seconds;
+  EXPECT_EQ(CurlNetworkFetcher::GetRetryDelay(1, seconds(0), 0.0),
+            milliseconds(500));
+  EXPECT_EQ(CurlNetworkFetcher::GetRetryDelay(1, seconds(0), 0.999),
+            milliseconds(999));
+  EXPECT_EQ(CurlNetworkFetcher::GetRetryDelay(3, seconds(0), 0.5),
+            milliseconds(3000));
+  EXPECT_EQ(CurlNetworkFetcher::GetRetryDelay(20, seconds(0), 1.0),
+            milliseconds(30000));
+  // Retry-After raises the delay but not past the cap.
+  EXPECT_EQ(CurlNetworkFetcher::GetRetryDelay(1, seconds(5), 0.0),
+            milliseconds(5000));
+  EXPECT_EQ(CurlNetworkFetcher::GetRetryDelay(1, seconds(3600), 0.0),
+            milliseconds(30000));
+}
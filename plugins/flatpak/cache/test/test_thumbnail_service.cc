@@ -0,0 +1,242 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <flutter/encodable_value.h>
+
+#include "flatpak/cache/interfaces/network_fetcher.h"
+#include "flatpak/cache/storage/sqlite_cache_storage.h"
+#include "flatpak/cache/thumbnails/image_codec.h"
+#include "flatpak/cache/thumbnails/thumbnail_service.h"
+
+using namespace flatpak_plugin;
+
+namespace {
+
+// Answers nothing; the tests override the calls ThumbnailService makes.
+class ImageFetcher : public INetworkFetcher {
+ public:
+  std::optional<std::string> Fetch(
+      const std::string& /* url */,
+      const std::vector<std::string>& /* headers */) override {
+    return std::nullopt;
+  }
+
+  std::optional<std::string> Post(
+      const std::string& /* url */,
+      const std::vector<std::pair<std::string, std::string>>& /* form_data */,
+      const std::vector<std::string>& /* headers */) override {
+    return std::nullopt;
+  }
+
+  bool IsNetworkAvailable() override { return true; }
+
+  long GetLastResponseCode() override { return 200; }
+
+  void SetBearerToken(const std::string& /* token */) override {}
+
+  std::optional<flutter::EncodableList> FetchRemotes(
+      const std::string& /* installation_id */) override {
+    return std::nullopt;
+  }
+};
+
+class ThumbnailServiceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    test_db_path_ =
+        "/tmp/thumbnail_service_test_" +
+        std::to_string(
+            std::chrono::steady_clock::now().time_since_epoch().count()) +
+        ".db";
+  }
+
+  void TearDown() override {
+    for (const auto* suffix : {"", "-wal", "-shm"}) {
+      std::filesystem::remove(test_db_path_ + suffix);
+    }
+  }
+
+  std::string test_db_path_;
+};
+
+}  // namespace
+
+TEST(ImageCodecTest, ResizeAveragesAreaWithoutAlphaBleed) {
+  EXPECT_EQ(FitWithin(1920, 1080, 256, 256), std::make_pair(256u, 144u));
+  EXPECT_EQ(FitWithin(1920, 1080, 0, 270), std::make_pair(480u, 270u));
+  EXPECT_EQ(FitWithin(48, 48, 128, 128), std::make_pair(48u, 48u));
+
+  // Left half opaque red; right half one blue pixel and three transparent
+  // black ones.
+  RgbaImage image{4, 2, std::string(4 * 2 * 4, '\0')};
+  auto set = [&image](const size_t x, const size_t y, const uint8_t r,
+                      const uint8_t g, const uint8_t b, const uint8_t a) {
+    auto* pixel = reinterpret_cast<uint8_t*>(image.pixels.data()) +
+                  (y * image.width + x) * 4;
+    pixel[0] = r;
+    pixel[1] = g;
+    pixel[2] = b;
+    pixel[3] = a;
+  };
+  for (size_t y = 0; y < 2; y++) {
+    set(0, y, 255, 0, 0, 255);
+    set(1, y, 255, 0, 0, 255);
+  }
+  set(3, 1, 0, 0, 255, 255);
+
+  const auto resized = ResizeImage(image, 2, 2);
+  ASSERT_EQ(resized.width, 2u);
+  ASSERT_EQ(resized.height, 1u);
+  const auto* pixels = reinterpret_cast<const uint8_t*>(resized.pixels.data());
+  EXPECT_EQ(std::vector<int>(pixels, pixels + 8),
+            (std::vector<int>{255, 0, 0, 255, 0, 0, 255, 64}));
+}
+
+#if defined(ENABLE_PNG)
+TEST_F(ThumbnailServiceTest, ReusesDownloadedSource) {
+  class CountingFetcher final : public ImageFetcher {
+   public:
+    CountingFetcher(std::string image, std::atomic<int>* fetches)
+        : image_(std::move(image)), fetches_(fetches) {}
+
+    std::optional<std::string> Fetch(
+        const std::string& /* url */,
+        const std::vector<std::string>& /* headers */) override {
+      ++*fetches_;
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      return image_;
+    }
+
+   private:
+    std::string image_;
+    std::atomic<int>* fetches_;
+  };
+
+  RgbaImage source{64, 32, std::string(64 * 32 * 4, '\xff')};
+  const auto png = EncodePng(source);
+  ASSERT_TRUE(png);
+  const std::string url = "https://example.com/screenshot.png";
+
+  SQLiteCacheStorage storage(test_db_path_);
+  ASSERT_TRUE(storage.Initialize());
+  std::atomic<int> fetches{0};
+  {
+    ThumbnailService service(
+        &storage, std::make_unique<CountingFetcher>(*png, &fetches), 2,
+        std::chrono::hours(1), 1024 * 1024);
+
+    // Concurrent requests for one thumbnail share a single job.
+    std::vector<ThumbnailService::ThumbnailPtr> results(8);
+    std::vector<std::thread> threads;
+    for (auto& result : results) {
+      threads.emplace_back([&service, &url, &result] {
+        result = service.Get({url, 16, 16});
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    ASSERT_TRUE(results[0]);
+    EXPECT_EQ(results[0]->width, 16u);
+    EXPECT_EQ(results[0]->height, 8u);
+    EXPECT_EQ(results[0]->data.size(), 16u * 8 * 4);
+    EXPECT_EQ(fetches.load(), 1);
+
+    // Another size is made from the stored source.
+    const auto encoded = service.Get({url, 32, 32, ThumbnailFormat::PNG});
+    ASSERT_TRUE(encoded);
+    EXPECT_EQ(encoded->width, 32u);
+    EXPECT_EQ(DetectImageFormat(encoded->data), ImageFormat::PNG);
+    EXPECT_EQ(fetches.load(), 1);
+
+    EXPECT_FALSE(service.Get({"relative/icon.png", 16, 16}));
+  }
+
+  // Stored thumbnails survive the in-memory tier.
+  ThumbnailService reopened(&storage, nullptr, 1, std::chrono::hours(1), 0);
+  const auto stored = reopened.Get({url, 16, 16});
+  ASSERT_TRUE(stored);
+  EXPECT_EQ(stored->height, 8u);
+}
+
+TEST_F(ThumbnailServiceTest, ExpiredThumbnailsAreRevalidated) {
+  class RevalidatingFetcher final : public ImageFetcher {
+   public:
+    RevalidatingFetcher(std::string image, std::atomic<int>* downloads)
+        : image_(std::move(image)), downloads_(downloads) {}
+
+    FetchResult FetchConditional(
+        const std::string& /* url */,
+        const std::vector<std::string>& /* headers */,
+        const HttpValidators& validators) override {
+      FetchResult result;
+      if (validators.etag == "\"v1\"") {
+        result.status = 304;
+        return result;
+      }
+      ++*downloads_;
+      result.status = 200;
+      result.body = image_;
+      result.validators.etag = "\"v1\"";
+      return result;
+    }
+
+   private:
+    std::string image_;
+    std::atomic<int>* downloads_;
+  };
+
+  RgbaImage source{64, 32, std::string(64 * 32 * 4, '\xff')};
+  const auto png = EncodePng(source);
+  ASSERT_TRUE(png);
+  const std::string url = "https://example.com/icon.png";
+
+  SQLiteCacheStorage storage(test_db_path_);
+  ASSERT_TRUE(storage.Initialize());
+  std::atomic<int> downloads{0};
+  // With a zero TTL every entry is expired as soon as it is stored.
+  ThumbnailService service(
+      &storage, std::make_unique<RevalidatingFetcher>(*png, &downloads), 1,
+      std::chrono::seconds(0), 0);
+
+  const auto first = service.Get({url, 16, 16});
+  ASSERT_TRUE(first);
+  const auto validators =
+      storage.RetrieveValidators(ThumbnailService::GetSourceKey(url));
+  ASSERT_TRUE(validators);
+  EXPECT_EQ(HttpValidators::Parse(*validators).etag, "\"v1\"");
+
+  // The origin answers 304, so the stored thumbnail is served again.
+  const auto second = service.Get({url, 16, 16});
+  ASSERT_TRUE(second);
+  EXPECT_EQ(second->data, first->data);
+  const auto resized = service.Get({url, 8, 8});
+  ASSERT_TRUE(resized);
+  EXPECT_EQ(resized->width, 8u);
+  EXPECT_EQ(downloads.load(), 1);
+}
+#endif
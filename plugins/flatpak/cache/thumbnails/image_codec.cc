@@ -0,0 +1,380 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "image_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#if defined(ENABLE_PNG)
+#include <png.h>
+#endif
+#if defined(ENABLE_JPEG)
+#include <csetjmp>
+#include <cstdio>
+
+#include <jpeglib.h>
+#endif
+
+namespace flatpak_plugin {
+
+namespace {
+
+// Keeps a corrupt or hostile header from triggering a huge allocation.
+constexpr uint64_t kMaxPixels = 64 * 1024 * 1024;
+
+constexpr uint8_t kPngSignature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a,
+                                     '\n'};
+constexpr uint8_t kJpegSignature[] = {0xff, 0xd8, 0xff};
+
+bool StartsWith(const std::string_view data,
+                const uint8_t* signature,
+                const size_t size) {
+  return data.size() >= size && std::memcmp(data.data(), signature, size) == 0;
+}
+
+bool IsTooLarge(const uint64_t width, const uint64_t height) {
+  return width == 0 || height == 0 || width * height > kMaxPixels;
+}
+
+#if defined(ENABLE_PNG)
+std::optional<RgbaImage> DecodePng(const std::string_view data) {
+  png_image png{};
+  png.version = PNG_IMAGE_VERSION;
+  if (!png_image_begin_read_from_memory(&png, data.data(), data.size())) {
+    spdlog::error("[ImageCodec] Failed to read PNG header: {}", png.message);
+    return std::nullopt;
+  }
+  if (IsTooLarge(png.width, png.height)) {
+    spdlog::error("[ImageCodec] PNG too large: {}x{}", png.width, png.height);
+    png_image_free(&png);
+    return std::nullopt;
+  }
+
+  png.format = PNG_FORMAT_RGBA;
+  RgbaImage image;
+  image.width = png.width;
+  image.height = png.height;
+  image.pixels.resize(PNG_IMAGE_SIZE(png));
+  if (!png_image_finish_read(&png, nullptr, image.pixels.data(), 0, nullptr)) {
+    spdlog::error("[ImageCodec] Failed to decode PNG: {}", png.message);
+    png_image_free(&png);
+    return std::nullopt;
+  }
+  return image;
+}
+#endif
+
+#if defined(ENABLE_JPEG)
+struct JpegErrorManager {
+  jpeg_error_mgr manager;
+  jmp_buf jump;
+};
+
+[[noreturn]] void OnJpegError(const j_common_ptr cinfo) {
+  char message[JMSG_LENGTH_MAX];
+  cinfo->err->format_message(cinfo, message);
+  spdlog::error("[ImageCodec] Failed to decode JPEG: {}", message);
+  longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump, 1);
+}
+
+// Nothing below setjmp() may own resources that need unwinding; |image| is
+// only written through libjpeg and released by the caller.
+bool DecodeJpegInto(const std::string_view data,
+                    const uint32_t max_width,
+                    const uint32_t max_height,
+                    RgbaImage* image) {
+  jpeg_decompress_struct cinfo{};
+  JpegErrorManager error{};
+  cinfo.err = jpeg_std_error(&error.manager);
+  error.manager.error_exit = OnJpegError;
+  error.manager.output_message = [](j_common_ptr) {};
+
+  if (setjmp(error.jump)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo,
+               reinterpret_cast<unsigned char*>(const_cast<char*>(data.data())),
+               static_cast<unsigned long>(data.size()));
+  jpeg_read_header(&cinfo, TRUE);
+  if (IsTooLarge(cinfo.image_width, cinfo.image_height)) {
+    spdlog::error("[ImageCodec] JPEG too large: {}x{}", cinfo.image_width,
+                  cinfo.image_height);
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+
+  // Let the IDCT do the coarse downscaling.
+  const auto [fit_width, fit_height] = FitWithin(
+      cinfo.image_width, cinfo.image_height, max_width, max_height);
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = 1;
+  for (const unsigned denom : {8u, 4u, 2u}) {
+    if ((cinfo.image_width + denom - 1) / denom >= fit_width &&
+        (cinfo.image_height + denom - 1) / denom >= fit_height) {
+      cinfo.scale_denom = denom;
+      break;
+    }
+  }
+  cinfo.out_color_space = JCS_RGB;
+  jpeg_start_decompress(&cinfo);
+
+  image->width = cinfo.output_width;
+  image->height = cinfo.output_height;
+  image->pixels.resize(static_cast<size_t>(image->width) * image->height * 4);
+  const size_t stride = static_cast<size_t>(image->width) * 4;
+  while (cinfo.output_scanline < cinfo.output_height) {
+    auto* row = reinterpret_cast<uint8_t*>(image->pixels.data()) +
+                cinfo.output_scanline * stride;
+    JSAMPROW rows[] = {row};
+    jpeg_read_scanlines(&cinfo, rows, 1);
+    // Expand RGB to RGBA in place, back to front.
+    for (size_t x = image->width; x-- > 0;) {
+      const uint8_t r = row[x * 3];
+      const uint8_t g = row[x * 3 + 1];
+      const uint8_t b = row[x * 3 + 2];
+      row[x * 4] = r;
+      row[x * 4 + 1] = g;
+      row[x * 4 + 2] = b;
+      row[x * 4 + 3] = 0xff;
+    }
+  }
+
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  return true;
+}
+#endif
+
+/**
+ * @brief The source pixels under one destination pixel along one axis and
+ * the fraction of each that is covered.
+ */
+struct Span {
+  uint32_t first;
+  std::vector<float> weights;
+};
+
+std::vector<Span> ComputeSpans(const uint32_t source, const uint32_t target) {
+  const double scale = static_cast<double>(source) / target;
+  std::vector<Span> spans(target);
+  for (uint32_t i = 0; i < target; i++) {
+    const double begin = i * scale;
+    const double end = std::min<double>((i + 1) * scale, source);
+    auto& span = spans[i];
+    span.first = static_cast<uint32_t>(begin);
+    const auto last = std::min(source, static_cast<uint32_t>(std::ceil(end)));
+    for (uint32_t s = span.first; s < last; s++) {
+      const double covered =
+          std::min<double>(end, s + 1) - std::max<double>(begin, s);
+      span.weights.push_back(static_cast<float>(covered / scale));
+    }
+  }
+  return spans;
+}
+
+}  // namespace
+
+ImageFormat DetectImageFormat(const std::string_view data) {
+  if (StartsWith(data, kPngSignature, sizeof(kPngSignature))) {
+    return ImageFormat::PNG;
+  }
+  if (StartsWith(data, kJpegSignature, sizeof(kJpegSignature))) {
+    return ImageFormat::JPEG;
+  }
+  return ImageFormat::UNKNOWN;
+}
+
+bool CanDecodeImage(const ImageFormat format) {
+  switch (format) {
+    case ImageFormat::PNG:
+#if defined(ENABLE_PNG)
+      return true;
+#else
+      return false;
+#endif
+    case ImageFormat::JPEG:
+#if defined(ENABLE_JPEG)
+      return true;
+#else
+      return false;
+#endif
+    case ImageFormat::UNKNOWN:
+      break;
+  }
+  return false;
+}
+
+bool CanEncodePng() {
+#if defined(ENABLE_PNG)
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::pair<uint32_t, uint32_t> FitWithin(const uint32_t width,
+                                        const uint32_t height,
+                                        const uint32_t max_width,
+                                        const uint32_t max_height) {
+  double scale = 1.0;
+  if (max_width > 0 && width > max_width) {
+    scale = static_cast<double>(max_width) / width;
+  }
+  if (max_height > 0 && height > max_height) {
+    scale = std::min(scale, static_cast<double>(max_height) / height);
+  }
+  const auto scaled = [scale](const uint32_t value) {
+    return std::max<uint32_t>(
+        1, static_cast<uint32_t>(std::lround(value * scale)));
+  };
+  return {scaled(width), scaled(height)};
+}
+
+std::optional<RgbaImage> DecodeImage(const std::string_view data,
+                                     const uint32_t max_width,
+                                     const uint32_t max_height) {
+  switch (DetectImageFormat(data)) {
+#if defined(ENABLE_PNG)
+    case ImageFormat::PNG:
+      return DecodePng(data);
+#endif
+#if defined(ENABLE_JPEG)
+    case ImageFormat::JPEG: {
+      RgbaImage image;
+      if (!DecodeJpegInto(data, max_width, max_height, &image)) {
+        return std::nullopt;
+      }
+      return image;
+    }
+#endif
+    default:
+      spdlog::error("[ImageCodec] Unsupported image format");
+      return std::nullopt;
+  }
+}
+
+RgbaImage ResizeImage(const RgbaImage& image,
+                      const uint32_t max_width,
+                      const uint32_t max_height) {
+  const auto [width, height] =
+      FitWithin(image.width, image.height, max_width, max_height);
+  if (width == image.width && height == image.height) {
+    return image;
+  }
+
+  const auto* source = reinterpret_cast<const uint8_t*>(image.pixels.data());
+  const auto columns = ComputeSpans(image.width, width);
+  const auto rows = ComputeSpans(image.height, height);
+
+  // Horizontal pass into premultiplied floats, one row per source row.
+  std::vector<float> narrowed(static_cast<size_t>(image.height) * width * 4);
+  for (uint32_t y = 0; y < image.height; y++) {
+    const uint8_t* in = source + static_cast<size_t>(y) * image.width * 4;
+    float* out = narrowed.data() + static_cast<size_t>(y) * width * 4;
+    for (uint32_t x = 0; x < width; x++, out += 4) {
+      const auto& span = columns[x];
+      float r = 0, g = 0, b = 0, a = 0;
+      const uint8_t* pixel = in + static_cast<size_t>(span.first) * 4;
+      for (const float weight : span.weights) {
+        const float alpha = pixel[3] * weight;
+        r += pixel[0] * alpha;
+        g += pixel[1] * alpha;
+        b += pixel[2] * alpha;
+        a += alpha;
+        pixel += 4;
+      }
+      out[0] = r;
+      out[1] = g;
+      out[2] = b;
+      out[3] = a;
+    }
+  }
+
+  // Vertical pass, then back to straight alpha.
+  RgbaImage result;
+  result.width = width;
+  result.height = height;
+  result.pixels.resize(static_cast<size_t>(width) * height * 4);
+  auto* destination = reinterpret_cast<uint8_t*>(result.pixels.data());
+  std::vector<float> sum(static_cast<size_t>(width) * 4);
+  const auto to_byte = [](const float value) {
+    return static_cast<uint8_t>(std::clamp(value + 0.5f, 0.0f, 255.0f));
+  };
+  for (uint32_t y = 0; y < height; y++) {
+    std::fill(sum.begin(), sum.end(), 0.0f);
+    const auto& span = rows[y];
+    for (size_t i = 0; i < span.weights.size(); i++) {
+      const float weight = span.weights[i];
+      const float* in =
+          narrowed.data() + static_cast<size_t>(span.first + i) * width * 4;
+      for (size_t c = 0; c < sum.size(); c++) {
+        sum[c] += in[c] * weight;
+      }
+    }
+    uint8_t* out = destination + static_cast<size_t>(y) * width * 4;
+    for (size_t x = 0; x < width; x++) {
+      const float* pixel = sum.data() + x * 4;
+      const float alpha = pixel[3];
+      if (alpha <= 0.0f) {
+        std::memset(out + x * 4, 0, 4);
+        continue;
+      }
+      out[x * 4] = to_byte(pixel[0] / alpha);
+      out[x * 4 + 1] = to_byte(pixel[1] / alpha);
+      out[x * 4 + 2] = to_byte(pixel[2] / alpha);
+      out[x * 4 + 3] = to_byte(alpha);
+    }
+  }
+  return result;
+}
+
+std::optional<std::string> EncodePng(const RgbaImage& image) {
+#if defined(ENABLE_PNG)
+  if (image.pixels.size() !=
+      static_cast<size_t>(image.width) * image.height * 4) {
+    return std::nullopt;
+  }
+  png_image png{};
+  png.version = PNG_IMAGE_VERSION;
+  png.width = image.width;
+  png.height = image.height;
+  png.format = PNG_FORMAT_RGBA;
+
+  // Sized for the worst case so the image is compressed only once.
+  std::string encoded(PNG_IMAGE_PNG_SIZE_MAX(png), '\0');
+  png_alloc_size_t size = encoded.size();
+  if (!png_image_write_to_memory(&png, encoded.data(), &size, 0,
+                                 image.pixels.data(), 0, nullptr)) {
+    spdlog::error("[ImageCodec] Failed to encode PNG: {}", png.message);
+    return std::nullopt;
+  }
+  encoded.resize(size);
+  return encoded;
+#else
+  (void)image;
+  return std::nullopt;
+#endif
+}
+
+}  // namespace flatpak_plugin
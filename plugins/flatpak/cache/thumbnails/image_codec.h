@@ -0,0 +1,116 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_CACHE_IMAGE_CODEC_H
+#define PLUGINS_FLATPAK_CACHE_IMAGE_CODEC_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace flatpak_plugin {
+
+/**
+ * @brief A decoded image: 8-bit RGBA with straight alpha, rows top to bottom
+ * without padding.
+ */
+struct RgbaImage {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  std::string pixels;
+};
+
+/**
+ * @enum ImageFormat
+ * @brief Encoded image formats recognized by their signature.
+ */
+enum class ImageFormat { UNKNOWN, PNG, JPEG };
+
+/**
+ * @brief Detects the format of encoded image data from its first bytes.
+ */
+ImageFormat DetectImageFormat(std::string_view data);
+
+/**
+ * @brief Whether images of |format| can be decoded in this build (PNG needs
+ * ENABLE_PNG, JPEG needs ENABLE_JPEG).
+ */
+bool CanDecodeImage(ImageFormat format);
+
+/**
+ * @brief Whether EncodePng() is available in this build.
+ */
+bool CanEncodePng();
+
+/**
+ * @brief Computes the size of an image scaled down to fit a bounding box
+ * with its aspect ratio kept. Images are never scaled up.
+ * @param width Source width
+ * @param height Source height
+ * @param max_width Box width; zero leaves the width unbounded
+ * @param max_height Box height; zero leaves the height unbounded
+ * @return The scaled width and height, at least 1x1
+ */
+std::pair<uint32_t, uint32_t> FitWithin(uint32_t width,
+                                        uint32_t height,
+                                        uint32_t max_width,
+                                        uint32_t max_height);
+
+/**
+ * @brief Decodes a PNG or JPEG image to RGBA.
+ *
+ * When a bounding box is given, JPEG images are decoded at the smallest DCT
+ * scale (1/2, 1/4 or 1/8) that is still at least as large as the image
+ * scaled to fit the box, which skips most of the decoding work for
+ * thumbnails. Images above 64 megapixels are rejected.
+ * @param data Encoded image
+ * @param max_width Width of the box the image will be scaled to; zero for
+ * no limit
+ * @param max_height Height of that box; zero for no limit
+ * @return The decoded image, or std::nullopt if the data is corrupt or the
+ * format cannot be decoded
+ */
+std::optional<RgbaImage> DecodeImage(std::string_view data,
+                                     uint32_t max_width = 0,
+                                     uint32_t max_height = 0);
+
+/**
+ * @brief Scales an image down to fit a bounding box by area averaging.
+ *
+ * Every destination pixel is the coverage-weighted mean of the source
+ * pixels under it, computed on premultiplied alpha so transparent pixels do
+ * not bleed their color into the edges of icons.
+ * @param image Source image
+ * @param max_width Box width; zero leaves the width unbounded
+ * @param max_height Box height; zero leaves the height unbounded
+ * @return The scaled image, or a copy if it already fits
+ */
+RgbaImage ResizeImage(const RgbaImage& image,
+                      uint32_t max_width,
+                      uint32_t max_height);
+
+/**
+ * @brief Encodes an image as PNG.
+ * @return The PNG data, or std::nullopt if encoding failed or PNG support
+ * is not built in
+ */
+std::optional<std::string> EncodePng(const RgbaImage& image);
+
+}  // namespace flatpak_plugin
+
+#endif  // PLUGINS_FLATPAK_CACHE_IMAGE_CODEC_H
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "thumbnail_channel.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <flutter/method_channel.h>
+#include <flutter/standard_method_codec.h>
+
+#include "thumbnail_service.h"
+
+namespace flatpak_plugin {
+
+namespace {
+
+const flutter::EncodableValue* Find(const flutter::EncodableMap& map,
+                                    const char* key) {
+  const auto it = map.find(flutter::EncodableValue(key));
+  return it == map.end() ? nullptr : &it->second;
+}
+
+// Dart ints arrive as int32 or int64 depending on their value.
+std::optional<int64_t> GetInt(const flutter::EncodableMap& map,
+                              const char* key) {
+  const auto* value = Find(map, key);
+  if (!value) {
+    return std::nullopt;
+  }
+  if (const auto* small = std::get_if<int32_t>(value)) {
+    return *small;
+  }
+  if (const auto* large = std::get_if<int64_t>(value)) {
+    return *large;
+  }
+  return std::nullopt;
+}
+
+std::optional<ThumbnailRequest> ParseRequest(
+    const flutter::EncodableValue* arguments) {
+  const auto* map =
+      arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+  if (!map) {
+    return std::nullopt;
+  }
+  const auto* source = Find(*map, "source");
+  const auto width = GetInt(*map, "width");
+  const auto height = GetInt(*map, "height");
+  if (!source || !std::holds_alternative<std::string>(*source) || !width ||
+      !height || *width < 0 || *height < 0 || *width > UINT32_MAX ||
+      *height > UINT32_MAX) {
+    return std::nullopt;
+  }
+
+  ThumbnailRequest request{std::get<std::string>(*source),
+                           static_cast<uint32_t>(*width),
+                           static_cast<uint32_t>(*height)};
+  if (const auto* format = Find(*map, "format")) {
+    const auto* name = std::get_if<std::string>(format);
+    if (name && *name == "png") {
+      request.format = ThumbnailFormat::PNG;
+    } else if (!name || *name != "rgba") {
+      return std::nullopt;
+    }
+  }
+  return request;
+}
+
+flutter::EncodableValue ToEncodable(const Thumbnail& thumbnail) {
+  const auto* data = reinterpret_cast<const uint8_t*>(thumbnail.data.data());
+  return flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("width"),
+       flutter::EncodableValue(static_cast<int64_t>(thumbnail.width))},
+      {flutter::EncodableValue("height"),
+       flutter::EncodableValue(static_cast<int64_t>(thumbnail.height))},
+      {flutter::EncodableValue("format"),
+       flutter::EncodableValue(
+           thumbnail.format == ThumbnailFormat::PNG ? "png" : "rgba")},
+      {flutter::EncodableValue("data"),
+       flutter::EncodableValue(
+           std::vector<uint8_t>(data, data + thumbnail.data.size()))},
+  });
+}
+
+}  // namespace
+
+ThumbnailChannel::ThumbnailChannel(flutter::BinaryMessenger* messenger,
+                                   ThumbnailService* service)
+    : channel_(std::make_unique<flutter::MethodChannel<>>(
+          messenger,
+          "flatpak_plugin/thumbnails",
+          &flutter::StandardMethodCodec::GetInstance())) {
+  channel_->SetMethodCallHandler(
+      [service](const flutter::MethodCall<>& call,
+                std::unique_ptr<flutter::MethodResult<>> result) {
+        if (call.method_name() != "getThumbnail") {
+          result->NotImplemented();
+          return;
+        }
+        auto request = ParseRequest(call.arguments());
+        if (!request) {
+          result->Error("INVALID_ARGUMENTS",
+                        "Expected source, width and height");
+          return;
+        }
+        // std::function needs a copyable callable.
+        std::shared_ptr<flutter::MethodResult<>> reply = std::move(result);
+        service->Submit(
+            *request, [reply, source = request->source](
+                          const ThumbnailService::ThumbnailPtr& thumbnail) {
+              if (thumbnail) {
+                reply->Success(ToEncodable(*thumbnail));
+              } else {
+                reply->Error("UNAVAILABLE", "Failed to load image: " + source);
+              }
+            });
+      });
+}
+
+ThumbnailChannel::~ThumbnailChannel() {
+  channel_->SetMethodCallHandler(nullptr);
+}
+
+}  // namespace flatpak_plugin
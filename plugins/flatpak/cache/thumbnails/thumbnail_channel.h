@@ -0,0 +1,64 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_CACHE_THUMBNAIL_CHANNEL_H
+#define PLUGINS_FLATPAK_CACHE_THUMBNAIL_CHANNEL_H
+
+#include <memory>
+
+#include <flutter/encodable_value.h>
+
+namespace flutter {
+class BinaryMessenger;
+template <typename T>
+class MethodChannel;
+}  // namespace flutter
+
+namespace flatpak_plugin {
+
+class ThumbnailService;
+
+/**
+ * @brief Serves thumbnails on the "flatpak_plugin/thumbnails" method
+ * channel.
+ *
+ * "getThumbnail" takes a map with "source" (URL or path), "width" and
+ * "height" of the bounding box and an optional "format" of "rgba" (default)
+ * or "png". It answers with a map of "width", "height", "format" and the
+ * "data" bytes, or an "UNAVAILABLE" error if the image could not be loaded.
+ * Replies are sent from the service's worker threads.
+ */
+class ThumbnailChannel {
+ public:
+  /**
+   * @param messenger Messenger to register the channel with
+   * @param service Service to answer from; must outlive the channel
+   */
+  ThumbnailChannel(flutter::BinaryMessenger* messenger,
+                   ThumbnailService* service);
+
+  ~ThumbnailChannel();
+
+  ThumbnailChannel(const ThumbnailChannel&) = delete;
+  ThumbnailChannel& operator=(const ThumbnailChannel&) = delete;
+
+ private:
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> channel_;
+};
+
+}  // namespace flatpak_plugin
+
+#endif  // PLUGINS_FLATPAK_CACHE_THUMBNAIL_CHANNEL_H
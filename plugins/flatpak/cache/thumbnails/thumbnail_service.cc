@@ -0,0 +1,367 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "thumbnail_service.h"
+
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include "image_codec.h"
+
+namespace flatpak_plugin {
+
+namespace {
+
+// Stored thumbnails start with a version, the format, and the width and
+// height as little-endian uint32.
+constexpr uint8_t kThumbnailVersion = 1;
+constexpr size_t kHeaderSize = 10;
+
+constexpr std::string_view kFileScheme = "file://";
+
+bool IsRemote(const std::string& source) {
+  return source.rfind("http://", 0) == 0 || source.rfind("https://", 0) == 0;
+}
+
+void PutUint32(std::string& buffer, const uint32_t value) {
+  for (size_t i = 0; i < sizeof(value); i++) {
+    buffer.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+uint32_t GetUint32(const char* data) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < sizeof(value); i++) {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+ThumbnailService::ThumbnailService(ICacheStorage* storage,
+                                   std::unique_ptr<INetworkFetcher> fetcher,
+                                   const size_t threads,
+                                   const std::chrono::seconds ttl,
+                                   const size_t memory_cache_bytes)
+    : storage_(storage),
+      fetcher_(std::move(fetcher)),
+      ttl_(ttl),
+      memory_cache_(memory_cache_bytes > 0
+                        ? std::make_unique<MemoryCache>(memory_cache_bytes)
+                        : nullptr),
+      workers_(std::max<size_t>(threads, 1)) {}
+
+ThumbnailService::~ThumbnailService() {
+  stopping_.store(true);
+  // Fails downloads in flight while the workers can still take their
+  // callbacks.
+  std::lock_guard lock(fetch_mutex_);
+  fetcher_.reset();
+}
+
+std::string ThumbnailService::GetCacheKey(const ThumbnailRequest& request) {
+  return fmt::format("thumbnail:{}x{}:{}:{}", request.max_width,
+                     request.max_height,
+                     request.format == ThumbnailFormat::PNG ? "png" : "rgba",
+                     request.source);
+}
+
+std::string ThumbnailService::GetSourceKey(const std::string& source) {
+  return "thumbnail_source:" + source;
+}
+
+void ThumbnailService::Submit(const ThumbnailRequest& request,
+                              Callback callback) {
+  if (request.source.empty() ||
+      (request.format == ThumbnailFormat::PNG && !CanEncodePng())) {
+    callback(nullptr);
+    return;
+  }
+
+  auto key = GetCacheKey(request);
+  if (memory_cache_) {
+    if (auto thumbnail = memory_cache_->Get<ThumbnailPtr>(key)) {
+      callback(std::move(*thumbnail));
+      return;
+    }
+  }
+
+  {
+    std::lock_guard lock(pending_mutex_);
+    auto& waiting = pending_[key];
+    waiting.push_back(std::move(callback));
+    if (waiting.size() > 1) {
+      // Joins the job already queued for this thumbnail.
+      return;
+    }
+  }
+
+  workers_.Post([this, request, key = std::move(key)] {
+    RunStep(key, request.source, [&] { return Generate(request, key); });
+  });
+}
+
+ThumbnailService::ThumbnailPtr ThumbnailService::Get(
+    const ThumbnailRequest& request) {
+  auto promise = std::make_shared<std::promise<ThumbnailPtr>>();
+  auto future = promise->get_future();
+  Submit(request, [promise](ThumbnailPtr thumbnail) {
+    promise->set_value(std::move(thumbnail));
+  });
+  return future.get();
+}
+
+void ThumbnailService::Complete(const std::string& key,
+                                const ThumbnailPtr& thumbnail) {
+  std::vector<Callback> callbacks;
+  {
+    std::lock_guard lock(pending_mutex_);
+    if (const auto it = pending_.find(key); it != pending_.end()) {
+      callbacks = std::move(it->second);
+      pending_.erase(it);
+    }
+  }
+  for (const auto& callback : callbacks) {
+    callback(thumbnail);
+  }
+}
+
+void ThumbnailService::RunStep(
+    const std::string& key,
+    const std::string& source,
+    const std::function<std::optional<ThumbnailPtr>()>& step) {
+  std::optional<ThumbnailPtr> thumbnail = ThumbnailPtr();
+  try {
+    if (!stopping_.load()) {
+      thumbnail = step();
+    }
+  } catch (const std::exception& e) {
+    spdlog::error("[ThumbnailService] Failed to make thumbnail of {}: {}",
+                  source, e.what());
+    thumbnail = ThumbnailPtr();
+  }
+  if (thumbnail) {
+    Complete(key, *thumbnail);
+  }
+}
+
+std::optional<ThumbnailService::ThumbnailPtr> ThumbnailService::Generate(
+    const ThumbnailRequest& request,
+    const std::string& key) {
+  if (auto stored = ReadStored(key, false)) {
+    return Remember(key, std::move(stored));
+  }
+
+  if (!IsRemote(request.source)) {
+    const auto encoded = LoadFile(request.source);
+    return encoded ? Build(request, key, *encoded, std::nullopt)
+                   : ThumbnailPtr();
+  }
+
+  // Another size of the same image may have been made before.
+  const auto source_key = GetSourceKey(request.source);
+  if (const auto encoded = storage_->Retrieve(source_key)) {
+    return Build(request, key, *encoded, std::nullopt);
+  }
+
+  // An expired source is revalidated rather than downloaded again.
+  const auto validators = storage_->RetrieveValidators(source_key);
+  return Download(request, key,
+                  validators ? HttpValidators::Parse(*validators)
+                             : HttpValidators());
+}
+
+std::optional<ThumbnailService::ThumbnailPtr> ThumbnailService::Download(
+    const ThumbnailRequest& request,
+    const std::string& key,
+    const HttpValidators& validators) {
+  std::lock_guard lock(fetch_mutex_);
+  if (!fetcher_) {
+    return ThumbnailPtr();
+  }
+  fetcher_->FetchConditionalAsync(
+      request.source, {}, validators,
+      [this, request, key, validators](FetchResult result) {
+        // Decoding continues on a worker so the fetcher can move on.
+        workers_.Post([this, request, key, validators,
+                       result = std::move(result)]() mutable {
+          RunStep(key, request.source, [&] {
+            return OnDownloaded(request, key, validators, std::move(result));
+          });
+        });
+      });
+  return std::nullopt;
+}
+
+std::optional<ThumbnailService::ThumbnailPtr> ThumbnailService::OnDownloaded(
+    const ThumbnailRequest& request,
+    const std::string& key,
+    const HttpValidators& validators,
+    FetchResult result) {
+  if (result.IsNotModified() && !validators.IsEmpty()) {
+    // A 304 may carry new validators; the others stay as stored.
+    auto current = validators;
+    if (!result.validators.etag.empty()) {
+      current.etag = std::move(result.validators.etag);
+    }
+    if (!result.validators.last_modified.empty()) {
+      current.last_modified = std::move(result.validators.last_modified);
+    }
+    const auto expiry = std::chrono::system_clock::now() + ttl_;
+    if (storage_->ExtendExpiry(GetSourceKey(request.source), expiry,
+                               current.Serialize())) {
+      if (auto stale = ReadStored(key, true)) {
+        storage_->ExtendExpiry(key, expiry);
+        return Remember(key, std::move(stale));
+      }
+      if (const auto encoded =
+              storage_->RetrieveStale(GetSourceKey(request.source))) {
+        return Build(request, key, *encoded, std::nullopt);
+      }
+    }
+    // The stored source was removed meanwhile, e.g. by cleanup.
+    return Download(request, key, {});
+  }
+
+  if (!result.body) {
+    spdlog::error("[ThumbnailService] Failed to download {} ({})",
+                  request.source, result.status);
+    return ThumbnailPtr();
+  }
+  return Build(request, key, *result.body, result.validators);
+}
+
+ThumbnailService::ThumbnailPtr ThumbnailService::Build(
+    const ThumbnailRequest& request,
+    const std::string& key,
+    const std::string& encoded,
+    const std::optional<HttpValidators>& source_validators) {
+  auto decoded = DecodeImage(encoded, request.max_width, request.max_height);
+  if (!decoded) {
+    spdlog::error("[ThumbnailService] Failed to decode {}", request.source);
+    return nullptr;
+  }
+  const auto expiry = std::chrono::system_clock::now() + ttl_;
+  // Only images that decode are kept for other sizes.
+  if (source_validators) {
+    storage_->StoreWithValidators(
+        GetSourceKey(request.source), encoded, expiry,
+        source_validators->IsEmpty() ? std::string()
+                                     : source_validators->Serialize());
+  }
+
+  auto resized = ResizeImage(*decoded, request.max_width, request.max_height);
+  decoded.reset();
+
+  auto thumbnail = std::make_shared<Thumbnail>();
+  thumbnail->width = resized.width;
+  thumbnail->height = resized.height;
+  thumbnail->format = request.format;
+  if (request.format == ThumbnailFormat::PNG) {
+    auto png = EncodePng(resized);
+    if (!png) {
+      return nullptr;
+    }
+    thumbnail->data = std::move(*png);
+  } else {
+    thumbnail->data = std::move(resized.pixels);
+  }
+
+  storage_->Store(key, Serialize(*thumbnail), expiry);
+  return Remember(key, std::move(thumbnail));
+}
+
+ThumbnailService::ThumbnailPtr ThumbnailService::ReadStored(
+    const std::string& key,
+    const bool include_expired) {
+  ThumbnailPtr stored;
+  storage_->RetrieveInPlace(
+      key,
+      [&stored](const char* data, const size_t size) {
+        stored = Deserialize(data, size);
+      },
+      include_expired);
+  return stored;
+}
+
+ThumbnailService::ThumbnailPtr ThumbnailService::Remember(
+    const std::string& key,
+    ThumbnailPtr thumbnail) {
+  if (memory_cache_ && thumbnail) {
+    memory_cache_->Put(key, thumbnail, thumbnail->data.size(),
+                       std::chrono::system_clock::now() + ttl_);
+  }
+  return thumbnail;
+}
+
+std::optional<std::string> ThumbnailService::LoadFile(
+    const std::string& source) {
+  const std::string path = source.rfind(kFileScheme, 0) == 0
+                               ? source.substr(kFileScheme.size())
+                               : source;
+  if (path.empty() || path.front() != '/') {
+    spdlog::error("[ThumbnailService] Unsupported image source: {}", source);
+    return std::nullopt;
+  }
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    spdlog::error("[ThumbnailService] Failed to open {}", path);
+    return std::nullopt;
+  }
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+std::string ThumbnailService::Serialize(const Thumbnail& thumbnail) {
+  std::string buffer;
+  buffer.reserve(kHeaderSize + thumbnail.data.size());
+  buffer.push_back(static_cast<char>(kThumbnailVersion));
+  buffer.push_back(static_cast<char>(thumbnail.format));
+  PutUint32(buffer, thumbnail.width);
+  PutUint32(buffer, thumbnail.height);
+  buffer.append(thumbnail.data);
+  return buffer;
+}
+
+ThumbnailService::ThumbnailPtr ThumbnailService::Deserialize(
+    const char* data,
+    const size_t size) {
+  if (size < kHeaderSize ||
+      static_cast<uint8_t>(data[0]) != kThumbnailVersion) {
+    return nullptr;
+  }
+  auto thumbnail = std::make_shared<Thumbnail>();
+  thumbnail->format = static_cast<ThumbnailFormat>(data[1]);
+  thumbnail->width = GetUint32(data + 2);
+  thumbnail->height = GetUint32(data + 6);
+  thumbnail->data.assign(data + kHeaderSize, size - kHeaderSize);
+  if (thumbnail->format == ThumbnailFormat::RGBA &&
+      thumbnail->data.size() !=
+          static_cast<size_t>(thumbnail->width) * thumbnail->height * 4) {
+    return nullptr;
+  }
+  return thumbnail;
+}
+
+}  // namespace flatpak_plugin
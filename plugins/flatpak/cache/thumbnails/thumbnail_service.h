@@ -0,0 +1,205 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_CACHE_THUMBNAIL_SERVICE_H
+#define PLUGINS_FLATPAK_CACHE_THUMBNAIL_SERVICE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <flutter/encodable_value.h>
+
+#include "flatpak/cache/interfaces/cache_storage.h"
+#include "flatpak/cache/interfaces/network_fetcher.h"
+#include "flatpak/cache/storage/memory_cache.h"
+#include "plugins/flatpak/worker_pool.h"
+
+namespace flatpak_plugin {
+
+/**
+ * @enum ThumbnailFormat
+ * @brief Pixel format of a thumbnail.
+ * - RGBA: Raw 8-bit RGBA rows, ready for a texture upload.
+ * - PNG: PNG encoded; needs PNG support in the build.
+ */
+enum class ThumbnailFormat : uint8_t { RGBA = 0, PNG = 1 };
+
+/**
+ * @struct ThumbnailRequest
+ * @brief An image to scale down to fit a bounding box.
+ * @var source An http(s) URL, a file:// URL or an absolute path, e.g. the
+ * URL of a screenshot Image or the path of a cached Icon.
+ * @var max_width Box width in pixels; zero for no limit.
+ * @var max_height Box height in pixels; zero for no limit.
+ * @var format Format of the returned data.
+ */
+struct ThumbnailRequest {
+  std::string source;
+  uint32_t max_width = 0;
+  uint32_t max_height = 0;
+  ThumbnailFormat format = ThumbnailFormat::RGBA;
+};
+
+/**
+ * @struct Thumbnail
+ * @brief A scaled image. Its size fits the requested box with the aspect
+ * ratio of the source kept; images are never scaled up.
+ */
+struct Thumbnail {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  ThumbnailFormat format = ThumbnailFormat::RGBA;
+  std::string data;
+};
+
+/**
+ * @brief Downloads, decodes and scales app icons and screenshots on a worker
+ * pool and caches the results.
+ *
+ * Lookups go through three tiers: an in-process LRU of finished thumbnails,
+ * the thumbnails in the cache storage, and the downloaded source images in
+ * the cache storage, so another size of the same image is made without
+ * downloading it again. Concurrent requests for the same thumbnail share one
+ * job. Local files are read from disk and not copied into the storage.
+ *
+ * Downloads go through the fetcher's asynchronous API, so no worker is held
+ * while a download or its retry backoff is pending; decoding and scaling run
+ * in parallel. An expired download is revalidated with the validators stored
+ * with it, and when the origin answers 304 Not Modified the stored source and
+ * thumbnail are kept for another TTL without decoding them again.
+ */
+class ThumbnailService {
+ public:
+  using ThumbnailPtr = std::shared_ptr<const Thumbnail>;
+  // Receives null if the image could not be loaded or decoded.
+  using Callback = std::function<void(ThumbnailPtr)>;
+
+  /**
+   * @param storage Shared cache storage, must be safe for concurrent use (as
+   * SQLiteCacheStorage is) and outlive the service
+   * @param fetcher Fetcher for http(s) sources, used by this service only;
+   * calls to it are serialized
+   * @param threads Number of decode workers
+   * @param ttl Time-to-live of stored thumbnails and source images
+   * @param memory_cache_bytes Budget of the in-process tier; zero disables it
+   */
+  ThumbnailService(ICacheStorage* storage,
+                   std::unique_ptr<INetworkFetcher> fetcher,
+                   size_t threads = 2,
+                   std::chrono::seconds ttl = std::chrono::hours(24 * 7),
+                   size_t memory_cache_bytes = 16 * 1024 * 1024);
+
+  /**
+   * @brief Answers queued requests and downloads in flight with null and
+   * waits for running ones.
+   */
+  ~ThumbnailService();
+
+  ThumbnailService(const ThumbnailService&) = delete;
+  ThumbnailService& operator=(const ThumbnailService&) = delete;
+
+  /**
+   * @brief Requests a thumbnail.
+   *
+   * A thumbnail in the in-process tier is passed to |callback| right away on
+   * the calling thread; otherwise |callback| runs on a worker thread.
+   * @param request The image and the size to scale it to
+   * @param callback Receives the thumbnail
+   */
+  void Submit(const ThumbnailRequest& request, Callback callback);
+
+  /**
+   * @brief Requests a thumbnail and waits for it. Must not be called from a
+   * callback, which runs on a worker.
+   */
+  ThumbnailPtr Get(const ThumbnailRequest& request);
+
+  /**
+   * @brief Gets the storage key of a thumbnail
+   */
+  static std::string GetCacheKey(const ThumbnailRequest& request);
+
+  /**
+   * @brief Gets the storage key of a downloaded source image
+   */
+  static std::string GetSourceKey(const std::string& source);
+
+ private:
+  // Runs a step of a job on a worker. Steps return the thumbnail to complete
+  // the job with, or std::nullopt if the job continues after a download.
+  void RunStep(const std::string& key,
+               const std::string& source,
+               const std::function<std::optional<ThumbnailPtr>()>& step);
+
+  std::optional<ThumbnailPtr> Generate(const ThumbnailRequest& request,
+                                       const std::string& key);
+
+  std::optional<ThumbnailPtr> Download(const ThumbnailRequest& request,
+                                       const std::string& key,
+                                       const HttpValidators& validators);
+
+  std::optional<ThumbnailPtr> OnDownloaded(const ThumbnailRequest& request,
+                                           const std::string& key,
+                                           const HttpValidators& validators,
+                                           FetchResult result);
+
+  // Decodes and scales |encoded|; stores it as the source image of the
+  // request unless |source_validators| is unset.
+  ThumbnailPtr Build(const ThumbnailRequest& request,
+                     const std::string& key,
+                     const std::string& encoded,
+                     const std::optional<HttpValidators>& source_validators);
+
+  ThumbnailPtr ReadStored(const std::string& key, bool include_expired);
+
+  ThumbnailPtr Remember(const std::string& key, ThumbnailPtr thumbnail);
+
+  static std::optional<std::string> LoadFile(const std::string& source);
+
+  void Complete(const std::string& key, const ThumbnailPtr& thumbnail);
+
+  static std::string Serialize(const Thumbnail& thumbnail);
+
+  static ThumbnailPtr Deserialize(const char* data, size_t size);
+
+  ICacheStorage* storage_;
+  // Guards |fetcher_|, which is released first on destruction.
+  std::mutex fetch_mutex_;
+  std::unique_ptr<INetworkFetcher> fetcher_;
+  const std::chrono::seconds ttl_;
+  std::unique_ptr<MemoryCache> memory_cache_;
+
+  // Callbacks waiting for a thumbnail, keyed by its storage key.
+  std::mutex pending_mutex_;
+  std::unordered_map<std::string, std::vector<Callback>> pending_;
+
+  std::atomic<bool> stopping_{false};
+
+  // Declared last so it is joined before the members above are destroyed.
+  WorkerPool workers_;
+};
+
+}  // namespace flatpak_plugin
+
+#endif  // PLUGINS_FLATPAK_CACHE_THUMBNAIL_SERVICE_H
@@ -31,8 +31,10 @@ Component::Component(const xmlNode* node, std::string language)
   for (xmlNode* current = node->children; current; current = current->next) {
     if (current->type == XML_ELEMENT_NODE) {
       std::string nodeName = reinterpret_cast<const char*>(current->name);
+      xmlChar* rawContent = xmlNodeGetContent(current);
       std::string content =
-          reinterpret_cast<const char*>(xmlNodeGetContent(current));
+          rawContent ? reinterpret_cast<const char*>(rawContent) : "";
+      xmlFree(rawContent);
 
       // Required fields
       if (nodeName == "id") {
@@ -105,6 +105,12 @@ class Component {
   static ContentRatingValue CharToRatingValue(const char* value);
 
  private:
+  // Restored field by field from an AppStream snapshot.
+  friend class AppstreamSnapshotReader;
+  friend class AppstreamSnapshotWriter;
+
+  Component() = default;
+
   void parseCategories(const xmlNode* node);
 
   void parseIcons(xmlNode* node);
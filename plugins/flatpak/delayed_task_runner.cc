@@ -0,0 +1,87 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "delayed_task_runner.h"
+
+#include "plugins/common/common.h"
+
+namespace flatpak_plugin {
+
+DelayedTaskRunner::DelayedTaskRunner()
+    : thread_(&DelayedTaskRunner::Run, this) {}
+
+DelayedTaskRunner::~DelayedTaskRunner() {
+  {
+    std::lock_guard lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void DelayedTaskRunner::Post(std::function<void()> task) {
+  PostDelayed(Clock::duration::zero(), std::move(task));
+}
+
+void DelayedTaskRunner::PostDelayed(const Clock::duration delay,
+                                    std::function<void()> task) {
+  {
+    std::lock_guard lock(mutex_);
+    tasks_.push({Clock::now() + delay, next_sequence_++, std::move(task)});
+  }
+  cv_.notify_one();
+}
+
+bool DelayedTaskRunner::RunsTasksOnCurrentThread() const {
+  return std::this_thread::get_id() == thread_.get_id();
+}
+
+void DelayedTaskRunner::Run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock lock(mutex_);
+      while (true) {
+        if (tasks_.empty()) {
+          if (stop_) {
+            return;
+          }
+          cv_.wait(lock);
+          continue;
+        }
+        if (stop_ || tasks_.top().due <= Clock::now()) {
+          break;
+        }
+        // Wakes up early when a task due sooner is posted.
+        cv_.wait_until(lock, tasks_.top().due);
+      }
+      // The queue only hands out const references; the task is moved out
+      // before it is popped.
+      task = std::move(const_cast<Task&>(tasks_.top()).run);
+      tasks_.pop();
+    }
+    try {
+      task();
+    } catch (const std::exception& e) {
+      spdlog::error("[FlatpakPlugin] Delayed task failed: {}", e.what());
+    }
+  }
+}
+
+}  // namespace flatpak_plugin
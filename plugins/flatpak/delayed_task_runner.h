@@ -0,0 +1,95 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef PLUGINS_FLATPAK_DELAYED_TASK_RUNNER_H
+#define PLUGINS_FLATPAK_DELAYED_TASK_RUNNER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace flatpak_plugin {
+
+/**
+ * \brief Single thread running tasks at a due time, in due-time order and
+ * FIFO among tasks due at the same time. Used to schedule retries without
+ * blocking the thread that asked for them.
+ */
+class DelayedTaskRunner {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  DelayedTaskRunner();
+
+  /**
+   * \brief Runs the tasks that are still queued right away, without waiting
+   * for their due time, then joins the thread.
+   */
+  ~DelayedTaskRunner();
+
+  DelayedTaskRunner(const DelayedTaskRunner&) = delete;
+  DelayedTaskRunner& operator=(const DelayedTaskRunner&) = delete;
+
+  /**
+   * \brief Queues a task to run as soon as possible.
+   * \param task The task to run on the runner thread.
+   */
+  void Post(std::function<void()> task);
+
+  /**
+   * \brief Queues a task to run once |delay| has passed.
+   * \param delay Time to wait before running the task.
+   * \param task The task to run on the runner thread.
+   */
+  void PostDelayed(Clock::duration delay, std::function<void()> task);
+
+  /**
+   * \brief Whether the caller is running on the runner thread.
+   */
+  bool RunsTasksOnCurrentThread() const;
+
+ private:
+  struct Task {
+    Clock::time_point due;
+    uint64_t sequence;
+    std::function<void()> run;
+  };
+
+  struct Later {
+    bool operator()(const Task& a, const Task& b) const {
+      return a.due != b.due ? a.due > b.due : a.sequence > b.sequence;
+    }
+  };
+
+  void Run();
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::priority_queue<Task, std::vector<Task>, Later> tasks_;
+  uint64_t next_sequence_ = 0;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+}  // namespace flatpak_plugin
+
+#endif  // PLUGINS_FLATPAK_DELAYED_TASK_RUNNER_H
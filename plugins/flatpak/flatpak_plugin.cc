@@ -20,6 +20,8 @@
 #include <sstream>
 #include <vector>
 
+#include <flutter/event_stream_handler_functions.h>
+#include <flutter/standard_method_codec.h>
 #include <zlib.h>
 #include <asio/post.hpp>
 
@@ -33,6 +35,7 @@ void FlatpakPlugin::RegisterWithRegistrar(flutter::PluginRegistrar* registrar) {
   auto plugin = std::make_unique<FlatpakPlugin>();
 
   SetUp(registrar->messenger(), plugin.get());
+  plugin->SetUpTransactionChannels(registrar->messenger());
 
   registrar->AddPlugin(std::move(plugin));
 }
@@ -40,7 +43,11 @@ void FlatpakPlugin::RegisterWithRegistrar(flutter::PluginRegistrar* registrar) {
 FlatpakPlugin::FlatpakPlugin()
     : io_context_(std::make_unique<asio::io_context>(ASIO_CONCURRENCY_HINT_1)),
       work_(io_context_->get_executor()),
-      strand_(std::make_unique<asio::io_context::strand>(*io_context_)) {
+      strand_(std::make_unique<asio::io_context::strand>(*io_context_)),
+      transactions_(std::make_unique<TransactionQueue>(
+          [this](flutter::EncodableMap event) {
+            SendTransactionEvent(std::move(event));
+          })) {
   thread_ = std::thread([&] { io_context_->run(); });
 
   asio::post(*strand_, [&]() {
@@ -61,6 +68,7 @@ FlatpakPlugin::FlatpakPlugin()
 }
 
 FlatpakPlugin::~FlatpakPlugin() {
+  transactions_.reset();
   io_context_->stop();
   if (thread_.joinable()) {
     thread_.join();
@@ -124,11 +132,19 @@ ErrorOr<flutter::EncodableList> FlatpakPlugin::GetApplicationsRemote(
 }
 
 ErrorOr<bool> FlatpakPlugin::ApplicationInstall(const std::string& id) {
-  return FlatpakShim::ApplicationInstall(id);
+  if (id.empty()) {
+    return ErrorOr<bool>(
+        FlutterError("INVALID_APP_ID", "Application ID is required"));
+  }
+  return transactions_->Run({id}, {});
 }
 
 ErrorOr<bool> FlatpakPlugin::ApplicationUninstall(const std::string& id) {
-  return FlatpakShim::ApplicationUninstall(id);
+  if (id.empty()) {
+    return ErrorOr<bool>(
+        FlutterError("INVALID_APP_ID", "Application ID is required"));
+  }
+  return transactions_->Run({}, {id});
 }
 
 ErrorOr<bool> FlatpakPlugin::ApplicationStart(
@@ -141,4 +157,92 @@ ErrorOr<bool> FlatpakPlugin::ApplicationStop(const std::string& id) {
   return FlatpakShim::ApplicationStop(id);
 }
 
+void FlatpakPlugin::SetUpTransactionChannels(
+    flutter::BinaryMessenger* messenger) {
+  transaction_channel_ = std::make_unique<flutter::MethodChannel<>>(
+      messenger, "flatpak_plugin/transactions",
+      &flutter::StandardMethodCodec::GetInstance());
+  transaction_channel_->SetMethodCallHandler(
+      [this](const flutter::MethodCall<>& call,
+             std::unique_ptr<flutter::MethodResult<>> result) {
+        HandleTransactionCall(call, std::move(result));
+      });
+
+  transaction_event_channel_ = std::make_unique<flutter::EventChannel<>>(
+      messenger, "flatpak_plugin/transaction_events",
+      &flutter::StandardMethodCodec::GetInstance());
+  transaction_event_channel_->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<>>(
+          [this](const flutter::EncodableValue* /* arguments */,
+                 std::unique_ptr<flutter::EventSink<>>&& events)
+              -> std::unique_ptr<flutter::StreamHandlerError<>> {
+            std::lock_guard lock(event_sink_mutex_);
+            event_sink_ = std::move(events);
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* /* arguments */)
+              -> std::unique_ptr<flutter::StreamHandlerError<>> {
+            std::lock_guard lock(event_sink_mutex_);
+            event_sink_.reset();
+            return nullptr;
+          }));
+}
+
+// "submit" takes a map with "install" and/or "uninstall" lists of
+// application ids or refs and answers with the transaction id right away.
+// "cancel" takes the transaction id.
+void FlatpakPlugin::HandleTransactionCall(
+    const flutter::MethodCall<>& call,
+    std::unique_ptr<flutter::MethodResult<>> result) {
+  const auto* arguments =
+      std::get_if<flutter::EncodableMap>(call.arguments());
+  if (call.method_name() == "submit") {
+    const auto get_ids = [arguments](const char* key) {
+      std::vector<std::string> ids;
+      if (!arguments) {
+        return ids;
+      }
+      const auto it = arguments->find(flutter::EncodableValue(key));
+      if (it == arguments->end()) {
+        return ids;
+      }
+      if (const auto* list = std::get_if<flutter::EncodableList>(&it->second)) {
+        for (const auto& value : *list) {
+          if (const auto* id = std::get_if<std::string>(&value);
+              id && !id->empty()) {
+            ids.push_back(*id);
+          }
+        }
+      }
+      return ids;
+    };
+    auto install = get_ids("install");
+    auto uninstall = get_ids("uninstall");
+    if (install.empty() && uninstall.empty()) {
+      result->Error("INVALID_APP_ID", "Application ID is required");
+      return;
+    }
+    result->Success(flutter::EncodableValue(
+        transactions_->Submit(std::move(install), std::move(uninstall))));
+  } else if (call.method_name() == "cancel") {
+    const auto* id = std::get_if<int64_t>(call.arguments());
+    const auto* small_id = std::get_if<int32_t>(call.arguments());
+    if (!id && !small_id) {
+      result->Error("INVALID_TRANSACTION_ID", "Transaction id is required");
+      return;
+    }
+    result->Success(
+        flutter::EncodableValue(transactions_->Cancel(id ? *id : *small_id)));
+  } else {
+    result->NotImplemented();
+  }
+}
+
+void FlatpakPlugin::SendTransactionEvent(flutter::EncodableMap event) {
+  std::lock_guard lock(event_sink_mutex_);
+  if (event_sink_) {
+    event_sink_->Success(flutter::EncodableValue(std::move(event)));
+  }
+}
+
 }  // namespace flatpak_plugin
\ No newline at end of file
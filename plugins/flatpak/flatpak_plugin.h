@@ -17,13 +17,17 @@
 #ifndef FLUTTER_PLUGIN_FLATPAK_PLUGIN_H
 #define FLUTTER_PLUGIN_FLATPAK_PLUGIN_H
 
+#include <mutex>
 #include <thread>
 
+#include <flutter/event_channel.h>
+#include <flutter/method_channel.h>
 #include <flutter/plugin_registrar.h>
 #include <asio/io_context_strand.hpp>
 
 #include "flatpak_shim.h"
 #include "messages.g.h"
+#include "transaction_queue.h"
 
 namespace flatpak_plugin {
 class FlatpakPlugin final : public flutter::Plugin, public FlatpakApi {
@@ -65,7 +69,8 @@ class FlatpakPlugin final : public flutter::Plugin, public FlatpakApi {
   ErrorOr<flutter::EncodableList> GetApplicationsRemote(
       const std::string& id) override;
 
-  // Install application of given id.
+  // Install application of given id. Runs as a queued transaction whose
+  // progress is streamed on the transaction event channel.
   ErrorOr<bool> ApplicationInstall(const std::string& id) override;
 
   // Uninstall application with specified id.
@@ -85,12 +90,30 @@ class FlatpakPlugin final : public flutter::Plugin, public FlatpakApi {
   FlatpakPlugin& operator=(const FlatpakPlugin&) = delete;
 
  private:
+  // Registers the "flatpak_plugin/transactions" method channel, which
+  // queues batched transactions without blocking the caller, and the
+  // "flatpak_plugin/transaction_events" event channel reporting them.
+  void SetUpTransactionChannels(flutter::BinaryMessenger* messenger);
+
+  void HandleTransactionCall(
+      const flutter::MethodCall<>& call,
+      std::unique_ptr<flutter::MethodResult<>> result);
+
+  void SendTransactionEvent(flutter::EncodableMap event);
+
   std::string name_;
   std::thread thread_;
   pthread_t pthread_self_;
   std::unique_ptr<asio::io_context> io_context_;
   asio::executor_work_guard<decltype(io_context_->get_executor())> work_;
   std::unique_ptr<asio::io_context::strand> strand_;
+
+  std::unique_ptr<flutter::MethodChannel<>> transaction_channel_;
+  std::unique_ptr<flutter::EventChannel<>> transaction_event_channel_;
+  std::mutex event_sink_mutex_;
+  std::unique_ptr<flutter::EventSink<>> event_sink_;
+  // Declared last: its worker may still send events while it is destroyed.
+  std::unique_ptr<TransactionQueue> transactions_;
 };
 }  // namespace flatpak_plugin
 
@@ -16,7 +16,11 @@
 
 #include "flatpak_shim.h"
 
+#include <condition_variable>
+#include <cstring>
 #include <filesystem>
+#include <memory>
+#include <mutex>
 
 #include <libxml/tree.h>
 #include <libxml/xmlstring.h>
@@ -34,8 +38,266 @@
 #include "component.h"
 #include "cxxopts/include/cxxopts.hpp"
 #include "messages.g.h"
+#include "worker_pool.h"
 
 namespace flatpak_plugin {
+
+namespace {
+
+// Remote queries are network bound, so a few workers cover typical setups.
+constexpr size_t kRemoteWorkers = 4;
+constexpr auto kRemoteTimeout = std::chrono::seconds(20);
+
+WorkerPool& remote_pool() {
+  static WorkerPool pool(kRemoteWorkers);
+  return pool;
+}
+
+template <typename Result>
+using RemoteTask = std::function<
+    Result(FlatpakInstallation*, const std::string&, GCancellable*)>;
+
+// Runs |task| for every remote on the pool and waits for all of them. Each
+// remote gets |timeout| from the moment its task starts running, so time
+// spent queued behind other lookups on the shared pool does not count.
+// Remotes that did not answer in time are cancelled and yield std::nullopt;
+// their late results are discarded. |task| may still be running after this
+// returns, so it must own everything it captures.
+template <typename Result>
+std::vector<std::optional<Result>> for_each_remote(
+    FlatpakInstallation* installation,
+    const std::vector<std::string>& remotes,
+    const RemoteTask<Result>& task,
+    const std::chrono::milliseconds timeout = kRemoteTimeout) {
+  using Clock = std::chrono::steady_clock;
+
+  struct Batch {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::optional<Clock::time_point>> started;
+    std::vector<bool> done;
+    std::vector<std::optional<Result>> results;
+    std::vector<GCancellable*> cancellables;
+
+    ~Batch() {
+      for (auto* cancellable : cancellables) {
+        g_object_unref(cancellable);
+      }
+    }
+  };
+
+  auto batch = std::make_shared<Batch>();
+  batch->started.resize(remotes.size());
+  batch->done.resize(remotes.size());
+  batch->results.resize(remotes.size());
+  for (size_t i = 0; i < remotes.size(); i++) {
+    batch->cancellables.push_back(g_cancellable_new());
+  }
+
+  for (size_t i = 0; i < remotes.size(); i++) {
+    g_object_ref(installation);
+    remote_pool().Post([batch, i, installation, remote = remotes[i], task] {
+      {
+        std::lock_guard lock(batch->mutex);
+        batch->started[i] = Clock::now();
+      }
+      batch->cv.notify_all();
+
+      std::optional<Result> result;
+      try {
+        result = task(installation, remote, batch->cancellables[i]);
+      } catch (const std::exception& e) {
+        spdlog::error("[FlatpakPlugin] Query of remote '{}' failed: {}",
+                      remote, e.what());
+      }
+      g_object_unref(installation);
+      {
+        std::lock_guard lock(batch->mutex);
+        batch->results[i] = std::move(result);
+        batch->done[i] = true;
+      }
+      batch->cv.notify_all();
+    });
+  }
+
+  std::vector<bool> abandoned(remotes.size());
+  std::unique_lock lock(batch->mutex);
+  while (true) {
+    const auto now = Clock::now();
+    bool waiting = false;
+    std::optional<Clock::time_point> next_deadline;
+    for (size_t i = 0; i < remotes.size(); i++) {
+      if (batch->done[i] || abandoned[i]) {
+        continue;
+      }
+      if (batch->started[i]) {
+        const auto deadline = *batch->started[i] + timeout;
+        if (deadline <= now) {
+          spdlog::warn(
+              "[FlatpakPlugin] Remote '{}' did not answer within {} ms",
+              remotes[i], timeout.count());
+          g_cancellable_cancel(batch->cancellables[i]);
+          abandoned[i] = true;
+          continue;
+        }
+        if (!next_deadline || deadline < *next_deadline) {
+          next_deadline = deadline;
+        }
+      }
+      waiting = true;
+    }
+    if (!waiting) {
+      break;
+    }
+    // Queued tasks have no deadline yet; their start wakes us up.
+    if (next_deadline) {
+      batch->cv.wait_until(lock, *next_deadline);
+    } else {
+      batch->cv.wait(lock);
+    }
+  }
+
+  std::vector<std::optional<Result>> results(remotes.size());
+  for (size_t i = 0; i < remotes.size(); i++) {
+    if (batch->done[i]) {
+      results[i] = batch->results[i];
+    }
+  }
+  return results;
+}
+
+std::vector<std::string> get_enabled_remote_names(
+    FlatpakInstallation* installation) {
+  std::vector<std::string> names;
+  GError* error = nullptr;
+  auto remotes =
+      flatpak_installation_list_remotes(installation, nullptr, &error);
+  if (error) {
+    spdlog::error("[FlatpakPlugin] Error getting remotes: {}", error->message);
+    g_clear_error(&error);
+    return names;
+  }
+  for (guint i = 0; i < remotes->len; i++) {
+    auto remote = static_cast<FlatpakRemote*>(g_ptr_array_index(remotes, i));
+    if (!flatpak_remote_get_disabled(remote)) {
+      names.emplace_back(flatpak_remote_get_name(remote));
+    }
+  }
+  g_ptr_array_unref(remotes);
+  return names;
+}
+
+// Minimum interval between progress reports of one operation.
+constexpr guint kProgressUpdateMs = 250;
+
+// Per-run state shared by the transaction signal handlers. All signals are
+// emitted on the thread running the transaction.
+struct TransactionState {
+  const TransactionProgressCallback* on_progress = nullptr;
+  TransactionProgress progress;
+  size_t started = 0;
+  gint64 operation_start = 0;
+};
+
+void report_progress(const TransactionState* state) {
+  if (state->on_progress && *state->on_progress) {
+    (*state->on_progress)(state->progress);
+  }
+}
+
+void on_transaction_progress_changed(FlatpakTransactionProgress* progress,
+                                     const gpointer user_data) {
+  auto* state = static_cast<TransactionState*>(user_data);
+  auto& snapshot = state->progress;
+  snapshot.percent = flatpak_transaction_progress_get_progress(progress);
+  snapshot.bytes_transferred =
+      flatpak_transaction_progress_get_bytes_transferred(progress);
+  char* status = flatpak_transaction_progress_get_status(progress);
+  snapshot.status = status ? status : "";
+  g_free(status);
+
+  snapshot.eta_seconds = -1;
+  if (!flatpak_transaction_progress_get_is_estimating(progress) &&
+      snapshot.percent > 0 && snapshot.percent < 100) {
+    const gint64 elapsed = g_get_monotonic_time() - state->operation_start;
+    snapshot.eta_seconds = elapsed * (100 - snapshot.percent) /
+                           snapshot.percent / G_USEC_PER_SEC;
+  }
+  report_progress(state);
+}
+
+void on_transaction_new_operation(FlatpakTransaction* transaction,
+                                  FlatpakTransactionOperation* operation,
+                                  FlatpakTransactionProgress* progress,
+                                  const gpointer user_data) {
+  auto* state = static_cast<TransactionState*>(user_data);
+  auto& snapshot = state->progress;
+  if (state->started == 0) {
+    GList* operations = flatpak_transaction_get_operations(transaction);
+    snapshot.operation_count = g_list_length(operations);
+    g_list_free_full(operations, g_object_unref);
+  }
+  snapshot.operation = state->started++;
+  snapshot.ref = flatpak_transaction_operation_get_ref(operation);
+  snapshot.kind = flatpak_transaction_operation_type_to_string(
+      flatpak_transaction_operation_get_operation_type(operation));
+  snapshot.percent = 0;
+  snapshot.bytes_transferred = 0;
+  snapshot.eta_seconds = -1;
+  snapshot.status.clear();
+  state->operation_start = g_get_monotonic_time();
+
+  spdlog::info("[FlatpakPlugin] Transaction operation {}/{}: {} {}",
+               snapshot.operation + 1, snapshot.operation_count,
+               snapshot.kind, snapshot.ref);
+  if (state->on_progress && *state->on_progress) {
+    flatpak_transaction_progress_set_update_frequency(progress,
+                                                      kProgressUpdateMs);
+    g_signal_connect(progress, "changed",
+                     G_CALLBACK(on_transaction_progress_changed), state);
+  }
+  report_progress(state);
+}
+
+void on_transaction_operation_done(FlatpakTransaction* /* transaction */,
+                                   FlatpakTransactionOperation* /* operation */,
+                                   const char* /* commit */,
+                                   FlatpakTransactionResult /* result */,
+                                   const gpointer user_data) {
+  auto* state = static_cast<TransactionState*>(user_data);
+  state->progress.percent = 100;
+  state->progress.eta_seconds = 0;
+  report_progress(state);
+}
+
+gboolean on_transaction_operation_error(
+    FlatpakTransaction* /* transaction */,
+    FlatpakTransactionOperation* operation,
+    const GError* error,
+    const FlatpakTransactionErrorDetails details,
+    gpointer /* user_data */) {
+  const bool non_fatal = details & FLATPAK_TRANSACTION_ERROR_DETAILS_NON_FATAL;
+  spdlog::error("[FlatpakPlugin] Transaction operation {} failed{}: {}",
+                flatpak_transaction_operation_get_ref(operation),
+                non_fatal ? " (ignored)" : "", error->message);
+  // Returning FALSE aborts the remaining operations.
+  return non_fatal;
+}
+
+// The installation handles are shared for the life of the process, so their
+// cached remotes and refs are reloaded before each use to pick up changes
+// made outside it, e.g. by the flatpak CLI.
+void drop_installation_caches(FlatpakInstallation* installation) {
+  GError* error = nullptr;
+  if (!flatpak_installation_drop_caches(installation, nullptr, &error)) {
+    spdlog::warn("[FlatpakPlugin] Failed to drop installation caches: {}",
+                 error ? error->message : "unknown error");
+    g_clear_error(&error);
+  }
+}
+
+}  // namespace
+
 std::optional<std::string> FlatpakShim::getOptionalAttribute(
     const xmlNode* node,
     const char* attrName) {
@@ -161,16 +423,47 @@ void FlatpakShim::PrintComponent(const Component& component) {
   }
 }
 
+FlatpakInstallation* FlatpakShim::get_user_installation(GError** error) {
+  static std::mutex mutex;
+  static FlatpakInstallation* installation = nullptr;
+
+  std::lock_guard lock(mutex);
+  if (!installation) {
+    installation = flatpak_installation_new_user(nullptr, error);
+    if (!installation) {
+      return nullptr;
+    }
+  } else {
+    drop_installation_caches(installation);
+  }
+  return static_cast<FlatpakInstallation*>(g_object_ref(installation));
+}
+
 GPtrArray* FlatpakShim::get_system_installations() {
-  GError* error = nullptr;
-  const auto sys_installs = flatpak_get_system_installations(nullptr, &error);
-  if (error) {
-    spdlog::error("[FlatpakPlugin] Error getting system installations: {}",
-                  error->message);
-    g_ptr_array_unref(sys_installs);
-    g_clear_error(&error);
+  static std::mutex mutex;
+  static GPtrArray* sys_installs = nullptr;
+
+  std::lock_guard lock(mutex);
+  if (!sys_installs) {
+    GError* error = nullptr;
+    sys_installs = flatpak_get_system_installations(nullptr, &error);
+    if (error) {
+      spdlog::error("[FlatpakPlugin] Error getting system installations: {}",
+                    error->message);
+      g_clear_error(&error);
+      if (sys_installs) {
+        g_ptr_array_unref(sys_installs);
+        sys_installs = nullptr;
+      }
+      return nullptr;
+    }
+  } else {
+    for (guint i = 0; i < sys_installs->len; i++) {
+      drop_installation_caches(static_cast<FlatpakInstallation*>(
+          g_ptr_array_index(sys_installs, i)));
+    }
   }
-  return sys_installs;
+  return sys_installs ? g_ptr_array_ref(sys_installs) : nullptr;
 }
 
 GPtrArray* FlatpakShim::get_remotes(FlatpakInstallation* installation) {
@@ -516,23 +809,30 @@ void FlatpakShim::get_application_list(
 ErrorOr<flutter::EncodableList> FlatpakShim::GetApplicationsInstalled() {
   flutter::EncodableList application_list;
   GError* error = nullptr;
-  auto installation = flatpak_installation_new_user(nullptr, &error);
-  get_application_list(installation, application_list);
-
-  const auto system_installations = get_system_installations();
-  for (size_t i = 0; i < system_installations->len; i++) {
-    installation = static_cast<FlatpakInstallation*>(
-        g_ptr_array_index(system_installations, i));
+  if (auto installation = get_user_installation(&error)) {
     get_application_list(installation, application_list);
+    g_object_unref(installation);
+  } else {
+    spdlog::error("[FlatpakPlugin] Failed to get user installation: {}",
+                  error ? error->message : "unknown error");
+    g_clear_error(&error);
+  }
+
+  if (const auto system_installations = get_system_installations()) {
+    for (size_t i = 0; i < system_installations->len; i++) {
+      const auto installation = static_cast<FlatpakInstallation*>(
+          g_ptr_array_index(system_installations, i));
+      get_application_list(installation, application_list);
+    }
+    g_ptr_array_unref(system_installations);
   }
-  g_ptr_array_unref(system_installations);
 
   return ErrorOr<flutter::EncodableList>(std::move(application_list));
 }
 
 ErrorOr<Installation> FlatpakShim::GetUserInstallation() {
   GError* error = nullptr;
-  const auto installation = flatpak_installation_new_user(nullptr, &error);
+  const auto installation = get_user_installation(&error);
   if (error) {
     spdlog::error("[FlatpakPlugin] Error getting user installation: {}",
                   error->message);
@@ -573,7 +873,7 @@ ErrorOr<flutter::EncodableList> FlatpakShim::GetApplicationsRemote(
     spdlog::info("[FlatpakPlugin] Get Applications from Remote {}", id);
     GError* error = nullptr;
 
-    auto installation = flatpak_installation_new_user(nullptr, &error);
+    auto installation = get_user_installation(&error);
     if (error) {
       spdlog::error("[FlatpakPlugin] Failed to get user installation: {}",
                     error->message);
@@ -637,7 +937,7 @@ ErrorOr<bool> FlatpakShim::RemoteAdd(const Remote& configuration) {
 
     spdlog::info("[FlatpakPlugin] Adding Remote {}", configuration.name());
     GError* error = nullptr;
-    auto installation = flatpak_installation_new_user(nullptr, &error);
+    auto installation = get_user_installation(&error);
     if (error) {
       spdlog::error("[FlatpakPlugin] Failed to get user installation: {}",
                     error->message);
@@ -741,7 +1041,7 @@ ErrorOr<bool> FlatpakShim::RemoteRemove(const std::string& id) {
 
     spdlog::info("[FlatpakPlugin] Removing remote {}", id);
     GError* error = nullptr;
-    auto installation = flatpak_installation_new_user(nullptr, &error);
+    auto installation = get_user_installation(&error);
     if (error) {
       spdlog::error("[FlatpakPlugin] Failed to get user installation: {}",
                     error->message);
@@ -775,295 +1075,226 @@ ErrorOr<bool> FlatpakShim::RemoteRemove(const std::string& id) {
 }
 
 ErrorOr<bool> FlatpakShim::ApplicationInstall(const std::string& id) {
-  try {
-    if (id.empty()) {
-      return ErrorOr<bool>(
-          FlutterError("INVALID_APP_ID", "Application ID is required"));
-    }
-
-    spdlog::debug("[FlatpakPlugin] Installing application: {}", id);
-    GError* error = nullptr;
-
-    auto installation = flatpak_installation_new_user(nullptr, &error);
-    if (error) {
-      spdlog::error("[FlatpakPlugin] Failed to get user installation: {}",
-                    error->message);
-      g_clear_error(&error);
-      return ErrorOr<bool>(FlutterError("INSTALLATION_ERROR",
-                                        "Failed to get user installation"));
-    }
-
-    // Try parsing as a full ref first
-    auto app_ref = flatpak_ref_parse(id.c_str(), &error);
-    if (!error && app_ref) {
-      const char* app_name = flatpak_ref_get_name(app_ref);
-      const char* app_arch = flatpak_ref_get_arch(app_ref);
-      const char* app_branch = flatpak_ref_get_branch(app_ref);
-
-      spdlog::debug(
-          "[FlatpakPlugin] Parsed ref - name: {}, arch: {}, branch: {}",
-          app_name, app_arch, app_branch);
-
-      std::string remote_name =
-          find_remote_for_app(installation, app_name, app_arch, app_branch);
-      if (remote_name.empty()) {
-        spdlog::error("[FlatpakPlugin] Failed to find remote for app: {}",
-                      app_name);
-        g_object_unref(app_ref);
-        g_object_unref(installation);
-        return ErrorOr<bool>(
-            FlutterError("INSTALL_FAILED", "Failed to find remote for app"));
-      }
-
-      FlatpakInstalledRef* installed_ref = flatpak_installation_install(
-          installation, remote_name.c_str(), FLATPAK_REF_KIND_APP, app_name,
-          app_arch, app_branch, nullptr, nullptr, nullptr, &error);
-
-      if (error) {
-        spdlog::error("[FlatpakPlugin] Failed to install '{}': {}", id,
-                      error->message);
-        g_object_unref(app_ref);
-        g_object_unref(installation);
-        g_clear_error(&error);
-        return ErrorOr<bool>(
-            FlutterError("INSTALL_FAILED", "Failed to install application"));
-      }
-
-      if (installed_ref) {
-        spdlog::info("[FlatpakPlugin] Successfully installed: {}", id);
-        g_object_unref(installed_ref);
-      }
-      g_object_unref(app_ref);
-      g_object_unref(installation);
-      return ErrorOr<bool>(true);
-    }
-
-    if (error) {
-      g_clear_error(&error);
-    }
+  if (id.empty()) {
+    return ErrorOr<bool>(
+        FlutterError("INVALID_APP_ID", "Application ID is required"));
+  }
+  spdlog::debug("[FlatpakPlugin] Installing application: {}", id);
+  return RunTransaction({id}, {}, nullptr, nullptr);
+}
 
-    // Search in all remotes for this app ID
-    auto remote_and_ref = find_app_in_remotes(installation, id);
-    if (remote_and_ref.first.empty()) {
-      spdlog::error("[FlatpakPlugin] Application '{}' not found in any remote",
-                    id);
-      g_object_unref(installation);
-      return ErrorOr<bool>(
-          FlutterError("APP_NOT_FOUND", "Application not found in remotes"));
-    }
+ErrorOr<bool> FlatpakShim::ApplicationUninstall(const std::string& id) {
+  if (id.empty()) {
+    return ErrorOr<bool>(
+        FlutterError("INVALID_APP_ID", "Application ID is required"));
+  }
+  spdlog::debug("[FlatpakPlugin] Uninstalling application: {}", id);
+  return RunTransaction({}, {id}, nullptr, nullptr);
+}
 
-    auto found_ref = flatpak_ref_parse(remote_and_ref.second.c_str(), &error);
-    if (error || !found_ref) {
-      spdlog::error("[FlatpakPlugin] Failed to parse found ref: {}",
-                    remote_and_ref.second);
-      g_object_unref(installation);
-      if (error) {
-        g_clear_error(&error);
-      }
-      return ErrorOr<bool>(
-          FlutterError("APP_NOT_FOUND", "Failed to parse found ref"));
+std::optional<std::pair<std::string, std::string>>
+FlatpakShim::resolve_remote_ref(FlatpakInstallation* installation,
+                                const std::string& id) {
+  GError* error = nullptr;
+  // Try parsing as a full ref first
+  if (FlatpakRef* app_ref = flatpak_ref_parse(id.c_str(), &error)) {
+    const char* app_name = flatpak_ref_get_name(app_ref);
+    std::string remote_name = find_remote_for_app(
+        installation, app_name, flatpak_ref_get_arch(app_ref),
+        flatpak_ref_get_branch(app_ref));
+    char* ref = flatpak_ref_format_ref(app_ref);
+    std::pair<std::string, std::string> result(std::move(remote_name), ref);
+    g_free(ref);
+    g_object_unref(app_ref);
+    if (result.first.empty()) {
+      spdlog::error("[FlatpakPlugin] Failed to find remote for app: {}", id);
+      return std::nullopt;
     }
+    return result;
+  }
+  g_clear_error(&error);
 
-    const char* app_name = flatpak_ref_get_name(found_ref);
-    const char* app_arch = flatpak_ref_get_arch(found_ref);
-    const char* app_branch = flatpak_ref_get_branch(found_ref);
+  // Search in all remotes for this app ID
+  auto remote_and_ref = find_app_in_remotes(installation, id);
+  if (remote_and_ref.first.empty()) {
+    spdlog::error("[FlatpakPlugin] Application '{}' not found in any remote",
+                  id);
+    return std::nullopt;
+  }
+  spdlog::info("[FlatpakPlugin] Found app '{}' in remote '{}' as '{}'", id,
+               remote_and_ref.first, remote_and_ref.second);
+  return remote_and_ref;
+}
 
-    spdlog::info("[FlatpakPlugin] Found app '{}' in remote '{}' as '{}'", id,
-                 remote_and_ref.first, remote_and_ref.second);
+std::optional<std::string> FlatpakShim::resolve_installed_ref(
+    FlatpakInstallation* installation,
+    const std::string& id) {
+  GError* error = nullptr;
+  // Try parsing as a full ref first
+  if (FlatpakRef* app_ref = flatpak_ref_parse(id.c_str(), &error)) {
+    char* ref = flatpak_ref_format_ref(app_ref);
+    std::string result(ref);
+    g_free(ref);
+    g_object_unref(app_ref);
+    return result;
+  }
+  g_clear_error(&error);
 
-    FlatpakInstalledRef* installed_ref = flatpak_installation_install(
-        installation, remote_and_ref.first.c_str(), FLATPAK_REF_KIND_APP,
-        app_name, app_arch, app_branch, nullptr, nullptr, nullptr, &error);
+  // Search in installed apps
+  spdlog::debug("[FlatpakPlugin] Searching installed apps for: {}", id);
+  const auto refs = flatpak_installation_list_installed_refs_by_kind(
+      installation, FLATPAK_REF_KIND_APP, nullptr, &error);
+  if (!refs) {
+    spdlog::error("[FlatpakPlugin] Failed to get installed apps: {}",
+                  error ? error->message : "unknown error");
+    g_clear_error(&error);
+    return std::nullopt;
+  }
 
-    if (error) {
-      spdlog::error("[FlatpakPlugin] Failed to install '{}': {}", id,
-                    error->message);
-      g_object_unref(found_ref);
-      g_object_unref(installation);
-      g_clear_error(&error);
-      return ErrorOr<bool>(
-          FlutterError("INSTALL_FAILED", "Failed to install application"));
+  // Search for exact match first, then partial match
+  FlatpakRef* found = nullptr;
+  for (guint i = 0; i < refs->len && !found; i++) {
+    const auto ref = FLATPAK_REF(g_ptr_array_index(refs, i));
+    if (const char* name = flatpak_ref_get_name(ref); name && id == name) {
+      found = ref;
     }
-
-    if (installed_ref) {
-      spdlog::info("[FlatpakPlugin] Successfully installed: {}", id);
-      g_object_unref(installed_ref);
+  }
+  for (guint i = 0; i < refs->len && !found; i++) {
+    const auto ref = FLATPAK_REF(g_ptr_array_index(refs, i));
+    if (const char* name = flatpak_ref_get_name(ref);
+        name && std::strstr(name, id.c_str())) {
+      spdlog::debug("[FlatpakPlugin] Found partial match: {}", name);
+      found = ref;
     }
+  }
 
-    g_object_unref(found_ref);
-    g_object_unref(installation);
-    return ErrorOr<bool>(true);
-  } catch (const std::exception& e) {
-    spdlog::error("[FlatpakPlugin] Exception installing application: {}",
-                  e.what());
-    return ErrorOr<bool>(FlutterError("INSTALL_FAILED", "Exception occurred"));
+  std::optional<std::string> result;
+  if (found) {
+    char* ref = flatpak_ref_format_ref(found);
+    result = ref;
+    g_free(ref);
+  } else {
+    spdlog::error(
+        "[FlatpakPlugin] Application '{}' not found in installed "
+        "applications",
+        id);
   }
+  g_ptr_array_unref(refs);
+  return result;
 }
 
-ErrorOr<bool> FlatpakShim::ApplicationUninstall(const std::string& id) {
-  try {
-    if (id.empty()) {
-      return ErrorOr<bool>(
-          FlutterError("INVALID_APP_ID", "Application ID is required"));
-    }
+ErrorOr<bool> FlatpakShim::RunTransaction(
+    const std::vector<std::string>& install_ids,
+    const std::vector<std::string>& uninstall_ids,
+    const TransactionProgressCallback& on_progress,
+    GCancellable* cancellable) {
+  if (install_ids.empty() && uninstall_ids.empty()) {
+    return ErrorOr<bool>(
+        FlutterError("INVALID_APP_ID", "Application ID is required"));
+  }
+  const char* failure_code = install_ids.empty()     ? "UNINSTALL_FAILED"
+                             : uninstall_ids.empty() ? "INSTALL_FAILED"
+                                                     : "TRANSACTION_FAILED";
 
-    spdlog::debug("[FlatpakPlugin] Uninstalling application: {}", id);
-    GError* error = nullptr;
+  GError* error = nullptr;
+  FlatpakInstallation* installation = get_user_installation(&error);
+  if (!installation) {
+    spdlog::error("[FlatpakPlugin] Failed to get user installation: {}",
+                  error ? error->message : "unknown error");
+    g_clear_error(&error);
+    return ErrorOr<bool>(
+        FlutterError("INSTALLATION_ERROR", "Failed to get user installation"));
+  }
 
-    auto installation = flatpak_installation_new_user(nullptr, &error);
-    if (error) {
-      spdlog::error("[FlatpakPlugin] Failed to get user installation: {}",
-                    error->message);
+  FlatpakTransaction* transaction =
+      flatpak_transaction_new_for_installation(installation, cancellable,
+                                               &error);
+  if (!transaction) {
+    FlutterError failure(
+        failure_code, error ? error->message : "Failed to create transaction");
+    g_clear_error(&error);
+    g_object_unref(installation);
+    return ErrorOr<bool>(std::move(failure));
+  }
+  // Runtimes and extensions may come from any configured remote.
+  flatpak_transaction_add_default_dependency_sources(transaction);
+
+  std::optional<FlutterError> failure;
+  for (const auto& id : install_ids) {
+    const auto remote_ref = resolve_remote_ref(installation, id);
+    if (!remote_ref) {
+      failure = FlutterError("APP_NOT_FOUND",
+                             "Application not found in remotes: " + id);
+      break;
+    }
+    if (!flatpak_transaction_add_install(transaction, remote_ref->first.c_str(),
+                                         remote_ref->second.c_str(), nullptr,
+                                         &error)) {
+      failure = FlutterError(failure_code, error->message);
       g_clear_error(&error);
-      return ErrorOr<bool>(FlutterError("INSTALLATION_ERROR",
-                                        "Failed to get user installation"));
+      break;
     }
-
-    // Try parsing as a full ref first
-    auto app_ref = flatpak_ref_parse(id.c_str(), &error);
-    if (!error && app_ref) {
-      const char* app_name = flatpak_ref_get_name(app_ref);
-      const char* app_arch = flatpak_ref_get_arch(app_ref);
-      const char* app_branch = flatpak_ref_get_branch(app_ref);
-
-      spdlog::debug(
-          "[FlatpakPlugin] Parsed ref - name: {}, arch: {}, branch: {}",
-          app_name, app_arch, app_branch);
-
-      gboolean result = flatpak_installation_uninstall(
-          installation, FLATPAK_REF_KIND_APP, app_name, app_arch, app_branch,
-          nullptr, nullptr, nullptr, &error);
-
-      if (error) {
-        spdlog::error("[FlatpakPlugin] Failed to uninstall '{}': {}", id,
-                      error->message);
-        g_object_unref(app_ref);
-        g_object_unref(installation);
-        g_clear_error(&error);
-        return ErrorOr<bool>(FlutterError("UNINSTALL_FAILED",
-                                          "Failed to uninstall application"));
-      }
-
-      if (result) {
-        spdlog::info("[FlatpakPlugin] Successfully uninstalled: {}", id);
-      }
-      g_object_unref(app_ref);
-      g_object_unref(installation);
-      return ErrorOr(static_cast<bool>(result));
+  }
+  for (size_t i = 0; i < uninstall_ids.size() && !failure; i++) {
+    const auto ref = resolve_installed_ref(installation, uninstall_ids[i]);
+    if (!ref) {
+      failure = FlutterError("APP_NOT_FOUND",
+                             "Application not found: " + uninstall_ids[i]);
+      break;
     }
-
-    if (error) {
+    if (!flatpak_transaction_add_uninstall(transaction, ref->c_str(),
+                                           &error)) {
+      failure = FlutterError(failure_code, error->message);
       g_clear_error(&error);
     }
+  }
 
-    // Search in installed apps
-    spdlog::debug("[FlatpakPlugin] Searching installed apps for: {}", id);
-
-    const auto refs =
-        flatpak_installation_list_installed_refs(installation, nullptr, &error);
-    if (error) {
-      spdlog::error("[FlatpakPlugin] Failed to get installed apps: {}",
-                    error->message);
-      g_clear_error(&error);
-      g_object_unref(installation);
-      return ErrorOr<bool>(
-          FlutterError("UNINSTALL_ERROR", "Failed to get installed apps"));
-    }
-
-    std::string found_app_name;
-    std::string found_arch;
-    std::string found_branch;
-    bool app_found = false;
-
-    // Search for exact match first, then partial match
-    for (guint i = 0; i < refs->len && !app_found; i++) {
-      const auto ref =
-          static_cast<FlatpakInstalledRef*>(g_ptr_array_index(refs, i));
-
-      if (flatpak_ref_get_kind(FLATPAK_REF(ref)) != FLATPAK_REF_KIND_APP) {
-        continue;
-      }
-
-      if (const auto ref_name = flatpak_ref_get_name(FLATPAK_REF(ref))) {
-        std::string ref_name_str(ref_name);
-        // Check for exact match
-        if (ref_name_str == id) {
-          found_app_name = ref_name_str;
-          found_arch = flatpak_ref_get_arch(FLATPAK_REF(ref));
-          found_branch = flatpak_ref_get_branch(FLATPAK_REF(ref));
-          app_found = true;
-          spdlog::debug("[FlatpakPlugin] Found exact match: {}", ref_name_str);
-        }
-      }
-    }
-
-    // If no exact match, try partial match
-    if (!app_found) {
-      for (guint i = 0; i < refs->len; i++) {
-        const auto ref =
-            static_cast<FlatpakInstalledRef*>(g_ptr_array_index(refs, i));
-
-        if (flatpak_ref_get_kind(FLATPAK_REF(ref)) != FLATPAK_REF_KIND_APP) {
-          continue;
-        }
-
-        if (const auto ref_name = flatpak_ref_get_name(FLATPAK_REF(ref))) {
-          if (std::string ref_name_str(ref_name);
-              ref_name_str.find(id) != std::string::npos) {
-            found_app_name = ref_name_str;
-            found_arch = flatpak_ref_get_arch(FLATPAK_REF(ref));
-            found_branch = flatpak_ref_get_branch(FLATPAK_REF(ref));
-            app_found = true;
-            spdlog::debug("[FlatpakPlugin] Found partial match: {}",
-                          ref_name_str);
-            break;
-          }
-        }
+  if (!failure) {
+    TransactionState state;
+    state.on_progress = &on_progress;
+    g_signal_connect(transaction, "new-operation",
+                     G_CALLBACK(on_transaction_new_operation), &state);
+    g_signal_connect(transaction, "operation-done",
+                     G_CALLBACK(on_transaction_operation_done), &state);
+    g_signal_connect(transaction, "operation-error",
+                     G_CALLBACK(on_transaction_operation_error), &state);
+
+    // Keep the pulls off whatever context is the default on this thread.
+    GMainContext* context = g_main_context_new();
+    g_main_context_push_thread_default(context);
+    const gboolean result =
+        flatpak_transaction_run(transaction, cancellable, &error);
+    g_main_context_pop_thread_default(context);
+    g_main_context_unref(context);
+
+    if (!result) {
+      if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        failure =
+            FlutterError("TRANSACTION_CANCELLED", "Transaction was cancelled");
+      } else {
+        failure = FlutterError(failure_code,
+                               error ? error->message : "Transaction failed");
       }
-    }
-
-    g_ptr_array_unref(refs);
-
-    if (!app_found) {
-      spdlog::error(
-          "[FlatpakPlugin] Application '{}' not found in installed "
-          "applications",
-          id);
-      g_object_unref(installation);
-      return ErrorOr<bool>(
-          FlutterError("APP_NOT_FOUND", "Application not found"));
-    }
-
-    spdlog::info(
-        "[FlatpakPlugin] Found installed app '{}' -> name: {}, arch: {}, "
-        "branch: {}",
-        id, found_app_name, found_arch, found_branch);
-
-    gboolean result = flatpak_installation_uninstall(
-        installation, FLATPAK_REF_KIND_APP, found_app_name.c_str(),
-        found_arch.c_str(), found_branch.c_str(), nullptr, nullptr, nullptr,
-        &error);
-
-    if (error) {
-      spdlog::error("[FlatpakPlugin] Failed to uninstall '{}': {}", id,
-                    error->message);
-      g_object_unref(installation);
       g_clear_error(&error);
-      return ErrorOr<bool>(
-          FlutterError("UNINSTALL_FAILED", "Failed to uninstall application"));
     }
 
-    if (result) {
-      spdlog::info("[FlatpakPlugin] Successfully uninstalled: {}", id);
+    // The transaction worked on its own copy of the installation.
+    if (!flatpak_installation_drop_caches(installation, nullptr, &error)) {
+      g_clear_error(&error);
     }
-    g_object_unref(installation);
-    return ErrorOr<bool>(static_cast<bool>(result));
-  } catch (const std::exception& e) {
-    spdlog::error("[FlatpakPlugin] Exception uninstalling application: {}",
-                  e.what());
-    return ErrorOr<bool>(
-        FlutterError("UNINSTALL_FAILED", "Exception occurred"));
   }
+
+  g_object_unref(transaction);
+  g_object_unref(installation);
+  if (failure) {
+    spdlog::error("[FlatpakPlugin] Transaction failed: {}",
+                  failure->message());
+    return ErrorOr<bool>(std::move(*failure));
+  }
+  spdlog::info("[FlatpakPlugin] Transaction finished: {} installed, {} "
+               "uninstalled",
+               install_ids.size(), uninstall_ids.size());
+  return ErrorOr<bool>(true);
 }
 
 ErrorOr<bool> FlatpakShim::ApplicationStart(
@@ -1078,7 +1309,7 @@ ErrorOr<bool> FlatpakShim::ApplicationStart(
 
   // Check if the application is installed first
   GError* error = nullptr;
-  auto installation = flatpak_installation_new_user(nullptr, &error);
+  auto installation = get_user_installation(&error);
   if (error) {
     spdlog::error("[FlatpakPlugin] Failed to get user installation: {}",
                   error->message);
@@ -1164,7 +1395,7 @@ ErrorOr<bool> FlatpakShim::ApplicationStop(const std::string& id) {
 
   // Check if the application is installed first
   GError* error = nullptr;
-  auto installation = flatpak_installation_new_user(nullptr, &error);
+  auto installation = get_user_installation(&error);
   if (error) {
     spdlog::error("[FlatpakPlugin] Failed to get user installation: {}",
                   error->message);
@@ -1242,7 +1473,7 @@ ErrorOr<flutter::EncodableList> FlatpakShim::get_remotes_by_installation_id(
     GError* error = nullptr;
 
     if (installation_id == "user") {
-      installation = flatpak_installation_new_user(nullptr, &error);
+      installation = get_user_installation(&error);
       if (error) {
         const std::string error_msg = error->message;
         g_clear_error(&error);
@@ -1309,76 +1540,74 @@ std::string FlatpakShim::find_remote_for_app(FlatpakInstallation* installation,
                                              const char* app_name,
                                              const char* app_arch,
                                              const char* app_branch) {
-  GError* error = nullptr;
-  auto remotes =
-      flatpak_installation_list_remotes(installation, nullptr, &error);
-  if (error) {
-    spdlog::error("[FlatpakPlugin] Error getting remotes: {}", error->message);
-    g_clear_error(&error);
-    return "";
-  }
-
-  for (guint i = 0; i < remotes->len; i++) {
-    auto remote = static_cast<FlatpakRemote*>(g_ptr_array_index(remotes, i));
-    const auto remote_name = flatpak_remote_get_name(remote);
-
-    if (flatpak_remote_get_disabled(remote)) {
-      continue;
-    }
-
-    auto remote_ref = flatpak_installation_fetch_remote_ref_sync(
-        installation, remote_name, FLATPAK_REF_KIND_APP, app_name, app_arch,
-        app_branch, nullptr, &error);
-
-    if (remote_ref && !error) {
-      g_object_unref(remote_ref);
-      g_ptr_array_unref(remotes);
-      return {remote_name};
-    }
+  const auto remote_names = get_enabled_remote_names(installation);
+  const std::string name = app_name ? app_name : "";
+  const std::string arch = app_arch ? app_arch : "";
+  const std::string branch = app_branch ? app_branch : "";
+
+  const auto found = for_each_remote<bool>(
+      installation, remote_names,
+      [name, arch, branch](FlatpakInstallation* inst,
+                           const std::string& remote,
+                           GCancellable* cancellable) {
+        GError* error = nullptr;
+        auto remote_ref = flatpak_installation_fetch_remote_ref_sync(
+            inst, remote.c_str(), FLATPAK_REF_KIND_APP, name.c_str(),
+            arch.empty() ? nullptr : arch.c_str(),
+            branch.empty() ? nullptr : branch.c_str(), cancellable, &error);
+        g_clear_error(&error);
+        if (!remote_ref) {
+          return false;
+        }
+        g_object_unref(remote_ref);
+        return true;
+      });
 
-    if (error) {
-      g_clear_error(&error);
+  // Keep the configured remote order as priority.
+  for (size_t i = 0; i < remote_names.size(); i++) {
+    if (found[i].value_or(false)) {
+      return remote_names[i];
     }
   }
-
-  g_ptr_array_unref(remotes);
   return "";
 }
 
 std::pair<std::string, std::string> FlatpakShim::find_app_in_remotes(
     FlatpakInstallation* installation,
     const std::string& app_id) {
-  std::vector<std::string> priority_remotes = {"flathub", "fedora",
-                                               "gnome-nightly"};
-  std::vector<std::string> common_branches = {"stable", "beta", "master"};
-  std::string default_arch = flatpak_get_default_arch();
-
-  // Try priority remotes first
-  for (const auto& remote_name : priority_remotes) {
-    for (const auto& branch_name : common_branches) {
-      GError* error = nullptr;
-      auto remote_ref = flatpak_installation_fetch_remote_ref_sync(
-          installation, remote_name.c_str(), FLATPAK_REF_KIND_APP,
-          app_id.c_str(), default_arch.c_str(), branch_name.c_str(), nullptr,
-          &error);
-
-      if (remote_ref && !error) {
-        std::string ref_string = "app/";
-        ref_string += app_id;
-        ref_string += "/";
-        ref_string += default_arch;
-        ref_string += "/";
-        ref_string += branch_name;
-
-        spdlog::info("[FlatpakPlugin] Found '{}' in remote '{}' as '{}'",
-                     app_id, remote_name, ref_string);
-        g_object_unref(remote_ref);
-        return {remote_name, ref_string};
-      }
+  const std::vector<std::string> priority_remotes = {"flathub", "fedora",
+                                                     "gnome-nightly"};
+  const std::string default_arch = flatpak_get_default_arch();
+
+  // Try priority remotes first, all at once; the first remote in priority
+  // order that has the app wins.
+  const auto found = for_each_remote<std::string>(
+      installation, priority_remotes,
+      [app_id, default_arch](FlatpakInstallation* inst,
+                             const std::string& remote,
+                             GCancellable* cancellable) -> std::string {
+        for (const char* branch_name : {"stable", "beta", "master"}) {
+          GError* error = nullptr;
+          auto remote_ref = flatpak_installation_fetch_remote_ref_sync(
+              inst, remote.c_str(), FLATPAK_REF_KIND_APP, app_id.c_str(),
+              default_arch.c_str(), branch_name, cancellable, &error);
+          g_clear_error(&error);
+          if (remote_ref) {
+            g_object_unref(remote_ref);
+            return "app/" + app_id + "/" + default_arch + "/" + branch_name;
+          }
+          if (g_cancellable_is_cancelled(cancellable)) {
+            break;
+          }
+        }
+        return "";
+      });
 
-      if (error) {
-        g_clear_error(&error);
-      }
+  for (size_t i = 0; i < priority_remotes.size(); i++) {
+    if (found[i] && !found[i]->empty()) {
+      spdlog::info("[FlatpakPlugin] Found '{}' in remote '{}' as '{}'", app_id,
+                   priority_remotes[i], *found[i]);
+      return {priority_remotes[i], *found[i]};
     }
   }
 
@@ -1388,40 +1617,31 @@ std::pair<std::string, std::string> FlatpakShim::find_app_in_remotes(
 std::pair<std::string, std::string> FlatpakShim::find_app_in_remotes_fallback(
     FlatpakInstallation* installation,
     const std::string& app_id) {
-  GError* error = nullptr;
-  auto remotes =
-      flatpak_installation_list_remotes(installation, nullptr, &error);
-  if (error) {
-    spdlog::error("[FlatpakPlugin] Error getting remotes: {}", error->message);
-    g_clear_error(&error);
-    return {"", ""};
-  }
-
-  for (guint i = 0; i < remotes->len; i++) {
-    auto remote = static_cast<FlatpakRemote*>(g_ptr_array_index(remotes, i));
-    if (flatpak_remote_get_disabled(remote)) {
-      continue;
-    }
+  const auto remote_names = get_enabled_remote_names(installation);
+  const auto results = for_each_remote<std::pair<std::string, std::string>>(
+      installation, remote_names,
+      [app_id](FlatpakInstallation* inst, const std::string& remote,
+               GCancellable* cancellable) {
+        return search_in_single_remote(inst, remote.c_str(), app_id,
+                                       cancellable);
+      });
 
-    const auto remote_name = flatpak_remote_get_name(remote);
-    auto result = search_in_single_remote(installation, remote_name, app_id);
-    if (!result.first.empty()) {
-      g_ptr_array_unref(remotes);
-      return result;
+  for (const auto& result : results) {
+    if (result && !result->first.empty()) {
+      return *result;
     }
   }
-
-  g_ptr_array_unref(remotes);
   return {"", ""};
 }
 
 std::pair<std::string, std::string> FlatpakShim::search_in_single_remote(
     FlatpakInstallation* installation,
     const char* remote_name,
-    const std::string& app_id) {
+    const std::string& app_id,
+    GCancellable* cancellable) {
   GError* error = nullptr;
   auto remote_refs = flatpak_installation_list_remote_refs_sync(
-      installation, remote_name, nullptr, &error);
+      installation, remote_name, cancellable, &error);
 
   if (error) {
     spdlog::error("[FlatpakPlugin] Skipping remote '{}': {}", remote_name,
@@ -1554,7 +1774,8 @@ flutter::EncodableList FlatpakShim::convert_applications_to_EncodableList(
     if (auto appstream_path = g_file_get_path(appstream_dir)) {
       const std::string appstream_file =
           std::string(appstream_path) + "/appstream.xml.gz";
-      catalog = AppstreamCatalog(appstream_file, "en");
+      catalog.emplace(appstream_file, "en",
+                      get_appstream_snapshot_path(remote, default_arch));
       spdlog::debug("[FlatpakPlugin] AppstreamCatalog loaded {} components",
                     catalog->getTotalComponentCount());
       g_free(appstream_path);
@@ -1670,6 +1891,21 @@ std::vector<char> FlatpakShim::decompress_gzip(
   return decompressedData;
 }
 
+std::string FlatpakShim::get_appstream_snapshot_path(FlatpakRemote* remote,
+                                                     const char* arch) {
+  const char* remote_name = flatpak_remote_get_name(remote);
+  if (!remote_name || !arch) {
+    return "";
+  }
+  const std::string dir =
+      std::string(g_get_user_cache_dir()) + "/flatpak-plugin";
+  if (g_mkdir_with_parents(dir.c_str(), 0700) != 0) {
+    spdlog::warn("[FlatpakPlugin] Cannot create cache directory {}", dir);
+    return "";
+  }
+  return dir + "/appstream-" + remote_name + "-" + arch + ".snapshot";
+}
+
 std::optional<Application> FlatpakShim::create_component(
     FlatpakRemoteRef* app_ref,
     const std::optional<AppstreamCatalog>& app_catalog) {
@@ -1697,9 +1933,8 @@ std::optional<Application> FlatpakShim::create_component(
 
     // fill Application data fields from catalog
     if (app_catalog.has_value()) {
-      auto component_optional = app_catalog->searchById(std::string(app_id));
-      if (component_optional.has_value()) {
-        const auto& component = component_optional.value();
+      if (const Component* found = app_catalog->searchById(app_id)) {
+        const auto& component = *found;
         name = component.getName();
         summary = component.getSummary();
         if (component.getVersion().has_value()) {
@@ -18,8 +18,11 @@
 #define FLUTTER_PLUGIN_FLATPAK_FLATPAK_SHIM_H
 
 #include <filesystem>
+#include <functional>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #define FLATPAK_EXTERN extern "C"
 #include <flatpak/flatpak.h>
@@ -32,6 +35,23 @@
 
 namespace flatpak_plugin {
 
+/**
+ * \brief Progress of the operation a transaction is currently running.
+ */
+struct TransactionProgress {
+  std::string ref;             ///< Ref of the current operation.
+  std::string kind;            ///< "install", "update", "uninstall", ...
+  size_t operation = 0;        ///< Index of the current operation.
+  size_t operation_count = 0;  ///< Operations after dependency resolution.
+  int percent = 0;             ///< Progress of the current operation.
+  uint64_t bytes_transferred = 0;
+  int64_t eta_seconds = -1;  ///< Estimated time left, -1 if unknown.
+  std::string status;
+};
+
+using TransactionProgressCallback =
+    std::function<void(const TransactionProgress&)>;
+
 /**
  * \brief A utility class providing various helper functions for interacting
  * with Flatpak installations, remotes, and applications.
@@ -66,8 +86,19 @@ struct FlatpakShim {
   static void PrintComponent(const Component& component);
 
   /**
-   * \brief Retrieves the system installations available on the host.
-   * \return A GPtrArray containing pointers to FlatpakInstallation objects.
+   * \brief Retrieves the process-wide user installation, creating it on
+   * first use and dropping its caches on later uses.
+   * \param error Set if the installation could not be created.
+   * \return A new reference the caller must unref, or nullptr on error.
+   */
+  static FlatpakInstallation* get_user_installation(GError** error);
+
+  /**
+   * \brief Retrieves the system installations available on the host. The
+   * array is created once and shared; its installations drop their caches
+   * on every later call.
+   * \return A new reference to a GPtrArray of FlatpakInstallation objects the
+   * caller must unref, or nullptr on error.
    */
   static GPtrArray* get_system_installations();
 
@@ -190,6 +221,24 @@ struct FlatpakShim {
    */
   static ErrorOr<bool> ApplicationUninstall(const std::string& id);
 
+  /**
+   * \brief Installs and uninstalls several applications in one
+   * FlatpakTransaction on the user installation. Dependencies are resolved
+   * once for the whole batch, so shared runtimes are only downloaded once.
+   * Blocks until the transaction finished.
+   * \param install_ids Application ids or full refs to install.
+   * \param uninstall_ids Application ids or full refs to uninstall.
+   * \param on_progress Called on the calling thread as operations start,
+   * progress and finish. May be empty.
+   * \param cancellable Cancels the transaction, may be nullptr.
+   * \return An ErrorOr object containing true or an error.
+   */
+  static ErrorOr<bool> RunTransaction(
+      const std::vector<std::string>& install_ids,
+      const std::vector<std::string>& uninstall_ids,
+      const TransactionProgressCallback& on_progress,
+      GCancellable* cancellable);
+
   /**
    * \brief Start flatpak application.
    * \param id id of the application to start.
@@ -230,7 +279,8 @@ struct FlatpakShim {
                                          const char* app_branch);
 
   /**
-   * \brief Search for app ID  in all remotes.
+   * \brief Search for app ID  in all remotes. Remotes are queried in
+   * parallel, each bounded by a timeout.
    * \param installation Installation that contains the App.
    * \param app_id Application id.
    * \return A Pair of two strings contains remote name and application ref.
@@ -246,7 +296,8 @@ struct FlatpakShim {
   static std::pair<std::string, std::string> search_in_single_remote(
       FlatpakInstallation* installation,
       const char* remote_name,
-      const std::string& app_id);
+      const std::string& app_id,
+      GCancellable* cancellable = nullptr);
 
   /**
    * \brief Converts a FlatpakRemoteType to its string representation.
@@ -298,6 +349,36 @@ struct FlatpakShim {
       std::vector<char>& decompressedData);
 
  private:
+  /**
+   * \brief Finds the remote providing an application.
+   * \param installation Installation whose remotes are searched.
+   * \param id Application id or full ref.
+   * \return The remote name and full ref, or std::nullopt if not found.
+   */
+  static std::optional<std::pair<std::string, std::string>>
+  resolve_remote_ref(FlatpakInstallation* installation, const std::string& id);
+
+  /**
+   * \brief Finds an installed application, preferring an exact name match
+   * over a partial one.
+   * \param installation Installation to search.
+   * \param id Application id or full ref.
+   * \return The full ref, or std::nullopt if not installed.
+   */
+  static std::optional<std::string> resolve_installed_ref(
+      FlatpakInstallation* installation,
+      const std::string& id);
+
+  /**
+   * \brief Gets the AppStream snapshot file for a remote, creating its
+   * directory under the user cache directory if needed.
+   * \param remote The remote whose catalog is cached.
+   * \param arch The catalog architecture.
+   * \return The snapshot path, or an empty string if unavailable.
+   */
+  static std::string get_appstream_snapshot_path(FlatpakRemote* remote,
+                                                 const char* arch);
+
   static std::optional<Application> create_component(
       FlatpakRemoteRef* app_ref,
       const std::optional<AppstreamCatalog>& app_catalog);
@@ -39,6 +39,11 @@ class Icon {
   void printIconDetails() const;
 
  private:
+  friend class AppstreamSnapshotReader;
+  friend class AppstreamSnapshotWriter;
+
+  Icon() = default;
+
   std::optional<std::string> type_;
   std::optional<int> width_;
   std::optional<int> height_;
@@ -35,6 +35,11 @@ class Release {
   [[nodiscard]] const std::optional<std::string>& getSize() const;
 
  private:
+  friend class AppstreamSnapshotReader;
+  friend class AppstreamSnapshotWriter;
+
+  Release() = default;
+
   std::string version_;
   std::string timestamp_;
   std::optional<std::string> description_;
@@ -37,6 +37,11 @@ class Image {
   void printImageDetails() const;
 
  private:
+  friend class AppstreamSnapshotReader;
+  friend class AppstreamSnapshotWriter;
+
+  Image() = default;
+
   std::optional<std::string> type_;
   std::optional<int> width_;
   std::optional<int> height_;
@@ -62,6 +67,11 @@ class Video {
   void printVideoDetails() const;
 
  private:
+  friend class AppstreamSnapshotReader;
+  friend class AppstreamSnapshotWriter;
+
+  Video() = default;
+
   std::optional<std::string> container_;
   std::optional<std::string> codec_;
   std::optional<int> width_;
@@ -86,6 +96,11 @@ class Screenshot {
   void printScreenshotDetails() const;
 
  private:
+  friend class AppstreamSnapshotReader;
+  friend class AppstreamSnapshotWriter;
+
+  Screenshot() = default;
+
   std::optional<std::string> type_;
   std::vector<std::string> captions_;
   std::optional<std::vector<Image>> images_;
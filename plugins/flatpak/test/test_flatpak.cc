@@ -1,13 +1,23 @@
+#include <atomic>
 #include <chrono>
+#include <filesystem>
 #include <fstream>
+#include <mutex>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
+#include <zlib.h>
 
 #include <flutter/encodable_value.h>
 
+#include "flatpak/appstream_catalog.h"
+#include "flatpak/appstream_search_index.h"
 #include "flatpak/component.h"
+#include "flatpak/delayed_task_runner.h"
 #include "flatpak/flatpak_shim.h"
+#include "flatpak/worker_pool.h"
 
 using namespace flatpak_plugin;
 
@@ -178,6 +188,250 @@ TEST_F(ComponentTest, Component_CompleteParsingTest) {
   xmlFreeDoc(doc);
 }
 
+class AppstreamCatalogTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    catalog_path_ =
+        "/tmp/appstream_catalog_test_" +
+        std::to_string(
+            std::chrono::steady_clock::now().time_since_epoch().count()) +
+        ".xml.gz";
+    const std::string xml = R"(<?xml version="1.0" encoding="UTF-8"?>
+<components version="0.8" origin="flathub">
+  <component type="desktop">
+    <id>org.example.Zeta</id>
+    <name>Zeta</name>
+    <summary>Last by name</summary>
+    <categories>
+      <category>Utility</category>
+    </categories>
+    <keywords>
+      <keyword>notes</keyword>
+    </keywords>
+    <icon type="cached" width="64" height="64">zeta.png</icon>
+    <screenshots>
+      <screenshot type="default">
+        <caption>Main window</caption>
+        <image type="source" width="800" height="600">https://example.org/zeta.png</image>
+      </screenshot>
+    </screenshots>
+    <releases>
+      <release version="1.0" timestamp="1700000000"/>
+    </releases>
+    <content_rating type="oars-1.1">
+      <content_attribute id="social-chat">mild</content_attribute>
+    </content_rating>
+  </component>
+  <component type="desktop">
+    <id>org.example.Alpha</id>
+    <name>Alpha</name>
+    <summary>First by name</summary>
+    <categories>
+      <category>Utility</category>
+      <category>Office</category>
+    </categories>
+  </component>
+  <component type="runtime">
+    <id>org.example.Zeta</id>
+    <name>Duplicate</name>
+    <summary>Shadowed by the first entry</summary>
+  </component>
+</components>
+)";
+    const gzFile gz = gzopen(catalog_path_.c_str(), "wb");
+    ASSERT_NE(gz, nullptr);
+    gzwrite(gz, xml.data(), static_cast<unsigned>(xml.size()));
+    gzclose(gz);
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(catalog_path_);
+    std::filesystem::remove(snapshotPath());
+  }
+
+  [[nodiscard]] std::string snapshotPath() const {
+    return catalog_path_ + ".snapshot";
+  }
+
+  static void expectSameCatalog(const AppstreamCatalog& a,
+                                const AppstreamCatalog& b) {
+    ASSERT_EQ(a.getTotalComponentCount(), b.getTotalComponentCount());
+    for (size_t i = 0; i < a.getTotalComponentCount(); i++) {
+      const auto& x = a.getComponents()[i];
+      const auto& y = b.getComponents()[i];
+      EXPECT_EQ(x.getId(), y.getId());
+      EXPECT_EQ(x.getName(), y.getName());
+      EXPECT_EQ(x.getSummary(), y.getSummary());
+      EXPECT_EQ(x.getCategories(), y.getCategories());
+      EXPECT_EQ(x.getKeywords(), y.getKeywords());
+      EXPECT_EQ(x.getContentRatingType(), y.getContentRatingType());
+      EXPECT_EQ(x.getContentRating(), y.getContentRating());
+      EXPECT_EQ(x.getIcons().has_value(), y.getIcons().has_value());
+      EXPECT_EQ(x.getReleases().has_value(), y.getReleases().has_value());
+      EXPECT_EQ(x.getScreenshots().has_value(), y.getScreenshots().has_value());
+    }
+    EXPECT_EQ(a.getUniqueCategories(), b.getUniqueCategories());
+    EXPECT_EQ(a.getUniqueKeywords(), b.getUniqueKeywords());
+  }
+
+  std::string catalog_path_;
+};
+
+TEST_F(AppstreamCatalogTest, StreamsCompressedCatalogIntoIndexes) {
+  const AppstreamCatalog catalog(catalog_path_, "");
+  ASSERT_EQ(catalog.getTotalComponentCount(), 3u);
+
+  const Component* zeta = catalog.searchById("org.example.Zeta");
+  ASSERT_NE(zeta, nullptr);
+  EXPECT_EQ(zeta->getName(), "Zeta");
+  EXPECT_EQ(catalog.searchById("org.example.Missing"), nullptr);
+
+  const auto utilities = catalog.searchByCategory("Utility", true, "name");
+  ASSERT_EQ(utilities.size(), 2u);
+  EXPECT_EQ(utilities[0]->getName(), "Alpha");
+  EXPECT_EQ(utilities[1]->getName(), "Zeta");
+  EXPECT_EQ(catalog.searchByCategory("Utility").front()->getName(), "Zeta");
+  EXPECT_TRUE(catalog.searchByCategory("Game").empty());
+
+  const auto notes = catalog.searchByKeyword("notes");
+  ASSERT_EQ(notes.size(), 1u);
+  EXPECT_EQ(notes[0], zeta);
+
+  EXPECT_EQ(catalog.getUniqueCategories(),
+            (std::unordered_set<std::string>{"Utility", "Office"}));
+  EXPECT_EQ(catalog.getUniqueKeywords(),
+            (std::unordered_set<std::string>{"notes"}));
+}
+
+TEST_F(AppstreamCatalogTest, SnapshotRestoresCatalogWithoutParsing) {
+  const AppstreamCatalog parsed(catalog_path_, "", snapshotPath());
+  ASSERT_TRUE(std::filesystem::exists(snapshotPath()));
+
+  // Replace the source content but keep its stamp; the snapshot still wins.
+  const auto mtime = std::filesystem::last_write_time(catalog_path_);
+  const auto size = std::filesystem::file_size(catalog_path_);
+  {
+    std::ofstream garbage(catalog_path_, std::ios::binary | std::ios::trunc);
+    garbage << std::string(size, ' ');
+  }
+  std::filesystem::last_write_time(catalog_path_, mtime);
+
+  const AppstreamCatalog restored(catalog_path_, "", snapshotPath());
+  expectSameCatalog(parsed, restored);
+
+  const Component* zeta = restored.searchById("org.example.Zeta");
+  ASSERT_NE(zeta, nullptr);
+  ASSERT_TRUE(zeta->getIcons().has_value());
+  EXPECT_EQ(zeta->getIcons()->at(0).getWidth(), 64);
+  EXPECT_EQ(zeta->getIcons()->at(0).getPath(), "zeta.png");
+  ASSERT_TRUE(zeta->getScreenshots().has_value());
+  const auto& screenshot = zeta->getScreenshots()->at(0);
+  EXPECT_EQ(screenshot.getType(), "default");
+  EXPECT_EQ(screenshot.getCaptions(), std::vector<std::string>{"Main window"});
+  ASSERT_TRUE(screenshot.getImages().has_value());
+  EXPECT_EQ(screenshot.getImages()->at(0).getUrl(),
+            "https://example.org/zeta.png");
+  EXPECT_FALSE(screenshot.getVideo().has_value());
+  ASSERT_TRUE(zeta->getReleases().has_value());
+  EXPECT_EQ(zeta->getReleases()->at(0).getVersion(), "1.0");
+  EXPECT_EQ(restored.searchByCategory("Utility").size(), 2u);
+  EXPECT_FALSE(restored.getComponents()[1].getIcons().has_value());
+}
+
+TEST_F(AppstreamCatalogTest, StaleOrCorruptSnapshotIsRebuilt) {
+  { const AppstreamCatalog parsed(catalog_path_, "", snapshotPath()); }
+
+  // A different language invalidates the snapshot and rewrites it.
+  const AppstreamCatalog localized(catalog_path_, "de", snapshotPath());
+  EXPECT_EQ(localized.getTotalComponentCount(), 3u);
+
+  {
+    std::fstream snapshot(snapshotPath(),
+                          std::ios::binary | std::ios::in | std::ios::out);
+    snapshot.seekp(64);
+    snapshot << std::string(64, '\xff');
+  }
+  const AppstreamCatalog reparsed(catalog_path_, "de", snapshotPath());
+  expectSameCatalog(localized, reparsed);
+}
+
+TEST_F(AppstreamCatalogTest, RankedPrefixSearch) {
+  const AppstreamCatalog catalog(catalog_path_, "");
+
+  // Name matches outrank keyword-only matches; the last word is a prefix.
+  auto results = catalog.search("ZET");
+  ASSERT_EQ(results.size(), 2u);
+  EXPECT_EQ(results[0]->getName(), "Zeta");
+  EXPECT_EQ(results[1]->getName(), "Duplicate");
+
+  results = catalog.search("first by na");
+  ASSERT_EQ(results.size(), 1u);
+  EXPECT_EQ(results[0]->getName(), "Alpha");
+
+  // Earlier words must match whole terms.
+  EXPECT_TRUE(catalog.search("fir by").empty());
+  EXPECT_TRUE(catalog.search("note alpha").empty());
+  EXPECT_EQ(catalog.search("example", 1).size(), 1u);
+  EXPECT_TRUE(catalog.search("  ").empty());
+}
+
+TEST(AppstreamSearchIndexTest, TokenizerFoldsCase) {
+  EXPECT_EQ(AppstreamSearchIndex::tokenize("GNOME Web-Browser, v2.0!"),
+            (std::vector<std::string>{"gnome", "web", "browser", "v2", "0"}));
+  EXPECT_EQ(AppstreamSearchIndex::tokenize("ÜBER Žluť ΣΟΦΊΑ Привет"),
+            (std::vector<std::string>{"über", "žluť", "σοφία", "привет"}));
+  EXPECT_TRUE(AppstreamSearchIndex::tokenize(" \xff— ").empty());
+}
+
+TEST_F(AppstreamCatalogTest, MissingFileYieldsEmptyCatalog) {
+  const AppstreamCatalog catalog(catalog_path_ + ".missing", "en");
+  EXPECT_EQ(catalog.getTotalComponentCount(), 0u);
+  EXPECT_EQ(catalog.searchById("org.example.Zeta"), nullptr);
+}
+
+TEST(WorkerPoolTest, RunsTasksConcurrentlyAndDrainsOnDestruction) {
+  std::atomic<int> running{0};
+  std::atomic<int> peak{0};
+  std::atomic<int> done{0};
+  {
+    WorkerPool pool(4);
+    for (int i = 0; i < 8; i++) {
+      pool.Post([&] {
+        const int now = ++running;
+        int expected = peak.load();
+        while (now > expected && !peak.compare_exchange_weak(expected, now)) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        --running;
+        ++done;
+      });
+    }
+  }
+  EXPECT_EQ(done.load(), 8);
+  EXPECT_GT(peak.load(), 1);
+}
+
+TEST(DelayedTaskRunnerTest, RunsByDueTimeAndDrainsOnDestruction) {
+  std::mutex mutex;
+  std::vector<int> order;
+  const auto record = [&](const int value) {
+    return [&, value] {
+      std::lock_guard lock(mutex);
+      order.push_back(value);
+    };
+  };
+  {
+    DelayedTaskRunner runner;
+    runner.PostDelayed(std::chrono::milliseconds(60), record(3));
+    runner.PostDelayed(std::chrono::milliseconds(20), record(2));
+    runner.Post(record(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(120));
+    // Still queued on destruction, so run without waiting an hour.
+    runner.PostDelayed(std::chrono::hours(1), record(4));
+  }
+  EXPECT_EQ(order, (std::vector<int>{1, 2, 3, 4}));
+}
+
 TEST_F(FlatpakPluginTest, GetUserInstallationsTest) {
   const auto result = FlatpakShim::GetUserInstallation();
 
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transaction_queue.h"
+
+#include <future>
+#include <utility>
+
+#include "plugins/common/common.h"
+
+namespace flatpak_plugin {
+
+TransactionQueue::TransactionQueue(EventCallback on_event)
+    : on_event_(std::move(on_event)) {}
+
+TransactionQueue::~TransactionQueue() {
+  std::lock_guard lock(mutex_);
+  for (const auto& [id, cancellable] : cancellables_) {
+    g_cancellable_cancel(cancellable);
+  }
+}
+
+flutter::EncodableMap TransactionQueue::MakeEvent(const int64_t id,
+                                                  const char* event) {
+  return {
+      {flutter::EncodableValue("id"), flutter::EncodableValue(id)},
+      {flutter::EncodableValue("event"), flutter::EncodableValue(event)},
+  };
+}
+
+int64_t TransactionQueue::Submit(std::vector<std::string> install_ids,
+                                 std::vector<std::string> uninstall_ids,
+                                 DoneCallback on_done) {
+  GCancellable* cancellable = g_cancellable_new();
+  int64_t id;
+  {
+    std::lock_guard lock(mutex_);
+    id = next_id_++;
+    cancellables_.emplace(id, cancellable);
+  }
+  if (on_event_) {
+    on_event_(MakeEvent(id, "queued"));
+  }
+
+  worker_.Post([this, id, cancellable, install = std::move(install_ids),
+                uninstall = std::move(uninstall_ids),
+                on_done = std::move(on_done)] {
+    const auto on_progress = [this, id](const TransactionProgress& progress) {
+      auto event = MakeEvent(id, "progress");
+      event[flutter::EncodableValue("ref")] =
+          flutter::EncodableValue(progress.ref);
+      event[flutter::EncodableValue("kind")] =
+          flutter::EncodableValue(progress.kind);
+      event[flutter::EncodableValue("operation")] =
+          flutter::EncodableValue(static_cast<int64_t>(progress.operation));
+      event[flutter::EncodableValue("operationCount")] =
+          flutter::EncodableValue(
+              static_cast<int64_t>(progress.operation_count));
+      event[flutter::EncodableValue("progress")] =
+          flutter::EncodableValue(progress.percent);
+      event[flutter::EncodableValue("bytesTransferred")] =
+          flutter::EncodableValue(
+              static_cast<int64_t>(progress.bytes_transferred));
+      event[flutter::EncodableValue("eta")] =
+          flutter::EncodableValue(progress.eta_seconds);
+      event[flutter::EncodableValue("status")] =
+          flutter::EncodableValue(progress.status);
+      on_event_(std::move(event));
+    };
+
+    auto result = FlatpakShim::RunTransaction(
+        install, uninstall,
+        on_event_ ? TransactionProgressCallback(on_progress) : nullptr,
+        cancellable);
+    {
+      std::lock_guard lock(mutex_);
+      cancellables_.erase(id);
+    }
+    g_object_unref(cancellable);
+
+    if (on_event_) {
+      if (!result.has_error()) {
+        on_event_(MakeEvent(id, "done"));
+      } else if (result.error().code() == "TRANSACTION_CANCELLED") {
+        on_event_(MakeEvent(id, "cancelled"));
+      } else {
+        auto event = MakeEvent(id, "error");
+        event[flutter::EncodableValue("code")] =
+            flutter::EncodableValue(result.error().code());
+        event[flutter::EncodableValue("message")] =
+            flutter::EncodableValue(result.error().message());
+        on_event_(std::move(event));
+      }
+    }
+    if (on_done) {
+      on_done(result);
+    }
+  });
+  return id;
+}
+
+ErrorOr<bool> TransactionQueue::Run(std::vector<std::string> install_ids,
+                                    std::vector<std::string> uninstall_ids) {
+  std::promise<ErrorOr<bool>> promise;
+  auto result = promise.get_future();
+  Submit(std::move(install_ids), std::move(uninstall_ids),
+         [&promise](const ErrorOr<bool>& value) { promise.set_value(value); });
+  return result.get();
+}
+
+bool TransactionQueue::Cancel(const int64_t id) {
+  std::lock_guard lock(mutex_);
+  const auto it = cancellables_.find(id);
+  if (it == cancellables_.end()) {
+    return false;
+  }
+  spdlog::info("[FlatpakPlugin] Cancelling transaction {}", id);
+  g_cancellable_cancel(it->second);
+  return true;
+}
+
+}  // namespace flatpak_plugin
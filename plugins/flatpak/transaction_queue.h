@@ -0,0 +1,101 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PLUGINS_FLATPAK_TRANSACTION_QUEUE_H
+#define PLUGINS_FLATPAK_TRANSACTION_QUEUE_H
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "flatpak_shim.h"
+#include "worker_pool.h"
+
+namespace flatpak_plugin {
+
+/**
+ * \brief Runs install/uninstall transactions one after another on a worker
+ * thread and reports their lifecycle and progress as events.
+ *
+ * Every event is a map with the transaction "id" and an "event" of
+ * "queued", "progress", "done", "error" or "cancelled". Progress events add
+ * "ref", "kind", "operation", "operationCount", "progress" (percent),
+ * "bytesTransferred", "eta" (seconds, -1 if unknown) and "status"; error
+ * events add "code" and "message".
+ */
+class TransactionQueue {
+ public:
+  using EventCallback = std::function<void(flutter::EncodableMap)>;
+  using DoneCallback = std::function<void(const ErrorOr<bool>&)>;
+
+  /**
+   * \param on_event Called from the worker thread for every event.
+   */
+  explicit TransactionQueue(EventCallback on_event);
+
+  /**
+   * \brief Cancels the running and queued transactions and waits for them.
+   */
+  ~TransactionQueue();
+
+  TransactionQueue(const TransactionQueue&) = delete;
+  TransactionQueue& operator=(const TransactionQueue&) = delete;
+
+  /**
+   * \brief Queues one transaction for a batch of applications.
+   * \param install_ids Application ids or refs to install.
+   * \param uninstall_ids Application ids or refs to uninstall.
+   * \param on_done Called on the worker thread with the result, may be
+   * empty.
+   * \return The transaction id used in events and for Cancel().
+   */
+  int64_t Submit(std::vector<std::string> install_ids,
+                 std::vector<std::string> uninstall_ids,
+                 DoneCallback on_done = nullptr);
+
+  /**
+   * \brief Queues a transaction and waits for its result.
+   */
+  ErrorOr<bool> Run(std::vector<std::string> install_ids,
+                    std::vector<std::string> uninstall_ids);
+
+  /**
+   * \brief Cancels a queued or running transaction.
+   * \param id Transaction id returned by Submit().
+   * \return false if the transaction already finished.
+   */
+  bool Cancel(int64_t id);
+
+ private:
+  static flutter::EncodableMap MakeEvent(int64_t id, const char* event);
+
+  EventCallback on_event_;
+
+  std::mutex mutex_;
+  int64_t next_id_ = 1;
+  std::unordered_map<int64_t, GCancellable*> cancellables_;
+
+  // Transactions lock the installation, so one worker is enough. Declared
+  // last so it is joined before the members above are destroyed.
+  WorkerPool worker_{1};
+};
+
+}  // namespace flatpak_plugin
+
+#endif  // PLUGINS_FLATPAK_TRANSACTION_QUEUE_H
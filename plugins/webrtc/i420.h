@@ -0,0 +1,318 @@
+/*
+ * Copyright 2020-2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <GLES3/gl3.h>
+
+#include <plugins/common/common.h>
+
+namespace flutter_webrtc_plugin::i420 {
+
+static const GLchar* kVertexSource = R"glsl(#version 300 es
+  precision highp float;
+
+  layout(location = 0) in vec3 vertexPosition_modelspace;
+  layout(location = 1) in vec2 texcoord;
+  out vec2 Texcoord;
+  void main()
+  {
+    Texcoord = texcoord;
+    gl_Position.xyz = vertexPosition_modelspace;
+    gl_Position.w = 1.0;
+  }
+)glsl";
+
+static const GLchar* kFragmentSource = R"glsl(#version 300 es
+  precision highp float;
+  in vec2 Texcoord;
+  uniform sampler2D textureY;
+  uniform sampler2D textureU;
+  uniform sampler2D textureV;
+  layout(location = 0) out vec4 fragColor;
+  void main() {
+    float r, g, b, y, u, v;
+    vec2 coord = vec2(Texcoord.x, 1.0 - Texcoord.y);
+    y = texture(textureY, coord).r - 0.0625;
+    u = texture(textureU, coord).r - 0.5;
+    v = texture(textureV, coord).r - 0.5;
+    r = clamp(y + 1.370705 * v, 0.0, 1.0);
+    g = clamp(y - 0.337633 * u - 0.698001 * v, 0.0, 1.0);
+    b = clamp(y + 1.732446 * u, 0.0, 1.0);
+    fragColor = vec4(r, g, b, 1.0);
+  }
+)glsl";
+
+/**
+ * @brief Converts I420 frames to RGBA on the GPU.
+ *
+ * The Y, U and V planes are uploaded as three GL_R8 textures and drawn into
+ * an FBO backed by `textureId`, which is handed to Flutter as a GL texture.
+ * `textureId` keeps its name across resize() so the registered Flutter
+ * texture stays valid when the remote video changes resolution.
+ *
+ * All methods must be called with the texture registrar's GL context
+ * current.
+ */
+class Shader {
+ public:
+  GLuint textureId{};
+  GLuint framebuffer{};
+  GLuint program{};
+  GLsizei width{}, height{};
+
+  Shader() {
+    glGenFramebuffers(1, &framebuffer);
+
+    glGenVertexArrays(1, &vertex_arr_id_);
+    glBindVertexArray(vertex_arr_id_);
+
+    program = load_shaders();
+    texY = glGetUniformLocation(program, "textureY");
+    texU = glGetUniformLocation(program, "textureU");
+    texV = glGetUniformLocation(program, "textureV");
+
+    glGenTextures(3, &planeTexture[0]);
+    for (const auto plane : planeTexture) {
+      glBindTexture(GL_TEXTURE_2D, plane);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    glGenTextures(1, &textureId);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Vertex buffer setup
+    glGenBuffers(1, &vertex_buffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    static constexpr GLfloat g_vertex_buffer_data[] = {
+        -1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, -1.0f, 1.0f, 0.0f,
+        1.0f,  1.0f,  0.0f, 1.0f,  -1.0f, 0.0f, -1.0f, 1.0f, 0.0f,
+    };
+    glBufferData(GL_ARRAY_BUFFER, sizeof(g_vertex_buffer_data),
+                 g_vertex_buffer_data, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &coord_buffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, coord_buffer_);
+    static constexpr GLfloat coord_buffer_data[] = {
+        0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+    };
+    glBufferData(GL_ARRAY_BUFFER, sizeof(coord_buffer_data), coord_buffer_data,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    // Allocate a placeholder so the texture is complete before the first
+    // frame arrives.
+    resize(1, 1);
+  }
+
+  ~Shader() {
+    glDeleteBuffers(1, &coord_buffer_);
+    glDeleteBuffers(1, &vertex_buffer_);
+    glDeleteVertexArrays(1, &vertex_arr_id_);
+    glDeleteProgram(program);
+    glDeleteTextures(1, &textureId);
+    glDeleteTextures(3, &planeTexture[0]);
+    glDeleteFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }
+
+  Shader(const Shader&) = delete;
+  Shader& operator=(const Shader&) = delete;
+
+  /**
+   * @brief Re-specify output and plane storage for a new frame size
+   * @param[in] _width Frame width in pixels
+   * @param[in] _height Frame height in pixels
+   * @return void
+   * @relation
+   * flutter
+   */
+  void resize(const GLsizei _width, const GLsizei _height) {
+    width = _width;
+    height = _height;
+    const GLsizei chroma_width = (width + 1) / 2;
+    const GLsizei chroma_height = (height + 1) / 2;
+
+    glBindTexture(GL_TEXTURE_2D, planeTexture[0]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED,
+                 GL_UNSIGNED_BYTE, nullptr);
+    for (int i = 1; i < 3; i++) {
+      glBindTexture(GL_TEXTURE_2D, planeTexture[i]);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, chroma_width, chroma_height, 0,
+                   GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           textureId, 0);
+    if (const auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        status != GL_FRAMEBUFFER_COMPLETE) {
+      spdlog::error("[webrtc] I420 framebuffer is not complete: 0x{:X}",
+                    status);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }
+
+  /**
+   * @brief Load I420 planes
+   * @param[in] y_buf Pointer to the luminance plane
+   * @param[in] y_stride Row stride of the luminance plane in bytes
+   * @param[in] u_buf Pointer to the U plane
+   * @param[in] u_stride Row stride of the U plane in bytes
+   * @param[in] v_buf Pointer to the V plane
+   * @param[in] v_stride Row stride of the V plane in bytes
+   * @return void
+   * @relation
+   * flutter
+   */
+  void load_planes(const uint8_t* y_buf,
+                   const GLint y_stride,
+                   const uint8_t* u_buf,
+                   const GLint u_stride,
+                   const uint8_t* v_buf,
+                   const GLint v_stride) const {
+    const GLsizei chroma_width = (width + 1) / 2;
+    const GLsizei chroma_height = (height + 1) / 2;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    upload_plane(GL_TEXTURE0, planeTexture[0], width, height, y_stride, y_buf);
+    upload_plane(GL_TEXTURE1, planeTexture[1], chroma_width, chroma_height,
+                 u_stride, u_buf);
+    upload_plane(GL_TEXTURE2, planeTexture[2], chroma_width, chroma_height,
+                 v_stride, v_buf);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  }
+
+  void draw_core() const {
+    SPDLOG_TRACE("[webrtc] i420 draw_core");
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    glUseProgram(program);
+    glUniform1i(texY, 0);
+    glUniform1i(texU, 1);
+    glUniform1i(texV, 2);
+
+    glBindVertexArray(vertex_arr_id_);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, coord_buffer_);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // The texture is sampled from the raster context.
+    glFinish();
+  }
+
+ private:
+  GLint texY{};
+  GLint texU{};
+  GLint texV{};
+  std::array<GLuint, 3> planeTexture{};
+
+  GLuint vertex_arr_id_{};
+  GLuint vertex_buffer_{};
+  GLuint coord_buffer_{};
+
+  static void upload_plane(const GLenum unit,
+                           const GLuint texture,
+                           const GLsizei plane_width,
+                           const GLsizei plane_height,
+                           const GLint stride,
+                           const uint8_t* data) {
+    glActiveTexture(unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, plane_width, plane_height, GL_RED,
+                    GL_UNSIGNED_BYTE, data);
+  }
+
+  static GLuint load_shaders(const GLchar* vsource = kVertexSource,
+                             const GLchar* fsource = kFragmentSource) {
+    GLint result;
+    GLsizei length;
+    std::array<GLchar, 1000> info{};
+
+    const GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex_shader, 1, &vsource, nullptr);
+    glCompileShader(vertex_shader);
+    glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &result);
+    if (result == GL_FALSE) {
+      glGetShaderInfoLog(vertex_shader, info.size(), &length, info.data());
+      SPDLOG_ERROR("Failed to compile {}", std::string(info.data(), length));
+      glDeleteShader(vertex_shader);
+      return 0;
+    }
+
+    const GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragment_shader, 1, &fsource, nullptr);
+    glCompileShader(fragment_shader);
+    glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &result);
+    if (result == GL_FALSE) {
+      glGetShaderInfoLog(fragment_shader, info.size(), &length, info.data());
+      SPDLOG_ERROR("Failed to compile {}", std::string(info.data(), length));
+      glDeleteShader(vertex_shader);
+      glDeleteShader(fragment_shader);
+      return 0;
+    }
+
+    const GLuint shaderProgram = glCreateProgram();
+    glAttachShader(shaderProgram, vertex_shader);
+    glAttachShader(shaderProgram, fragment_shader);
+    glLinkProgram(shaderProgram);
+
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &result);
+    if (result == GL_FALSE) {
+      glGetProgramInfoLog(shaderProgram, info.size(), &length, info.data());
+      SPDLOG_ERROR("Fail to link {}", std::string(info.data(), length));
+      return 0;
+    }
+
+    glDetachShader(shaderProgram, vertex_shader);
+    glDetachShader(shaderProgram, fragment_shader);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+    return shaderProgram;
+  }
+};
+
+}  // namespace flutter_webrtc_plugin::i420
@@ -4,6 +4,11 @@
 #include "flutter_common.h"
 #include "flutter_webrtc_base.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace flutter_webrtc_plugin {
 
 class FlutterRTCDataChannelObserver : public RTCDataChannelObserver {
@@ -17,11 +22,28 @@ class FlutterRTCDataChannelObserver : public RTCDataChannelObserver {
 
   void OnMessage(const char* buffer, int length, bool binary) override;
 
+  // Coalesces messages received within |interval| into a single
+  // "dataChannelReceiveMessages" event carrying a "messages" list. A zero
+  // interval restores one "dataChannelReceiveMessage" event per message,
+  // after the queued messages have been delivered.
+  void SetBatchInterval(std::chrono::milliseconds interval);
+
   scoped_refptr<RTCDataChannel> data_channel() { return data_channel_; }
 
  private:
+  void StopBatching();
+  void BatchLoop(std::chrono::milliseconds interval);
+  void FlushBatch(EncodableList messages);
+
   std::unique_ptr<EventChannelProxy> event_channel_;
   scoped_refptr<RTCDataChannel> data_channel_;
+
+  std::mutex batch_mutex_;
+  std::condition_variable batch_cv_;
+  EncodableList pending_messages_;
+  std::thread batch_thread_;
+  bool batching_ = false;
+  bool batch_stop_ = false;
 };
 
 class FlutterDataChannel {
@@ -39,6 +61,10 @@ class FlutterDataChannel {
                               const EncodableValue& data,
                               std::unique_ptr<MethodResultProxy>);
 
+  void DataChannelSetBatchInterval(const std::string& data_channel_uuid,
+                                   int64_t interval_ms,
+                                   std::unique_ptr<MethodResultProxy>);
+
   void DataChannelClose(RTCDataChannel* data_channel,
                         const std::string& data_channel_uuid,
                         std::unique_ptr<MethodResultProxy>);
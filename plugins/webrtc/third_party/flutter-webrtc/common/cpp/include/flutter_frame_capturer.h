@@ -7,31 +7,66 @@
 #include "rtc_video_frame.h"
 #include "rtc_video_renderer.h"
 
-#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
 
 namespace flutter_webrtc_plugin {
 
 using namespace libwebrtc;
 
+// Captures a single frame from a video track without blocking the caller.
+//
+// The capturer registers itself as a renderer, OnFrame() fulfils a one-shot
+// promise with the first frame it sees, and a worker thread waits for that
+// frame (up to the timeout), detaches from the track, encodes and writes the
+// file, then completes the method result. Instances are shared-owned by the
+// worker so they outlive CaptureFrame().
 class FlutterFrameCapturer
-    : public RTCVideoRenderer<scoped_refptr<RTCVideoFrame>> {
+    : public RTCVideoRenderer<scoped_refptr<RTCVideoFrame>>,
+      public std::enable_shared_from_this<FlutterFrameCapturer> {
  public:
-  FlutterFrameCapturer(RTCVideoTrack* track, std::string path);
+  enum class Format {
+    kPng,
+    // Needs libjpeg at build time (ENABLE_JPEG); captureFrame fails without.
+    kJpeg,
+    // Tightly packed RGBA8888, no header. Cheapest to produce.
+    kRaw,
+  };
+
+  static constexpr std::chrono::milliseconds kDefaultTimeout{3000};
+  static constexpr int kDefaultJpegQuality = 90;
+
+  FlutterFrameCapturer(RTCVideoTrack* track,
+                       std::string path,
+                       Format format,
+                       std::chrono::milliseconds timeout = kDefaultTimeout);
+
+  // Picks the output format from the file extension (.jpg/.jpeg, .raw/.rgba,
+  // anything else is PNG).
+  static Format FormatFromPath(const std::string& path);
+
+  // Parses "png", "jpeg"/"jpg" or "raw". Falls back to FormatFromPath().
+  static Format FormatFromString(const std::string& format,
+                                 const std::string& path);
 
   void OnFrame(scoped_refptr<RTCVideoFrame> frame) override;
 
+  // Returns immediately; |result| is completed from the worker thread.
   void CaptureFrame(std::unique_ptr<MethodResultProxy> result);
 
  private:
-  RTCVideoTrack* track_;
+  scoped_refptr<RTCVideoTrack> track_;
   std::string path_;
-  std::mutex mutex_;
-  scoped_refptr<RTCVideoFrame> frame_;
-  volatile bool catch_frame_{};
+  Format format_;
+  std::chrono::milliseconds timeout_;
+  std::atomic<bool> frame_captured_{false};
+  std::promise<scoped_refptr<RTCVideoFrame>> frame_promise_;
 
-  bool SaveFrame();
+  bool SaveFrame(const scoped_refptr<RTCVideoFrame>& frame) const;
 };
 
 }  // namespace flutter_webrtc_plugin
 
-#endif  // !FLUTTER_WEBRTC_RTC_FRAME_CAPTURER_HXX
\ No newline at end of file
+#endif  // !FLUTTER_WEBRTC_RTC_FRAME_CAPTURER_HXX
@@ -145,6 +145,8 @@ class FlutterPeerConnection {
 
   static void CaptureFrame(RTCVideoTrack* track,
                            std::string path,
+                           const std::string& format,
+                           int64_t timeout_ms,
                            std::unique_ptr<MethodResultProxy> result);
 
   static scoped_refptr<RTCRtpTransceiver> getRtpTransceiverById(
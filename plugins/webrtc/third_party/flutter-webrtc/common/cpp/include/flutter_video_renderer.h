@@ -7,6 +7,8 @@
 #include "rtc_video_frame.h"
 #include "rtc_video_renderer.h"
 
+#include "plugins/webrtc/i420.h"
+
 #include <mutex>
 
 namespace flutter_webrtc_plugin {
@@ -25,15 +27,30 @@ class FlutterVideoRenderer
                   std::unique_ptr<flutter::TextureVariant> texture,
                   int64_t texture_id);
 
+  // Switches the renderer to GPU surface mode: frames are uploaded as I420
+  // planes and converted by |shader| instead of CopyPixelBuffer. Must be
+  // called before initialize().
+  void SetShader(std::unique_ptr<i420::Shader> shader);
+
+  // Deletes the GL objects owned by the renderer. Safe to call in pixel
+  // buffer mode.
+  void ReleaseShader();
+
   virtual const FlutterDesktopPixelBuffer* CopyPixelBuffer(size_t width,
                                                            size_t height) const;
 
+  const FlutterDesktopGpuSurfaceDescriptor* GpuSurfaceDescriptor(
+      size_t width,
+      size_t height) const;
+
   void OnFrame(scoped_refptr<RTCVideoFrame> frame) override;
 
   void SetVideoTrack(const scoped_refptr<RTCVideoTrack>& track);
 
   int64_t texture_id() const { return texture_id_; }
 
+  GLuint gl_texture_id() const { return shader_texture_id_; }
+
   bool CheckMediaStream(const std::string& mediaId) const;
 
   bool CheckVideoTrack(const std::string& mediaId) const;
@@ -55,6 +72,10 @@ class FlutterVideoRenderer
   std::unique_ptr<flutter::TextureVariant> texture_;
   std::shared_ptr<FlutterDesktopPixelBuffer> pixel_buffer_;
   mutable std::shared_ptr<uint8_t> rgb_buffer_;
+  bool gpu_surface_ = false;
+  std::unique_ptr<i420::Shader> shader_;
+  GLuint shader_texture_id_ = 0;
+  FlutterDesktopGpuSurfaceDescriptor descriptor_{};
   mutable std::mutex mutex_;
   RTCVideoFrame::VideoRotation rotation_ = RTCVideoFrame::kVideoRotation_0;
 };
@@ -74,6 +95,9 @@ class FlutterVideoRendererManager {
                             std::unique_ptr<MethodResultProxy> result);
 
  private:
+  // True unless WEBRTC_VIDEO_RENDERER=pixel_buffer is set.
+  static bool UseGpuSurface();
+
   FlutterWebRTCBase* base_;
   std::map<int64_t, scoped_refptr<FlutterVideoRenderer>> renderers_;
 };
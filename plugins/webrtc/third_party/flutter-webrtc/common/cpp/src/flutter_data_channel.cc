@@ -1,5 +1,6 @@
 #include "flutter_data_channel.h"
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -15,7 +16,81 @@ FlutterRTCDataChannelObserver::FlutterRTCDataChannelObserver(
   data_channel_->RegisterObserver(this);
 }
 
-FlutterRTCDataChannelObserver::~FlutterRTCDataChannelObserver() = default;
+FlutterRTCDataChannelObserver::~FlutterRTCDataChannelObserver() {
+  StopBatching();
+}
+
+void FlutterRTCDataChannelObserver::SetBatchInterval(
+    std::chrono::milliseconds interval) {
+  StopBatching();
+  if (interval.count() <= 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(batch_mutex_);
+  batching_ = true;
+  batch_stop_ = false;
+  batch_thread_ = std::thread(&FlutterRTCDataChannelObserver::BatchLoop, this,
+                              interval);
+}
+
+void FlutterRTCDataChannelObserver::StopBatching() {
+  {
+    std::lock_guard<std::mutex> lock(batch_mutex_);
+    if (!batching_) {
+      return;
+    }
+    batch_stop_ = true;
+  }
+  batch_cv_.notify_one();
+  if (batch_thread_.joinable()) {
+    batch_thread_.join();
+  }
+
+  // Messages keep queueing until the thread's last batch is out. The rest
+  // is delivered under the lock, so OnMessage() cannot send a newer message
+  // directly ahead of them.
+  std::lock_guard<std::mutex> lock(batch_mutex_);
+  EncodableList messages;
+  messages.swap(pending_messages_);
+  FlushBatch(std::move(messages));
+  batching_ = false;
+}
+
+void FlutterRTCDataChannelObserver::BatchLoop(
+    std::chrono::milliseconds interval) {
+  std::unique_lock<std::mutex> lock(batch_mutex_);
+  while (!batch_stop_) {
+    batch_cv_.wait(lock, [this] {
+      return batch_stop_ || !pending_messages_.empty();
+    });
+    if (batch_stop_) {
+      break;
+    }
+    // Give the rest of this frame's messages a chance to arrive.
+    batch_cv_.wait_for(lock, interval, [this] { return batch_stop_; });
+    if (batch_stop_) {
+      // StopBatching() delivers the remainder in order.
+      break;
+    }
+    EncodableList messages;
+    messages.swap(pending_messages_);
+    lock.unlock();
+    FlushBatch(std::move(messages));
+    lock.lock();
+  }
+}
+
+void FlutterRTCDataChannelObserver::FlushBatch(EncodableList messages) {
+  if (messages.empty()) {
+    return;
+  }
+  EncodableMap params;
+  params[EncodableValue("event")] =
+      EncodableValue("dataChannelReceiveMessages");
+  params[EncodableValue("id")] = EncodableValue(data_channel_->id());
+  params[EncodableValue("messages")] = EncodableValue(std::move(messages));
+  event_channel_->Success(EncodableValue(std::move(params)), true);
+}
 
 void FlutterDataChannel::CreateDataChannel(
     const std::string& peerConnectionId,
@@ -75,19 +150,43 @@ void FlutterDataChannel::DataChannelSend(
     const std::string& type,
     const EncodableValue& data,
     std::unique_ptr<MethodResultProxy> result) {
+  // Send straight from the decoded message; the data channel copies the
+  // payload into its own send queue.
   bool is_binary = type == "binary";
-  if (is_binary && TypeIs<std::vector<uint8_t>>(data)) {
-    auto buffer = GetValue<std::vector<uint8_t>>(data);
-    data_channel->Send(buffer.data(), static_cast<uint32_t>(buffer.size()),
+  if (const auto* buffer = std::get_if<std::vector<uint8_t>>(&data);
+      is_binary && buffer) {
+    data_channel->Send(buffer->data(), static_cast<uint32_t>(buffer->size()),
                        true);
+  } else if (const auto* str = std::get_if<std::string>(&data)) {
+    data_channel->Send(reinterpret_cast<const uint8_t*>(str->data()),
+                       static_cast<uint32_t>(str->size()), false);
   } else {
-    auto str = GetValue<std::string>(data);
-    data_channel->Send(reinterpret_cast<const uint8_t*>(str.c_str()),
-                       static_cast<uint32_t>(str.length()), false);
+    result->Error("dataChannelSendFailed",
+                  "dataChannelSend() unsupported data type");
+    return;
   }
   result->Success();
 }
 
+void FlutterDataChannel::DataChannelSetBatchInterval(
+    const std::string& data_channel_uuid,
+    int64_t interval_ms,
+    std::unique_ptr<MethodResultProxy> result) {
+  base_->lock();
+  auto it = base_->data_channel_observers_.find(data_channel_uuid);
+  FlutterRTCDataChannelObserver* observer =
+      it != base_->data_channel_observers_.end() ? it->second.get() : nullptr;
+  base_->unlock();
+  if (observer == nullptr) {
+    result->Error("dataChannelSetBatchIntervalFailed",
+                  "dataChannelSetBatchInterval() data_channel is null");
+    return;
+  }
+  observer->SetBatchInterval(
+      std::chrono::milliseconds(std::max<int64_t>(interval_ms, 0)));
+  result->Success();
+}
+
 void FlutterDataChannel::DataChannelClose(
     RTCDataChannel* data_channel,
     const std::string& data_channel_uuid,
@@ -136,17 +235,33 @@ void FlutterRTCDataChannelObserver::OnStateChange(RTCDataChannelState state) {
 void FlutterRTCDataChannelObserver::OnMessage(const char* buffer,
                                               int length,
                                               bool binary) {
+  // Copy the payload exactly once, straight into the value that is handed
+  // to the codec.
+  const auto size = static_cast<size_t>(length);
+  EncodableValue data =
+      binary ? EncodableValue(std::vector<uint8_t>(
+                   reinterpret_cast<const uint8_t*>(buffer),
+                   reinterpret_cast<const uint8_t*>(buffer) + size))
+             : EncodableValue(std::string(buffer, size));
+
+  {
+    std::lock_guard<std::mutex> lock(batch_mutex_);
+    if (batching_) {
+      EncodableMap message;
+      message[EncodableValue("type")] =
+          EncodableValue(binary ? "binary" : "text");
+      message[EncodableValue("data")] = std::move(data);
+      pending_messages_.emplace_back(std::move(message));
+      batch_cv_.notify_one();
+      return;
+    }
+  }
+
   EncodableMap params;
   params[EncodableValue("event")] = EncodableValue("dataChannelReceiveMessage");
-
   params[EncodableValue("id")] = EncodableValue(data_channel_->id());
   params[EncodableValue("type")] = EncodableValue(binary ? "binary" : "text");
-  std::string str(buffer, static_cast<size_t>(length));
-  params[EncodableValue("data")] =
-      binary ? EncodableValue(std::vector<uint8_t>(str.begin(), str.end()))
-             : EncodableValue(str);
-
-  auto data = EncodableValue(params);
-  event_channel_->Success(data, true);
+  params[EncodableValue("data")] = std::move(data);
+  event_channel_->Success(EncodableValue(std::move(params)), true);
 }
 }  // namespace flutter_webrtc_plugin
@@ -4,75 +4,222 @@
 
 #include "flutter_frame_capturer.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#if defined(ENABLE_JPEG)
+#include <csetjmp>
+
+#include <jpeglib.h>
+#endif
+
 #include "svpng.hpp"
 
 namespace flutter_webrtc_plugin {
 
+namespace {
+
+std::string ToLower(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return value;
+}
+
+bool EndsWith(const std::string& value, const std::string& suffix) {
+  return value.size() >= suffix.size() &&
+         value.compare(value.size() - suffix.size(), suffix.size(), suffix) ==
+             0;
+}
+
+#if defined(ENABLE_JPEG)
+struct JpegErrorManager {
+  jpeg_error_mgr manager;
+  jmp_buf jump;
+};
+
+[[noreturn]] void OnJpegError(const j_common_ptr cinfo) {
+  longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump, 1);
+}
+
+// libjpeg reports errors through error_exit, whose default calls exit().
+// Nothing below setjmp() may own resources that need unwinding, so the row
+// buffer is allocated before it.
+bool WriteJpeg(FILE* file,
+               const uint8_t* rgba,
+               const int width,
+               const int height,
+               const int quality) {
+  std::vector<uint8_t> row(static_cast<size_t>(width) * 3);
+  jpeg_compress_struct cinfo{};
+  JpegErrorManager error{};
+  cinfo.err = jpeg_std_error(&error.manager);
+  error.manager.error_exit = OnJpegError;
+  error.manager.output_message = [](j_common_ptr) {};
+
+  if (setjmp(error.jump)) {
+    jpeg_destroy_compress(&cinfo);
+    return false;
+  }
+
+  jpeg_create_compress(&cinfo);
+  jpeg_stdio_dest(&cinfo, file);
+
+  cinfo.image_width = static_cast<JDIMENSION>(width);
+  cinfo.image_height = static_cast<JDIMENSION>(height);
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, quality, TRUE);
+  jpeg_start_compress(&cinfo, TRUE);
+
+  // Drop the alpha channel one row at a time.
+  while (cinfo.next_scanline < cinfo.image_height) {
+    const uint8_t* src =
+        rgba + static_cast<size_t>(cinfo.next_scanline) * width * 4;
+    for (int x = 0; x < width; x++) {
+      row[x * 3] = src[x * 4];
+      row[x * 3 + 1] = src[x * 4 + 1];
+      row[x * 3 + 2] = src[x * 4 + 2];
+    }
+    JSAMPROW row_pointer = row.data();
+    jpeg_write_scanlines(&cinfo, &row_pointer, 1);
+  }
+
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  return true;
+}
+#endif
+
+}  // namespace
+
 FlutterFrameCapturer::FlutterFrameCapturer(RTCVideoTrack* track,
-                                           std::string path) {
-  track_ = track;
-  path_ = std::move(path);
+                                           std::string path,
+                                           Format format,
+                                           std::chrono::milliseconds timeout)
+    : track_(track),
+      path_(std::move(path)),
+      format_(format),
+      timeout_(timeout) {}
+
+FlutterFrameCapturer::Format FlutterFrameCapturer::FormatFromPath(
+    const std::string& path) {
+  const auto lower = ToLower(path);
+  if (EndsWith(lower, ".jpg") || EndsWith(lower, ".jpeg")) {
+    return Format::kJpeg;
+  }
+  if (EndsWith(lower, ".raw") || EndsWith(lower, ".rgba")) {
+    return Format::kRaw;
+  }
+  return Format::kPng;
+}
+
+FlutterFrameCapturer::Format FlutterFrameCapturer::FormatFromString(
+    const std::string& format,
+    const std::string& path) {
+  const auto lower = ToLower(format);
+  if (lower == "png") {
+    return Format::kPng;
+  }
+  if (lower == "jpeg" || lower == "jpg") {
+    return Format::kJpeg;
+  }
+  if (lower == "raw") {
+    return Format::kRaw;
+  }
+  return FormatFromPath(path);
 }
 
 void FlutterFrameCapturer::OnFrame(scoped_refptr<RTCVideoFrame> frame) {
-  if (frame_ != nullptr) {
+  // Only the first frame is of interest; later ones may still arrive until
+  // the worker detaches us from the track.
+  if (frame_captured_.exchange(true)) {
     return;
   }
-
-  frame_ = frame.get()->Copy();
-  catch_frame_ = true;
+  // Frame buffers are immutable and ref-counted, holding a reference is
+  // enough to keep the pixels alive for the encoder.
+  frame_promise_.set_value(frame);
 }
 
 void FlutterFrameCapturer::CaptureFrame(
     std::unique_ptr<MethodResultProxy> result) {
-  mutex_.lock();
-  // Here init catch_frame_ flag
-  catch_frame_ = false;
-
-  track_->AddRenderer(this);
-  // Here waiting for catch_frame_ is set to true
-  while (!catch_frame_) {
+#if !defined(ENABLE_JPEG)
+  if (format_ == Format::kJpeg) {
+    result->Error("captureFrame", "JPEG output is not available in this build");
+    return;
   }
-  // Here unlock the mutex
-  mutex_.unlock();
+#endif
 
-  mutex_.lock();
-  track_->RemoveRenderer(this);
+  auto frame_future = frame_promise_.get_future();
+  std::shared_ptr<MethodResultProxy> result_ptr(result.release());
 
-  bool success = SaveFrame();
-  mutex_.unlock();
+  track_->AddRenderer(this);
 
-  std::shared_ptr<MethodResultProxy> result_ptr(result.release());
-  if (success) {
-    result_ptr->Success();
-  } else {
-    result_ptr->Error("1", "Cannot save the frame as .png file");
-  }
+  std::thread([self = shared_from_this(),
+               frame_future = std::move(frame_future), result_ptr]() mutable {
+    const auto status = frame_future.wait_for(self->timeout_);
+
+    // Never remove the renderer from within OnFrame(), the track holds its
+    // sink lock while delivering frames.
+    self->track_->RemoveRenderer(self.get());
+
+    if (status != std::future_status::ready) {
+      result_ptr->Error("captureFrame",
+                        "captureFrame() timed out waiting for a frame");
+      return;
+    }
+
+    if (self->SaveFrame(frame_future.get())) {
+      result_ptr->Success();
+    } else {
+      result_ptr->Error("1", "Cannot save the frame to " + self->path_);
+    }
+  }).detach();
 }
 
-bool FlutterFrameCapturer::SaveFrame() {
-  if (frame_ == nullptr) {
+bool FlutterFrameCapturer::SaveFrame(
+    const scoped_refptr<RTCVideoFrame>& frame) const {
+  if (frame == nullptr) {
     return false;
   }
 
-  int width = frame_.get()->width();
-  int height = frame_.get()->height();
-  int bytes_per_pixel = 4;
-  auto* pixels =
-      new uint8_t[static_cast<unsigned long>(width * height * bytes_per_pixel)];
+  const int width = frame->width();
+  const int height = frame->height();
+  constexpr int bytes_per_pixel = 4;
+  std::vector<uint8_t> pixels(static_cast<size_t>(width) *
+                              static_cast<size_t>(height) * bytes_per_pixel);
 
-  frame_.get()->ConvertToARGB(RTCVideoFrame::Type::kABGR, pixels,
-                              /* unused */ -1, width, height);
+  frame->ConvertToARGB(RTCVideoFrame::Type::kABGR, pixels.data(),
+                       /* unused */ -1, width, height);
 
   FILE* file = fopen(path_.c_str(), "wb");
   if (!file) {
     return false;
   }
 
-  svpng(file, static_cast<unsigned int>(width),
-        static_cast<unsigned int>(height), pixels, 1);
+  bool success = true;
+  switch (format_) {
+    case Format::kPng:
+      svpng(file, static_cast<unsigned int>(width),
+            static_cast<unsigned int>(height), pixels.data(), 1);
+      break;
+    case Format::kJpeg:
+#if defined(ENABLE_JPEG)
+      success =
+          WriteJpeg(file, pixels.data(), width, height, kDefaultJpegQuality);
+#else
+      success = false;
+#endif
+      break;
+    case Format::kRaw:
+      success = fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+      break;
+  }
   fclose(file);
-  return true;
+  return success;
 }
 
-}  // namespace flutter_webrtc_plugin
\ No newline at end of file
+}  // namespace flutter_webrtc_plugin
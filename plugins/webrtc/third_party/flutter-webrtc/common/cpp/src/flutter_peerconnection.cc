@@ -833,9 +833,18 @@ void FlutterPeerConnection::SetConfiguration(
 void FlutterPeerConnection::CaptureFrame(
     RTCVideoTrack* track,
     std::string path,
+    const std::string& format,
+    int64_t timeout_ms,
     std::unique_ptr<MethodResultProxy> result) {
-  FlutterFrameCapturer capturer(track, std::move(path));
-  capturer.CaptureFrame(std::move(result));
+  const auto capture_format =
+      FlutterFrameCapturer::FormatFromString(format, path);
+  const auto timeout = timeout_ms > 0
+                           ? std::chrono::milliseconds(timeout_ms)
+                           : FlutterFrameCapturer::kDefaultTimeout;
+  // The capturer keeps itself alive until the frame has been written.
+  auto capturer = std::make_shared<FlutterFrameCapturer>(
+      track, std::move(path), capture_format, timeout);
+  capturer->CaptureFrame(std::move(result));
 }
 
 scoped_refptr<RTCRtpTransceiver> FlutterPeerConnection::getRtpTransceiverById(
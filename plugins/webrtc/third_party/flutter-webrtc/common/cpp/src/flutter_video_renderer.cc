@@ -1,11 +1,51 @@
 #include "flutter_video_renderer.h"
 
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 
 namespace flutter_webrtc_plugin {
 
+static constexpr char kVideoRendererEnvironmentVariable[] =
+    "WEBRTC_VIDEO_RENDERER";
+
 FlutterVideoRenderer::~FlutterVideoRenderer() = default;
 
+void FlutterVideoRenderer::SetShader(std::unique_ptr<i420::Shader> shader) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  shader_ = std::move(shader);
+  gpu_surface_ = true;
+  shader_texture_id_ = shader_->textureId;
+  descriptor_ = {
+      .struct_size = sizeof(FlutterDesktopGpuSurfaceDescriptor),
+      .handle = &shader_texture_id_,
+      .width = static_cast<size_t>(shader_->width),
+      .height = static_cast<size_t>(shader_->height),
+      .visible_width = static_cast<size_t>(shader_->width),
+      .visible_height = static_cast<size_t>(shader_->height),
+      .format = kFlutterDesktopPixelFormatRGBA8888,
+      .release_callback = [](void* /* release_context */) {},
+      .release_context = this,
+  };
+}
+
+void FlutterVideoRenderer::ReleaseShader() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!shader_) {
+    return;
+  }
+  registrar_->TextureMakeCurrent();
+  shader_.reset();
+  registrar_->TextureClearCurrent();
+}
+
+const FlutterDesktopGpuSurfaceDescriptor*
+FlutterVideoRenderer::GpuSurfaceDescriptor(size_t /* width */,
+                                           size_t /* height */) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return &descriptor_;
+}
+
 void FlutterVideoRenderer::initialize(
     TextureRegistrar* registrar,
     BinaryMessenger* messenger,
@@ -77,6 +117,31 @@ void FlutterVideoRenderer::OnFrame(scoped_refptr<RTCVideoFrame> frame) {
 
     last_frame_size_ = {static_cast<size_t>(frame->width()), static_cast<size_t>(frame->height())};
   }
+  if (gpu_surface_) {
+    // Upload the planes straight from the decoded frame; no CPU colour
+    // conversion and no intermediate RGBA buffer.
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!shader_) {
+        return;
+      }
+      registrar_->TextureMakeCurrent();
+      if (shader_->width != frame->width() ||
+          shader_->height != frame->height()) {
+        shader_->resize(frame->width(), frame->height());
+        descriptor_.width = descriptor_.visible_width =
+            static_cast<size_t>(frame->width());
+        descriptor_.height = descriptor_.visible_height =
+            static_cast<size_t>(frame->height());
+      }
+      shader_->load_planes(frame->DataY(), frame->StrideY(), frame->DataU(),
+                           frame->StrideU(), frame->DataV(), frame->StrideV());
+      shader_->draw_core();
+      registrar_->TextureClearCurrent();
+    }
+    registrar_->MarkTextureFrameAvailable(texture_id_);
+    return;
+  }
   mutex_.lock();
   frame_ = frame;
   mutex_.unlock();
@@ -114,9 +179,37 @@ FlutterVideoRendererManager::FlutterVideoRendererManager(
     FlutterWebRTCBase* base)
     : base_(base) {}
 
+bool FlutterVideoRendererManager::UseGpuSurface() {
+  const char* env = std::getenv(kVideoRendererEnvironmentVariable);
+  return !env || std::strcmp(env, "pixel_buffer") != 0;
+}
+
 void FlutterVideoRendererManager::CreateVideoRendererTexture(
     std::unique_ptr<MethodResultProxy> result) {
   auto texture = new RefCountedObject<FlutterVideoRenderer>();
+  if (UseGpuSurface()) {
+    base_->textures_->TextureMakeCurrent();
+    texture->SetShader(std::make_unique<i420::Shader>());
+    base_->textures_->TextureClearCurrent();
+
+    auto textureVariant =
+        std::make_unique<flutter::TextureVariant>(flutter::GpuSurfaceTexture(
+            kFlutterDesktopGpuSurfaceTypeGlTexture2D,
+            [texture](size_t width, size_t height)
+                -> const FlutterDesktopGpuSurfaceDescriptor* {
+              return texture->GpuSurfaceDescriptor(width, height);
+            }));
+    base_->textures_->RegisterTexture(textureVariant.get());
+    // GL textures are addressed by their texture name.
+    const auto texture_id = static_cast<int64_t>(texture->gl_texture_id());
+    texture->initialize(base_->textures_, base_->messenger_,
+                        std::move(textureVariant), texture_id);
+    renderers_[texture_id] = texture;
+    EncodableMap params;
+    params[EncodableValue("textureId")] = EncodableValue(texture_id);
+    result->Success(EncodableValue(params));
+    return;
+  }
   auto textureVariant =
       std::make_unique<flutter::TextureVariant>(flutter::PixelBufferTexture(
           [texture](size_t width,
@@ -171,6 +264,7 @@ void FlutterVideoRendererManager::VideoRendererDispose(
   auto it = renderers_.find(texture_id);
   if (it != renderers_.end()) {
     it->second->SetVideoTrack(nullptr);
+    it->second->ReleaseShader();
 #if defined(_WINDOWS)
     base_->textures_->UnregisterTexture(texture_id,
                                         [&, it] { renderers_.erase(it); });
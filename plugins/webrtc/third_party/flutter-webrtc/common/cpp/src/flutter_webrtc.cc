@@ -309,7 +309,8 @@ void FlutterWebRTC::HandleMethodCall(
       result->Error("Bad Arguments", "Null constraints arguments received");
       return;
     }
-    const auto params = GetValue<EncodableMap>(*method_call.arguments());
+    // Borrow the arguments rather than copying the map (and its payload).
+    const auto& params = std::get<EncodableMap>(*method_call.arguments());
     const std::string peerConnectionId = findString(params, "peerConnectionId");
     RTCPeerConnection* pc = PeerConnectionForId(peerConnectionId);
     if (pc == nullptr) {
@@ -320,14 +321,27 @@ void FlutterWebRTC::HandleMethodCall(
 
     const std::string dataChannelId = findString(params, "dataChannelId");
     const std::string type = findString(params, "type");
-    const EncodableValue data = findEncodableValue(params, "data");
+    const auto data = params.find(EncodableValue("data"));
     RTCDataChannel* data_channel = DataChannelForId(dataChannelId);
     if (data_channel == nullptr) {
       result->Error("dataChannelSendFailed",
                     "dataChannelSend() data_channel is null");
       return;
     }
-    DataChannelSend(data_channel, type, data, std::move(result));
+    if (data == params.end()) {
+      result->Error("dataChannelSendFailed", "dataChannelSend() data is null");
+      return;
+    }
+    DataChannelSend(data_channel, type, data->second, std::move(result));
+  } else if (method_call.method_name() == "dataChannelSetBatchInterval") {
+    if (!method_call.arguments()) {
+      result->Error("Bad Arguments", "Null constraints arguments received");
+      return;
+    }
+    const auto params = GetValue<EncodableMap>(*method_call.arguments());
+    const std::string dataChannelId = findString(params, "dataChannelId");
+    const int64_t interval = findLongInt(params, "interval");
+    DataChannelSetBatchInterval(dataChannelId, interval, std::move(result));
   } else if (method_call.method_name() == "dataChannelClose") {
     if (!method_call.arguments()) {
       result->Error("Bad Arguments", "Null constraints arguments received");
@@ -940,8 +954,11 @@ void FlutterWebRTC::HandleMethodCall(
       result->Error("captureFrame", "captureFrame() track not is video track");
       return;
     }
-    CaptureFrame(reinterpret_cast<RTCVideoTrack*>(track), path,
-                 std::move(result));
+    // Optional: "png" (default), "jpeg" or "raw" RGBA, and a timeout.
+    const std::string format = findString(params, "format");
+    const int64_t timeout_ms = findLongInt(params, "timeout");
+    CaptureFrame(reinterpret_cast<RTCVideoTrack*>(track), path, format,
+                 timeout_ms, std::move(result));
 
   } else if (method_call.method_name() == "createLocalMediaStream") {
     CreateLocalMediaStream(std::move(result));
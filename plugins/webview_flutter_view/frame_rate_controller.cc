@@ -0,0 +1,130 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "frame_rate_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace plugin_webview_flutter {
+
+namespace {
+
+// Callback intervals longer than this are gaps in rendering, not cadence.
+constexpr uint32_t kMaxCadenceSampleMs =
+    1000 / FrameRateController::kIdleFrameRate;
+
+// Without fresh back-pressure samples the compositor is assumed to keep up.
+constexpr auto kCadenceExpiry = std::chrono::seconds(2);
+
+}  // namespace
+
+bool FrameRateController::OnPaint(const bool dirty,
+                                  const Clock::time_point now) {
+  std::scoped_lock lock(mutex_);
+  if (!dirty || IsHiddenLocked(now)) {
+    skipped_frames_++;
+    return false;
+  }
+  if (frame_pending_) {
+    back_pressure_ = true;
+  }
+  last_dirty_paint_ = now;
+  painted_frames_++;
+  return true;
+}
+
+void FrameRateController::OnFrameRequested(const Clock::time_point now) {
+  std::scoped_lock lock(mutex_);
+  if (!frame_pending_) {
+    frame_pending_ = true;
+    frame_requested_at_ = now;
+  }
+}
+
+bool FrameRateController::OnFrameCallback(const uint32_t time,
+                                          const Clock::time_point now) {
+  std::scoped_lock lock(mutex_);
+  const bool was_occluded =
+      frame_pending_ && now - frame_requested_at_ > kOcclusionTimeout;
+  frame_pending_ = false;
+
+  if (back_pressure_ && have_last_callback_) {
+    const uint32_t delta = time - last_callback_time_;
+    if (delta > 0 && delta <= kMaxCadenceSampleMs) {
+      cadence_interval_ms_ =
+          cadence_interval_ms_ == 0
+              ? delta
+              : cadence_interval_ms_ + (delta - cadence_interval_ms_) / 8;
+      last_cadence_sample_ = now;
+    }
+  }
+  back_pressure_ = false;
+  have_last_callback_ = true;
+  last_callback_time_ = time;
+  return was_occluded;
+}
+
+void FrameRateController::SetDetached(const bool detached) {
+  std::scoped_lock lock(mutex_);
+  detached_ = detached;
+}
+
+void FrameRateController::SetOffscreen(const bool offscreen) {
+  std::scoped_lock lock(mutex_);
+  offscreen_ = offscreen;
+}
+
+bool FrameRateController::IsDetached() const {
+  std::scoped_lock lock(mutex_);
+  return detached_;
+}
+
+bool FrameRateController::IsHidden(const Clock::time_point now) const {
+  std::scoped_lock lock(mutex_);
+  return IsHiddenLocked(now);
+}
+
+bool FrameRateController::IsHiddenLocked(const Clock::time_point now) const {
+  return detached_ || offscreen_ ||
+         (frame_pending_ && now - frame_requested_at_ > kOcclusionTimeout);
+}
+
+int FrameRateController::TargetFrameRate(const Clock::time_point now) const {
+  std::scoped_lock lock(mutex_);
+  if (IsHiddenLocked(now) || now - last_dirty_paint_ > kIdleTimeout) {
+    return kIdleFrameRate;
+  }
+  if (cadence_interval_ms_ == 0 ||
+      now - last_cadence_sample_ > kCadenceExpiry) {
+    return kMaxFrameRate;
+  }
+  const auto rate =
+      static_cast<int>(std::lround(1000.0 / cadence_interval_ms_));
+  return std::clamp(rate, kIdleFrameRate, kMaxFrameRate);
+}
+
+uint64_t FrameRateController::painted_frames() const {
+  std::scoped_lock lock(mutex_);
+  return painted_frames_;
+}
+
+uint64_t FrameRateController::skipped_frames() const {
+  std::scoped_lock lock(mutex_);
+  return skipped_frames_;
+}
+
+}  // namespace plugin_webview_flutter
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2024 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLUTTER_PLUGIN_WEBVIEW_FRAME_RATE_CONTROLLER_H_
+#define FLUTTER_PLUGIN_WEBVIEW_FRAME_RATE_CONTROLLER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace plugin_webview_flutter {
+
+/**
+ * @brief Chooses the CEF windowless frame rate for a webview.
+ *
+ * The rate follows the Wayland frame callback cadence when CEF produces
+ * frames faster than the compositor consumes them, drops to an idle rate when
+ * no dirty rects arrive, and reports the view as hidden when it is detached,
+ * moved offscreen, or the compositor stops delivering frame callbacks.
+ *
+ * Frame callbacks arrive on the Wayland thread while paints arrive on the CEF
+ * UI thread, so all state is guarded by a mutex.
+ */
+class FrameRateController {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr int kMaxFrameRate = 60;
+  static constexpr int kIdleFrameRate = 5;
+  static constexpr std::chrono::milliseconds kIdleTimeout{1000};
+  static constexpr std::chrono::milliseconds kOcclusionTimeout{1000};
+
+  /**
+   * @brief Records a paint from CEF.
+   * @param dirty true when the paint carries at least one dirty rect
+   * @param now current time
+   * @return true if the frame should be uploaded and presented
+   */
+  bool OnPaint(bool dirty, Clock::time_point now = Clock::now());
+
+  /**
+   * @brief Records that a frame callback was requested for the next commit.
+   * @param now current time
+   */
+  void OnFrameRequested(Clock::time_point now = Clock::now());
+
+  /**
+   * @brief Records a delivered frame callback.
+   * @param time callback timestamp in milliseconds
+   * @param now current time
+   * @return true if the view was considered occluded until this callback
+   */
+  bool OnFrameCallback(uint32_t time, Clock::time_point now = Clock::now());
+
+  void SetDetached(bool detached);
+  void SetOffscreen(bool offscreen);
+  bool IsDetached() const;
+
+  /**
+   * @brief Whether the browser should be told it is hidden.
+   * @param now current time
+   * @return true if detached, offscreen or occluded
+   */
+  bool IsHidden(Clock::time_point now = Clock::now()) const;
+
+  /**
+   * @brief Frame rate to apply with SetWindowlessFrameRate.
+   * @param now current time
+   * @return frames per second
+   */
+  int TargetFrameRate(Clock::time_point now = Clock::now()) const;
+
+  uint64_t painted_frames() const;
+  uint64_t skipped_frames() const;
+
+ private:
+  bool IsHiddenLocked(Clock::time_point now) const;
+
+  mutable std::mutex mutex_;
+
+  bool detached_ = false;
+  bool offscreen_ = false;
+
+  bool frame_pending_ = false;
+  Clock::time_point frame_requested_at_{};
+
+  // Set when a paint arrives while the previous frame callback is pending,
+  // i.e. CEF is producing frames faster than the compositor presents them.
+  bool back_pressure_ = false;
+  bool have_last_callback_ = false;
+  uint32_t last_callback_time_ = 0;
+  double cadence_interval_ms_ = 0;
+  Clock::time_point last_cadence_sample_{};
+
+  Clock::time_point last_dirty_paint_ = Clock::now();
+
+  uint64_t painted_frames_ = 0;
+  uint64_t skipped_frames_ = 0;
+};
+
+}  // namespace plugin_webview_flutter
+
+#endif  // FLUTTER_PLUGIN_WEBVIEW_FRAME_RATE_CONTROLLER_H_
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2025 Toyota Connected North America
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+
+#include "gtest/gtest.h"
+
+#include "frame_rate_controller.h"
+
+using plugin_webview_flutter::FrameRateController;
+using std::chrono::milliseconds;
+
+namespace {
+
+/**
+ * Drives |frames| frame callbacks |interval_ms| apart while CEF paints
+ * faster than they arrive, and returns the time of the last one.
+ */
+FrameRateController::Clock::time_point PaintUnderBackPressure(
+    FrameRateController& controller,
+    const FrameRateController::Clock::time_point start,
+    const int frames,
+    const uint32_t interval_ms) {
+  auto now = start;
+  for (int i = 0; i < frames; i++) {
+    now = start + milliseconds(i * interval_ms);
+    controller.OnFrameRequested(now);
+    // The previous frame is still pending when the next paint arrives.
+    EXPECT_TRUE(controller.OnPaint(true, now));
+    controller.OnFrameCallback(i * interval_ms, now);
+  }
+  return now;
+}
+
+}  // namespace
+
+TEST(FrameRateControllerTest, PresentsOnlyDirtyPaints) {
+  FrameRateController controller;
+  const auto now = FrameRateController::Clock::now();
+
+  EXPECT_FALSE(controller.OnPaint(false, now));
+  EXPECT_TRUE(controller.OnPaint(true, now));
+  EXPECT_EQ(controller.painted_frames(), 1u);
+  EXPECT_EQ(controller.skipped_frames(), 1u);
+  EXPECT_EQ(controller.TargetFrameRate(now),
+            FrameRateController::kMaxFrameRate);
+}
+
+TEST(FrameRateControllerTest, DropsToIdleRateWithoutDirtyPaints) {
+  FrameRateController controller;
+  const auto start = FrameRateController::Clock::now();
+  ASSERT_TRUE(controller.OnPaint(true, start));
+
+  const auto idle =
+      start + FrameRateController::kIdleTimeout + milliseconds(1);
+  EXPECT_FALSE(controller.OnPaint(false, idle));
+  EXPECT_EQ(controller.TargetFrameRate(idle),
+            FrameRateController::kIdleFrameRate);
+  EXPECT_FALSE(controller.IsHidden(idle));
+
+  // The next dirty paint restores the full rate.
+  EXPECT_TRUE(controller.OnPaint(true, idle));
+  EXPECT_EQ(controller.TargetFrameRate(idle),
+            FrameRateController::kMaxFrameRate);
+}
+
+TEST(FrameRateControllerTest, FollowsCompositorCadenceUnderBackPressure) {
+  FrameRateController controller;
+  const auto start = FrameRateController::Clock::now();
+
+  const auto now = PaintUnderBackPressure(controller, start, 10, 33);
+  EXPECT_EQ(controller.TargetFrameRate(now), 30);
+
+  // Without back pressure the cadence sample ages out.
+  const auto later = now + std::chrono::seconds(2) + milliseconds(1);
+  ASSERT_TRUE(controller.OnPaint(true, later));
+  EXPECT_EQ(controller.TargetFrameRate(later),
+            FrameRateController::kMaxFrameRate);
+}
+
+TEST(FrameRateControllerTest, IgnoresCallbacksWithoutBackPressure) {
+  FrameRateController controller;
+  const auto start = FrameRateController::Clock::now();
+
+  // Paints that arrive after the callback do not throttle CEF.
+  for (uint32_t i = 0; i < 10; i++) {
+    const auto now = start + milliseconds(i * 33);
+    ASSERT_TRUE(controller.OnPaint(true, now));
+    controller.OnFrameRequested(now);
+    controller.OnFrameCallback(i * 33, now);
+  }
+  EXPECT_EQ(controller.TargetFrameRate(start + milliseconds(300)),
+            FrameRateController::kMaxFrameRate);
+}
+
+TEST(FrameRateControllerTest, ClampsSlowCadenceToIdleRate) {
+  FrameRateController controller;
+  const auto start = FrameRateController::Clock::now();
+
+  // 150 ms is within the cadence window but below the idle rate.
+  const auto now = PaintUnderBackPressure(controller, start, 5, 150);
+  EXPECT_EQ(controller.TargetFrameRate(now), 7);
+
+  // Longer gaps are rendering pauses and are not sampled.
+  FrameRateController paused;
+  const auto paused_now = PaintUnderBackPressure(paused, start, 3, 500);
+  EXPECT_EQ(paused.TargetFrameRate(paused_now),
+            FrameRateController::kMaxFrameRate);
+}
+
+TEST(FrameRateControllerTest, HidesWhenDetachedOrOffscreen) {
+  FrameRateController controller;
+  const auto now = FrameRateController::Clock::now();
+
+  controller.SetOffscreen(true);
+  EXPECT_TRUE(controller.IsHidden(now));
+  EXPECT_FALSE(controller.OnPaint(true, now));
+  EXPECT_EQ(controller.TargetFrameRate(now),
+            FrameRateController::kIdleFrameRate);
+  controller.SetOffscreen(false);
+  EXPECT_FALSE(controller.IsHidden(now));
+
+  controller.SetDetached(true);
+  EXPECT_TRUE(controller.IsDetached());
+  EXPECT_TRUE(controller.IsHidden(now));
+}
+
+TEST(FrameRateControllerTest, HidesWhileFrameCallbacksStall) {
+  FrameRateController controller;
+  const auto start = FrameRateController::Clock::now();
+  controller.OnFrameRequested(start);
+  EXPECT_FALSE(controller.IsHidden(start));
+
+  const auto stalled =
+      start + FrameRateController::kOcclusionTimeout + milliseconds(1);
+  EXPECT_TRUE(controller.IsHidden(stalled));
+  EXPECT_FALSE(controller.OnPaint(true, stalled));
+
+  // The callback reports the occlusion and unhides the view.
+  EXPECT_TRUE(controller.OnFrameCallback(0, stalled));
+  EXPECT_FALSE(controller.IsHidden(stalled));
+  EXPECT_TRUE(controller.OnPaint(true, stalled));
+}
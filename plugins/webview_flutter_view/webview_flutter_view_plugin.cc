@@ -20,8 +20,12 @@
 
 #include <flutter/plugin_registrar.h>
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include "plugins/common/common.h"
 
@@ -57,6 +61,39 @@ GLuint LoadShader(const GLchar* shaderSrc, const GLenum type) {
   return shader;
 }
 
+namespace {
+
+constexpr uint32_t FourCC(const char a,
+                          const char b,
+                          const char c,
+                          const char d) {
+  return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) |
+         (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+}
+
+// Mirrors drm_fourcc.h without pulling in libdrm.
+constexpr uint32_t kDrmFormatArgb8888 = FourCC('A', 'R', '2', '4');
+constexpr uint32_t kDrmFormatAbgr8888 = FourCC('A', 'B', '2', '4');
+constexpr uint64_t kDrmFormatModInvalid = 0x00ffffffffffffffULL;
+
+// How often the frame rate controller is re-evaluated on the CEF UI thread.
+constexpr int64_t kFrameRateUpdateIntervalMs = 250;
+
+bool HasExtension(const char* extensions, const char* name) {
+  if (!extensions) {
+    return false;
+  }
+  const size_t len = strlen(name);
+  for (const char* p = extensions; (p = strstr(p, name)) != nullptr; p += len) {
+    if ((p == extensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == 0)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
 // static
 void WebviewFlutterPlugin::RegisterWithRegistrar(
     flutter::PluginRegistrar* registrar) {
@@ -93,49 +130,271 @@ void WebviewPlatformView::GetViewRect(CefRefPtr<CefBrowser> /* browser */,
 
 void WebviewPlatformView::OnPaint(CefRefPtr<CefBrowser> /* browser */,
                                   PaintElementType type,
-                                  const RectList& /* dirtyRects */,
+                                  const RectList& dirtyRects,
                                   const void* buffer,
                                   int width,
                                   int height) {
-  spdlog::trace("[webview_flutter] OnPaint, width: {}, height: {}, type: {}",
-                width, height, (uint8_t)type);
+  spdlog::trace(
+      "[webview_flutter] OnPaint, width: {}, height: {}, type: {}, dirty: {}",
+      width, height, (uint8_t)type, dirtyRects.size());
+  // Popup widgets are not composited yet; uploading them would overwrite the
+  // view texture with a differently sized buffer.
+  if (type != PET_VIEW) {
+    return;
+  }
+  // A full upload is needed when the texture was never sized or a paint was
+  // skipped, so the frame counts as dirty until then.
+  if (!frame_rate_.OnPaint(!dirtyRects.empty() || needs_full_upload_)) {
+    if (!dirtyRects.empty()) {
+      needs_full_upload_ = true;
+    }
+    return;
+  }
+
   if (eglGetCurrentContext() != egl_context_) {
     eglMakeCurrent(egl_display_, egl_surface_, egl_surface_, egl_context_);
   }
 
   glBindTexture(GL_TEXTURE_2D, gl_texture_);
+  if (width != texture_width_ || height != texture_height_) {
+    // Storage is only (re)specified on size change; the whole frame is dirty.
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, buffer);
+    texture_width_ = width;
+    texture_height_ = height;
+  } else if (needs_full_upload_) {
+    // Skipped paints took their dirty rects with them.
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA,
+                    GL_UNSIGNED_BYTE, buffer);
+  } else if (use_pbo_) {
+    UploadDirtyRectsPbo(dirtyRects, buffer, width, height);
+  } else {
+    UploadDirtyRects(dirtyRects, buffer, width, height);
+  }
+  needs_full_upload_ = false;
 
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
-               GL_UNSIGNED_BYTE, buffer);
-  glBindTexture(GL_TEXTURE_2D, 0);
-
-  glUseProgram(programObject_);
-  glUniform1i(glGetUniformLocation(programObject_, "texture1"), 0);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, gl_texture_);
-
-  glBindVertexArray(VAO);
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  DrawQuad(gl_texture_);
+  PresentFrame();
+}
 
+void WebviewPlatformView::PresentFrame() {
+  // Held across the swap so dispose cannot destroy the surfaces under it.
+  // Swap interval is 0, so this does not block the CEF UI thread on the
+  // compositor. The context stays current on this thread between paints.
+  std::scoped_lock lock(frame_mutex_);
+  if (!surface_ || !subsurface_) {
+    return;
+  }
+  RequestFrameCallbackLocked();
   eglSwapBuffers(egl_display_, egl_surface_);
-  eglMakeCurrent(egl_display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
 
   wl_subsurface_place_below(subsurface_, parent_surface_);
   wl_subsurface_set_position(subsurface_, 0, 0);
   wl_surface_commit(surface_);
 }
 
+void WebviewPlatformView::UploadDirtyRects(const RectList& dirtyRects,
+                                           const void* pixels,
+                                           const int width,
+                                           const int height) const {
+  // |pixels| is either the CEF buffer or an offset into the bound PBO. Both
+  // share the frame layout, so each rect is addressed with skip pixels/rows.
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+  for (const auto& rect : dirtyRects) {
+    const int x = std::clamp(rect.x, 0, width);
+    const int y = std::clamp(rect.y, 0, height);
+    const int w = std::min(rect.x + rect.width, width) - x;
+    const int h = std::min(rect.y + rect.height, height) - y;
+    if (w <= 0 || h <= 0) {
+      continue;
+    }
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, x);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, y);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE,
+                    pixels);
+  }
+  glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+  glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+void WebviewPlatformView::UploadDirtyRectsPbo(const RectList& dirtyRects,
+                                              const void* buffer,
+                                              const int width,
+                                              const int height) {
+  const auto stride = static_cast<size_t>(width) * 4;
+  const auto size = stride * static_cast<size_t>(height);
+  if (pbo_size_ != size) {
+    for (const auto pbo : pbo_) {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size),
+                   nullptr, GL_STREAM_DRAW);
+    }
+    pbo_size_ = size;
+  }
+
+  // Rotate through the ring so the driver can still be reading the previous
+  // buffers while this one is filled.
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_[pbo_index_]);
+  pbo_index_ = (pbo_index_ + 1) % kPboCount;
+
+  auto* dst = static_cast<uint8_t*>(
+      glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size),
+                       GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+  if (!dst) {
+    spdlog::warn("[webview_flutter] glMapBufferRange failed, disabling PBO");
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    use_pbo_ = false;
+    UploadDirtyRects(dirtyRects, buffer, width, height);
+    return;
+  }
+
+  const auto* src = static_cast<const uint8_t*>(buffer);
+  for (const auto& rect : dirtyRects) {
+    const int x = std::clamp(rect.x, 0, width);
+    const int y = std::clamp(rect.y, 0, height);
+    const int w = std::min(rect.x + rect.width, width) - x;
+    const int h = std::min(rect.y + rect.height, height) - y;
+    if (w <= 0 || h <= 0) {
+      continue;
+    }
+    for (int row = y; row < y + h; row++) {
+      const size_t offset =
+          static_cast<size_t>(row) * stride + static_cast<size_t>(x) * 4;
+      memcpy(dst + offset, src + offset, static_cast<size_t>(w) * 4);
+    }
+  }
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+  UploadDirtyRects(dirtyRects, nullptr, width, height);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
 void WebviewPlatformView::OnAcceleratedPaint(
     CefRefPtr<CefBrowser> /* browser */,
-    PaintElementType /* type */,
-    const RectList& /* dirtyRects */,
-    const CefAcceleratedPaintInfo& /* info */) {
-  spdlog::trace("[webview_flutter] OnAcceleratedPaint");
+    PaintElementType type,
+    const RectList& dirtyRects,
+    const CefAcceleratedPaintInfo& info) {
+  spdlog::trace("[webview_flutter] OnAcceleratedPaint, planes: {}, type: {}",
+                info.plane_count, (uint8_t)type);
+  if (type != PET_VIEW || !shared_texture_enabled_) {
+    return;
+  }
+  if (!frame_rate_.OnPaint(!dirtyRects.empty())) {
+    return;
+  }
+
+  if (eglGetCurrentContext() != egl_context_) {
+    eglMakeCurrent(egl_display_, egl_surface_, egl_surface_, egl_context_);
+  }
+
+  const EGLImageKHR image = CreateDmabufImage(info);
+  if (image == EGL_NO_IMAGE_KHR) {
+    spdlog::error(
+        "[webview_flutter] dmabuf import failed (0x{:x}), falling back to "
+        "OnPaint",
+        eglGetError());
+    shared_texture_enabled_ = false;
+    CefPostTask(TID_UI,
+                base::BindOnce(&WebviewPlatformView::FallbackToSoftwarePaint,
+                               weak_this_));
+    return;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, shared_texture_);
+  glEGLImageTargetTexture2DOES_(GL_TEXTURE_2D, image);
+  DrawQuad(shared_texture_);
+
+  // The dmabuf is only valid for the duration of this callback, so sampling
+  // must complete before CEF recycles it.
+  glFinish();
+  eglDestroyImageKHR_(egl_display_, image);
+
+  PresentFrame();
+}
+
+EGLImageKHR WebviewPlatformView::CreateDmabufImage(
+    const CefAcceleratedPaintInfo& info) const {
+  static constexpr EGLint kPlaneAttribs[][5] = {
+      {EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT,
+       EGL_DMA_BUF_PLANE0_PITCH_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT,
+       EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT},
+      {EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT,
+       EGL_DMA_BUF_PLANE1_PITCH_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT,
+       EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT},
+      {EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT,
+       EGL_DMA_BUF_PLANE2_PITCH_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT,
+       EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT},
+      {EGL_DMA_BUF_PLANE3_FD_EXT, EGL_DMA_BUF_PLANE3_OFFSET_EXT,
+       EGL_DMA_BUF_PLANE3_PITCH_EXT, EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT,
+       EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT},
+  };
+
+  // The quad program swizzles .bgra to match CEF's software buffers, so the
+  // dmabuf is imported with red and blue swapped to sample the same way.
+  uint32_t fourcc;
+  switch (info.format) {
+    case CEF_COLOR_TYPE_BGRA_8888:
+      fourcc = kDrmFormatAbgr8888;
+      break;
+    case CEF_COLOR_TYPE_RGBA_8888:
+      fourcc = kDrmFormatArgb8888;
+      break;
+    default:
+      return EGL_NO_IMAGE_KHR;
+  }
+  if (info.plane_count <= 0 ||
+      info.plane_count > static_cast<int>(std::size(kPlaneAttribs))) {
+    return EGL_NO_IMAGE_KHR;
+  }
+
+  // The frame was produced for the view size CEF last queried, which lags
+  // behind resizes, and the buffer may be padded past it; the frame carries
+  // its own size. Importing just the visible rect crops the padding when it
+  // starts at the origin.
+  const auto& visible = info.extra.visible_rect;
+  const bool use_visible = visible.x == 0 && visible.y == 0 &&
+                           visible.width > 0 && visible.height > 0;
+  const int width = use_visible ? visible.width : info.extra.coded_size.width;
+  const int height =
+      use_visible ? visible.height : info.extra.coded_size.height;
+  if (width <= 0 || height <= 0) {
+    return EGL_NO_IMAGE_KHR;
+  }
+
+  std::vector<EGLint> attribs = {EGL_WIDTH, width, EGL_HEIGHT, height,
+                                 EGL_LINUX_DRM_FOURCC_EXT,
+                                 static_cast<EGLint>(fourcc)};
+  const bool has_modifier = dmabuf_modifiers_supported_ &&
+                            info.modifier != kDrmFormatModInvalid;
+  for (int i = 0; i < info.plane_count; i++) {
+    const auto& plane = info.planes[i];
+    attribs.insert(attribs.end(),
+                   {kPlaneAttribs[i][0], plane.fd, kPlaneAttribs[i][1],
+                    static_cast<EGLint>(plane.offset), kPlaneAttribs[i][2],
+                    static_cast<EGLint>(plane.stride)});
+    if (has_modifier) {
+      attribs.insert(
+          attribs.end(),
+          {kPlaneAttribs[i][3],
+           static_cast<EGLint>(info.modifier & 0xffffffff),
+           kPlaneAttribs[i][4], static_cast<EGLint>(info.modifier >> 32)});
+    }
+  }
+  attribs.push_back(EGL_NONE);
+
+  return eglCreateImageKHR_(egl_display_, EGL_NO_CONTEXT,
+                            EGL_LINUX_DMA_BUF_EXT, nullptr, attribs.data());
+}
+
+void WebviewPlatformView::DrawQuad(const GLuint texture) const {
+  glUseProgram(programObject_);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, texture);
+
+  glBindVertexArray(VAO);
+  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 WebviewFlutterPlugin::WebviewFlutterPlugin() {}
@@ -202,6 +461,7 @@ WebviewPlatformView::WebviewPlatformView(
   parent_surface_ = flutter_view->GetWindow()->GetBaseSurface();
   surface_ =
       wl_compositor_create_surface(flutter_view->GetDisplay()->GetCompositor());
+  wl_surface_add_listener(surface_, &surface_listener, this);
 
   parent_surface_ = flutter_view->GetWindow()->GetBaseSurface();
   subsurface_ = wl_subcompositor_get_subsurface(
@@ -225,9 +485,34 @@ WebviewPlatformView::WebviewPlatformView(
 
 WebviewPlatformView::~WebviewPlatformView() {
   spdlog::debug("[webview_flutter] ~WebviewPlatformView");
+  InvalidateWeakPtrs();
   removeListener_(platformViewsContext_, id_);
 }
 
+void WebviewPlatformView::InvalidateWeakPtrs() {
+  // Stops the UpdateFrameRate() loop and drops queued ApplyFrameRate() and
+  // FallbackToSoftwarePaint() tasks. This has to happen on the UI thread, and
+  // before any member goes away, so a task cannot be running meanwhile.
+  if (CefCurrentlyOn(TID_UI)) {
+    weak_factory_.InvalidateWeakPtrs();
+    return;
+  }
+  // If the task is dropped because the UI thread is shutting down, the
+  // promise is destroyed with it and the wait still returns.
+  auto done = std::make_shared<std::promise<void>>();
+  auto invalidated = done->get_future();
+  if (CefPostTask(TID_UI,
+                  base::BindOnce(
+                      [](WebviewPlatformView* self,
+                         const std::shared_ptr<std::promise<void>>& done) {
+                        self->weak_factory_.InvalidateWeakPtrs();
+                        done->set_value();
+                      },
+                      base::Unretained(this), std::move(done)))) {
+    invalidated.wait();
+  }
+}
+
 void WebviewPlatformView::CefThreadMain() {
   std::vector<const char*> args;
   args.reserve(11);
@@ -254,6 +539,8 @@ void WebviewPlatformView::CefThreadMain() {
       eglCreateWindowSurface(egl_display_, egl_config_, egl_window_, nullptr);
 
   eglMakeCurrent(egl_display_, egl_surface_, egl_surface_, egl_context_);
+  // Frame pacing is driven by CEF; never block OnPaint waiting for vsync.
+  eglSwapInterval(egl_display_, 0);
   InitializeScene();
 
   // Load libcef.so
@@ -320,21 +607,103 @@ WebviewFlutterPlugin::~WebviewFlutterPlugin() {
 
 void WebviewPlatformView::OnContextInitialized() {
   spdlog::debug("[webview_flutter] WebviewPlatformView::OnContextInitialized");
+  weak_this_ = weak_factory_.GetWeakPtr();
+  CreateBrowser("https://www.google.com", shared_texture_enabled_);
+  UpdateFrameRate();
+}
+
+void WebviewPlatformView::CreateBrowser(const std::string& url,
+                                        const bool shared_texture) {
   CefWindowInfo window_info;
   window_info.SetAsWindowless(true);
-  // window_info.shared_texture_enabled = true; // For OnAcceleratedPaint
-  // callback
+  // Frames are delivered to OnAcceleratedPaint as dmabufs instead of OnPaint.
+  window_info.shared_texture_enabled = shared_texture;
 
   CefBrowserSettings browserSettings;
-  browserSettings.windowless_frame_rate = 60;  // 30 is default
+  // Adjusted at runtime by UpdateFrameRate.
+  browserSettings.windowless_frame_rate = applied_frame_rate_;
 
-  spdlog::debug("[webview_flutter] CreateBrowserSync++");
+  spdlog::debug("[webview_flutter] CreateBrowserSync++ shared_texture: {}",
+                shared_texture);
   browser_ = CefBrowserHost::CreateBrowserSync(
-      window_info, this, "https://www.google.com", browserSettings, nullptr,
-      nullptr);
+      window_info, this, url, browserSettings, nullptr, nullptr);
   spdlog::debug("[webview_flutter] CreateBrowserSync--");
 }
 
+void WebviewPlatformView::FallbackToSoftwarePaint() {
+  // Shared texture mode is fixed at browser creation, so the browser is
+  // recreated at the same URL with software OnPaint delivery.
+  if (!browser_) {
+    return;
+  }
+  const std::string url = browser_->GetMainFrame()->GetURL();
+  browser_->GetHost()->CloseBrowser(true);
+  browser_ = nullptr;
+  CreateBrowser(url, false);
+  applied_hidden_ = false;
+}
+
+void WebviewPlatformView::RequestFrameCallback() {
+  std::scoped_lock lock(frame_mutex_);
+  RequestFrameCallbackLocked();
+}
+
+void WebviewPlatformView::RequestFrameCallbackLocked() {
+  if (callback_ || !surface_) {
+    return;
+  }
+  callback_ = wl_surface_frame(surface_);
+  wl_callback_add_listener(callback_, &frame_listener, this);
+  frame_rate_.OnFrameRequested();
+}
+
+void WebviewPlatformView::UpdateFrameRate() {
+  ApplyFrameRate();
+  // The view is gone for good once detached and hidden; stop polling.
+  if (frame_rate_.IsDetached() && applied_hidden_) {
+    return;
+  }
+  CefPostDelayedTask(
+      TID_UI, base::BindOnce(&WebviewPlatformView::UpdateFrameRate, weak_this_),
+      kFrameRateUpdateIntervalMs);
+}
+
+void WebviewPlatformView::ApplyFrameRate() {
+  if (browser_) {
+    const auto host = browser_->GetHost();
+    const auto now = FrameRateController::Clock::now();
+
+    if (const bool hidden = frame_rate_.IsHidden(now);
+        hidden != applied_hidden_) {
+      spdlog::debug(
+          "[webview_flutter] WasHidden: {}, painted: {}, skipped: {}", hidden,
+          frame_rate_.painted_frames(), frame_rate_.skipped_frames());
+      host->WasHidden(hidden);
+      host->SetAudioMuted(hidden);
+      applied_hidden_ = hidden;
+      if (hidden) {
+        // Keep a frame callback outstanding so the compositor tells us when
+        // the surface becomes visible again.
+        RequestFrameCallback();
+        std::scoped_lock lock(frame_mutex_);
+        if (surface_) {
+          wl_surface_commit(surface_);
+        }
+      }
+    }
+
+    if (const int rate = frame_rate_.TargetFrameRate(now);
+        rate != applied_frame_rate_) {
+      spdlog::debug(
+          "[webview_flutter] windowless frame rate: {}, painted: {}, "
+          "skipped: {}",
+          rate, frame_rate_.painted_frames(), frame_rate_.skipped_frames());
+      host->SetWindowlessFrameRate(rate);
+      applied_frame_rate_ = rate;
+    }
+  }
+}
+
 void WebviewPlatformView::InitializeScene() {
   constexpr GLchar vShaderStr[] =
       "#version 320 es\n"
@@ -366,6 +735,20 @@ void WebviewPlatformView::InitializeScene() {
   glGenTextures(1, &gl_texture_);
   glGenRenderbuffers(1, &depthrenderbuffer_);
 
+  glBindTexture(GL_TEXTURE_2D, gl_texture_);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  use_pbo_ = getenv("WEBVIEW_PBO_UPLOAD") != nullptr;
+  if (use_pbo_) {
+    glGenBuffers(kPboCount, pbo_);
+  }
+
+  InitializeDmabufImport();
+
   const GLuint vertexShader = LoadShader(vShaderStr, GL_VERTEX_SHADER);
   const GLuint fragmentShader = LoadShader(fShaderStr, GL_FRAGMENT_SHADER);
 
@@ -395,6 +778,9 @@ void WebviewPlatformView::InitializeScene() {
   }
 
   programObject_ = programObject;
+  texture_uniform_ = glGetUniformLocation(programObject_, "ourTexture");
+  glUseProgram(programObject_);
+  glUniform1i(texture_uniform_, 0);
 
   float vertices[] = {
       // positions          // colors           // texture coords
@@ -434,6 +820,45 @@ void WebviewPlatformView::InitializeScene() {
   glEnableVertexAttribArray(2);
 }
 
+void WebviewPlatformView::InitializeDmabufImport() {
+  const char* egl_extensions = eglQueryString(egl_display_, EGL_EXTENSIONS);
+  const auto* gl_extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  if (getenv("WEBVIEW_DISABLE_SHARED_TEXTURE") ||
+      !HasExtension(egl_extensions, "EGL_EXT_image_dma_buf_import") ||
+      !HasExtension(gl_extensions, "GL_OES_EGL_image")) {
+    spdlog::debug("[webview_flutter] dmabuf import unavailable, using OnPaint");
+    return;
+  }
+
+  eglCreateImageKHR_ = reinterpret_cast<PFNEGLCREATEIMAGEKHRPROC>(
+      eglGetProcAddress("eglCreateImageKHR"));
+  eglDestroyImageKHR_ = reinterpret_cast<PFNEGLDESTROYIMAGEKHRPROC>(
+      eglGetProcAddress("eglDestroyImageKHR"));
+  glEGLImageTargetTexture2DOES_ =
+      reinterpret_cast<PFNGLEGLIMAGETARGETTEXTURE2DOESPROC>(
+          eglGetProcAddress("glEGLImageTargetTexture2DOES"));
+  if (!eglCreateImageKHR_ || !eglDestroyImageKHR_ ||
+      !glEGLImageTargetTexture2DOES_) {
+    spdlog::debug("[webview_flutter] EGLImage entry points missing");
+    return;
+  }
+  dmabuf_modifiers_supported_ =
+      HasExtension(egl_extensions, "EGL_EXT_image_dma_buf_import_modifiers");
+
+  glGenTextures(1, &shared_texture_);
+  glBindTexture(GL_TEXTURE_2D, shared_texture_);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  shared_texture_enabled_ = true;
+  spdlog::debug("[webview_flutter] dmabuf import enabled, modifiers: {}",
+                dmabuf_modifiers_supported_);
+}
+
 void WebviewPlatformView::InitializeEGL() {
   EGLint major, minor;
   EGLBoolean ret = eglInitialize(egl_display_, &major, &minor);
@@ -1192,13 +1617,21 @@ void WebviewPlatformView::on_set_offset(const double left,
                     plugin->left_, plugin->top_);
       wl_subsurface_set_position(plugin->subsurface_, plugin->left_,
                                  plugin->top_);
-      if (!plugin->callback_) {
-        on_frame(plugin, plugin->callback_, 0);
-      }
     }
+    std::scoped_lock lock(plugin->frame_mutex_);
+    plugin->UpdateOffscreenLocked();
   }
 }
 
+void WebviewPlatformView::UpdateOffscreenLocked() {
+  // The parent window size is not exposed to plugins, so the left and top
+  // edges are checked from the offset and the right and bottom edges by the
+  // compositor, which sends leave once the surface overlaps no output.
+  frame_rate_.SetOffscreen(
+      left_ + width_ <= 0 || top_ + height_ <= 0 ||
+      (output_events_seen_ && entered_outputs_ == 0));
+}
+
 void WebviewPlatformView::on_touch(int32_t action,
                                    int32_t point_count,
                                    const size_t point_data_size,
@@ -1256,6 +1689,10 @@ void WebviewPlatformView::SendTouch(int id,
 void WebviewPlatformView::on_dispose(bool /* hybrid */, void* data) {
   spdlog::debug("[webview_flutter] on_dispose");
   const auto plugin = static_cast<WebviewPlatformView*>(data);
+  // Hidden and muted on the next UpdateFrameRate pass.
+  plugin->frame_rate_.SetDetached(true);
+
+  std::scoped_lock lock(plugin->frame_mutex_);
   if (plugin->callback_) {
     wl_callback_destroy(plugin->callback_);
     plugin->callback_ = nullptr;
@@ -1283,15 +1720,58 @@ const struct platform_view_listener
         .reject_gesture = nullptr,
 };
 
-void WebviewPlatformView::on_frame(void* /* data */,
-                                   wl_callback* /* callback */,
-                                   const uint32_t /* time */) {
-  spdlog::debug("[webview_flutter] on_frame");
+void WebviewPlatformView::on_frame(void* data,
+                                   wl_callback* callback,
+                                   const uint32_t time) {
+  spdlog::trace("[webview_flutter] on_frame: {}", time);
+  const auto plugin = static_cast<WebviewPlatformView*>(data);
+  {
+    std::scoped_lock lock(plugin->frame_mutex_);
+    if (plugin->callback_ == callback) {
+      plugin->callback_ = nullptr;
+    }
+    wl_callback_destroy(callback);
+  }
+
+  if (plugin->frame_rate_.OnFrameCallback(time)) {
+    // The surface is visible again; unhide without waiting for the next pass.
+    CefPostTask(TID_UI, base::BindOnce(&WebviewPlatformView::ApplyFrameRate,
+                                       plugin->weak_this_));
+  }
 }
 
 const wl_callback_listener WebviewPlatformView::frame_listener = {.done =
                                                                       on_frame};
 
+void WebviewPlatformView::on_surface_enter(void* data,
+                                           wl_surface* /* surface */,
+                                           wl_output* /* output */) {
+  const auto plugin = static_cast<WebviewPlatformView*>(data);
+  std::scoped_lock lock(plugin->frame_mutex_);
+  plugin->entered_outputs_++;
+  plugin->output_events_seen_ = true;
+  plugin->UpdateOffscreenLocked();
+}
+
+void WebviewPlatformView::on_surface_leave(void* data,
+                                           wl_surface* /* surface */,
+                                           wl_output* /* output */) {
+  const auto plugin = static_cast<WebviewPlatformView*>(data);
+  std::scoped_lock lock(plugin->frame_mutex_);
+  plugin->entered_outputs_ = std::max(plugin->entered_outputs_ - 1, 0);
+  plugin->UpdateOffscreenLocked();
+}
+
+const wl_surface_listener WebviewPlatformView::surface_listener = {
+    .enter = on_surface_enter,
+    .leave = on_surface_leave,
+#if defined(WL_SURFACE_PREFERRED_BUFFER_SCALE_SINCE_VERSION)
+    // Sent to version 6 surfaces; a null handler would crash on dispatch.
+    .preferred_buffer_scale = [](void*, wl_surface*, int32_t) {},
+    .preferred_buffer_transform = [](void*, wl_surface*, uint32_t) {},
+#endif
+};
+
 void WebviewPlatformView::DrawFrame(uint32_t /* time */) const {}
 
 }  // namespace plugin_webview_flutter
@@ -21,10 +21,18 @@
 #include <flutter/plugin_registrar.h>
 
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES3/gl32.h>
+// gl2ext.h depends on the platform macros from gl32.h.
+#include <GLES2/gl2ext.h>
 #include <wayland-client.h>
 #include <wayland-egl.h>
 
+#include <future>
+#include <memory>
+#include <mutex>
+
+#include "frame_rate_controller.h"
 #include "messages.g.h"
 
 #include <base/cef_bind.h>
@@ -40,6 +48,7 @@
 #include <cef_render_handler.h>
 #include <cef_task.h>
 #include <include/base/cef_callback.h>
+#include <include/base/cef_weak_ptr.h>
 #include <include/wrapper/cef_closure_task.h>
 
 #include "flutter_desktop_engine_state.h"
@@ -118,26 +127,100 @@ class WebviewPlatformView final : public PlatformView,
   wl_callback* callback_;
   wl_subsurface* subsurface_;
 
+  // Guards |callback_|, which is requested on the CEF UI thread and
+  // completed on the Wayland thread, and |surface_| and |subsurface_|, which
+  // are committed by paints on the CEF UI thread and destroyed by dispose.
+  std::mutex frame_mutex_;
+  // Outputs |surface_| currently overlaps, from wl_surface enter/leave; a
+  // surface moved past any edge of the outputs leaves all of them. Only
+  // trusted once an enter was seen, since clients that never bound wl_output
+  // get no events. Guarded by |frame_mutex_|.
+  int entered_outputs_ = 0;
+  bool output_events_seen_ = false;
+  FrameRateController frame_rate_;
+  // Last state pushed to the browser host; CEF UI thread only.
+  int applied_frame_rate_ = FrameRateController::kMaxFrameRate;
+  bool applied_hidden_ = false;
+
   EGLDisplay egl_display_;
   wl_egl_window* egl_window_;
   int buffer_size_ = 32;
   EGLContext egl_context_{};
   EGLConfig egl_config_{};
   GLuint programObject_{};
+  GLint texture_uniform_ = -1;
   EGLSurface egl_surface_{};
   GLuint gl_texture_ = 0;
+  int texture_width_ = 0;
+  int texture_height_ = 0;
+  // Set when a paint is skipped: its dirty rects are lost, so the next paint
+  // uploads the whole frame. CEF UI thread only.
+  bool needs_full_upload_ = true;
   GLuint framebuffer_ = 0;
   GLuint depthrenderbuffer_ = 0;
   unsigned int VBO, VAO, EBO;
   const double width_, height_;
 
+  // Optional pixel unpack buffer ring used to stream dirty rects to the GPU.
+  // Enabled by setting WEBVIEW_PBO_UPLOAD in the environment.
+  static constexpr int kPboCount = 3;
+  bool use_pbo_ = false;
+  GLuint pbo_[kPboCount]{};
+  size_t pbo_size_ = 0;
+  int pbo_index_ = 0;
+
+  // Accelerated paint: CEF dmabuf frames are imported as EGLImages into
+  // |shared_texture_|. Only enabled when the EGL/GL extensions are present.
+  PFNEGLCREATEIMAGEKHRPROC eglCreateImageKHR_ = nullptr;
+  PFNEGLDESTROYIMAGEKHRPROC eglDestroyImageKHR_ = nullptr;
+  PFNGLEGLIMAGETARGETTEXTURE2DOESPROC glEGLImageTargetTexture2DOES_ = nullptr;
+  bool dmabuf_modifiers_supported_ = false;
+  bool shared_texture_enabled_ = false;
+  GLuint shared_texture_ = 0;
+
+  // Bound into every task posted to the CEF UI thread, so tasks still queued
+  // when the view is destroyed are dropped. Taken once on the UI thread in
+  // OnContextInitialized() and copied from there, since the factory is not
+  // thread-safe; invalidated on the UI thread by the destructor.
+  base::WeakPtr<WebviewPlatformView> weak_this_;
+  // Must stay the last member.
+  base::WeakPtrFactory<WebviewPlatformView> weak_factory_{this};
+
   void InitializeEGL();
   void InitializeScene();
+  void UploadDirtyRects(const RectList& dirtyRects,
+                        const void* pixels,
+                        int width,
+                        int height) const;
+  void UploadDirtyRectsPbo(const RectList& dirtyRects,
+                           const void* buffer,
+                           int width,
+                           int height);
+  void InitializeDmabufImport();
+  EGLImageKHR CreateDmabufImage(const CefAcceleratedPaintInfo& info) const;
+  void DrawQuad(GLuint texture) const;
+  void CreateBrowser(const std::string& url, bool shared_texture);
+  void RequestFrameCallback();
+  void RequestFrameCallbackLocked();
+  void PresentFrame();
+  void UpdateOffscreenLocked();
+  void UpdateFrameRate();
+  void ApplyFrameRate();
+  void FallbackToSoftwarePaint();
+  void InvalidateWeakPtrs();
   void DrawFrame(uint32_t time) const;
 
   static void on_frame(void* data, wl_callback* callback, uint32_t time);
   static const wl_callback_listener frame_listener;
 
+  static void on_surface_enter(void* data,
+                               wl_surface* surface,
+                               wl_output* output);
+  static void on_surface_leave(void* data,
+                               wl_surface* surface,
+                               wl_output* output);
+  static const wl_surface_listener surface_listener;
+
   static void on_resize(double width, double height, void* data);
   static void on_set_direction(int32_t direction, void* data);
   static void on_set_offset(double left, double top, void* data);